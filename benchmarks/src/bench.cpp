@@ -0,0 +1,241 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    bench.cpp
+ * @brief   Minimal benchmark harness implementation
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+#include "bench.h"
+
+#define BENCH_MIN_BATCH_SEC     0.2
+
+using namespace std;
+
+namespace anatomist {
+
+static double TimeBatch(function<void()> &fn, uint64_t iterations)
+{
+    auto start = chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < iterations; i++) {
+        fn();
+    }
+
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+}
+
+void Bench::Add(const string &name, function<void()> fn, double audio_sec, uint32_t reps)
+{
+    bench_t b;
+
+    b.name = name;
+    b.fn = fn;
+    b.audio_sec = audio_sec;
+    b.reps = max(reps, 1U);
+    b.calls = 0;
+
+    benches_.push_back(b);
+}
+
+void Bench::AddLatency(const string &name, function<void()> fn, uint64_t calls,
+                       double audio_sec)
+{
+    bench_t b;
+
+    b.name = name;
+    b.fn = fn;
+    b.audio_sec = audio_sec;
+    b.reps = 1;
+    b.calls = max<uint64_t>(calls, 1);
+
+    benches_.push_back(b);
+}
+
+Bench::result_t Bench::Run_(bench_t &b)
+{
+    result_t r;
+    vector<double> per_iter;
+    uint64_t iterations = 1;
+
+    /* warm up and calibrate the batch size at the same time */
+    double ns = TimeBatch(b.fn, iterations);
+    while (ns < BENCH_MIN_BATCH_SEC * 1e9) {
+        iterations = max<uint64_t>(iterations * 2,
+                                   iterations * BENCH_MIN_BATCH_SEC * 1e9 / max(ns, 1.0));
+        ns = TimeBatch(b.fn, iterations);
+    }
+
+    for (uint32_t rep = 0; rep < b.reps; rep++) {
+        per_iter.push_back(TimeBatch(b.fn, iterations) / iterations);
+    }
+
+    sort(per_iter.begin(), per_iter.end());
+
+    r.name = b.name;
+    r.iterations = iterations;
+    r.reps = b.reps;
+    r.ns_min = per_iter.front();
+    r.ns_median = per_iter[per_iter.size() / 2];
+    r.ns_max = per_iter.back();
+    r.realtime = (b.audio_sec > 0) ? b.audio_sec * 1e9 / r.ns_median : 0;
+
+    return r;
+}
+
+Bench::result_t Bench::RunLatency_(bench_t &b)
+{
+    result_t r;
+    vector<double> per_call(b.calls);
+
+    /* warm up caches and branch predictors */
+    TimeBatch(b.fn, min<uint64_t>(b.calls, 16));
+
+    for (uint64_t i = 0; i < b.calls; i++) {
+        per_call[i] = TimeBatch(b.fn, 1);
+    }
+
+    sort(per_call.begin(), per_call.end());
+
+    r.name = b.name;
+    r.iterations = b.calls;
+    r.reps = b.reps;
+    r.ns_min = per_call.front();
+    r.ns_median = per_call[per_call.size() / 2];
+    r.ns_max = per_call.back();
+    /* real time margin is defined by the slowest call */
+    r.realtime = (b.audio_sec > 0) ? b.audio_sec * 1e9 / r.ns_max : 0;
+
+    return r;
+}
+
+void Bench::Run(const string &filter, ostream &log)
+{
+    for (auto &b : benches_) {
+        if (b.name.find(filter) == string::npos) {
+            continue;
+        }
+
+        result_t r = (b.calls > 0) ? RunLatency_(b) : Run_(b);
+
+        log << left << setw(32) << r.name << right
+            << setw(16) << fixed << setprecision(0) << r.ns_median << " ns";
+        if (b.calls > 0) {
+            log << setw(16) << r.ns_max << " ns max";
+        }
+        if (r.realtime > 0) {
+            log << setw(10) << setprecision(1) << r.realtime << "x RT";
+        }
+        log << endl;
+
+        results_.push_back(r);
+    }
+}
+
+const vector<Bench::result_t> & Bench::Results()
+{
+    return results_;
+}
+
+void Bench::WriteJson(ostream &os)
+{
+    os << "{\n  \"benchmarks\": [\n";
+
+    for (uint32_t i = 0; i < results_.size(); i++) {
+        result_t &r = results_[i];
+
+        os << "    {\"name\": \"" << r.name << "\""
+           << ", \"iterations\": " << r.iterations
+           << ", \"reps\": " << r.reps
+           << fixed << setprecision(1)
+           << ", \"ns_min\": " << r.ns_min
+           << ", \"ns_median\": " << r.ns_median
+           << ", \"ns_max\": " << r.ns_max
+           << setprecision(3)
+           << ", \"realtime\": " << r.realtime
+           << "}" << (i + 1 < results_.size() ? "," : "") << "\n";
+    }
+
+    os << "  ]\n}\n";
+}
+
+map<string, double> Bench::LoadBaseline(const string &path)
+{
+    static const string name_key = "\"name\": \"";
+    static const string median_key = "\"ns_median\": ";
+    map<string, double> baseline;
+    ifstream is(path);
+    string line;
+
+    if (!is.is_open()) {
+        throw runtime_error("Failed to open baseline " + path);
+    }
+
+    while (getline(is, line)) {
+        size_t name_pos = line.find(name_key);
+        size_t median_pos = line.find(median_key);
+
+        if ((name_pos == string::npos) || (median_pos == string::npos)) {
+            continue;
+        }
+
+        name_pos += name_key.size();
+        string name = line.substr(name_pos, line.find('"', name_pos) - name_pos);
+
+        baseline[name] = stod(line.substr(median_pos + median_key.size()));
+    }
+
+    return baseline;
+}
+
+uint32_t Bench::Compare(const map<string, double> &baseline, double threshold,
+                        ostream &log)
+{
+    uint32_t regressions = 0;
+
+    for (auto &r : results_) {
+        auto it = baseline.find(r.name);
+
+        if ((it == baseline.end()) || (it->second <= 0)) {
+            log << left << setw(32) << r.name << "  no baseline" << endl;
+            continue;
+        }
+
+        double change = r.ns_median / it->second - 1;
+        bool regressed = change > threshold;
+
+        log << left << setw(32) << r.name << right << showpos << fixed
+            << setprecision(1) << setw(10) << change * 100 << "%" << noshowpos
+            << (regressed ? "  REGRESSION" : "") << endl;
+
+        if (regressed) {
+            regressions++;
+        }
+    }
+
+    return regressions;
+}
+
+}
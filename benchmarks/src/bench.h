@@ -0,0 +1,123 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file        bench.h
+ * @brief       Minimal benchmark harness
+ *
+ * Each benchmark is a callable which is run in batches. Batch size is
+ * calibrated so that a single batch takes at least BENCH_MIN_BATCH_SEC,
+ * several batches are timed and min and median per-iteration time are
+ * reported. Results are emitted as JSON with one benchmark per line so
+ * previous runs can be loaded back as a baseline.
+ *
+ * Latency benchmarks time every call on its own instead and additionally
+ * report the worst case, which is what matters for real-time processing.
+ */
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+namespace anatomist {
+
+class Bench {
+
+public:
+    struct result_t {
+        std::string name;
+        uint64_t    iterations;     /* per batch */
+        uint32_t    reps;
+        double      ns_min;
+        double      ns_median;
+        double      ns_max;
+        double      realtime;       /* audio seconds per wall clock second, 0 if n/a */
+    };
+
+private:
+    struct bench_t {
+        std::string             name;
+        std::function<void()>   fn;
+        double                  audio_sec;
+        uint32_t                reps;
+        uint64_t                calls;      /* latency benchmark if > 0 */
+    };
+
+    std::vector<bench_t>    benches_;
+    std::vector<result_t>   results_;
+
+    result_t Run_(bench_t &b);
+
+    result_t RunLatency_(bench_t &b);
+
+public:
+    /**
+     * Register a benchmark
+     *
+     * @param   name        unique benchmark name
+     * @param   fn          code to be timed, single iteration
+     * @param   audio_sec   duration of audio processed per iteration,
+     *                      is used to report real time factor
+     * @param   reps        number of timed batches
+     */
+    void Add(const std::string &name, std::function<void()> fn,
+             double audio_sec = 0, uint32_t reps = 5);
+
+    /**
+     * Register a latency benchmark
+     *
+     * @param   name        unique benchmark name
+     * @param   fn          code to be timed, single call
+     * @param   calls       number of individually timed calls
+     * @param   audio_sec   duration of audio processed per call
+     */
+    void AddLatency(const std::string &name, std::function<void()> fn,
+                    uint64_t calls, double audio_sec = 0);
+
+    /**
+     * Run registered benchmarks whose names contain \p filter
+     */
+    void Run(const std::string &filter, std::ostream &log);
+
+    const std::vector<result_t> & Results();
+
+    void WriteJson(std::ostream &os);
+
+    /**
+     * Load median timings from JSON written by WriteJson()
+     */
+    static std::map<std::string, double> LoadBaseline(const std::string &path);
+
+    /**
+     * Compare results against a baseline
+     *
+     * @param   baseline    median timings by benchmark name
+     * @param   threshold   allowed relative slowdown, e.g. 0.1 for 10%
+     * @return  number of regressions found
+     */
+    uint32_t Compare(const std::map<std::string, double> &baseline, double threshold,
+                     std::ostream &log);
+};
+
+}
@@ -0,0 +1,363 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    bench_run.cpp
+ * @brief   Benchmarks of the libmusic processing stages
+ */
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string.h>
+#include <stdlib.h>
+
+#define CHORD_DETECTOR_TEST_FRIENDS friend class ChordDetectorBench
+
+#include "beat_detector.h"
+#include "beat_tracker.h"
+#include "chord_detector.h"
+#include "chord_session.h"
+#include "config.h"
+#include "cqt_wrapper.h"
+#include "envelope.h"
+#include "fft.h"
+#include "fft_wrapper.h"
+#include "goertzel_bank.h"
+#include "pitch_cls_profile.h"
+#include "rt_chord_analyzer.h"
+#include "signal_energy.h"
+#include "viterbi.h"
+#include "window_functions.h"
+
+#include "bench.h"
+#include "signals.h"
+
+#define BENCH_SAMPLERATE    44100
+#define BENCH_SIGNAL_SEC    10
+#define BENCH_F_MIN         ((freq_hz_t)41.2)   /* E1 */
+#define BENCH_F_MAX         ((freq_hz_t)1046.5) /* C6 */
+#define BENCH_THRESHOLD_PCT 10
+#define BENCH_RT_BLOCK_SIZE 4096
+
+using namespace anatomist;
+using namespace std;
+
+namespace anatomist {
+
+/**
+ * Access to the stages of ChordDetector which are not part of the API
+ */
+class ChordDetectorBench {
+
+public:
+    static Viterbi::prob_matrix_t ScoreMatrix(ChordDetector &cd, chromagram_t &c)
+    {
+        return cd.GetScoreMatrix_(c, vector<bool>());
+    }
+
+    static uint32_t TplsCount(ChordDetector &cd)
+    {
+        return cd.tpl_collection_->Size();
+    }
+};
+
+}
+
+void usage();
+
+static void addStageBenchmarks(Bench &bench)
+{
+    auto td = make_shared<td_t>(SynthSignal::Chords(BENCH_SAMPLERATE, BENCH_SIGNAL_SEC));
+
+    for (uint32_t size : { 4096U, 16384U, 65536U }) {
+        auto noise = make_shared<td_t>(SynthSignal::Noise(size));
+
+        bench.Add("fft/" + to_string(size), [noise]() {
+            anatomist::FFT fft(noise->data(), noise->size(), BENCH_SAMPLERATE, false);
+        });
+    }
+
+    auto frame = make_shared<td_t>(SynthSignal::Noise(CFG_WINDOW_SIZE));
+    bench.Add("window/hamming", [frame]() { td_t x(*frame); WindowFunctions::applyHamming(x); });
+    bench.Add("window/hann", [frame]() { td_t x(*frame); WindowFunctions::applyHann(x); });
+    bench.Add("window/blackman", [frame]() { td_t x(*frame); WindowFunctions::applyBlackman(x); });
+
+    bench.Add("envelope", [td]() {
+        Envelope e(td->data(), td->size());
+    }, BENCH_SIGNAL_SEC);
+
+    auto envelope = make_shared<Envelope>(td->data(), td->size());
+    bench.Add("beat_detector", [envelope]() {
+        BeatDetector bd(envelope.get(), BENCH_SAMPLERATE);
+    }, BENCH_SIGNAL_SEC);
+
+    bench.Add("signal_energy", [td]() {
+        SignalEnergy energy(*td);
+    }, BENCH_SIGNAL_SEC);
+
+    bench.Add("beat_tracker", [td]() {
+        BeatTracker bt(BENCH_SAMPLERATE);
+        bt.Process(td->data(), td->size(), nullptr);
+    }, BENCH_SIGNAL_SEC);
+
+    bench.Add("fft_wrapper", [td]() {
+        FFTWrapper tft(BENCH_F_MIN, BENCH_F_MAX, BENCH_SAMPLERATE, CFG_WINDOW_SIZE, CFG_WINDOW_SIZE);
+        tft.Process(*td, 0);
+    }, BENCH_SIGNAL_SEC);
+
+    bench.Add("goertzel_bank", [td]() {
+        GoertzelBank tft(BENCH_F_MIN, BENCH_F_MAX, BENCH_SAMPLERATE, CFG_WINDOW_SIZE, CFG_WINDOW_SIZE);
+        tft.Process(*td, 0);
+    }, BENCH_SIGNAL_SEC);
+
+    bench.Add("goertzel_bank/sliding", [td]() {
+        GoertzelBank tft(BENCH_F_MIN, BENCH_F_MAX, BENCH_SAMPLERATE, CFG_WINDOW_SIZE, CFG_WINDOW_SIZE / 8);
+        tft.Process(*td, 0);
+    }, BENCH_SIGNAL_SEC);
+
+    bench.Add("cqt_wrapper/init", []() {
+        CQTWrapper tft(BENCH_F_MIN, BENCH_F_MAX, BENCH_SAMPLERATE, CFG_WINDOW_SIZE, CFG_WINDOW_SIZE);
+    });
+
+    bench.Add("cqt_wrapper", [td]() {
+        CQTWrapper tft(BENCH_F_MIN, BENCH_F_MAX, BENCH_SAMPLERATE, CFG_WINDOW_SIZE, CFG_WINDOW_SIZE);
+        tft.Process(*td, 0);
+    }, BENCH_SIGNAL_SEC);
+
+    auto cqt = make_shared<CQTWrapper>(BENCH_F_MIN, BENCH_F_MAX, BENCH_SAMPLERATE,
+                                       CFG_WINDOW_SIZE, CFG_WINDOW_SIZE);
+    cqt->Process(*td, 0);
+    auto spectrogram = make_shared<log_spectrogram_t>(cqt->GetSpectrogram());
+
+    bench.Add("pitch_cls_profile", [cqt, spectrogram]() {
+        for (auto &column : *spectrogram) {
+            PitchClsProfile pcp(column, cqt.get());
+        }
+    }, BENCH_SIGNAL_SEC);
+
+    bench.Add("chord_detector/init", []() {
+        ChordDetector cd;
+    });
+
+    auto cd = make_shared<ChordDetector>();
+    auto chromagram = make_shared<chromagram_t>(
+            cd->GetChromagram(td->data(), td->size(), BENCH_SAMPLERATE));
+
+    bench.Add("template_scoring", [cd, chromagram]() {
+        ChordDetectorBench::ScoreMatrix(*cd, *chromagram);
+    }, BENCH_SIGNAL_SEC);
+
+    /* same model as used by ChordDetector */
+    uint32_t states = ChordDetectorBench::TplsCount(*cd);
+    double self_p = cd->GetConfig().self_transition_p;
+    auto obs = make_shared<Viterbi::prob_matrix_t>(ChordDetectorBench::ScoreMatrix(*cd, *chromagram));
+    auto init_p = make_shared<vector<prob_t>>(states, 0);
+    auto trans_p = make_shared<Viterbi::prob_matrix_t>(states,
+            vector<prob_t>(states, (1 - self_p) / (states - 1)));
+
+    init_p->back() = 1;
+    for (uint32_t i = 0; i < states; i++) {
+        (*trans_p)[i][i] = self_p;
+    }
+
+    bench.Add("viterbi", [obs, init_p, trans_p]() {
+        Viterbi::GetPath(*init_p, *obs, *trans_p);
+    }, BENCH_SIGNAL_SEC);
+}
+
+static void addRealTimeBenchmarks(Bench &bench)
+{
+    auto td = make_shared<td_t>(SynthSignal::Chords(BENCH_SAMPLERATE, BENCH_SIGNAL_SEC));
+    auto rt = make_shared<RTChordAnalyzer>(BENCH_SAMPLERATE, BENCH_RT_BLOCK_SIZE);
+    auto pos = make_shared<uint32_t>(0);
+    uint32_t blocks = td->size() / BENCH_RT_BLOCK_SIZE;
+
+    /* go over the signal block by block, the way an audio callback would */
+    bench.AddLatency("rt_chord_analyzer/" + to_string(BENCH_RT_BLOCK_SIZE), [td, rt, pos, blocks]() {
+        rt->Process(td->data() + *pos * BENCH_RT_BLOCK_SIZE);
+        *pos = (*pos + 1) % blocks;
+    }, blocks * 10, 1.0 * BENCH_RT_BLOCK_SIZE / BENCH_SAMPLERATE);
+
+    auto rt_low = make_shared<RTChordAnalyzer>(BENCH_SAMPLERATE, AnalysisConfig::Preset("lowlatency"));
+    auto pos_low = make_shared<uint32_t>(0);
+    uint32_t hop = rt_low->BlockSize();
+    uint32_t hops = td->size() / hop;
+
+    bench.AddLatency("rt_chord_analyzer/lowlatency", [td, rt_low, pos_low, hop, hops]() {
+        rt_low->Process(td->data() + *pos_low * hop);
+        *pos_low = (*pos_low + 1) % hops;
+    }, hops * 10, 1.0 * hop / BENCH_SAMPLERATE);
+}
+
+static void addEndToEndBenchmarks(Bench &bench, bool with_long)
+{
+    vector<pair<string, double>> inputs = { { "30s", 30 }, { "5min", 300 } };
+
+    if (with_long) {
+        inputs.push_back({ "60min", 3600 });
+    }
+
+    for (auto &input : inputs) {
+        double sec = input.second;
+        auto td = make_shared<td_t>();
+
+        bench.Add("chord_detector/" + input.first, [td, sec]() {
+            /* generate lazily so that filtered out inputs cost nothing */
+            if (td->empty()) {
+                *td = SynthSignal::Chords(BENCH_SAMPLERATE, sec);
+            }
+
+            ChordDetector cd;
+            vector<segment_t> segments;
+
+            cd.getSegments(segments, td->data(), td->size(), BENCH_SAMPLERATE);
+        }, sec, sec > 60 ? 1 : 3);
+    }
+
+    auto gaps = make_shared<td_t>();
+
+    /* half of the input is silent, analysis of silence is skipped */
+    bench.Add("chord_detector/30s_gaps", [gaps]() {
+        if (gaps->empty()) {
+            *gaps = SynthSignal::Chords(BENCH_SAMPLERATE, 30);
+            for (uint32_t i = 0; i < gaps->size(); i++) {
+                if ((i / (5 * BENCH_SAMPLERATE)) % 2 == 1) {
+                    (*gaps)[i] = 0;
+                }
+            }
+        }
+
+        ChordDetector cd;
+        vector<segment_t> segments;
+
+        cd.getSegments(segments, gaps->data(), gaps->size(), BENCH_SAMPLERATE);
+    }, 30, 3);
+
+    auto td = make_shared<td_t>();
+
+    for (auto &name : AnalysisConfig::Presets()) {
+        AnalysisConfig config = AnalysisConfig::Preset(name);
+
+        bench.Add("chord_detector/preset/" + name, [td, config]() {
+            if (td->empty()) {
+                *td = SynthSignal::Chords(BENCH_SAMPLERATE, 30);
+            }
+
+            ChordDetector cd(config);
+            vector<segment_t> segments;
+
+            cd.getSegments(segments, td->data(), td->size(), BENCH_SAMPLERATE);
+        }, 30, 3);
+    }
+
+    auto session_td = make_shared<td_t>();
+    auto session_cd = make_shared<ChordDetector>();
+    auto session = make_shared<unique_ptr<ChordSession>>();
+
+    /*
+     * Last 10 s of a 5 min recording are re-analysed, which costs the same
+     * as appending them. Warm-up analyses the whole recording.
+     */
+    bench.Add("chord_session/5min_last_10s", [session_td, session_cd, session]() {
+        if (session_td->empty()) {
+            *session_td = SynthSignal::Chords(BENCH_SAMPLERATE, 300);
+            session->reset(new ChordSession(*session_cd, BENCH_SAMPLERATE));
+        }
+
+        (*session)->Invalidate(290 * BENCH_SAMPLERATE, session_td->size());
+        (*session)->Update(*session_td);
+    }, 10, 3);
+}
+
+int main(int argc, char *argv[])
+{
+    string json_path, baseline_path, filter;
+    double threshold = BENCH_THRESHOLD_PCT;
+    bool with_long = false;
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "--json") == 0) && (i + 1 < argc)) {
+            json_path = argv[++i];
+        } else if ((strcmp(argv[i], "--baseline") == 0) && (i + 1 < argc)) {
+            baseline_path = argv[++i];
+        } else if ((strcmp(argv[i], "--threshold") == 0) && (i + 1 < argc)) {
+            threshold = atof(argv[++i]);
+        } else if ((strcmp(argv[i], "--filter") == 0) && (i + 1 < argc)) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--long") == 0) {
+            with_long = true;
+        } else {
+            usage();
+            return (strcmp(argv[i], "-h") == 0) ? 0 : -1;
+        }
+    }
+
+    Bench bench;
+    /* stdout is kept for the JSON unless it goes to a file */
+    ostream &log = json_path.empty() ? cerr : cout;
+
+    try {
+        addStageBenchmarks(bench);
+        addRealTimeBenchmarks(bench);
+        addEndToEndBenchmarks(bench, with_long);
+
+        bench.Run(filter, log);
+
+        if (!json_path.empty()) {
+            ofstream os(json_path);
+            bench.WriteJson(os);
+        } else {
+            bench.WriteJson(cout);
+        }
+
+        if (!baseline_path.empty()) {
+            uint32_t regressions = bench.Compare(Bench::LoadBaseline(baseline_path),
+                                                 threshold / 100, log);
+            if (regressions > 0) {
+                log << regressions << " benchmark(s) regressed by more than "
+                     << threshold << "%" << endl;
+                return 1;
+            }
+        }
+    } catch (exception &e) {
+        cerr << e.what() << endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+void usage()
+{
+    cout << "Usage:\n"
+         << "\tlmbench [--filter <substr>] [--long] [--json <file>]\n"
+         << "\t        [--baseline <file> [--threshold <pct>]]\n"
+         << endl;
+
+    cout << "\nOptions:\n"
+         << "\t--filter <substr>\trun only benchmarks with names containing <substr>\n"
+         << "\t--long\t\t\talso run end-to-end analysis of 60 minutes of audio\n"
+         << "\t--json <file>\t\twrite results to <file> instead of stdout. Progress\n"
+         << "\t\t\t\tgoes to stderr while results go to stdout\n"
+         << "\t--baseline <file>\tcompare median timings to results of a previous run\n"
+         << "\t--threshold <pct>\tslowdown to be reported as regression, "
+         << BENCH_THRESHOLD_PCT << "% by default\n"
+         << endl;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    signals.cpp
+ * @brief   Reproducible synthetic input for benchmarks
+ */
+
+#include <cmath>
+#include <random>
+
+#include "signals.h"
+
+#define SIGNAL_SEED         2019
+#define SIGNAL_HARMONICS    4
+#define SIGNAL_NOISE        0.01
+#define SIGNAL_CHORD_SEC    2
+
+using namespace std;
+
+namespace anatomist {
+
+static double MidiToHz(int midi)
+{
+    return 440 * pow(2, (midi - 69) / 12.0);
+}
+
+td_t SynthSignal::Chords(uint32_t samplerate, double seconds)
+{
+    /* bass note followed by the triad, MIDI note numbers */
+    static const int progression[][4] = {
+        { 48, 60, 64, 67 },     /* C */
+        { 45, 57, 60, 64 },     /* Am */
+        { 41, 60, 65, 69 },     /* F */
+        { 43, 59, 62, 67 },     /* G */
+    };
+    static const uint32_t chords_cnt = sizeof(progression) / sizeof(progression[0]);
+    td_t td(static_cast<uint64_t>(samplerate * seconds), 0);
+    minstd_rand rng(SIGNAL_SEED);
+    uniform_real_distribution<double> noise(-SIGNAL_NOISE, SIGNAL_NOISE);
+
+    for (uint64_t i = 0; i < td.size(); i++) {
+        double t = 1.0 * i / samplerate;
+        const int *chord = progression[static_cast<uint64_t>(t / SIGNAL_CHORD_SEC) % chords_cnt];
+        double x = 0;
+
+        for (uint32_t n = 0; n < 4; n++) {
+            for (uint32_t h = 1; h <= SIGNAL_HARMONICS; h++) {
+                x += sin(2 * M_PI * MidiToHz(chord[n]) * h * t) / h;
+            }
+        }
+
+        td[i] = 0.1 * x + noise(rng);
+    }
+
+    return td;
+}
+
+td_t SynthSignal::Noise(uint32_t samples)
+{
+    td_t td(samples);
+    minstd_rand rng(SIGNAL_SEED);
+    uniform_real_distribution<double> dist(-1, 1);
+
+    for (auto &x : td) {
+        x = dist(rng);
+    }
+
+    return td;
+}
+
+}
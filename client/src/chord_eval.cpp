@@ -0,0 +1,377 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    chord_eval.cpp
+ * @brief   Scoring of recognised chords against reference annotations
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chord_eval.h"
+
+/**
+ * Pitch classes up to the fifth, what the majmin vocabulary compares
+ */
+#define TRIAD_MASK  0xFF
+
+using namespace anatomist;
+using namespace std;
+
+/**
+ * Intervals of a chord as MIREX vocabularies see it: extensions above the
+ * seventh are not part of the chord, added tones are
+ */
+static pcset_t mirexIntervals(const chord_t &c)
+{
+    chord_quality_t q = c.quality();
+
+    if (c.rootNote() == note_Unknown) {
+        return 0;
+    }
+
+    switch (q) {
+        case cq_maj9:
+        case cq_maj11:
+        case cq_maj13:
+            q = cq_maj7;
+            break;
+        case cq_min9:
+        case cq_min11:
+        case cq_min13:
+            q = cq_min7;
+            break;
+        case cq_9:
+            q = cq_7;
+            break;
+        default:
+            break;
+    }
+
+    return make_pcset(note_C, q);
+}
+
+static bool inMajMin(pcset_t intervals)
+{
+    pcset_t triad = intervals & TRIAD_MASK;
+
+    return (intervals == 0) ||
+           (triad == make_pcset(note_C, cq_maj)) || (triad == make_pcset(note_C, cq_min));
+}
+
+static bool inSevenths(pcset_t intervals)
+{
+    for (auto q : { cq_maj, cq_min, cq_7, cq_maj7, cq_min7 }) {
+        if (intervals == make_pcset(note_C, q)) {
+            return true;
+        }
+    }
+
+    return intervals == 0;
+}
+
+eval_result_t & eval_result_t::operator+=(const eval_result_t &r)
+{
+    duration += r.duration;
+    known += r.known;
+    pcset += r.pcset;
+    root += r.root;
+    majmin += r.majmin;
+    majmin_known += r.majmin_known;
+    sevenths += r.sevenths;
+    sevenths_known += r.sevenths_known;
+    seg += r.seg;
+
+    return *this;
+}
+
+lab_t ChordEval::ReadLab(const string &path)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    string text;
+    char buf[1 << 16];
+    size_t len;
+    lab_t lab;
+
+    if (f == nullptr) {
+        throw runtime_error("failed to open " + path);
+    }
+    while ((len = fread(buf, 1, sizeof(buf), f)) > 0) {
+        text.append(buf, len);
+    }
+    fclose(f);
+
+    const char *p = text.c_str();
+
+    while (*p != '\0') {
+        lab_segment_t seg;
+        char *end;
+
+        seg.start = strtod(p, &end);
+        if (end == p) {
+            /* empty or malformed line */
+            p += strcspn(p, "\n");
+            p += (*p == '\n') ? 1 : 0;
+            continue;
+        }
+        p = end;
+        seg.end = strtod(p, &end);
+        if (end == p) {
+            throw runtime_error("malformed line in " + path);
+        }
+        p = end + strspn(end, " \t");
+
+        string label(p, strcspn(p, " \t\r\n"));
+
+        p += strcspn(p, "\n");
+        p += (*p == '\n') ? 1 : 0;
+
+        try {
+            seg.chord = Chord(label);
+            seg.known = true;
+        } catch (exception &) {
+            seg.chord = Chord();
+            seg.known = false;
+        }
+
+        if (seg.end > seg.start) {
+            lab.push_back(seg);
+        }
+    }
+
+    return lab;
+}
+
+vector<dataset_item_t> ChordEval::ReadList(const string &path)
+{
+    ifstream ifs(path);
+    vector<dataset_item_t> items;
+    string line;
+
+    if (!ifs.is_open()) {
+        throw runtime_error("failed to open " + path);
+    }
+
+    while (getline(ifs, line)) {
+        dataset_item_t item;
+        size_t tab = line.find('\t');
+
+        if (line.empty() || (line[0] == '#')) {
+            continue;
+        }
+
+        item.audio = line.substr(0, tab);
+        if (tab != string::npos) {
+            item.lab = line.substr(tab + 1);
+        } else {
+            item.lab = item.audio.substr(0, item.audio.rfind('.')) + ".lab";
+        }
+        items.push_back(item);
+    }
+
+    return items;
+}
+
+void ChordEval::FrameChords(lab_t lab, size_t frames, double frame_sec,
+                            vector<chord_t> *chords, vector<bool> *known)
+{
+    size_t seg = 0;
+
+    sort(lab.begin(), lab.end(),
+         [](const lab_segment_t &a, const lab_segment_t &b) { return a.start < b.start; });
+
+    chords->assign(frames, Chord());
+    known->assign(frames, false);
+
+    for (size_t f = 0; f < frames; f++) {
+        double t = (f + 0.5) * frame_sec;
+
+        while ((seg < lab.size()) && (lab[seg].end <= t)) {
+            seg++;
+        }
+        if ((seg < lab.size()) && (lab[seg].start <= t)) {
+            (*chords)[f] = lab[seg].chord;
+            (*known)[f] = lab[seg].known;
+        }
+    }
+}
+
+lab_t ChordEval::FromSegments(const vector<segment_t> &segments, uint32_t samplerate)
+{
+    lab_t lab;
+
+    if (samplerate == 0) {
+        throw invalid_argument("FromSegments(): invalid sample rate");
+    }
+
+    lab.reserve(segments.size());
+    for (auto &s : segments) {
+        lab_segment_t seg;
+
+        seg.start = 1.0 * s.startIdx / samplerate;
+        seg.end = (s.endIdx + 1.0) / samplerate;
+        seg.chord = s.chord;
+        seg.known = true;
+        lab.push_back(seg);
+    }
+
+    return lab;
+}
+
+lab_t ChordEval::Adjust_(lab_t lab, double start, double end)
+{
+    lab_t res;
+    double t = start;
+    lab_segment_t gap;
+
+    gap.chord = Chord();
+    gap.known = true;
+
+    stable_sort(lab.begin(), lab.end(),
+                [](const lab_segment_t &l, const lab_segment_t &r) { return l.start < r.start; });
+
+    for (auto seg : lab) {
+        if ((seg.end <= t) || (t >= end)) {
+            continue;
+        }
+        if (seg.start > t) {
+            gap.start = t;
+            gap.end = min(seg.start, end);
+            res.push_back(gap);
+            t = gap.end;
+            if (t >= end) {
+                break;
+            }
+        }
+        seg.start = t;
+        seg.end = min(seg.end, end);
+        res.push_back(seg);
+        t = seg.end;
+    }
+
+    if (t < end) {
+        gap.start = t;
+        gap.end = end;
+        res.push_back(gap);
+    }
+
+    return res;
+}
+
+lab_t ChordEval::Merge_(const lab_t &lab)
+{
+    lab_t res;
+
+    for (auto &seg : lab) {
+        if (!res.empty() && (res.back().known == seg.known) && (res.back().chord == seg.chord)) {
+            res.back().end = seg.end;
+        } else {
+            res.push_back(seg);
+        }
+    }
+
+    return res;
+}
+
+double ChordEval::DirectionalHamming_(const lab_t &from, const lab_t &to)
+{
+    double distance = 0;
+    size_t j = 0;
+
+    for (auto &seg : from) {
+        double longest = 0;
+
+        while ((j < to.size()) && (to[j].end <= seg.start)) {
+            j++;
+        }
+        for (size_t k = j; (k < to.size()) && (to[k].start < seg.end); k++) {
+            longest = max(longest, min(seg.end, to[k].end) - max(seg.start, to[k].start));
+        }
+
+        distance += (seg.end - seg.start) - longest;
+    }
+
+    return distance;
+}
+
+eval_result_t ChordEval::Evaluate(lab_t ref, lab_t est)
+{
+    eval_result_t res;
+
+    if (ref.empty()) {
+        return res;
+    }
+
+    stable_sort(ref.begin(), ref.end(),
+                [](const lab_segment_t &l, const lab_segment_t &r) { return l.start < r.start; });
+
+    double start = ref.front().start, end = start;
+
+    for (auto &seg : ref) {
+        end = max(end, seg.end);
+    }
+
+    ref = Adjust_(ref, start, end);
+    est = Adjust_(est, start, end);
+
+    /* both cover [start, end) without gaps now, walk through them together */
+    size_t i = 0, j = 0;
+    double t = start;
+
+    while ((i < ref.size()) && (j < est.size())) {
+        const lab_segment_t &r = ref[i], &e = est[j];
+        double next = min(r.end, e.end);
+        double d = next - t;
+
+        if (r.known) {
+            pcset_t r_int = mirexIntervals(r.chord), e_int = mirexIntervals(e.chord);
+            bool same_root = (r.chord.rootNote() == e.chord.rootNote());
+
+            res.known += d;
+            res.pcset += r.chord.match(e.chord) ? d : 0;
+            res.root += same_root ? d : 0;
+
+            if (inMajMin(r_int)) {
+                res.majmin_known += d;
+                res.majmin += (same_root && ((r_int & TRIAD_MASK) == (e_int & TRIAD_MASK))) ? d : 0;
+            }
+            if (inSevenths(r_int)) {
+                res.sevenths_known += d;
+                res.sevenths += (same_root && (r_int == e_int)) ? d : 0;
+            }
+        }
+
+        t = next;
+        i += (r.end <= t) ? 1 : 0;
+        j += (e.end <= t) ? 1 : 0;
+    }
+
+    lab_t ref_merged = Merge_(ref), est_merged = Merge_(est);
+
+    res.duration = end - start;
+    res.seg = res.duration - max(DirectionalHamming_(ref_merged, est_merged),
+                                 DirectionalHamming_(est_merged, ref_merged));
+
+    return res;
+}
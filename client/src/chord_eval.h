@@ -0,0 +1,151 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    chord_eval.h
+ * @brief   Scoring of recognised chords against reference annotations
+ *
+ * Metrics follow the MIREX audio chord estimation task: every one is the
+ * part of the annotated duration where the estimate agrees with the
+ * reference under the metric's vocabulary. References outside of that
+ * vocabulary do not count.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "chord_detector.h"
+
+/**
+ * Part of a recording annotated with a single chord
+ */
+struct lab_segment_t {
+    double      start;      /**< seconds */
+    double      end;        /**< seconds, not included */
+    chord_t     chord;
+    bool        known;      /**< false if the label could not be parsed (X) */
+};
+
+typedef std::vector<lab_segment_t> lab_t;
+
+/**
+ * Recording of a dataset and its annotation
+ */
+struct dataset_item_t {
+    std::string audio;
+    std::string lab;
+};
+
+/**
+ * Durations in seconds the estimate is correct for under every metric
+ *
+ * Results of several recordings are added up to get the duration
+ * weighted scores of the whole dataset.
+ */
+struct eval_result_t {
+    double  duration = 0;           /**< annotated duration */
+    double  known = 0;              /**< annotated duration with a known chord */
+    double  pcset = 0;              /**< same pitch class set, see Chord::match() */
+    double  root = 0;
+    double  majmin = 0;
+    double  majmin_known = 0;       /**< duration of references in the majmin vocabulary */
+    double  sevenths = 0;
+    double  sevenths_known = 0;     /**< duration of references in the sevenths vocabulary */
+    double  seg = 0;                /**< segmentation score multiplied by the duration */
+
+    eval_result_t & operator+=(const eval_result_t &r);
+
+    /**
+     * Scores between 0 and 1
+     */
+    double PCSet() const    { return Ratio_(pcset, known); }
+    double Root() const     { return Ratio_(root, known); }
+    double MajMin() const   { return Ratio_(majmin, majmin_known); }
+    double Sevenths() const { return Ratio_(sevenths, sevenths_known); }
+    double Seg() const      { return Ratio_(seg, duration); }
+
+private:
+    static double Ratio_(double part, double total) { return (total > 0) ? part / total : 0; }
+};
+
+class ChordEval {
+    friend class TestChordEvalAdjust;
+
+    public:
+        /**
+         * Read a MIREX .lab file: one "<start> <end> <label>" per line
+         *
+         * Labels which can not be parsed are kept as unknown chords.
+         */
+        static lab_t ReadLab(const std::string &path);
+
+        /**
+         * Read a dataset list: a recording per line, optionally followed by
+         * a tab and its .lab annotation. By default the annotation is the
+         * recording path with the .lab extension.
+         */
+        static std::vector<dataset_item_t> ReadList(const std::string &path);
+
+        /**
+         * Annotated chord in the middle of every frame
+         *
+         * @param   lab         annotation
+         * @param   frames      number of frames
+         * @param   frame_sec   distance between frames in seconds
+         * @param   chords      output chord of every frame
+         * @param   known       output flag of every frame, false if the
+         *                      annotation does not cover the frame or its
+         *                      chord is unknown
+         */
+        static void FrameChords(lab_t lab, size_t frames, double frame_sec,
+                                std::vector<chord_t> *chords, std::vector<bool> *known);
+
+        /**
+         * Convert the detector output to annotation
+         */
+        static lab_t FromSegments(const std::vector<segment_t> &segments, uint32_t samplerate);
+
+        /**
+         * Score \p est against \p ref over the annotated time span
+         *
+         * Both are swept once in the order of time, so the cost is linear
+         * in the number of segments. Parts of the span \p est does not cover
+         * are taken as no chord.
+         */
+        static eval_result_t Evaluate(lab_t ref, lab_t est);
+
+    private:
+        /**
+         * Sort, clip to [start, end) and fill the gaps with no chord
+         */
+        static lab_t Adjust_(lab_t lab, double start, double end);
+
+        /**
+         * Merge neighbours with the same chord
+         */
+        static lab_t Merge_(const lab_t &lab);
+
+        /**
+         * Duration of \p from which is not in the longest overlap of each
+         * of its segments with a segment of \p to
+         */
+        static double DirectionalHamming_(const lab_t &from, const lab_t &to);
+};
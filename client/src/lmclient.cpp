@@ -25,16 +25,28 @@
 #include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <string.h>
 #include <sndfile.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "beat_detector.h"
+#include "beat_tracker.h"
 #include "chord_detector.h"
 #include "config.h"
 #include "envelope.h"
 #include "fft.h"
+#include "kiss_fftr.h"
 #include "lmhelpers.h"
+#include "lmstats.h"
+#include "lmtrace.h"
+#include "output_writer.h"
 #include "window_functions.h"
 
 using namespace anatomist;
@@ -42,13 +54,19 @@ using namespace std;
 
 void usage();
 void printScales();
-void printSigEnvelope(amplitude_t *, uint32_t);
-void printFFT(double *, int, uint32_t, bool, bool);
-void printTimeDomain(double *, uint32_t, uint32_t, bool, bool);
-void printChordInfo(amplitude_t *, SF_INFO &, uint32_t, uint32_t, const string&, bool, int, bool, bool);
+void printSigEnvelope(amplitude_t *, uint32_t, OutputWriter &);
+void printFFT(double *, int, uint32_t, bool, bool, OutputWriter &);
+void printSTFT(SNDFILE *, SF_INFO &, uint32_t, uint32_t, bool, bool, OutputWriter &);
+void printTimeDomain(double *, uint32_t, uint32_t, bool, bool, OutputWriter &);
+void printChordInfo(amplitude_t *, SF_INFO &, uint32_t, uint32_t, const string&, bool, int, bool,
+                    const AnalysisConfig&, const string&, const string&, int, const string&,
+                    OutputWriter &);
 void printAudioFileInfo(SF_INFO &);
 void printBPM(amplitude_t *, uint32_t, uint32_t);
+void printBeats(amplitude_t *, SF_INFO &, OutputWriter &);
+void printOnsets(amplitude_t *, SF_INFO &, const AnalysisConfig&, OutputWriter &);
 void dumpTemplates();
+void printStats(const stats_t &);
 
 
 int main(int argc, char* argv[])
@@ -65,10 +83,22 @@ int main(int argc, char* argv[])
     bool pcpCSV = false;            // Raw PCP data in CSV format
     bool printEnvelope = false;     // print signal envelope
     bool detectBeat = false;        // print beats per minute
+    bool trackBeats = false;        // print individual beat timestamps
+    bool detectOnsets = false;      // print onset timestamps
     bool legacy = false;            // legacy version of the feature
+    bool stats = false;             // print per-stage statistics
+    string traceDir;                // directory to dump intermediate results to
+    string cacheDir;                // feature cache directory
+    string modelPath;               // trained chord model
+    AnalysisConfig config;          // analysis profile, compile-time defaults unless --preset
+    int jobs = 1;                   // processes to split chord recognition between
+    string serverSocket;            // lmserver to have chords recognized by
+    output_format_t format = OUTPUT_FORMAT_TEXT;    // format of the printed data
     int  n = 0;                     // a number of FFT windows to analyze
     string refChord;                // reference chord to evaluate against
     int winSize = 0;                // default window size is set by the lib
+    int hopSize = 0;                // hop between -f windows, half of the window by default
+    bool average = false;           // average -f windows into a single spectrum
 
     for (int i = 0; i < argc; i++) {
         if (strcmp(argv[i], "-f") == 0) {
@@ -83,6 +113,12 @@ int main(int argc, char* argv[])
         } else if ((strcmp(argv[i], "-b") == 0)) {
             detectBeat = true;
             minArgCnt++;
+        } else if ((strcmp(argv[i], "--beats") == 0)) {
+            trackBeats = true;
+            minArgCnt++;
+        } else if ((strcmp(argv[i], "--onsets") == 0)) {
+            detectOnsets = true;
+            minArgCnt++;
         } else if (strcmp(argv[i], "-i") == 0) {
             tdViaInverseDFT = true;
             minArgCnt++;
@@ -127,6 +163,66 @@ int main(int argc, char* argv[])
         } else if ((strcmp(argv[i], "--tplsdump") == 0)) {
             dumpTemplates();
             return 0;
+        } else if ((strcmp(argv[i], "--stats") == 0)) {
+            /* not counted in minArgCnt, can be combined with anything */
+            stats = true;
+        } else if ((strcmp(argv[i], "--trace") == 0)) {
+            /* not counted in minArgCnt, can be combined with anything */
+            i++;
+            if (i >= argc) { usage(); return 1; }
+            traceDir = string(argv[i]);
+        } else if ((strcmp(argv[i], "--cache") == 0)) {
+            /* not counted in minArgCnt, has effect with -c only */
+            i++;
+            if (i >= argc) { usage(); return 1; }
+            cacheDir = string(argv[i]);
+        } else if ((strcmp(argv[i], "--model") == 0)) {
+            /* not counted in minArgCnt, has effect with -c only */
+            i++;
+            if (i >= argc) { usage(); return 1; }
+            modelPath = string(argv[i]);
+        } else if ((strcmp(argv[i], "--preset") == 0)) {
+            /* not counted in minArgCnt, has effect with -c and --onsets only */
+            i++;
+            if (i >= argc) { usage(); return 1; }
+            try {
+                config = AnalysisConfig::Preset(argv[i]);
+            } catch (const invalid_argument &e) {
+                cerr << e.what() << endl;
+                usage();
+                return 1;
+            }
+        } else if ((strcmp(argv[i], "--jobs") == 0)) {
+            /* not counted in minArgCnt, has effect with -c only */
+            i++;
+            if (i >= argc) { usage(); return 1; }
+            jobs = atoi(argv[i]);
+            if (jobs <= 0) { usage(); return 1; }
+        } else if ((strcmp(argv[i], "--hop") == 0)) {
+            /* not counted in minArgCnt, has effect with -f -w only */
+            i++;
+            if (i >= argc) { usage(); return 1; }
+            hopSize = atoi(argv[i]);
+            if (hopSize <= 0) { usage(); return 1; }
+        } else if ((strcmp(argv[i], "--avg") == 0)) {
+            /* not counted in minArgCnt, has effect with -f -w only */
+            average = true;
+        } else if ((strcmp(argv[i], "--format") == 0)) {
+            /* not counted in minArgCnt, can be combined with anything printing data */
+            i++;
+            if (i >= argc) { usage(); return 1; }
+            try {
+                format = OutputWriter::ParseFormat(argv[i]);
+            } catch (const invalid_argument &e) {
+                cerr << e.what() << endl;
+                usage();
+                return 1;
+            }
+        } else if ((strcmp(argv[i], "--server") == 0)) {
+            /* not counted in minArgCnt, has effect with -c only */
+            i++;
+            if (i >= argc) { usage(); return 1; }
+            serverSocket = string(argv[i]);
         } else if ((strcmp(argv[i], "--legacy") == 0)) {
             legacy = true;
             minArgCnt++;
@@ -144,9 +240,10 @@ int main(int argc, char* argv[])
         (printFD && printTD) || (isPolar && !printFD) ||
         (printAFI && minArgCnt > 3) || (logScale && !isPolar) ||
         (tdViaInverseDFT && !printTD) || (detectChord && minArgCnt > 6) ||
-        (winSize > 0 && !detectChord && (!printPCP && !pcpCSV)) ||
+        (winSize > 0 && !detectChord && !printFD && (!printPCP && !pcpCSV)) ||
         (detectChord && legacy && (winSize || n > 0)) ||
-        (printEnvelope && minArgCnt > 3) ||
+        (printEnvelope && minArgCnt > 3) || (trackBeats && minArgCnt > 3) ||
+        (detectOnsets && minArgCnt > 3) ||
         (detectBeat && !printTD && minArgCnt > 3) ||
         (detectBeat && printTD && minArgCnt > 4) || (legacy && minArgCnt == 3))
     {
@@ -167,6 +264,26 @@ int main(int argc, char* argv[])
         return 1;
     }
 
+    if (printFD && (winSize > 0)) {
+        /* short-time spectrum reads the file by itself, block by block */
+        OutputWriter writer(format);
+        int res = 0;
+
+        try {
+            printSTFT(sf, sfinfo, winSize, (hopSize > 0) ? hopSize : winSize / 2, average,
+                      logScale, writer);
+        } catch (const invalid_argument &e) {
+            cerr << e.what() << endl;
+            res = 1;
+        } catch (const runtime_error &e) {
+            cerr << e.what() << endl;
+            res = 1;
+        }
+        sf_close(sf);
+
+        return res;
+    }
+
     itemsCnt = sfinfo.frames * sfinfo.channels;
     buf = (double*) malloc(itemsCnt * sizeof(double));
 
@@ -175,20 +292,50 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    if (printTD) {
-        printTimeDomain(buf, itemsCnt, sfinfo.samplerate, tdViaInverseDFT, detectBeat);
-    } else if (printFD) {
-        printFFT(buf, sfinfo.samplerate, itemsCnt, isPolar, logScale);
-    } else if (printAFI) {
-        printAudioFileInfo(sfinfo);
-    } else if (detectChord || printPCP) {
-        printChordInfo(buf, sfinfo, itemsCnt, n, refChord, printPCP, winSize, legacy, pcpCSV);
-    } else if (printEnvelope) {
-        printSigEnvelope(buf, itemsCnt);
-    } else if (detectBeat && !printTD) {
-        printBPM(buf, itemsCnt, sfinfo.samplerate);
+    StatsCollector *collector = stats ? new StatsCollector() : nullptr;
+
+    if (!traceDir.empty()) {
+        Trace::Enable(traceDir);
+    }
+
+    OutputWriter writer(pcpCSV ? OUTPUT_FORMAT_CSV : format);
+
+    try {
+        if (printTD) {
+            printTimeDomain(buf, itemsCnt, sfinfo.samplerate, tdViaInverseDFT, detectBeat, writer);
+        } else if (printFD) {
+            printFFT(buf, sfinfo.samplerate, itemsCnt, isPolar, logScale, writer);
+        } else if (printAFI) {
+            printAudioFileInfo(sfinfo);
+        } else if (detectChord || printPCP) {
+            printChordInfo(buf, sfinfo, itemsCnt, n, refChord, printPCP, winSize, legacy,
+                           config, cacheDir, modelPath, jobs, serverSocket, writer);
+        } else if (printEnvelope) {
+            printSigEnvelope(buf, itemsCnt, writer);
+        } else if (detectBeat && !printTD) {
+            printBPM(buf, itemsCnt, sfinfo.samplerate);
+        } else if (trackBeats) {
+            printBeats(buf, sfinfo, writer);
+        } else if (detectOnsets) {
+            printOnsets(buf, sfinfo, config, writer);
+        }
+    } catch (const invalid_argument &e) {
+        /* format which can't hold the requested data */
+        cerr << e.what() << endl;
+        return 1;
+    } catch (const runtime_error &e) {
+        /* e.g. chord model which can't be loaded */
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    if (collector != nullptr) {
+        printStats(collector->Stats());
+        delete collector;
     }
 
+    Trace::Disable();
+
     sf_close(sf);
     free(buf);
 
@@ -196,7 +343,7 @@ int main(int argc, char* argv[])
 }
 
 void printTimeDomain(amplitude_t *td, uint32_t samples, uint32_t samplerate,
-                     bool td_via_inverse_dft, bool detect_beat)
+                     bool td_via_inverse_dft, bool detect_beat, OutputWriter &writer)
 {
 #define PLOT_SAMPLES_MAX    1000000U
     if (detect_beat) {
@@ -208,14 +355,19 @@ void printTimeDomain(amplitude_t *td, uint32_t samples, uint32_t samplerate,
         amplitude_t ampMin = *min_element(td, td + plotSamples);
         uint32_t beats = 0;
 
+        writer.Begin({ "sample", "value", "beat" });
         for (uint32_t i = 0; i < plotSamples; i++) {
             amplitude_t beatAmp = ampMin;
             if (i == beatOffset + beats * beatInterval) {
                 beatAmp = ampMax;
                 beats++;
             }
-            cout << i << "," << td[i] << "," << beatAmp << endl;
+            writer.Index(i);
+            writer.Value(td[i]);
+            writer.Value(beatAmp);
+            writer.EndRow();
         }
+        writer.End();
 
         return;
     }
@@ -227,17 +379,28 @@ void printTimeDomain(amplitude_t *td, uint32_t samples, uint32_t samplerate,
         fft->Inverse();
     }
 
+    writer.Begin({ "sample", "value" });
     for (uint32_t i = 0; i < samples; i++) {
-        cout << i << "," << real((*x)[i]) << endl;
+        writer.Index(i);
+        writer.Value(real((*x)[i]));
+        writer.EndRow();
     }
+    writer.End();
 
     delete fft;
 }
 
-void printSigEnvelope(amplitude_t *timeDomain, uint32_t samples) {
+void printSigEnvelope(amplitude_t *timeDomain, uint32_t samples, OutputWriter &writer) {
     Envelope *e = new Envelope(timeDomain, samples);
+    const vector<amplitude_t> &values = e->getValues();
 
-    cout << *e;
+    writer.Begin({ "index", "value" });
+    for (uint32_t i = 0; i < values.size(); i++) {
+        writer.Index(i);
+        writer.Value(values[i]);
+        writer.EndRow();
+    }
+    writer.End();
 
     delete e;
 }
@@ -250,6 +413,200 @@ void printBPM(amplitude_t *timeDomain, uint32_t samples, uint32_t sampleRate) {
     delete bd;
 }
 
+void printBeats(amplitude_t *timeDomain, SF_INFO &sfinfo, OutputWriter &writer)
+{
+#define BEATS_BLOCK_SIZE    4096
+    BeatTracker bt(sfinfo.samplerate);
+    vector<amplitude_t> block(BEATS_BLOCK_SIZE);
+    vector<uint32_t> beats;
+    bool text = (writer.Format() == OUTPUT_FORMAT_TEXT);
+    char line[32];
+
+    writer.Begin({ "time" });
+
+    /* feed the tracker block by block the same way a live input would do */
+    for (sf_count_t frame = 0; frame < sfinfo.frames; frame += BEATS_BLOCK_SIZE) {
+        uint32_t len = min(static_cast<sf_count_t>(BEATS_BLOCK_SIZE), sfinfo.frames - frame);
+
+        for (uint32_t i = 0; i < len; i++) {
+            block[i] = timeDomain[(frame + i) * sfinfo.channels];
+        }
+
+        beats.clear();
+        bt.Process(block.data(), len, &beats);
+
+        for (auto b : beats) {
+            if (text) {
+                snprintf(line, sizeof(line), "%.3f\n", b / (float) sfinfo.samplerate);
+                writer.Raw().Write(string(line));
+            } else {
+                writer.Value(b / (float) sfinfo.samplerate);
+                writer.EndRow();
+            }
+        }
+    }
+
+    /* tempo is a summary for humans, data formats hold the beats only */
+    if (text) {
+        snprintf(line, sizeof(line), "BPM: %.3f\n", bt.GetBPM());
+        writer.Raw().Write(string(line));
+    }
+    writer.End();
+}
+
+void printOnsets(amplitude_t *timeDomain, SF_INFO &sfinfo, const AnalysisConfig &config,
+                 OutputWriter &writer)
+{
+    ChordDetector cd(config);
+    /* first channel of the interleaved data */
+    SignalView channelTD(timeDomain, sfinfo.frames, 1, sfinfo.channels);
+    onsets_t onsets = cd.GetOnsets(channelTD, sfinfo.samplerate);
+    bool text = (writer.Format() == OUTPUT_FORMAT_TEXT);
+    char line[32];
+
+    writer.Begin({ "time", "strength" });
+    for (auto o : onsets.onsets) {
+        amplitude_t strength = onsets.strength[o / onsets.interval];
+
+        if (text) {
+            snprintf(line, sizeof(line), "%.3f\t%.3f\n", o / (float) sfinfo.samplerate, strength);
+            writer.Raw().Write(string(line));
+        } else {
+            writer.Value(o / (float) sfinfo.samplerate);
+            writer.Value(strength);
+            writer.EndRow();
+        }
+    }
+    writer.End();
+}
+
+/**
+ * Magnitude spectrum of the first channel window by window
+ *
+ * Every row is a window: its first sample followed by magnitudes of the
+ * bins. With \p average the windows are averaged into a single spectrum
+ * instead (Welch's method). Memory does not depend on the file length.
+ */
+void printSTFT(SNDFILE *sf, SF_INFO &sfinfo, uint32_t winSize, uint32_t hopSize,
+               bool average, bool logScale, OutputWriter &writer)
+{
+#define STFT_READ_FRAMES    65536
+    if (winSize % 2 != 0) {
+        throw invalid_argument("Window size has to be even");
+    }
+
+    if (winSize > sfinfo.frames) {
+        throw invalid_argument("Window of " + to_string(winSize) +
+                               " samples is longer than the input of " +
+                               to_string(sfinfo.frames));
+    }
+
+    kiss_fftr_cfg cfg = kiss_fftr_alloc(winSize, 0, nullptr, nullptr);
+
+    if (cfg == nullptr) {
+        throw runtime_error("Failed to allocate FFT of " + to_string(winSize) + " samples");
+    }
+
+    uint32_t bins = winSize / 2 + 1;
+    td_t window(winSize, 1.0);
+    vector<kiss_fft_scalar> frame(winSize), windowed(winSize);
+    vector<kiss_fft_cpx> fd(bins);
+    vector<amplitude_t> power(bins, 0), block(STFT_READ_FRAMES * sfinfo.channels);
+    uint32_t filled = 0, skip = 0;
+    uint64_t frameStart = 0, frames = 0;
+
+    WindowFunctions::applyHann(window);
+
+    /* a sine of amplitude A peaks at A, DC and Nyquist bins have no mirror */
+    amplitude_t norm = 0;
+    for (auto w : window) {
+        norm += w;
+    }
+    auto scale = [&](uint32_t k) {
+        return ((k == 0) || (k == bins - 1)) ? 1 / norm : 2 / norm;
+    };
+
+    auto processFrame = [&]() {
+        for (uint32_t i = 0; i < winSize; i++) {
+            windowed[i] = frame[i] * window[i];
+        }
+        kiss_fftr(cfg, windowed.data(), fd.data());
+
+        if (!average) {
+            writer.Index(frameStart);
+        }
+        for (uint32_t k = 0; k < bins; k++) {
+            amplitude_t mag = sqrt(fd[k].r * fd[k].r + fd[k].i * fd[k].i) * scale(k);
+
+            if (average) {
+                power[k] += mag * mag;
+            } else {
+                writer.Value(logScale ? 20 * log10(mag) : mag);
+            }
+        }
+        if (!average) {
+            writer.EndRow();
+        }
+
+        frameStart += hopSize;
+        frames++;
+    };
+
+    if (!average) {
+        vector<string> columns { "sample" };
+        for (uint32_t k = 0; k < bins; k++) {
+            columns.push_back(to_string(k * sfinfo.samplerate / static_cast<amplitude_t>(winSize)));
+        }
+        writer.Begin(columns);
+    }
+
+    sf_count_t got;
+    while ((got = sf_readf_double(sf, block.data(), STFT_READ_FRAMES)) > 0) {
+        for (sf_count_t i = 0; i < got; i++) {
+            if (skip > 0) {
+                skip--;
+                continue;
+            }
+
+            frame[filled++] = block[i * sfinfo.channels];
+            if (filled < winSize) {
+                continue;
+            }
+
+            processFrame();
+
+            if (hopSize < winSize) {
+                memmove(frame.data(), frame.data() + hopSize,
+                        (winSize - hopSize) * sizeof(frame[0]));
+                filled = winSize - hopSize;
+            } else {
+                filled = 0;
+                skip = hopSize - winSize;
+            }
+        }
+    }
+
+    /* zero padded tail, unless all of it is in the previous window already */
+    if ((frames == 0) || (filled > ((hopSize < winSize) ? winSize - hopSize : 0))) {
+        fill(frame.begin() + filled, frame.end(), 0);
+        processFrame();
+    }
+
+    kiss_fftr_free(cfg);
+
+    if (average) {
+        writer.Begin({ "frequency", "magnitude" });
+        for (uint32_t k = 0; k < bins; k++) {
+            amplitude_t p = power[k] / frames;
+
+            writer.Value(k * sfinfo.samplerate / static_cast<amplitude_t>(winSize));
+            writer.Value(logScale ? 10 * log10(p) : sqrt(p));
+            writer.EndRow();
+        }
+    }
+    writer.End();
+}
+
 double max_amplitude(amplitude_t *p, uint32_t len) {
     double max = p[0];
     for (uint32_t i = 0; i < len; i++) {
@@ -261,7 +618,7 @@ double max_amplitude(amplitude_t *p, uint32_t len) {
 }
 
 void printFFT(amplitude_t *td, int samplerate, uint32_t samples,
-              bool polar, bool logScale)
+              bool polar, bool logScale, OutputWriter &writer)
 {
     if (!polar) {
         throw runtime_error("Not implemented");
@@ -271,13 +628,15 @@ void printFFT(amplitude_t *td, int samplerate, uint32_t samples,
     amplitude_t *p = fft->GetFreqDomain().p;
     double mag_max = max_amplitude(p, fft->GetFreqDomainLen());
 
-    cout << mag_max;
-
+    writer.Begin({ "frequency", "magnitude" });
     for (uint32_t i = 0; i < fft->GetFreqDomainLen() / 2; i++) {
-        amplitude_t freq = i * samplerate / fft->GetSize();
+        amplitude_t freq = i * static_cast<amplitude_t>(samplerate) / fft->GetSize();
         double mag = logScale ? 10 * log10(p[i] / mag_max) : p[i];
-        cout << freq << "," << mag << endl;
+        writer.Value(freq);
+        writer.Value(mag);
+        writer.EndRow();
     }
+    writer.End();
 
     delete fft;
 }
@@ -345,63 +704,262 @@ void __printChordInfoLegacy(amplitude_t *timeDomain, SF_INFO &sfinfo,
     delete cd;
 }
 
+/**
+ * Split the recording into chunks, analyse every chunk in a child process
+ * and merge the results
+ */
+void __getSegmentsInJobs(ChordDetector *cd, const SignalView &td, uint32_t samplerate,
+                         int jobs, std::vector<segment_t> &segments)
+{
+    size_t alignment = cd->ChunkAlignment(samplerate);
+    size_t aligned = td.size() / alignment;
+    std::vector<size_t> bounds { 0 };
+    std::vector<pair<pid_t, int>> children;
+    std::vector<chunk_t> chunks;
+
+    for (int j = 1; j < jobs; j++) {
+        size_t bound = (aligned * j / jobs) * alignment;
+
+        if (bound > bounds.back()) {
+            bounds.push_back(bound);
+        }
+    }
+    if (td.size() > bounds.back()) {
+        bounds.push_back(td.size());
+    }
+
+    for (uint32_t c = 0; c + 1 < bounds.size(); c++) {
+        size_t from, to;
+        int fds[2];
+
+        cd->ChunkInput(samplerate, td.size(), bounds[c], bounds[c + 1], &from, &to);
+
+        if (pipe(fds) != 0) {
+            throw runtime_error("Failed to create a pipe");
+        }
+
+        pid_t pid = fork();
+
+        if (pid < 0) {
+            throw runtime_error("Failed to start a job");
+        }
+
+        if (pid == 0) {
+            ostringstream os;
+
+            close(fds[0]);
+            try {
+                ChordDetector::SaveChunk(cd->AnalyzeChunk(td.Sub(from, to - from), samplerate,
+                                                          td.size(), bounds[c], bounds[c + 1]),
+                                         os);
+            } catch (const exception &e) {
+                cerr << "Job " << c << " failed: " << e.what() << endl;
+                _exit(1);
+            }
+
+            string data = os.str();
+            for (size_t pos = 0; pos < data.size(); ) {
+                ssize_t written = write(fds[1], data.data() + pos, data.size() - pos);
+                if (written <= 0) {
+                    _exit(1);
+                }
+                pos += written;
+            }
+            _exit(0);
+        }
+
+        close(fds[1]);
+        children.push_back(make_pair(pid, fds[0]));
+    }
+
+    for (auto &child : children) {
+        string data;
+        char buf[4096];
+        ssize_t got;
+        int status;
+
+        while ((got = read(child.second, buf, sizeof(buf))) > 0) {
+            data.append(buf, got);
+        }
+        close(child.second);
+
+        if ((waitpid(child.first, &status, 0) != child.first) ||
+            !WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+        {
+            throw runtime_error("Chord recognition job failed");
+        }
+
+        istringstream is(data);
+        chunks.push_back(ChordDetector::LoadChunk(is));
+    }
+
+    cd->MergeChunks(chunks, td.size(), segments);
+}
+
+/**
+ * Have chords recognized by a running lmserver, see lmserver.cpp for the
+ * protocol. Samples are passed over shared memory rather than the socket.
+ */
+void __getSegmentsFromServer(const string &socketPath, amplitude_t *timeDomain,
+                             SF_INFO &sfinfo, std::vector<segment_t> &segments)
+{
+    struct sockaddr_un addr;
+    string shmName = "/lmclient-" + to_string(getpid());
+    size_t bytes = sfinfo.frames * sfinfo.channels * sizeof(amplitude_t);
+
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        throw invalid_argument("Socket path is too long");
+    }
+
+    int shm = shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (shm < 0) {
+        throw runtime_error("Failed to create shared memory");
+    }
+
+    void *pcm = MAP_FAILED;
+    if (ftruncate(shm, bytes) == 0) {
+        pcm = mmap(nullptr, bytes, PROT_WRITE, MAP_SHARED, shm, 0);
+    }
+    close(shm);
+    if (pcm == MAP_FAILED) {
+        shm_unlink(shmName.c_str());
+        throw runtime_error("Failed to map shared memory");
+    }
+    memcpy(pcm, timeDomain, bytes);
+    munmap(pcm, bytes);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if ((fd < 0) || (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0)) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        shm_unlink(shmName.c_str());
+        throw runtime_error("Failed to connect to " + socketPath);
+    }
+
+    ostringstream request;
+    request << "ANALYZE_SHM " << shmName << " " << sfinfo.frames << " " << sfinfo.channels
+            << " " << sfinfo.samplerate << " f64\n";
+
+    string data = request.str(), response;
+    for (size_t pos = 0; pos < data.size(); ) {
+        ssize_t written = send(fd, data.data() + pos, data.size() - pos, MSG_NOSIGNAL);
+        if (written <= 0) {
+            break;
+        }
+        pos += written;
+    }
+
+    /* segments come as soon as they are decoded, the status line is the last one */
+    char buf[4096];
+    ssize_t got;
+    while ((got = read(fd, buf, sizeof(buf))) > 0) {
+        response.append(buf, got);
+    }
+    close(fd);
+    shm_unlink(shmName.c_str());
+
+    istringstream lines(response);
+    string line, status;
+    while (getline(lines, line)) {
+        istringstream fields(line);
+        string type, chord;
+        segment_t s;
+
+        fields >> type;
+        if (type == "SEGMENT") {
+            fields >> s.startIdx >> s.endIdx >> s.silence >> chord;
+            s.chord = Chord(chord);
+            segments.push_back(s);
+        } else {
+            status = line;
+        }
+    }
+
+    if (status != "DONE") {
+        throw runtime_error("Server failed: " + (status.empty() ? "no response" : status));
+    }
+}
+
 void printChordInfo(amplitude_t *timeDomain, SF_INFO &sfinfo, uint32_t itemsCnt,
                     uint32_t n, const string &refChordStr, bool printPCP, int winSize,
-                    bool legacy, bool pcpCSV)
+                    bool legacy, const AnalysisConfig &config, const string &cacheDir,
+                    const string &modelPath, int jobs, const string &serverSocket,
+                    OutputWriter &writer)
 {
     if (legacy) {
         return __printChordInfoLegacy(timeDomain, sfinfo, itemsCnt, n, refChordStr,
                                       printPCP, winSize);
     }
 
-    ChordDetector *cd = new ChordDetector();
-    amplitude_t *channelTD = (amplitude_t *) malloc(sfinfo.frames * sizeof(amplitude_t));
+    /* the only detector of the process, decoding may take all the cores */
+    AnalysisConfig decode_config = config;
+
+    decode_config.viterbi_threads = 0;
+
+    ChordDetector *cd = new ChordDetector(decode_config);
+    /* first channel of the interleaved data */
+    SignalView channelTD(timeDomain, sfinfo.frames, 1, sfinfo.channels);
     std::vector<segment_t> segments;
     uint32_t fails = 0;
     chord_t refChord = refChordStr.empty() ? Chord() : Chord(refChordStr);
 
-    for (uint32_t i = 0; i < sfinfo.frames; i++) {
-        channelTD[i] = timeDomain[i * sfinfo.channels];
-    }
+    cd->SetFeatureCache(cacheDir);
+    cd->SetModel(modelPath);
 
     if (!printPCP) {
-        cd->getSegments(segments, channelTD, sfinfo.frames, sfinfo.samplerate);
-        for (uint32_t i = 0; i < segments.size(); i++) {
-            segment_t *s = &segments[i];
-            if (refChordStr.empty()) {
-                auto idxToSec = [&](int idx) {
-                    return Helpers::stdRound<float>(idx / (float) sfinfo.samplerate, 2);
-                };
-                cout << setw(3) << i << ": " << setw(3) << (s->silence ? "S" : s->chord.toString())
-                     << " [" << idxToSec(s->startIdx) << ", " << idxToSec(s->endIdx) << "]" << endl;
-            } else {
-                if (!s->silence && !refChord.match(s->chord)) {
-                    fails += (s->endIdx - s->startIdx + 1);
+        if (!serverSocket.empty()) {
+            __getSegmentsFromServer(serverSocket, timeDomain, sfinfo, segments);
+        } else if (jobs > 1) {
+            __getSegmentsInJobs(cd, channelTD, sfinfo.samplerate, jobs, segments);
+        } else {
+            cd->getSegments(segments, channelTD, sfinfo.samplerate);
+        }
+        if (refChordStr.empty()) {
+            writer.Begin({ "start", "end", "chord" }, true);
+            for (uint32_t i = 0; i < segments.size(); i++) {
+                writer.Segment(i, segments[i], sfinfo.samplerate);
+            }
+            writer.End();
+        } else {
+            for (auto &s : segments) {
+                if (!s.silence && !refChord.match(s.chord)) {
+                    fails += (s.endIdx - s.startIdx + 1);
                 }
             }
-        }
-
-        if (!refChordStr.empty()) {
             __printChordEvalScore(sfinfo.frames, fails);
         }
     } else {
-        chromagram_t chromagram = cd->GetChromagram(channelTD, sfinfo.frames, sfinfo.samplerate);
+        chromagram_t chromagram = cd->GetChromagram(channelTD, sfinfo.samplerate);
         uint32_t printCnt = (n == 0) ? chromagram.size() : std::min(static_cast<uint32_t>(chromagram.size()), n);
 
-        for (uint32_t i = 0; i < printCnt; i++) {
-            if (pcpCSV) {
-                cout << chromagram[i].toCSV() << endl;
-            } else {
-                cout << chromagram[i] << endl;
+        if (writer.Format() == OUTPUT_FORMAT_TEXT) {
+            for (uint32_t i = 0; i < printCnt; i++) {
+                cout << chromagram[i] << "\n";
+            }
+        } else {
+            /* raw values, their number depends on the library configuration */
+            writer.Begin({});
+            for (uint32_t i = 0; i < printCnt; i++) {
+                for (auto v : chromagram[i].getValues()) {
+                    writer.Value(v);
+                }
+                writer.EndRow();
             }
+            writer.End();
         }
 
         if (printCnt < chromagram.size()) {
-            cout << "Printed " << printCnt << " / " << chromagram.size() << endl;
+            /* keeps data formats parsable */
+            (writer.Format() == OUTPUT_FORMAT_TEXT ? cout : cerr)
+                << "Printed " << printCnt << " / " << chromagram.size() << endl;
         }
     }
 
-    free(channelTD);
     delete cd;
 }
 
@@ -443,6 +1001,24 @@ void dumpTemplates()
     delete c;
 }
 
+void printStats(const stats_t &stats)
+{
+    if (stats.empty()) {
+        cout << "No statistics collected, the library has to be built with CFG_STATS=1" << endl;
+        return;
+    }
+
+    cout << endl << left << setw(16) << "Stage" << right << setw(8) << "Calls"
+         << setw(12) << "Time, ms" << setw(12) << "Frames" << setw(16) << "Allocated, KiB"
+         << endl;
+
+    for (auto &s : stats) {
+        cout << left << setw(16) << s.name << right << setw(8) << s.calls
+             << setw(12) << fixed << setprecision(2) << s.wall_ns / 1e6
+             << setw(12) << s.frames << setw(16) << s.bytes / 1024 << endl;
+    }
+}
+
 void usage()
 {
     cout << "Usage:\n"
@@ -466,11 +1042,32 @@ void usage()
          << "\t--pcp\tprint Pitch Class Profile\n"
          << "\t--pcpcsv\tprint raw pitch class profile values in CSV format.\n"
          << "\t-w\twindow size in samples - length of blocks to pass for analysis.\n"
-         << "\t\tUsed with -c and --pcp\n"
+         << "\t\tUsed with -c and --pcp. With -f prints the spectrum window by window\n"
+         << "\t\tinstead of transforming the whole file at once\n"
+         << "\t--hop <n>\thop between -f -w windows in samples, half of the window by default\n"
+         << "\t--avg\taverage -f -w windows into a single spectrum (Welch's method)\n"
          << "\t-n <iterations>\tnumber of FFT windows to analyse. Used with -c or --pcp\n"
          << "\t-b\tdetect BPM of the input audio\n"
          << "\t\tIn combination with -t prints peaks at the beat indices along with time domain.\n"
+         << "\t--beats\ttrack beats block by block and print their timestamps in seconds\n"
+         << "\t--onsets\tprint onset timestamps in seconds and their strength. Onsets are\n"
+         << "\t\tdetected in the spectrogram chords are recognised from\n"
          << "\t--tplsdump\tdump all chord templates used for processing.\n"
+         << "\t--stats\tprint time, frames and memory allocated per processing stage.\n"
+         << "\t\tRequires the library built with CFG_STATS=1\n"
+         << "\t--cache <dir>\tkeep chromagrams in <dir> and reuse them on subsequent runs.\n"
+         << "\t\tUsed with -c\n"
+         << "\t--preset <name>\tanalysis profile: fast, balanced, accurate or\n"
+            "\t\tlowlatency, see AnalysisConfig. Used with -c and --onsets\n"
+         << "\t--model <file>\tdecode with the chord model trained by lmtrain. Used with -c\n"
+         << "\t--jobs <n>\tsplit the recording into <n> chunks analysed by separate\n"
+         << "\t\tprocesses. Result is the same as without splitting. Used with -c\n"
+         << "\t--format <fmt>\toutput format of -t, -e, -f, --beats, --onsets, -c and --pcp: text (default),\n"
+            "\t\tcsv, json, bin (float32 values) or lab (MIREX chord annotation, -c only)\n"
+         << "\t--server <socket>\thave chords recognized by lmserver listening on <socket>.\n"
+         << "\t\tUsed with -c\n"
+         << "\t--trace <dir>\tdump spectrogram, chromagram, score matrix and Viterbi path\n"
+         << "\t\tto <dir> in NumPy .npy format\n"
          << "\t--legacy\tuse legacy version of the feature. Can't be used a standalone option."
          << endl;
 
@@ -0,0 +1,263 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    lmeval.cpp
+ * @brief   Evaluation of chord recognition over an annotated dataset
+ *
+ * The dataset is a list of recordings, one per line. A line may give the
+ * annotation after a tab, otherwise it is looked up next to the recording
+ * with the .lab extension. Recordings are analysed in parallel, every
+ * worker keeps its own ChordDetector.
+ *
+ * Scores of the whole dataset are weighted by the annotated duration of
+ * every recording. Speed is the duration of the audio divided by the CPU
+ * time chord recognition took on the worker, reading of the files is not
+ * included. Workers decode in a single thread each, so that the CPU time
+ * of a worker is all the recognition took.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sndfile.h>
+#include <string.h>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+#include "chord_detector.h"
+#include "chord_eval.h"
+
+using namespace anatomist;
+using namespace std;
+
+struct track_t : dataset_item_t {
+    bool            done = false;
+    string          error;
+    double          seconds = 0;    /**< duration of the audio */
+    double          elapsed = 0;    /**< CPU seconds chord recognition took */
+    eval_result_t   res;
+};
+
+/**
+ * CPU time of the calling thread in seconds
+ */
+static double threadCpuTime()
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        throw runtime_error("failed to get the thread CPU time");
+    }
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void evaluate(ChordDetector &cd, track_t &track)
+{
+    SF_INFO sfinfo;
+    SNDFILE *sf;
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    if (!(sf = sf_open(track.audio.c_str(), SFM_READ, &sfinfo))) {
+        throw runtime_error("failed to open " + track.audio);
+    }
+
+    vector<double> buf(sfinfo.frames * sfinfo.channels);
+    sf_count_t read = sf_read_double(sf, buf.data(), buf.size());
+
+    sf_close(sf);
+    if (read <= 0) {
+        throw runtime_error("could not read " + track.audio);
+    }
+
+    lab_t ref = ChordEval::ReadLab(track.lab);
+    vector<segment_t> segments;
+    SignalView td(buf.data(), read / sfinfo.channels, 1, sfinfo.channels);
+
+    double start = threadCpuTime();
+    cd.getSegments(segments, td, sfinfo.samplerate);
+
+    track.seconds = 1.0 * td.size() / sfinfo.samplerate;
+    track.elapsed = threadCpuTime() - start;
+    track.res = ChordEval::Evaluate(ref, ChordEval::FromSegments(segments, sfinfo.samplerate));
+}
+
+static void worker(vector<track_t> *tracks, atomic<size_t> *next, const AnalysisConfig *config,
+                   const string *cacheDir, const string *modelPath)
+{
+    ChordDetector cd(*config);
+    size_t i;
+
+    cd.SetFeatureCache(*cacheDir);
+    cd.SetModel(*modelPath);
+
+    while ((i = (*next)++) < tracks->size()) {
+        track_t &track = (*tracks)[i];
+
+        try {
+            evaluate(cd, track);
+            track.done = true;
+        } catch (exception &e) {
+            track.error = e.what();
+        }
+    }
+}
+
+static void printScores(const eval_result_t &res)
+{
+    cout << setw(9) << res.PCSet() << setw(9) << res.Root() << setw(9) << res.MajMin()
+         << setw(9) << res.Sevenths() << setw(9) << res.Seg();
+}
+
+static void usage()
+{
+    cout << "Usage:\n"
+         << "\tlmeval [-j <n>] [--preset <name>] [--cache <dir>] [--model <file>] <list file>\n"
+         << endl;
+
+    cout << "\nOptions:\n"
+         << "\t-j <n>\tnumber of recordings analysed at once. Defaults to the number\n"
+         << "\t\tof hardware threads\n"
+         << "\t--preset <name>\tanalysis profile: fast, balanced, accurate or\n"
+         << "\t\tlowlatency. Defaults to the compile-time configuration\n"
+         << "\t--cache <dir>\tkeep chromagrams in <dir> and reuse them on subsequent runs\n"
+         << "\t--model <file>\tdecode with the chord model trained by lmtrain\n"
+         << "\t-h\tprint this help\n"
+         << endl;
+
+    cout << "\nEvery line of <list file> is a recording, optionally followed by a tab\n"
+         << "and its .lab annotation. By default the annotation is the recording\n"
+         << "path with the .lab extension." << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t workers = thread::hardware_concurrency();
+    string cacheDir;
+    string modelPath;
+    AnalysisConfig config;
+
+    for (int i = 1; i < argc - 1; i++) {
+        /* every option takes a value, the last argument is the list */
+        if (i + 1 >= argc - 1) {
+            usage();
+            return 1;
+        }
+
+        if (strcmp(argv[i], "-j") == 0) {
+            workers = atoi(argv[++i]);
+            if (workers == 0) { usage(); return 1; }
+        } else if (strcmp(argv[i], "--preset") == 0) {
+            try {
+                config = AnalysisConfig::Preset(argv[++i]);
+            } catch (exception &e) {
+                cerr << e.what() << endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            cacheDir = string(argv[++i]);
+        } else if (strcmp(argv[i], "--model") == 0) {
+            modelPath = string(argv[++i]);
+        } else {
+            cerr << "Unrecognized option: " << argv[i] << endl;
+            usage();
+            return 1;
+        }
+    }
+
+    if ((argc < 2) || (argv[argc - 1][0] == '-')) {
+        usage();
+        return (argc == 2) && (strcmp(argv[1], "-h") == 0) ? 0 : 1;
+    }
+
+    vector<track_t> tracks;
+
+    try {
+        for (auto &item : ChordEval::ReadList(argv[argc - 1])) {
+            track_t track;
+
+            static_cast<dataset_item_t &>(track) = item;
+            tracks.push_back(track);
+        }
+        if (!modelPath.empty()) {
+            /* fail early rather than in every worker, e.g. with a model of another preset */
+            ChordDetector(config).SetModel(modelPath);
+        }
+    } catch (exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    workers = max(1U, min<uint32_t>(workers, tracks.size()));
+    /* all the work of a recording is on its worker thread, see above */
+    config.viterbi_threads = 1;
+
+    atomic<size_t> next(0);
+    vector<thread> pool;
+    auto start = chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < workers; i++) {
+        pool.emplace_back(worker, &tracks, &next, &config, &cacheDir, &modelPath);
+    }
+    for (auto &t : pool) {
+        t.join();
+    }
+
+    chrono::duration<double> wall = chrono::steady_clock::now() - start;
+    eval_result_t total;
+    double seconds = 0, elapsed = 0;
+    uint32_t failed = 0;
+
+    cout << fixed << setprecision(4);
+    cout << "#" << setw(8) << "pcset" << setw(9) << "root" << setw(9) << "majmin"
+         << setw(9) << "sevenths" << setw(9) << "seg" << setw(12) << "x realtime"
+         << "  recording" << endl;
+
+    for (auto &track : tracks) {
+        if (!track.done) {
+            cerr << track.audio << ": " << track.error << endl;
+            failed++;
+            continue;
+        }
+
+        printScores(track.res);
+        cout << setw(12) << setprecision(1) << track.seconds / track.elapsed << setprecision(4)
+             << "  " << track.audio << endl;
+
+        total += track.res;
+        seconds += track.seconds;
+        elapsed += track.elapsed;
+    }
+
+    cout << "\n" << (tracks.size() - failed) << " recordings, " << setprecision(1) << seconds
+         << " s of audio, " << total.duration << " s annotated" << setprecision(4) << endl;
+    cout << "#" << setw(8) << "pcset" << setw(9) << "root" << setw(9) << "majmin"
+         << setw(9) << "sevenths" << setw(9) << "seg" << endl;
+    printScores(total);
+    cout << endl;
+
+    cout << "\nSpeed: " << setprecision(1) << (elapsed > 0 ? seconds / elapsed : 0)
+         << " x realtime per CPU, " << seconds / wall.count() << " x realtime with "
+         << workers << " workers" << endl;
+
+    return (failed > 0) ? 2 : 0;
+}
@@ -0,0 +1,452 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    lmserver.cpp
+ * @brief   Chord recognition daemon serving requests over a UNIX domain socket
+ *
+ * Every worker keeps its own ChordDetector, so templates and time-frequency
+ * transforms are built once rather than on every request. A connection
+ * carries a single request line:
+ *
+ *   ANALYZE <path>
+ *   ANALYZE_SHM <name> <frames> <channels> <samplerate> <f32|f64>
+ *
+ * The latter reads interleaved PCM from the POSIX shared memory object
+ * <name>, which stays owned by the client. The first channel is analysed
+ * in both cases. Segments are sent back as soon as they are decoded:
+ *
+ *   SEGMENT <start sample> <end sample> <silence 0|1> <chord in Harte syntax>
+ *
+ * and the response is terminated by either DONE or ERROR <message>.
+ */
+
+#include <condition_variable>
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <iostream>
+#include <mutex>
+#include <signal.h>
+#include <sndfile.h>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "chord_detector.h"
+#include "lmhelpers.h"
+
+#define QUEUE_SIZE_DEFAULT  16
+#define REQUEST_LEN_MAX     4096
+
+using namespace anatomist;
+using namespace std;
+
+/**
+ * Connections accepted but not picked up by a worker yet
+ *
+ * Push() blocks while the queue is full, so that a busy server stops
+ * accepting and new clients wait in the listen backlog.
+ */
+class ConnectionQueue {
+    public:
+        ConnectionQueue(size_t capacity) : capacity_(capacity), closed_(false) {}
+
+        bool Push(int fd)
+        {
+            unique_lock<mutex> lock(mutex_);
+
+            not_full_.wait(lock, [this] { return closed_ || (fds_.size() < capacity_); });
+            if (closed_) {
+                return false;
+            }
+            fds_.push_back(fd);
+            not_empty_.notify_one();
+
+            return true;
+        }
+
+        bool Pop(int *fd)
+        {
+            unique_lock<mutex> lock(mutex_);
+
+            not_empty_.wait(lock, [this] { return closed_ || !fds_.empty(); });
+            if (fds_.empty()) {
+                return false;
+            }
+            *fd = fds_.front();
+            fds_.pop_front();
+            not_full_.notify_one();
+
+            return true;
+        }
+
+        /**
+         * Wake everybody up, connections still queued are served anyway
+         */
+        void Close()
+        {
+            lock_guard<mutex> lock(mutex_);
+
+            closed_ = true;
+            not_full_.notify_all();
+            not_empty_.notify_all();
+        }
+
+    private:
+        size_t capacity_;
+        bool closed_;
+        deque<int> fds_;
+        mutex mutex_;
+        condition_variable not_full_;
+        condition_variable not_empty_;
+};
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onStopSignal(int)
+{
+    stopRequested = 1;
+}
+
+static bool sendAll(int fd, const string &s)
+{
+    size_t sent = 0;
+
+    while (sent < s.size()) {
+        ssize_t res = send(fd, s.data() + sent, s.size() - sent, MSG_NOSIGNAL);
+        if (res < 0 && errno == EINTR) {
+            continue;
+        }
+        if (res <= 0) {
+            return false;
+        }
+        sent += res;
+    }
+
+    return true;
+}
+
+static bool recvLine(int fd, string &line)
+{
+    char c;
+
+    line.clear();
+    while (line.size() < REQUEST_LEN_MAX) {
+        ssize_t res = recv(fd, &c, 1, 0);
+        if (res < 0 && errno == EINTR) {
+            continue;
+        }
+        if (res <= 0) {
+            return false;
+        }
+        if (c == '\n') {
+            return true;
+        }
+        line.push_back(c);
+    }
+
+    return false;
+}
+
+/**
+ * Streams segments to the client as the detector reports them
+ */
+class SegmentSender : public ChordDetector::ResultsListener {
+    public:
+        SegmentSender(int fd) : fd_(fd) {}
+
+        virtual void onPreprocessingProgress(float progress)
+        {
+            UNUSED(progress);
+        }
+
+        virtual void onChordSegmentProcessed(segment_t &s, float progress)
+        {
+            ostringstream msg;
+
+            UNUSED(progress);
+            msg << "SEGMENT " << s.startIdx << " " << s.endIdx << " " << s.silence << " "
+                << s.chord.toHarte() << "\n";
+            if (!sendAll(fd_, msg.str())) {
+                /* nobody to send the rest to, stops the analysis */
+                throw runtime_error("client has disconnected");
+            }
+        }
+
+        virtual void onChordAnalysisFinished() {}
+
+    private:
+        int fd_;
+};
+
+static void analyzeFile(ChordDetector &cd, const string &path, SegmentSender &sender)
+{
+    SF_INFO sfinfo;
+    SNDFILE *sf;
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    if (!(sf = sf_open(path.c_str(), SFM_READ, &sfinfo))) {
+        throw runtime_error("failed to open " + path);
+    }
+
+    vector<double> buf(sfinfo.frames * sfinfo.channels);
+    sf_count_t read = sf_read_double(sf, buf.data(), buf.size());
+
+    sf_close(sf);
+    if (read <= 0) {
+        throw runtime_error("could not read " + path);
+    }
+
+    cd.getSegments(SignalView(buf.data(), read / sfinfo.channels, 1, sfinfo.channels),
+                   sfinfo.samplerate, &sender);
+}
+
+static void analyzeShm(ChordDetector &cd, istringstream &args, SegmentSender &sender)
+{
+    string name, format;
+    size_t frames = 0;
+    uint32_t channels = 0, samplerate = 0;
+    struct stat st;
+
+    if (!(args >> name >> frames >> channels >> samplerate >> format) ||
+        (frames == 0) || (channels == 0) || (samplerate == 0) ||
+        ((format != "f32") && (format != "f64")))
+    {
+        throw invalid_argument("malformed ANALYZE_SHM request");
+    }
+
+    size_t bytes = frames * channels * ((format == "f32") ? sizeof(float) : sizeof(double));
+    int shm = shm_open(name.c_str(), O_RDONLY, 0);
+
+    if (shm < 0) {
+        throw runtime_error("failed to open shared memory " + name);
+    }
+    if ((fstat(shm, &st) != 0) || (static_cast<size_t>(st.st_size) < bytes)) {
+        close(shm);
+        throw runtime_error("shared memory " + name + " is smaller than the request says");
+    }
+
+    void *pcm = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, shm, 0);
+    close(shm);
+    if (pcm == MAP_FAILED) {
+        throw runtime_error("failed to map shared memory " + name);
+    }
+
+    try {
+        if (format == "f32") {
+            cd.getSegments(SignalView(static_cast<const float *>(pcm), frames, 1, channels),
+                           samplerate, &sender);
+        } else {
+            cd.getSegments(SignalView(static_cast<const double *>(pcm), frames, 1, channels),
+                           samplerate, &sender);
+        }
+    } catch (...) {
+        munmap(pcm, bytes);
+        throw;
+    }
+    munmap(pcm, bytes);
+}
+
+static void serve(ChordDetector &cd, int fd)
+{
+    string line, request;
+
+    if (!recvLine(fd, line)) {
+        return;
+    }
+
+    istringstream args(line);
+    SegmentSender sender(fd);
+
+    args >> request;
+    try {
+        if (request == "ANALYZE") {
+            string path;
+
+            getline(args >> ws, path);
+            if (path.empty()) {
+                throw invalid_argument("malformed ANALYZE request");
+            }
+            analyzeFile(cd, path, sender);
+        } else if (request == "ANALYZE_SHM") {
+            analyzeShm(cd, args, sender);
+        } else {
+            throw invalid_argument("unknown request " + request);
+        }
+        sendAll(fd, "DONE\n");
+    } catch (exception &e) {
+        sendAll(fd, string("ERROR ") + e.what() + "\n");
+    }
+}
+
+static void worker(ConnectionQueue *queue, const vector<uint32_t> *rates, const string *cacheDir)
+{
+    ChordDetector cd;
+    int fd;
+
+    cd.SetFeatureCache(*cacheDir);
+    for (auto sr : *rates) {
+        cd.Prepare(sr);
+    }
+
+    while (queue->Pop(&fd)) {
+        serve(cd, fd);
+        close(fd);
+    }
+}
+
+static void usage()
+{
+    cout << "Usage:\n"
+         << "\tlmserver [--workers <n>] [--queue <n>] [--rate <sr>]... [--cache <dir>] <socket>\n"
+         << endl;
+
+    cout << "\nOptions:\n"
+         << "\t--workers <n>\tnumber of requests analysed at once. Defaults to the number\n"
+         << "\t\tof hardware threads\n"
+         << "\t--queue <n>\tnumber of accepted requests waiting for a worker before\n"
+         << "\t\tnew connections are held back. Defaults to " << QUEUE_SIZE_DEFAULT << "\n"
+         << "\t--rate <sr>\tsample rate to have the models ready for at startup.\n"
+         << "\t\tCan be repeated, defaults to 44100 and 48000\n"
+         << "\t--cache <dir>\tkeep chromagrams in <dir> and reuse them on subsequent requests\n"
+         << "\t-h\tprint this help\n"
+         << endl;
+
+    cout << "\nRequests are served with lmclient --server <socket> -c <filename>" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t workers = thread::hardware_concurrency();
+    size_t queueSize = QUEUE_SIZE_DEFAULT;
+    vector<uint32_t> rates;
+    string cacheDir;
+
+    for (int i = 1; i < argc - 1; i++) {
+        /* every option takes a value, the last argument is the socket */
+        if (i + 1 >= argc - 1) {
+            usage();
+            return 1;
+        }
+
+        if (strcmp(argv[i], "--workers") == 0) {
+            workers = atoi(argv[++i]);
+            if (workers == 0) { usage(); return 1; }
+        } else if (strcmp(argv[i], "--queue") == 0) {
+            queueSize = atoi(argv[++i]);
+            if (queueSize == 0) { usage(); return 1; }
+        } else if (strcmp(argv[i], "--rate") == 0) {
+            rates.push_back(atoi(argv[++i]));
+            if (rates.back() == 0) { usage(); return 1; }
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            cacheDir = string(argv[++i]);
+        } else {
+            cerr << "Unrecognized option: " << argv[i] << endl;
+            usage();
+            return 1;
+        }
+    }
+
+    if ((argc < 2) || (argv[argc - 1][0] == '-')) {
+        usage();
+        return (argc == 2) && (strcmp(argv[1], "-h") == 0) ? 0 : 1;
+    }
+
+    if (rates.empty()) {
+        rates = {44100, 48000};
+    }
+    workers = max(workers, 1U);
+
+    struct sockaddr_un addr;
+    string socketPath(argv[argc - 1]);
+
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        cerr << "Socket path is too long" << endl;
+        return 1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        cerr << "Failed to create socket: " << strerror(errno) << endl;
+        return 1;
+    }
+
+    /* left over from a previous run which has not exited cleanly */
+    unlink(socketPath.c_str());
+    if ((bind(listener, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) ||
+        (listen(listener, SOMAXCONN) != 0))
+    {
+        cerr << "Failed to listen on " << socketPath << ": " << strerror(errno) << endl;
+        close(listener);
+        return 1;
+    }
+
+    /* no SA_RESTART, so that accept() returns once stop is requested */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onStopSignal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    ConnectionQueue queue(queueSize);
+    vector<thread> pool;
+
+    for (uint32_t i = 0; i < workers; i++) {
+        pool.emplace_back(worker, &queue, &rates, &cacheDir);
+    }
+
+    cerr << "Serving on " << socketPath << " with " << workers << " workers" << endl;
+
+    while (!stopRequested) {
+        int fd = accept(listener, nullptr, nullptr);
+
+        if (fd < 0) {
+            if ((errno == EINTR) || (errno == ECONNABORTED)) {
+                continue;
+            }
+            cerr << "accept() failed: " << strerror(errno) << endl;
+            break;
+        }
+        if (!queue.Push(fd)) {
+            close(fd);
+        }
+    }
+
+    queue.Close();
+    for (auto &t : pool) {
+        t.join();
+    }
+
+    close(listener);
+    unlink(socketPath.c_str());
+
+    return 0;
+}
@@ -0,0 +1,260 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    lmtrain.cpp
+ * @brief   Training of the chord model over an annotated dataset
+ *
+ * The dataset is the same list lmeval takes. Recordings are analysed up to
+ * the chromagram by a pool of workers, every one of them keeps its own
+ * ChordDetector and accumulates statistics into its own ChordModelTrainer.
+ * Those are added up once all the recordings are done, so workers never
+ * wait for each other and only one recording per worker is kept in memory.
+ *
+ * With --cache the chromagrams are kept on disk, so that training again
+ * with other annotations or smoothing skips the spectral analysis.
+ *
+ * The model is tied to the analysis parameters of its chromagrams, which
+ * are chosen with --preset and stored in the model file. Detectors with
+ * other parameters refuse to load it.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sndfile.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "chord_detector.h"
+#include "chord_eval.h"
+#include "chord_model.h"
+
+using namespace anatomist;
+using namespace std;
+
+struct worker_ctx_t {
+    const vector<dataset_item_t>    *items;
+    atomic<size_t>                  *next;
+    const string                    *cacheDir;
+    const AnalysisConfig            *config;
+    mutex                           *log;
+    ChordModelTrainer               trainer;
+    double                          seconds = 0;    /**< duration of the audio */
+    double                          elapsed = 0;    /**< seconds the analysis took */
+    uint32_t                        failed = 0;
+};
+
+static void train(ChordDetector &cd, const dataset_item_t &item, worker_ctx_t *ctx)
+{
+    SF_INFO sfinfo;
+    SNDFILE *sf;
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    if (!(sf = sf_open(item.audio.c_str(), SFM_READ, &sfinfo))) {
+        throw runtime_error("failed to open " + item.audio);
+    }
+
+    vector<double> buf(sfinfo.frames * sfinfo.channels);
+    sf_count_t read = sf_read_double(sf, buf.data(), buf.size());
+
+    sf_close(sf);
+    if (read <= 0) {
+        throw runtime_error("could not read " + item.audio);
+    }
+
+    lab_t lab = ChordEval::ReadLab(item.lab);
+    SignalView td(buf.data(), read / sfinfo.channels, 1, sfinfo.channels);
+    uint32_t interval = 0;
+    vector<chord_t> chords;
+    vector<bool> known;
+
+    auto start = chrono::steady_clock::now();
+    chromagram_t chromagram = cd.GetChromagram(td, sfinfo.samplerate, &interval);
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    ChordEval::FrameChords(lab, chromagram.size(), 1.0 * interval / sfinfo.samplerate,
+                           &chords, &known);
+    ctx->trainer.Add(chromagram, chords, known);
+
+    ctx->seconds += 1.0 * td.size() / sfinfo.samplerate;
+    ctx->elapsed += elapsed.count();
+}
+
+static void worker(worker_ctx_t *ctx)
+{
+    ChordDetector cd(*ctx->config);
+    size_t i;
+
+    cd.SetFeatureCache(*ctx->cacheDir);
+
+    while ((i = (*ctx->next)++) < ctx->items->size()) {
+        const dataset_item_t &item = (*ctx->items)[i];
+        string error;
+
+        try {
+            train(cd, item, ctx);
+        } catch (exception &e) {
+            error = e.what();
+            ctx->failed++;
+        }
+
+        lock_guard<mutex> lock(*ctx->log);
+
+        cerr << "[" << (i + 1) << "/" << ctx->items->size() << "] " << item.audio;
+        if (!error.empty()) {
+            cerr << ": " << error;
+        }
+        cerr << endl;
+    }
+}
+
+static void usage()
+{
+    cout << "Usage:\n"
+         << "\tlmtrain [-j <n>] [--preset <name>] [--cache <dir>] [--smoothing <count>]\n"
+         << "\t\t-o <model file> <list file>\n"
+         << endl;
+
+    cout << "\nOptions:\n"
+         << "\t-o <file>\twrite the trained model to <file>\n"
+         << "\t-j <n>\tnumber of recordings analysed at once. Defaults to the number\n"
+         << "\t\tof hardware threads\n"
+         << "\t--preset <name>\tanalysis profile: fast, balanced, accurate or\n"
+         << "\t\tlowlatency. Defaults to the compile-time configuration.\n"
+         << "\t\tThe model is only used with the same profile\n"
+         << "\t--cache <dir>\tkeep chromagrams in <dir> and reuse them on subsequent runs\n"
+         << "\t--smoothing <count>\tcount added to every initial state and transition.\n"
+         << "\t\tDefaults to 1\n"
+         << "\t-h\tprint this help\n"
+         << endl;
+
+    cout << "\n<list file> is the same as lmeval takes. The model is used with\n"
+         << "lmclient --model, lmeval --model or ChordDetector::SetModel(), with\n"
+         << "the same --preset." << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t workers = thread::hardware_concurrency();
+    string cacheDir, outPath;
+    double smoothing = 1;
+    AnalysisConfig config;
+
+    for (int i = 1; i < argc - 1; i++) {
+        /* every option takes a value, the last argument is the list */
+        if (i + 1 >= argc - 1) {
+            usage();
+            return 1;
+        }
+
+        if (strcmp(argv[i], "-j") == 0) {
+            workers = atoi(argv[++i]);
+            if (workers == 0) { usage(); return 1; }
+        } else if (strcmp(argv[i], "--preset") == 0) {
+            try {
+                config = AnalysisConfig::Preset(argv[++i]);
+            } catch (exception &e) {
+                cerr << e.what() << endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-o") == 0) {
+            outPath = string(argv[++i]);
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            cacheDir = string(argv[++i]);
+        } else if (strcmp(argv[i], "--smoothing") == 0) {
+            smoothing = atof(argv[++i]);
+            if (smoothing < 0) { usage(); return 1; }
+        } else {
+            cerr << "Unrecognized option: " << argv[i] << endl;
+            usage();
+            return 1;
+        }
+    }
+
+    if ((argc < 2) || (argv[argc - 1][0] == '-') || outPath.empty()) {
+        usage();
+        return (argc == 2) && (strcmp(argv[1], "-h") == 0) ? 0 : 1;
+    }
+
+    vector<dataset_item_t> items;
+
+    try {
+        items = ChordEval::ReadList(argv[argc - 1]);
+    } catch (exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    workers = max(1U, min<uint32_t>(workers, items.size()));
+
+    string params = ChordDetector::FeatureParams(config);
+    atomic<size_t> next(0);
+    mutex log;
+    vector<worker_ctx_t> ctxs(workers);
+    vector<thread> pool;
+    auto start = chrono::steady_clock::now();
+
+    for (auto &ctx : ctxs) {
+        ctx.items = &items;
+        ctx.next = &next;
+        ctx.cacheDir = &cacheDir;
+        ctx.config = &config;
+        ctx.log = &log;
+        ctx.trainer = ChordModelTrainer(params);
+        pool.emplace_back(worker, &ctx);
+    }
+    for (auto &t : pool) {
+        t.join();
+    }
+
+    chrono::duration<double> wall = chrono::steady_clock::now() - start;
+    ChordModelTrainer total(params);
+    double seconds = 0, elapsed = 0;
+    uint32_t failed = 0;
+
+    for (auto &ctx : ctxs) {
+        total += ctx.trainer;
+        seconds += ctx.seconds;
+        elapsed += ctx.elapsed;
+        failed += ctx.failed;
+    }
+
+    cout << fixed << setprecision(1);
+    cout << total.Recordings() << " recordings, " << failed << " failed, "
+         << seconds / 3600 << " h of audio, " << total.Frames() << " annotated frames" << endl;
+    cout << "Speed: " << (elapsed > 0 ? seconds / elapsed : 0) << " x realtime per worker, "
+         << seconds / wall.count() << " x realtime with " << workers << " workers" << endl;
+
+    try {
+        ChordModel model = total.Model(smoothing);
+
+        model.Save(outPath);
+        cout << "Model of " << model.Size() << " states written to " << outPath << endl;
+    } catch (exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return (failed > 0) ? 2 : 0;
+}
@@ -0,0 +1,274 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    output_writer.cpp
+ * @brief   Buffered writers of the client results in several formats
+ */
+
+#include <cmath>
+#include <stdexcept>
+#include <string.h>
+
+#include "lmhelpers.h"
+#include "output_writer.h"
+
+/**
+ * printf() %g never needs more for a double
+ */
+#define DOUBLE_CHARS_MAX    32
+
+/**
+ * Text keeps the std::cout default, the rest of the formats are for
+ * further processing and get more digits
+ */
+#define PRECISION_TEXT      6
+#define PRECISION_DATA      8
+
+using namespace anatomist;
+using namespace std;
+
+OutputBuffer::OutputBuffer(FILE *f) : f_(f), buf_(OUTPUT_BUFFER_SIZE), len_(0) {}
+
+OutputBuffer::~OutputBuffer()
+{
+    Flush();
+}
+
+void OutputBuffer::Write(const char *data, size_t len)
+{
+    if (len_ + len > buf_.size()) {
+        Flush();
+        if (len > buf_.size()) {
+            fwrite(data, 1, len, f_);
+            return;
+        }
+    }
+    memcpy(buf_.data() + len_, data, len);
+    len_ += len;
+}
+
+void OutputBuffer::WriteUInt(uint64_t v)
+{
+    char digits[20];
+    int n = 0;
+
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v > 0);
+
+    if (len_ + n > buf_.size()) {
+        Flush();
+    }
+    while (n > 0) {
+        buf_[len_++] = digits[--n];
+    }
+}
+
+void OutputBuffer::WriteDouble(double v, int precision)
+{
+    if (len_ + DOUBLE_CHARS_MAX > buf_.size()) {
+        Flush();
+    }
+    len_ += snprintf(buf_.data() + len_, DOUBLE_CHARS_MAX, "%.*g", precision, v);
+}
+
+void OutputBuffer::Flush()
+{
+    if (len_ > 0) {
+        fwrite(buf_.data(), 1, len_, f_);
+        len_ = 0;
+    }
+    fflush(f_);
+}
+
+OutputWriter::OutputWriter(output_format_t format, FILE *f) :
+    format_(format),
+    out_(f),
+    precision_((format == OUTPUT_FORMAT_TEXT) ? PRECISION_TEXT : PRECISION_DATA),
+    rows_(0),
+    cells_(0),
+    segments_(false)
+{
+}
+
+output_format_t OutputWriter::ParseFormat(const string &name)
+{
+    if (name == "text") {
+        return OUTPUT_FORMAT_TEXT;
+    } else if (name == "csv") {
+        return OUTPUT_FORMAT_CSV;
+    } else if (name == "json") {
+        return OUTPUT_FORMAT_JSON;
+    } else if (name == "bin") {
+        return OUTPUT_FORMAT_BIN;
+    } else if (name == "lab") {
+        return OUTPUT_FORMAT_LAB;
+    }
+
+    throw invalid_argument("Unknown output format " + name);
+}
+
+void OutputWriter::Begin(const vector<string> &columns, bool segments)
+{
+    if ((format_ == OUTPUT_FORMAT_LAB) && !segments) {
+        throw invalid_argument("lab format holds chord segments only");
+    }
+    if ((format_ == OUTPUT_FORMAT_BIN) && segments) {
+        throw invalid_argument("bin format can't hold chord segments");
+    }
+
+    rows_ = 0;
+    cells_ = 0;
+    segments_ = segments;
+
+    if ((format_ == OUTPUT_FORMAT_CSV) && !columns.empty()) {
+        for (size_t i = 0; i < columns.size(); i++) {
+            out_.Write(columns[i]);
+            out_.Write((i + 1 < columns.size()) ? ',' : '\n');
+        }
+    } else if (format_ == OUTPUT_FORMAT_JSON) {
+        if (segments) {
+            out_.Write('[');
+        } else {
+            out_.Write("{\"columns\":[");
+            for (size_t i = 0; i < columns.size(); i++) {
+                out_.Write(i ? ",\"" : "\"");
+                out_.Write(columns[i]);
+                out_.Write('"');
+            }
+            out_.Write("],\"rows\":[");
+        }
+    }
+}
+
+void OutputWriter::Separator_()
+{
+    if (format_ == OUTPUT_FORMAT_BIN) {
+        return;
+    }
+
+    if (cells_ == 0) {
+        if (format_ == OUTPUT_FORMAT_JSON) {
+            out_.Write(rows_ ? ",[" : "[");
+        }
+    } else {
+        out_.Write(',');
+    }
+    cells_++;
+}
+
+void OutputWriter::Index(uint64_t idx)
+{
+    if (format_ == OUTPUT_FORMAT_BIN) {
+        return;
+    }
+
+    Separator_();
+    out_.WriteUInt(idx);
+}
+
+void OutputWriter::Value(double v)
+{
+    if (format_ == OUTPUT_FORMAT_BIN) {
+        out_.WriteFloat32(v);
+        return;
+    }
+
+    Separator_();
+    if ((format_ == OUTPUT_FORMAT_JSON) && !isfinite(v)) {
+        /* JSON has no infinities, e.g. log magnitude of an empty bin */
+        out_.Write("null");
+    } else {
+        out_.WriteDouble(v, precision_);
+    }
+}
+
+void OutputWriter::EndRow()
+{
+    if (format_ == OUTPUT_FORMAT_JSON) {
+        out_.Write(']');
+    } else if (format_ != OUTPUT_FORMAT_BIN) {
+        out_.Write('\n');
+    }
+    cells_ = 0;
+    rows_++;
+}
+
+void OutputWriter::Segment(uint32_t idx, const segment_t &s, uint32_t samplerate)
+{
+    /* the end sample is inclusive, machine readable formats get contiguous bounds */
+    double start = s.startIdx / static_cast<double>(samplerate);
+    double end = (s.endIdx + 1) / static_cast<double>(samplerate);
+    string label = s.silence ? "N" : s.chord.toHarte();
+    char buf[64];
+
+    switch (format_) {
+    case OUTPUT_FORMAT_TEXT: {
+        auto idxToSec = [&](uint32_t i) {
+            return Helpers::stdRound<float>(i / (float) samplerate, 2);
+        };
+        string chord = s.silence ? "S" : s.chord.toString();
+
+        snprintf(buf, sizeof(buf), "%3u: %3s [", idx, chord.c_str());
+        out_.Write(string(buf));
+        out_.WriteDouble(idxToSec(s.startIdx), PRECISION_TEXT);
+        out_.Write(", ");
+        out_.WriteDouble(idxToSec(s.endIdx), PRECISION_TEXT);
+        out_.Write("]\n");
+        break;
+    }
+    case OUTPUT_FORMAT_CSV:
+        out_.WriteDouble(start, precision_);
+        out_.Write(',');
+        out_.WriteDouble(end, precision_);
+        out_.Write(',');
+        out_.Write(label);
+        out_.Write('\n');
+        break;
+    case OUTPUT_FORMAT_JSON:
+        out_.Write(rows_ ? ",{\"start\":" : "{\"start\":");
+        out_.WriteDouble(start, precision_);
+        out_.Write(",\"end\":");
+        out_.WriteDouble(end, precision_);
+        out_.Write(",\"chord\":\"");
+        out_.Write(label);
+        out_.Write("\"}");
+        break;
+    case OUTPUT_FORMAT_LAB:
+        snprintf(buf, sizeof(buf), "%.6f %.6f ", start, end);
+        out_.Write(string(buf));
+        out_.Write(label);
+        out_.Write('\n');
+        break;
+    default:
+        throw invalid_argument("Segments can't be written in this format");
+    }
+
+    rows_++;
+}
+
+void OutputWriter::End()
+{
+    if (format_ == OUTPUT_FORMAT_JSON) {
+        out_.Write(segments_ ? "]\n" : "]}\n");
+    }
+    out_.Flush();
+}
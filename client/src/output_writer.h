@@ -0,0 +1,155 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    output_writer.h
+ * @brief   Buffered writers of the client results in several formats
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "chord_detector.h"
+
+#define OUTPUT_BUFFER_SIZE  (1 << 20)
+
+typedef enum {
+    OUTPUT_FORMAT_TEXT,     /**< human readable, what lmclient has always printed */
+    OUTPUT_FORMAT_CSV,      /**< comma separated with a header line */
+    OUTPUT_FORMAT_JSON,
+    OUTPUT_FORMAT_BIN,      /**< raw native endian float32 values */
+    OUTPUT_FORMAT_LAB,      /**< MIREX chord annotation, segments only */
+} output_format_t;
+
+/**
+ * Accumulates output and hands it to stdio in large blocks
+ *
+ * Unlike printing with std::endl nothing is flushed per line. Goes through
+ * the same FILE as std::cout, so the two can be mixed as long as Flush()
+ * is called in between.
+ */
+class OutputBuffer {
+    public:
+        OutputBuffer(FILE *f);
+
+        ~OutputBuffer();
+
+        void Write(const char *data, size_t len);
+
+        void Write(const std::string &s)
+        {
+            Write(s.data(), s.size());
+        }
+
+        void Write(char c)
+        {
+            if (len_ == buf_.size()) {
+                Flush();
+            }
+            buf_[len_++] = c;
+        }
+
+        void WriteUInt(uint64_t v);
+
+        /**
+         * Same as printf() %g, e.g. what std::cout gives by default with
+         * \p precision 6
+         */
+        void WriteDouble(double v, int precision);
+
+        void WriteFloat32(float v)
+        {
+            Write(reinterpret_cast<const char *>(&v), sizeof(v));
+        }
+
+        void Flush();
+
+    private:
+        FILE *f_;
+        std::vector<char> buf_;
+        size_t len_;
+};
+
+/**
+ * Writes tables of values or chord segments in the selected format
+ *
+ * A table is written with Begin(), then Index() / Value() for every cell
+ * of a row followed by EndRow(), and End() at last. Segments are written
+ * with Segment() between Begin() and End(). Index cells are sample or
+ * frame numbers, the binary format leaves them out as they are implied by
+ * the position.
+ */
+class OutputWriter {
+    public:
+        OutputWriter(output_format_t format, FILE *f = stdout);
+
+        /**
+         * @throws  std::invalid_argument if \p name is not a known format
+         */
+        static output_format_t ParseFormat(const std::string &name);
+
+        /**
+         * @param   columns names of the table columns, no CSV header if empty
+         * @param   segments chord segments are going to be written
+         * @throws  std::invalid_argument if the format cannot hold the data
+         */
+        void Begin(const std::vector<std::string> &columns, bool segments = false);
+
+        void Index(uint64_t idx);
+
+        void Value(double v);
+
+        void EndRow();
+
+        /**
+         * @param   idx         position of the segment in the list
+         * @param   s           segment
+         * @param   samplerate  sample rate the segment bounds are measured in
+         */
+        void Segment(uint32_t idx, const segment_t &s, uint32_t samplerate);
+
+        void End();
+
+        /**
+         * Direct access for output which only makes sense as text
+         */
+        OutputBuffer & Raw()
+        {
+            return out_;
+        }
+
+        output_format_t Format()
+        {
+            return format_;
+        }
+
+    private:
+        output_format_t format_;
+        OutputBuffer out_;
+        int precision_;
+        uint64_t rows_;
+        uint32_t cells_;
+        bool segments_;
+
+        void Separator_();
+};
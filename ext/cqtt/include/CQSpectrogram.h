@@ -107,6 +107,13 @@ public:
      */
     RealBlock getRemainingOutput();
 
+    /**
+     * Discard any buffered input and return to the state following
+     * construction, so that a new signal can be processed without
+     * recalculating the kernel.
+     */
+    void reset();
+
 private:
     ConstantQ m_cq;
     Interpolation m_interpolation;
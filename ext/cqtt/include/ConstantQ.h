@@ -103,6 +103,13 @@ public:
      */
     ComplexBlock getRemainingOutput();
 
+    /**
+     * Discard any buffered input and return to the state following
+     * construction, so that a new signal can be processed without
+     * recalculating the kernel.
+     */
+    void reset();
+
 private:
     const CQParameters m_inparams;
     const double m_sampleRate;
@@ -117,11 +124,17 @@ private:
 
     std::vector<Resampler *> m_decimators;
     std::vector<RealSequence> m_buffers;
+    std::vector<int> m_bufferLatencies;
 
     int m_outputLatency;
 
     FFTReal *m_fft;
 
+    // Scratch of processOctaveBlock(), kept to avoid allocating per block
+    RealSequence m_ro;
+    RealSequence m_io;
+    ComplexSequence m_cv;
+
     void initialise();
     ComplexBlock processOctaveBlock(int octave);
 };
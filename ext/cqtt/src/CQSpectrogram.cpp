@@ -32,6 +32,7 @@
 #include "CQSpectrogram.h"
 
 #include <iostream>
+#include <iterator>
 #include <stdexcept>
 
 using std::cerr;
@@ -62,6 +63,14 @@ CQSpectrogram::getRemainingOutput()
     return postProcess(m_cq.getRemainingOutput(), true);
 }
 
+void
+CQSpectrogram::reset()
+{
+    m_cq.reset();
+    m_buffer.clear();
+    m_prevColumn.clear();
+}
+
 CQSpectrogram::RealBlock
 CQSpectrogram::postProcess(const ComplexBlock &cq, bool insist)
 {
@@ -98,7 +107,7 @@ CQSpectrogram::postProcess(const ComplexBlock &cq, bool insist)
     }
 
     for (int i = 0; i < width; ++i) {
-	m_buffer.push_back(spec[i]);
+	m_buffer.push_back(std::move(spec[i]));
     }
     
     if (m_interpolation == InterpolateHold) {
@@ -192,10 +201,12 @@ CQSpectrogram::fetchLinear(bool insist)
 	}
     } else if (firstFullHeight > 0) {
 	// can interpolate nothing, stash up to first full height & recurse
-	out = RealBlock(m_buffer.begin(), m_buffer.begin() + firstFullHeight);
-	m_buffer = RealBlock(m_buffer.begin() + firstFullHeight, m_buffer.end());
+	out = RealBlock(std::make_move_iterator(m_buffer.begin()),
+			std::make_move_iterator(m_buffer.begin() + firstFullHeight));
+	m_buffer.erase(m_buffer.begin(), m_buffer.begin() + firstFullHeight);
 	RealBlock more = fetchLinear(insist);
-	out.insert(out.end(), more.begin(), more.end());
+	out.insert(out.end(), std::make_move_iterator(more.begin()),
+		   std::make_move_iterator(more.end()));
 	return out;
     } else if (secondFullHeight < 0) {
 	// firstFullHeight == 0, but there is no second full height --
@@ -208,9 +219,10 @@ CQSpectrogram::fetchLinear(bool insist)
     } else {
 	// firstFullHeight == 0 and secondFullHeight also valid. Can interpolate
 	out = linearInterpolated(m_buffer, 0, secondFullHeight);
-	m_buffer = RealBlock(m_buffer.begin() + secondFullHeight, m_buffer.end());
+	m_buffer.erase(m_buffer.begin(), m_buffer.begin() + secondFullHeight);
 	RealBlock more = fetchLinear(insist);
-	out.insert(out.end(), more.begin(), more.end());
+	out.insert(out.end(), std::make_move_iterator(more.begin()),
+		   std::make_move_iterator(more.end()));
 	return out;
     }
 }
@@ -256,8 +256,9 @@ ConstantQ::initialise()
              << octaveLatency << endl;
 #endif
 
+        m_bufferLatencies.push_back(int(octaveLatency + 0.5));
         m_buffers.push_back
-            (RealSequence(int(octaveLatency + 0.5), 0.0));
+            (RealSequence(m_bufferLatencies[i], 0.0));
     }
 
     m_fft = new FFTReal(m_p.fftSize);
@@ -327,6 +328,15 @@ ConstantQ::process(const RealSequence &td)
     return out;
 }
 
+void
+ConstantQ::reset()
+{
+    for (int i = 0; i < (int)m_buffers.size(); ++i) {
+        if (m_decimators[i]) m_decimators[i]->reset();
+        m_buffers[i] = RealSequence(m_bufferLatencies[i], 0.0);
+    }
+}
+
 ConstantQ::ComplexBlock
 ConstantQ::getRemainingOutput()
 {
@@ -339,20 +349,21 @@ ConstantQ::getRemainingOutput()
 ConstantQ::ComplexBlock
 ConstantQ::processOctaveBlock(int octave)
 {
-    RealSequence ro(m_p.fftSize, 0.0);
-    RealSequence io(m_p.fftSize, 0.0);
+    m_ro.assign(m_p.fftSize, 0.0);
+    m_io.assign(m_p.fftSize, 0.0);
 
-    m_fft->forward(m_buffers[octave].data(), ro.data(), io.data());
+    m_fft->forward(m_buffers[octave].data(), m_ro.data(), m_io.data());
 
-    m_buffers[octave] = RealSequence(m_buffers[octave].begin() + m_p.fftHop,
-                                     m_buffers[octave].end());
+    // Drop the hop in place rather than copying the rest of the buffer
+    m_buffers[octave].erase(m_buffers[octave].begin(),
+                            m_buffers[octave].begin() + m_p.fftHop);
 
-    ComplexSequence cv(m_p.fftSize);
+    m_cv.resize(m_p.fftSize);
     for (int i = 0; i < m_p.fftSize; ++i) {
-        cv[i] = Complex(ro[i], io[i]);
+        m_cv[i] = Complex(m_ro[i], m_io[i]);
     }
 
-    ComplexSequence cqrowvec = m_kernel->processForward(cv);
+    ComplexSequence cqrowvec = m_kernel->processForward(m_cv);
 
     // Reform into a column matrix
     ComplexBlock cqblock;
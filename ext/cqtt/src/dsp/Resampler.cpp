@@ -271,6 +271,20 @@ Resampler::initialise(double snr, double bandwidth)
     // and j will appear before the one in which input sample a is at
     // the centre of the filter.
 
+    reset();
+
+#ifdef DEBUG_RESAMPLER
+    cerr << "initial phase " << m_phase << " (as " << (m_filterLength/2) << " % " << inputSpacing << ")"
+	      << ", latency " << m_latency << endl;
+#endif
+}
+
+void
+Resampler::reset()
+{
+    int inputSpacing = m_targetRate / m_gcd;
+    int outputSpacing = m_sourceRate / m_gcd;
+
     int h = int(m_filterLength / 2);
     int n = ceil(double(m_filterLength - h) / outputSpacing);
     
@@ -282,11 +296,6 @@ Resampler::initialise(double snr, double bandwidth)
 
     m_buffer = vector<double>(fill, 0);
     m_bufferOrigin = 0;
-
-#ifdef DEBUG_RESAMPLER
-    cerr << "initial phase " << m_phase << " (as " << (m_filterLength/2) << " % " << inputSpacing << ")"
-	      << ", latency " << m_latency << endl;
-#endif
 }
 
 double
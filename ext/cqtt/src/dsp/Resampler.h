@@ -84,6 +84,12 @@ public:
      */
     int getLatency() const { return m_latency; }
 
+    /**
+     * Discard any buffered input and return to the state the
+     * resampler had on construction, keeping the filter.
+     */
+    void reset();
+
     /**
      * Carry out a one-off resample of a single block of n
      * samples. The output is latency-compensated.
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file        analysis_config.h
+ * @brief       Runtime parameters of the chord analysis
+ *
+ * Parameters which trade speed for accuracy are kept in AnalysisConfig,
+ * which ChordDetector and the time-frequency transforms are constructed
+ * with, so one build can serve callers with different needs. Defaults are
+ * taken from config.h.
+ *
+ * Named presets for offline analysis, from the fastest to the most
+ * accurate, see README.md for lmbench and lmeval figures. Chords are known
+ * once the whole recording has been decoded, the window only sets the time
+ * resolution (186 ms for 8192 samples at 44.1 kHz, 93 ms for 4096):
+ *   - fast: constant-Q transform over 8192 sample windows. Half the frames
+ *     of "balanced" and about 1.4 times faster, with coarser chord
+ *     boundaries and lower accuracy. Not a low-latency profile, frames are
+ *     twice as long as with "balanced"
+ *   - balanced: constant-Q transform over 4096 sample windows, the defaults
+ *   - accurate: "balanced" with two hops per window and a stickier decoder.
+ *     Twice the frames, about 1.3 times slower, follows chord changes more
+ *     closely
+ *
+ * followed by the low-latency one:
+ *   - lowlatency: 2048 sample Hamming windows with two hops per window,
+ *     meant for RTChordAnalyzer. Every estimate comes from the last 46 ms
+ *     at 44.1 kHz and is updated every 23 ms, at the cost of bass
+ *     resolution and accuracy, extensions are the first to suffer. ChordDetector runs the constant-Q transform
+ *     with these windows
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace anatomist {
+
+class AnalysisConfig {
+
+public:
+    uint32_t    tft_type;           /**< TFT_TYPE_FFT, TFT_TYPE_CONSTANTQ or TFT_TYPE_GOERTZEL */
+    uint32_t    win_size;           /**< window size in samples at 44100 Hz and above */
+    uint32_t    hops_per_window;    /**< windows overlap that many times */
+    uint32_t    fft_size;           /**< longest input of the single window analysis */
+    uint32_t    window_func;        /**< WINDOW_FUNC_* applied before FFT */
+    uint32_t    hps_harmonics;      /**< harmonics of the product spectrum FFT based
+                                         analysis works with, 1 for the plain spectrum */
+    float       self_transition_p;  /**< probability of the chord to stay the same from
+                                         frame to frame, 0 means the same as any other */
+    uint32_t    viterbi_threads;    /**< threads decoding the chord sequence, 0 means one
+                                         per hardware thread. Is not part of the presets */
+
+    /**
+     * Constructor
+     *
+     * Takes the defaults from config.h, which is the "balanced" preset
+     * unless the library is built with other values.
+     */
+    AnalysisConfig();
+
+    /**
+     * Look a preset up by name
+     *
+     * @param   name    one of Presets()
+     * @return  preset
+     * @throws  std::invalid_argument if there is no such preset
+     */
+    static AnalysisConfig Preset(const std::string &name);
+
+    /**
+     * Names of all presets, the offline ones from the fastest to the most
+     * accurate, then "lowlatency"
+     */
+    static std::vector<std::string> Presets();
+
+    /**
+     * Hop size in samples between subsequent windows
+     */
+    uint32_t HopSize() const;
+
+    /**
+     * Check that parameters are consistent
+     *
+     * @throws  std::invalid_argument describing the first wrong parameter
+     */
+    void Validate() const;
+};
+
+}
+
+/** @} */
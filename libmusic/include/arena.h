@@ -0,0 +1,130 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file        arena.h
+ * @brief       Monotonic buffer for the temporaries of a single analysis
+ *
+ * An analysis makes a lot of short-lived allocations of the same sizes over
+ * and over: a scratch column per spectrogram frame, windows per profile,
+ * metrics per decoded frame. Taking them from an Arena makes each of them a
+ * pointer bump. Nothing is freed one by one, everything is released at once
+ * with Release(), which keeps up to a limit of the memory for the next
+ * analysis. Once the arena has grown to what an analysis needs, subsequent
+ * analyses of the same length do not touch the heap for their temporaries
+ * at all, as long as they fit into the limit.
+ *
+ * Only trivially destructible types can be kept in the arena, destructors
+ * are never called. The arena is not thread safe, threads may use memory
+ * allocated before they were started.
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include <memory>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace anatomist {
+
+class Arena {
+
+private:
+    struct block_t {
+        std::unique_ptr<char[]> data;
+        size_t                  size;
+    };
+
+    std::vector<block_t>    blocks_;
+    size_t                  used_;      /**< bytes taken from the last block */
+    size_t                  min_block_;
+    size_t                  max_retained_;
+
+public:
+    /**
+     * Constructor, no memory is allocated until the first Allocate()
+     *
+     * @param   min_block       smallest block requested from the heap in bytes
+     * @param   max_retained    most bytes kept by Release(), 16 MiB covers
+     *                          a few minutes of audio with the default config
+     */
+    explicit Arena(size_t min_block = 64 * 1024, size_t max_retained = 16 * 1024 * 1024);
+
+    Arena(const Arena &) = delete;
+    Arena & operator=(const Arena &) = delete;
+
+    /**
+     * Allocate \p bytes aligned to \p align, which has to be a power of 2
+     */
+    void * Allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+
+    /**
+     * Allocate an uninitialised array of \p n objects
+     */
+    template<typename T> T * Allocate(size_t n)
+    {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "destructors of objects in the arena are never called");
+
+        return static_cast<T *>(Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * Release everything allocated so far
+     *
+     * Memory is kept for reuse. If the last analysis did not fit into a
+     * single block, blocks are merged into one of their total size, but no
+     * larger than the limit given to the constructor.
+     */
+    void Release();
+
+    /**
+     * Bytes allocated from the heap
+     */
+    size_t Capacity() const;
+};
+
+/**
+ * Releases the arena when going out of scope, exceptions included
+ */
+class ArenaScope {
+
+private:
+    Arena &arena_;
+
+public:
+    explicit ArenaScope(Arena &arena) : arena_(arena) {}
+
+    ~ArenaScope()
+    {
+        arena_.Release();
+    }
+
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope & operator=(const ArenaScope &) = delete;
+};
+
+}
+
+/** @} */
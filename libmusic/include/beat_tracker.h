@@ -0,0 +1,171 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file        beat_tracker.h
+ * @brief       API for online tempo and beat tracking
+ *
+ * Unlike BeatDetector which needs the envelope of the whole signal the
+ * tracker consumes audio block by block with bounded memory:
+ *   1. Onset strength is calculated per hop as half-wave rectified
+ *      spectral flux of the log magnitudes
+ *   2. Tempo is re-estimated periodically by windowed autocorrelation
+ *      of the onset strength history weighted towards moderate tempi
+ *   3. Cumulative beat score is updated causally and beats are emitted
+ *      once the tolerance window around the predicted beat has passed
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "kiss_fftr.h"
+
+#include "lmtypes.h"
+#include "signal_view.h"
+
+#ifndef BEAT_TRACKER_TEST_FRIENDS
+#define BEAT_TRACKER_TEST_FRIENDS
+#endif
+
+namespace anatomist {
+
+class BeatTracker {
+
+BEAT_TRACKER_TEST_FRIENDS;
+
+private:
+    const uint32_t          sample_rate_;
+    const uint32_t          hop_size_;
+    const uint32_t          win_size_;
+
+    /**
+     * Ring buffers of onset strength and cumulative beat score.
+     * Both keep \ref history_ latest values
+     */
+    std::vector<amplitude_t> odf_;
+    std::vector<amplitude_t> cscore_;
+    uint32_t                history_;
+
+    /**
+     * Samples collected since the previous hop
+     */
+    std::vector<amplitude_t> in_buf_;
+    uint32_t                in_len_;
+
+    std::vector<amplitude_t> win_;
+    std::vector<amplitude_t> frame_;
+    std::vector<amplitude_t> prev_mags_;
+    std::vector<amplitude_t> acf_;
+    std::vector<kiss_fft_cpx> fd_;
+    kiss_fftr_cfg           fft_cfg_;
+
+    /**
+     * Index of the next onset strength frame
+     */
+    uint64_t                frame_idx_;
+
+    /**
+     * Beat period in onset strength frames
+     */
+    amplitude_t             period_;
+    bool                    tempo_known_;
+
+    /**
+     * Frame index of the last emitted beat, negative if there was none
+     */
+    int64_t                 last_beat_;
+
+    uint32_t                beats_cnt_;
+
+    amplitude_t OnsetStrength_();
+
+    void UpdateTempo_();
+
+    void UpdateScore_(amplitude_t odf);
+
+    void DetectBeat_(std::vector<uint32_t> *beats);
+
+    amplitude_t &Odf_(uint64_t frame);
+
+    amplitude_t &CScore_(uint64_t frame);
+
+    uint32_t FrameToIdx_(uint64_t frame);
+
+public:
+    /**
+     * Constructor
+     *
+     * @param   sample_rate sample rate of the data to be fed to \ref Process()
+     * @param   hop_size    distance between subsequent onset strength frames
+     */
+    BeatTracker(uint32_t sample_rate, uint32_t hop_size);
+
+    BeatTracker(uint32_t sample_rate);
+
+    ~BeatTracker();
+
+    BeatTracker(const BeatTracker &) = delete;
+
+    BeatTracker & operator=(const BeatTracker &) = delete;
+
+    /**
+     * Feed next block of the single channel time domain data
+     *
+     * Blocks may be of any size. Indices of the detected beats are measured
+     * in samples from the beginning of the stream and appended to \p beats.
+     *
+     * @param   td      time domain data
+     * @param   samples number of samples in \p td
+     * @param   beats   output vector of beat indices, may be null
+     */
+    void Process(const amplitude_t *td, uint32_t samples, std::vector<uint32_t> *beats);
+
+    /**
+     * Same as above for data of any layout
+     */
+    void Process(const SignalView &td, std::vector<uint32_t> *beats);
+
+    /**
+     * Forget all the accumulated state and start over
+     */
+    void Reset();
+
+    /**
+     * Current tempo estimate in beats per minute, 0 if not known yet
+     */
+    float GetBPM();
+
+    /**
+     * Current beat interval in samples, 0 if not known yet
+     */
+    uint32_t GetIdxInterval();
+
+    /**
+     * Total number of beats emitted since construction or \ref Reset()
+     */
+    uint32_t GetBeatsCnt();
+};
+
+}
+
+/** @} */
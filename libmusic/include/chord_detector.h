@@ -27,17 +27,26 @@
 #pragma once
 
 #include <iostream>
+#include <map>
+#include <memory>
 #include <stdint.h>
 #include <vector>
 
+#include "analysis_config.h"
+#include "arena.h"
 #include "chord_tpl_collection.h"
+#include "feature_cache.h"
 #include "fft.h"
 #include "lmhelpers.h"
+#include "lmstats.h"
 #include "lmtypes.h"
 #include "music_scale.h"
 #include "pcp_buf.h"
 #include "pitch_calculator.h"
 #include "pitch_cls_profile.h"
+#include "signal_energy.h"
+#include "signal_view.h"
+#include "thread_pool.h"
 #include "viterbi.h"
 
 #ifndef CHORD_DETECTOR_TEST_FRIENDS
@@ -51,6 +60,33 @@ struct segment_t {
     bool        silence;
 };
 
+static_assert(std::is_trivially_copyable<segment_t>::value,
+              "segments are kept in flat buffers, see ChordDetector::getSegments()");
+
+/**
+ * Result of the analysis of a part of the recording, see
+ * ChordDetector::AnalyzeChunk()
+ *
+ * Keeps everything decoding of the part depends on, so that chunks of the
+ * same recording can be combined into segments later on
+ */
+struct chunk_t {
+    uint32_t                    first_frame;    /**< index of the first frame in the recording */
+    uint32_t                    interval;       /**< distance between frames in samples */
+    Viterbi::prob_matrix_t      scores;         /**< template scores of every frame */
+    std::vector<amplitude_t>    power;          /**< mean power of every frame with samples */
+};
+
+/**
+ * Onsets detected in the spectrogram chords are recognised from, see
+ * ChordDetector::GetOnsets()
+ */
+struct onsets_t {
+    uint32_t                    interval;       /**< distance between strength frames in samples */
+    std::vector<amplitude_t>    strength;       /**< onset strength of every frame */
+    std::vector<uint32_t>       onsets;         /**< indices of the onsets in samples */
+};
+
 namespace anatomist {
 
 /**
@@ -60,6 +96,9 @@ class ChordDetector {
 
 CHORD_DETECTOR_TEST_FRIENDS;
 
+/* decodes the scores of the chunks it keeps the same way Decode_() does */
+friend class ChordSession;
+
 public:
     /**
      * Client listener to track analysis progress
@@ -83,11 +122,39 @@ public:
              * Called after all processing has been finished
              */
             virtual void onChordAnalysisFinished() = 0;
+
+            /**
+             * Report per-stage statistics right before
+             * onChordAnalysisFinished(). Is called only when the library
+             * is built with CFG_STATS
+             */
+            virtual void onStatsReported(const stats_t &) {}
 };
 
 private:
     PitchCalculator& __mPitchCalculator = PitchCalculator::getInstance();
+    const AnalysisConfig config_;
     ChordTplCollection *tpl_collection_;
+    ChordModel *model_;
+    stats_t stats_;
+    FeatureCache *feature_cache_;
+
+    /* ChunkParams_() results are cached for this sample rate */
+    uint32_t chunk_sr_;
+    size_t chunk_alignment_;
+    size_t chunk_context_;
+
+    /*
+     * Temporaries of an analysis, released when it is done and reused by
+     * the next one
+     */
+    Arena arena_;
+
+    /* decodes with AnalysisConfig::viterbi_threads, started on first use */
+    std::unique_ptr<ThreadPool> decode_pool_;
+
+    /* transforms built so far, by sample rate and window size */
+    std::map<std::pair<uint32_t, uint32_t>, std::unique_ptr<tft_t>> tfts_;
 
     FFT * GetFft_(td_t &td, uint32_t samplerate);
 
@@ -116,22 +183,127 @@ private:
      * @param   x           full channel time domain data
      * @param   sampleRate  sample rate of x
      * @param   l           listener to report progress to if \p segments is null
+     * @param   c           output chromagram, stops the processing there if
+     *                      not null
+     * @param   interval    output distance between frames of \p c in samples
+     * @param   onsets      output onsets, detected if not null
+     */
+    void Process_(std::vector<segment_t> *segments, const SignalView &x,
+                  uint32_t sr, ResultsListener *l, chromagram_t *c,
+                  uint32_t *interval = nullptr, onsets_t *onsets = nullptr);
+
+    /**
+     * Run all the stages up to and including chromagram calculation
+     *
+     * Silent frames are not analysed, their profiles are left zero.
+     *
+     * @param   x           full channel time domain data
+     * @param   energy      power queries over x, nullptr to analyse all the
+     *                      frames
+     * @param   sr          sample rate of x
+     * @param   interval    output distance between chromagram frames
+     *                      in samples of x
+     * @param   onsets      output onsets detected in the same spectrogram,
+     *                      nullptr if not needed
+     * @return  chromagram
+     */
+    chromagram_t Chromagram_(const SignalView &x, const SignalEnergy *energy,
+                             uint32_t sr, uint32_t *interval, onsets_t *onsets = nullptr);
+
+    /**
+     * Create the time-frequency transform selected with AnalysisConfig::tft_type
+     */
+    tft_t * NewTft_(uint32_t sr, uint32_t win_size);
+
+    /**
+     * Get a transform ready to process a new signal
+     *
+     * Transforms are kept and reused, as constructing one can take longer
+     * than analysing a short recording. The detector keeps the ownership.
+     */
+    tft_t * Tft_(uint32_t sr, uint32_t win_size);
+
+    /**
+     * Find where recording can be split into chunks and how much input
+     * around a chunk is needed to analyse it the same way as a whole
+     */
+    void ChunkParams_(uint32_t sr, size_t *alignment, size_t *context);
+
+    /**
+     * Mean power of chromagram frames
+     *
+     * @param   energy      power queries over the time domain data the
+     *                      chromagram is built from
+     * @param   interval    distance between chromagram frames in samples
+     * @return  power of every frame which has samples
+     */
+    std::vector<amplitude_t> FramePower_(const SignalEnergy &energy, uint32_t interval);
+
+    /**
+     * Find frames which are too quiet compared to the loudest one
+     *
+     * @param   power   mean power of every frame
+     * @return  silence flag for every frame
      */
-    void Process_(std::vector<segment_t> *segments, const td_t &x,
-                  uint32_t sr, ResultsListener *l, chromagram_t *c);
+    static std::vector<bool> SilentFrames_(const std::vector<amplitude_t> &power);
+
+    /**
+     * Find the most likely chord sequence and report it as segments
+     *
+     * @param   score_mtx   template scores of every frame
+     * @param   silent      silence flag of every frame
+     * @param   interval    distance between frames in samples
+     * @param   columns     first frame of every column of \p score_mtx, see
+     *                      BeatColumns(), empty if columns are frames
+     * @param   samples     length of the input
+     * @param   segments    output vector of segments
+     * @param   l           listener to report segments to if \p segments is null
+     */
+    void Decode_(Viterbi::prob_matrix_t &score_mtx, const std::vector<bool> &silent,
+                 uint32_t interval, const std::vector<uint32_t> &columns, size_t samples,
+                 std::vector<segment_t> *segments, ResultsListener *l);
+
+    /**
+     * Initial and transition probabilities of the decoder, from the model
+     * if there is one
+     */
+    void Transitions_(std::vector<prob_t> *init_p, Viterbi::prob_matrix_t *trans_p);
+
+    /**
+     * Report the decoded path as segments, see Decode_()
+     *
+     * @param   path        state of every column
+     * @param   seg_start   column to start from, segments before it are
+     *                      taken as reported already
+     */
+    void PathSegments_(const std::vector<uint32_t> &path, const std::vector<bool> &silent,
+                       uint32_t interval, const std::vector<uint32_t> &columns, size_t samples,
+                       uint32_t seg_start, std::vector<segment_t> *segments, ResultsListener *l);
 
     float Tune_(tft_t *tft);
 
-    Viterbi::prob_matrix_t GetScoreMatrix_(chromagram_t &chromagram);
+    /**
+     * Score every template against every frame, silent frames can only be N
+     */
+    Viterbi::prob_matrix_t GetScoreMatrix_(chromagram_t &chromagram,
+                                           const std::vector<bool> &silent);
 
     chromagram_t ChromagramFromSpectrogram_(tft_t *tft);
 
 public:
     /**
-     * Constructor
+     * Constructor, analysis parameters are the defaults from config.h
      */
     ChordDetector();
 
+    /**
+     * Constructor
+     *
+     * @param   config  analysis parameters, e.g. AnalysisConfig::Preset()
+     * @throws  std::invalid_argument if \p config is not valid
+     */
+    explicit ChordDetector(const AnalysisConfig &config);
+
     /**
      * Destructor
      */
@@ -162,6 +334,33 @@ public:
     void getSegments(amplitude_t *x, uint32_t samples, uint32_t sampleRate,
                      ResultsListener *listener);
 
+    /**
+     * Same as above for the input of any layout, e.g. interleaved float
+     * samples straight from the decoder
+     *
+     * Nothing is copied up front, frames are converted and down-mixed by
+     * the processing stages as they go.
+     */
+    void getSegments(std::vector<segment_t>& segments, const SignalView &x,
+                     uint32_t sampleRate);
+
+    void getSegments(const SignalView &x, uint32_t sampleRate, ResultsListener *listener);
+
+    /**
+     * Same as above, also detects onsets in the spectrogram chords are
+     * recognised from, see OnsetDetector
+     *
+     * The spectrogram is needed for onsets, so the feature cache is not
+     * read, only written to.
+     *
+     * @param   segments    output vector of segments
+     * @param   x           time domain data
+     * @param   sampleRate  sample rate of x
+     * @param   onsets      output onsets
+     */
+    void getSegments(std::vector<segment_t>& segments, const SignalView &x,
+                     uint32_t sampleRate, onsets_t *onsets);
+
     /**
      * Build major or minor scale from the main note
      *
@@ -174,6 +373,179 @@ public:
     pcp_t * GetPCP(amplitude_t *x, uint32_t samples, uint32_t samplerate);
 
     chromagram_t GetChromagram(amplitude_t *x, uint32_t samples, uint32_t samplerate);
+
+    chromagram_t GetChromagram(const SignalView &x, uint32_t samplerate);
+
+    /**
+     * Same as above, also gives the distance between chromagram frames
+     * in samples of \p x
+     */
+    chromagram_t GetChromagram(const SignalView &x, uint32_t samplerate, uint32_t *interval);
+
+    /**
+     * Detect onsets only
+     *
+     * Runs the same analysis as getSegments() up to the spectrogram, there
+     * is no separate transform for onsets.
+     *
+     * @param   x           time domain data
+     * @param   samplerate  sample rate of x
+     * @return  onsets
+     */
+    onsets_t GetOnsets(const SignalView &x, uint32_t samplerate);
+
+    /**
+     * Analysis parameters the detector was constructed with
+     */
+    const AnalysisConfig & GetConfig() const;
+
+    /**
+     * Description of every parameter chromagram calculation depends on
+     *
+     * Is used to build feature cache keys and is stored in trained models,
+     * which only fit chromagrams of the same parameters.
+     */
+    static std::string FeatureParams(const AnalysisConfig &config);
+
+    /**
+     * Per-stage statistics of the last analysis
+     *
+     * @return  statistics, empty unless the library is built with CFG_STATS
+     */
+    const stats_t & GetStats();
+
+    /**
+     * Build everything analysis at the given sample rate needs in advance
+     *
+     * Is meant for long living detectors, e.g. in a server, so that the
+     * first request does not pay for the initialisation.
+     *
+     * @param   sampleRate  sample rate of the recordings to come
+     */
+    void Prepare(uint32_t sampleRate);
+
+    /**
+     * Keep chromagrams in a persistent cache
+     *
+     * Subsequent analysis of the same audio with the same feature related
+     * parameters loads the chromagram from the cache instead of running
+     * spectral analysis. Decoding parameters are not part of the cache key.
+     *
+     * @param   dir     existing directory for the cache, empty string
+     *                  disables caching
+     */
+    void SetFeatureCache(const std::string &dir);
+
+    /**
+     * Decode with a trained model instead of the theoretical templates
+     *
+     * Templates, initial and transition probabilities all come from the
+     * model. Chromagrams do not depend on it, so cached ones are reused.
+     *
+     * @param   path    model file written by lmtrain, empty string brings
+     *                  back the theoretical templates
+     * @throws  std::invalid_argument if the model was trained on chromagrams
+     *          of other analysis parameters, see FeatureParams()
+     */
+    void SetModel(const std::string &path);
+
+    /**
+     * Chunk boundaries passed to AnalyzeChunk() have to be multiples of it
+     *
+     * @param   sampleRate  sample rate of the recording
+     * @return  alignment in samples
+     */
+    size_t ChunkAlignment(uint32_t sampleRate);
+
+    /**
+     * Part of the recording AnalyzeChunk() needs to analyse [start, end)
+     *
+     * The chunk is padded with the context the transform needs, so that its
+     * frames are the same as the ones of the whole recording.
+     *
+     * @param   sampleRate  sample rate of the recording
+     * @param   samples     length of the recording
+     * @param   start       first sample of the chunk
+     * @param   end         sample after the last one of the chunk
+     * @param   from        first sample to pass to AnalyzeChunk()
+     * @param   to          sample after the last one to pass to AnalyzeChunk()
+     */
+    void ChunkInput(uint32_t sampleRate, size_t samples, size_t start, size_t end,
+                    size_t *from, size_t *to);
+
+    /**
+     * Analyse range [start, end) of a recording up to decoding
+     *
+     * Chunks are independent of each other and can be analysed in parallel,
+     * e.g. by different processes.
+     *
+     * @param   x           samples [from, to) of the recording, see ChunkInput()
+     * @param   sampleRate  sample rate of the recording
+     * @param   samples     length of the recording
+     * @param   start       first sample of the chunk, multiple of ChunkAlignment()
+     * @param   end         sample after the last one of the chunk, multiple of
+     *                      ChunkAlignment() or \p samples
+     * @return  analysis results of the chunk
+     */
+    chunk_t AnalyzeChunk(const SignalView &x, uint32_t sampleRate, size_t samples,
+                         size_t start, size_t end);
+
+    /**
+     * Decode chunks which cover the whole recording into segments
+     *
+     * Result is the same as getSegments() over the whole recording gives,
+     * unless CFG_BEAT_SYNC is set: beats are only known for the whole
+     * recording, so chunks are always decoded frame by frame.
+     *
+     * @param   chunks      chunks of the recording in any order
+     * @param   samples     length of the recording
+     * @param   segments    output vector of segments
+     */
+    void MergeChunks(const std::vector<chunk_t> &chunks, size_t samples,
+                     std::vector<segment_t> &segments);
+
+    /**
+     * Serialize \p chunk to be merged by another process
+     */
+    static void SaveChunk(const chunk_t &chunk, std::ostream &os);
+
+    /**
+     * Read a chunk written by SaveChunk()
+     */
+    static chunk_t LoadChunk(std::istream &is);
+
+    /**
+     * Group chromagram frames into columns between detected beats
+     *
+     * The beat grid is extended with the detected tempo towards both ends
+     * of the recording, as the tracker needs a few seconds to lock.
+     *
+     * @param   td          time domain data the chromagram is built from
+     * @param   sampleRate  sample rate of \p td
+     * @param   interval    distance between chromagram frames in samples
+     * @param   frames      number of chromagram frames
+     * @return  first frame of every column followed by \p frames, empty
+     *          if no beats were found
+     */
+    static std::vector<uint32_t> BeatColumns(const SignalView &td, uint32_t sampleRate,
+                                             uint32_t interval, uint32_t frames);
+
+    /**
+     * Pool chromagram frames of every column into a single frame
+     *
+     * Silent frames are left out of pooling, a column is silent only if all
+     * of its frames are.
+     *
+     * @param   chromagram  chromagram to pool
+     * @param   columns     column boundaries as returned by BeatColumns()
+     * @param   pooling     BEAT_SYNC_MEAN, BEAT_SYNC_MEDIAN or BEAT_SYNC_MAX
+     * @param   silent      silence flag of every frame on input, of every
+     *                      column on output
+     * @return  one profile per column
+     */
+    static chromagram_t PoolChromagram(const chromagram_t &chromagram,
+                                       const std::vector<uint32_t> &columns, int pooling,
+                                       std::vector<bool> *silent);
 };
 
 }
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file        chord_model.h
+ * @brief       Trained chord HMM: templates, initial and transition probabilities
+ *
+ * A model has a state for every chord it can recognise, followed by the
+ * no chord (N) state. Models are trained from annotated recordings with
+ * ChordModelTrainer and kept in binary files, which
+ * ChordDetector::SetModel() loads at runtime.
+ *
+ * The file consists of a fixed header followed by the analysis parameters
+ * the model was trained with, the states, initial probabilities,
+ * transition matrix row by row and templates of every state. Values are
+ * stored in native byte order.
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "lmtypes.h"
+#include "pitch_cls_profile.h"
+#include "viterbi.h"
+
+namespace anatomist {
+
+class ChordModel {
+
+private:
+    std::vector<chord_t>                    states_;
+    std::vector<std::vector<amplitude_t>>   tpls_;
+    std::vector<prob_t>                     init_p_;
+    Viterbi::prob_matrix_t                  trans_p_;
+    std::string                             params_;
+
+public:
+    /**
+     * Constructor
+     *
+     * @param   states  chord of every state, the last one has to be N
+     * @param   tpls    template of every state in the layout of
+     *                  PitchClsProfile::getValues()
+     * @param   init_p  initial probabilities of the states
+     * @param   trans_p transition probabilities, trans_p[from][to]
+     * @param   params  analysis parameters of the chromagrams the model was
+     *                  trained on, see ChordDetector::FeatureParams()
+     */
+    ChordModel(const std::vector<chord_t> &states,
+               const std::vector<std::vector<amplitude_t>> &tpls,
+               const std::vector<prob_t> &init_p, const Viterbi::prob_matrix_t &trans_p,
+               const std::string &params = "");
+
+    /**
+     * Read a model written by Save()
+     */
+    static ChordModel Load(const std::string &path);
+
+    void Save(const std::string &path) const;
+
+    size_t Size() const;
+
+    const std::vector<chord_t> & States() const;
+
+    const std::vector<std::vector<amplitude_t>> & Templates() const;
+
+    const std::vector<prob_t> & InitProbs() const;
+
+    const Viterbi::prob_matrix_t & TransProbs() const;
+
+    const std::string & Params() const;
+};
+
+/**
+ * Accumulates statistics of annotated recordings into a ChordModel
+ *
+ * Statistics are kept relative to the chord root, so every recording
+ * contributes to the chords of all the roots: templates are averaged
+ * profiles rotated to the root and transitions are counted by the qualities
+ * and the interval between the roots.
+ *
+ * Trainers of separate threads are combined with operator+=(), the result
+ * does not depend on how recordings were split between them. Only trainers
+ * of the same analysis parameters can be combined.
+ */
+class ChordModelTrainer {
+
+private:
+    std::string                             params_;
+    size_t                                  dims_;
+    uint32_t                                recordings_;
+    uint64_t                                frames_;
+    std::vector<std::vector<amplitude_t>>   sums_;
+    std::vector<uint64_t>                   profiles_;
+    std::vector<double>                     init_cnt_;
+    std::vector<double>                     trans_cnt_;
+
+    /**
+     * Index of the chord quality, qualities of N and unsupported chords are
+     * the last one
+     */
+    static uint32_t Quality_(const chord_t &chord);
+
+    /**
+     * Pitch class of the root relative to C, 0 for N
+     */
+    static uint32_t Root_(const chord_t &chord);
+
+    static size_t TransIdx_(uint32_t q_from, uint32_t q_to, uint32_t interval);
+
+    /**
+     * Template of \p q rotated to \p root, \p q has to be seen in training
+     * unless it is N
+     */
+    std::vector<amplitude_t> Template_(uint32_t q, uint32_t root) const;
+
+public:
+    /**
+     * Constructor
+     *
+     * @param   params  analysis parameters of the chromagrams to be added,
+     *                  see ChordDetector::FeatureParams()
+     */
+    explicit ChordModelTrainer(const std::string &params = "");
+
+    /**
+     * Add an annotated recording
+     *
+     * Transitions are not counted across frames without annotation.
+     * Profiles of silent frames, which are left zero by the analysis, only
+     * count towards the transitions.
+     *
+     * @param   chromagram  chromagram of the recording
+     * @param   chords      annotated chord of every frame
+     * @param   known       false for frames without usable annotation
+     */
+    void Add(const chromagram_t &chromagram, const std::vector<chord_t> &chords,
+             const std::vector<bool> &known);
+
+    /**
+     * @throws  std::invalid_argument if \p t is of other analysis parameters
+     */
+    ChordModelTrainer & operator+=(const ChordModelTrainer &t);
+
+    /**
+     * Number of recordings added so far
+     */
+    uint32_t Recordings() const;
+
+    /**
+     * Number of annotated frames added so far
+     */
+    uint64_t Frames() const;
+
+    /**
+     * Build the model
+     *
+     * Only chord qualities seen in training get states, with every root.
+     * N always has a state, it gets the theoretical template if only
+     * silence was annotated as N.
+     *
+     * @param   smoothing   count added to every initial state and transition,
+     *                      so that nothing is impossible
+     * @return  trained model
+     */
+    ChordModel Model(double smoothing = 1) const;
+};
+
+}
+
+/** @} */
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file        chord_session.h
+ * @brief       Incremental chord recognition of a recording which grows or
+ *              is edited
+ *
+ * Running getSegments() over the whole recording again every time a bit of
+ * it has changed repeats the spectral analysis and decoding of everything.
+ * A session keeps template scores and frame power of every frame and the
+ * decoder metrics between updates, and builds on the chunk contract of
+ * ChordDetector: transform is restarted at the last aligned position whose
+ * frames do not see the change, so appending N seconds costs the analysis
+ * of N seconds plus a bounded context around the previous end.
+ *
+ * Decoding is propagated from the first changed frame until the first
+ * unchanged silent one or the end, and backtracked until the path joins
+ * the previous one. Silence is relative to the loudest frame of the whole
+ * recording, so frames whose silence flag flips because of the change are
+ * decoded again as well.
+ *
+ * Segments are the same as getSegments() over the whole recording gives,
+ * unless CFG_BEAT_SYNC is set: as with MergeChunks() frames are decoded
+ * one by one.
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "chord_detector.h"
+#include "signal_view.h"
+#include "viterbi.h"
+
+namespace anatomist {
+
+class ChordSession {
+
+private:
+    ChordDetector   &detector_;
+    const uint32_t  samplerate_;
+    size_t          alignment_;
+    size_t          context_;
+
+    /* length of the recording as of the last Update() */
+    size_t          samples_;
+
+    /* samples changed since the last Update(), none if from >= to */
+    size_t          dirty_from_;
+    size_t          dirty_to_;
+
+    uint32_t                    interval_;
+    Viterbi::prob_matrix_t      scores_;    /**< template scores of every frame */
+    std::vector<amplitude_t>    power_;     /**< mean power of every frame with samples */
+    std::vector<bool>           silent_;
+    Viterbi::prob_matrix_t      obs_;       /**< scores with silent frames forced to N */
+    std::vector<segment_t>      segments_;
+
+    std::unique_ptr<Viterbi::Incremental>   decoder_;
+
+    uint32_t        frames_analysed_;
+    uint32_t        frames_decoded_;
+
+    /**
+     * Rebuild segments which may have changed since \p frame
+     *
+     * @param   frame   first frame whose state or silence flag has changed
+     * @param   frames  number of frames before the update
+     * @param   samples length of the recording before the update
+     */
+    void UpdateSegments_(uint32_t frame, uint32_t frames, size_t samples);
+
+public:
+    /**
+     * Constructor
+     *
+     * The detector has to outlive the session and must not change its
+     * model or be used for anything else while the session is updated.
+     *
+     * @param   detector    detector to analyse the recording with
+     * @param   sampleRate  sample rate of the recording
+     * @throws  std::runtime_error if the detector can't analyse a recording
+     *          by parts, i.e. with CFG_DYNAMIC_WINDOW
+     */
+    ChordSession(ChordDetector &detector, uint32_t sampleRate);
+
+    ChordSession(const ChordSession &) = delete;
+
+    ChordSession & operator=(const ChordSession &) = delete;
+
+    /**
+     * Mark samples [start, end) as changed since the last Update()
+     *
+     * Appended samples need not be marked. An edit which changes the length
+     * of the recording shifts everything after it, so it has to be marked
+     * up to the new end.
+     *
+     * @param   start   first changed sample
+     * @param   end     sample after the last changed one
+     */
+    void Invalidate(size_t start, size_t end);
+
+    /**
+     * Bring the analysis up to date with the recording
+     *
+     * Samples past the length of the previous update are taken as
+     * appended, ones before it which have not been marked with
+     * Invalidate() have to be the same as before. A shorter recording
+     * drops the analysis of the removed tail.
+     *
+     * @param   x   the whole recording
+     */
+    void Update(const SignalView &x);
+
+    /**
+     * Segments of the recording as of the last Update()
+     */
+    const std::vector<segment_t> & GetSegments() const;
+
+    /**
+     * Number of frames the last Update() ran spectral analysis for
+     */
+    uint32_t FramesAnalysed() const;
+
+    /**
+     * Number of frames the last Update() propagated decoding over
+     */
+    uint32_t FramesDecoded() const;
+
+    /**
+     * Forget the recording, the next Update() analyses it from scratch
+     */
+    void Reset();
+};
+
+}
+
+/** @} */
@@ -26,7 +26,7 @@
 
 #pragma once
 
-#include <map>
+#include <stdexcept>
 #include <vector>
 
 #include "lmtypes.h"
@@ -51,56 +51,91 @@ typedef enum {
 
 typedef float tpl_score_t;
 
+/**
+ * Number of scale degrees a chord quality template is defined over (up to 13th)
+ */
+#define CHORD_TPL_DEGREES       13
+
+/**
+ * Largest number of slash subtypes a chord quality has
+ */
+#define CHORD_TPL_SUBTYPES_MAX  4
+
+/**
+ * Number of values in a theoretical template: bass and treble pitch classes
+ */
+#define CHORD_TPL_SIZE          (notes_Total * 2)
+
 
 typedef class ChordTpl {
 
 private:
-    static std::map<chord_quality_t, std::vector<std::vector<note_presense_state_t>>> chord_qlty_tpls_;
+    note_t              root_note_;
+    note_t              bass_note_ = note_Unknown;
+    int8_t              bass_interval_ = -1;
+    chord_quality_t     chord_quality_;
+    const amplitude_t   *tpl_;
+    size_t              size_;
 
-    note_t                      root_note_;
-    note_t                      bass_note_ = note_Unknown;
-    int8_t                      bass_interval_ = -1;
-    chord_quality_t             chord_quality_;
-    std::vector<amplitude_t>    tpl_;
-
-    void InitTpl_(note_t note, chord_quality_t cq, uint8_t slash_subtype);
+    /**
+     * Write the template of a chord into \p values
+     */
+    void InitTpl_(note_t note, chord_quality_t cq, uint8_t slash_subtype, amplitude_t *values);
 
     /**
      * Initialize template instance for N chord
      */
-    void InitN_();
+    void InitN_(amplitude_t *values);
 
     /**
      * Post initialization step
      */
-    void PostInit_(float boost);
+    static void PostInit_(amplitude_t *values, size_t size, float boost);
 
 public:
     /**
      * Constructor
      *
-     * Used for theoretical template generation
+     * Used for theoretical template generation. The template is written to
+     * \p values, which has to keep CHORD_TPL_SIZE elements for as long as the
+     * instance is used.
      */
-    ChordTpl(note_t note, chord_quality_t cq, uint8_t slash_subtype);
+    ChordTpl(note_t note, chord_quality_t cq, uint8_t slash_subtype, amplitude_t *values);
 
     /**
      * Constructor
      *
-     * Used for creating a class instance for HMM training results
+     * Used for creating a class instance for HMM training results, \p tpl
+     * has to outlive the instance. N is note_Unknown with cq_unknown.
      */
-    ChordTpl(note_t note, chord_quality_t cq, std::vector<prob_t> &tpl);
+    ChordTpl(note_t note, chord_quality_t cq, const std::vector<prob_t> &tpl);
+
+    tpl_score_t GetScore(pcp_t *pcp) const;
 
-    tpl_score_t GetScore(pcp_t *pcp);
+    tpl_score_t GetSalience(pcp_t *pcp) const;
 
-    tpl_score_t GetSalience(pcp_t *pcp);
+    note_t RootNote() const;
 
-    note_t RootNote();
+    note_t BassNote() const;
 
-    note_t BassNote();
+    chord_quality_t Quality() const;
 
-    chord_quality_t Quality();
+    /**
+     * Template values in the same layout as PitchClsProfile::getValues()
+     */
+    const amplitude_t * Values() const;
 
-    static size_t SlashSubtypesCnt(chord_quality_t q);
+    /**
+     * Number of template values
+     */
+    size_t Size() const;
+
+    static constexpr size_t SlashSubtypesCnt(chord_quality_t q)
+    {
+        return ((q < cq_Min) || (q > cq_Max)) ?
+                   throw std::invalid_argument("ChordTpl::SlashSubtypesCnt(): Invalid chord quality") :
+               ((q == cq_maj) || (q == cq_min)) ? CHORD_TPL_SUBTYPES_MAX : 1;
+    }
 
     friend std::ostream& operator<<(std::ostream& os, const ChordTpl& tpl);
 
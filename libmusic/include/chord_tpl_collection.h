@@ -26,11 +26,10 @@
 
 #pragma once
 
-#include <map>
-#include <memory>
 #include <vector>
 
 #include "lmtypes.h"
+#include "chord_model.h"
 #include "chord_tpl.h"
 #include "pitch_cls_profile.h"
 
@@ -40,27 +39,39 @@ namespace anatomist {
 class ChordTplCollection {
 
 private:
-    std::vector<chord_tpl_t *>  tpls_;
+    /**
+     * Either the templates all theoretical collections share or own_tpls_
+     */
+    const std::vector<chord_tpl_t>              *tpls_;
+    std::vector<chord_tpl_t>                    own_tpls_;
+    std::vector<std::vector<amplitude_t>>       hmm_values_;
 
-    void ClearChordTpls_();
-    void InitChordTpls_();
-    void InitFromHmm_();
+    void InitFromHmm_(const ChordModel &model);
     void InitTheoretical_();
 
 public:
     /**
      * Constructor
+     *
+     * Creates the theoretical templates
      */
     ChordTplCollection();
 
     /**
-     * Destructor
+     * Constructor
+     *
+     * Creates the templates of every state of a trained model, in the order
+     * of its states
      */
-    ~ChordTplCollection();
+    explicit ChordTplCollection(const ChordModel &model);
+
+    ChordTplCollection(const ChordTplCollection &) = delete;
+
+    ChordTplCollection & operator=(const ChordTplCollection &) = delete;
 
     size_t Size();
 
-    chord_tpl_t * GetTpl(uint32_t idx);
+    const chord_tpl_t * GetTpl(uint32_t idx);
 
     /**
      *
@@ -30,14 +30,27 @@
 //#define CFG_DYNAMIC_WINDOW
 #endif
 
+/**
+ * @brief Defaults of AnalysisConfig: transform, window and hop, FFT size,
+ *        window function and self-transition probability below can all be
+ *        changed at runtime, see AnalysisConfig::Preset()
+ */
 #ifndef CFG_TFT_TYPE
 #define CFG_TFT_TYPE TFT_TYPE_CONSTANTQ
 #endif /* CFG_TFT_TYPE */
 
+/**
+ * @brief Set to 1 to have every ChordDetector load the chord model trained
+ *        by lmtrain from CFG_HMM_MODEL_FILE, see ChordDetector::SetModel()
+ */
 #ifndef CFG_USE_HMM_TPLS
 #define CFG_USE_HMM_TPLS 0
 #endif /* CFG_USE_HMM_TPLS */
 
+#ifndef CFG_HMM_MODEL_FILE
+#define CFG_HMM_MODEL_FILE "chord_model.lmhm"
+#endif /* CFG_HMM_MODEL_FILE */
+
 #ifndef CFG_WINDOW_SIZE
 #define CFG_WINDOW_SIZE     ((uint32_t)4096)
 #endif /* CFG_WINDOW_SIZE */
@@ -57,6 +70,10 @@
 #define CFG_FFT_AVG_WINDOW 2
 #endif /* CFG_FFT_AVG_WINDOW */
 
+/**
+ * @brief Harmonics of the product spectrum BeatDetector works with, chord
+ *        analysis takes them from AnalysisConfig::hps_harmonics
+ */
 #ifndef CFG_FFT_HPS_HARMONICS
 #define CFG_FFT_HPS_HARMONICS   3
 #endif /* CFG_FFT_HPS_HARMONICS */
@@ -65,6 +82,28 @@
 #define CFG_WINDOW_FUNC WINDOW_FUNC_RECTANGULAR
 #endif /* CFG_WINDOW_FUNC */
 
+/**
+ * @brief Set to 1 to decimate the input before time-frequency transform
+ *
+ * Input is brought down to the lowest sample rate which is still safe for
+ * the analysed frequency range (see Decimator::SafeFactor())
+ */
+#ifndef CFG_DECIMATION
+#define CFG_DECIMATION  0
+#endif /* CFG_DECIMATION */
+
+#ifndef CFG_DECIMATION_FACTOR_MAX
+#define CFG_DECIMATION_FACTOR_MAX   8
+#endif /* CFG_DECIMATION_FACTOR_MAX */
+
+/**
+ * @brief Headroom between the highest analysed frequency and the passband
+ *        edge of the decimated signal
+ */
+#ifndef CFG_DECIMATION_MARGIN
+#define CFG_DECIMATION_MARGIN   1.1
+#endif /* CFG_DECIMATION_MARGIN */
+
 #ifndef CFG_PITCH_PRECISION_THRESHOLD
 /** @brief Determines pitch detection precision measured in octaves
  * If validated frequency does not fulfill precision requirements
@@ -88,6 +127,68 @@
 #define CFG_BEAT_INTERVAL_MAX 8192
 #endif /* CFG_BEAT_INTERVAL_MAX */
 
+/**
+ * @brief Hop size in samples between onset strength frames of the BeatTracker
+ */
+#ifndef CFG_BEAT_TRACKER_HOP_SIZE
+#define CFG_BEAT_TRACKER_HOP_SIZE   512
+#endif /* CFG_BEAT_TRACKER_HOP_SIZE */
+
+/**
+ * @brief Length of the onset strength history kept by the BeatTracker
+ */
+#ifndef CFG_BEAT_TRACKER_HISTORY_SEC
+#define CFG_BEAT_TRACKER_HISTORY_SEC    6
+#endif /* CFG_BEAT_TRACKER_HISTORY_SEC */
+
+/**
+ * @brief How often the BeatTracker re-estimates tempo
+ */
+#ifndef CFG_BEAT_TRACKER_TEMPO_UPDATE_SEC
+#define CFG_BEAT_TRACKER_TEMPO_UPDATE_SEC   1
+#endif /* CFG_BEAT_TRACKER_TEMPO_UPDATE_SEC */
+
+#ifndef CFG_BEAT_TRACKER_BPM_MIN
+#define CFG_BEAT_TRACKER_BPM_MIN    60
+#endif /* CFG_BEAT_TRACKER_BPM_MIN */
+
+#ifndef CFG_BEAT_TRACKER_BPM_MAX
+#define CFG_BEAT_TRACKER_BPM_MAX    200
+#endif /* CFG_BEAT_TRACKER_BPM_MAX */
+
+/**
+ * @brief How far a peak of the normalised onset strength has to exceed the
+ *        moving median around it to be an onset, see OnsetDetector
+ */
+#ifndef CFG_ONSET_THRESHOLD
+#define CFG_ONSET_THRESHOLD     0.1
+#endif /* CFG_ONSET_THRESHOLD */
+
+/**
+ * @brief Length of the moving median window of the onset detection
+ */
+#ifndef CFG_ONSET_WINDOW_SEC
+#define CFG_ONSET_WINDOW_SEC    1.0
+#endif /* CFG_ONSET_WINDOW_SEC */
+
+/**
+ * @brief Onsets closer than that to a stronger one are dropped
+ */
+#ifndef CFG_ONSET_MIN_GAP_SEC
+#define CFG_ONSET_MIN_GAP_SEC   0.15
+#endif /* CFG_ONSET_MIN_GAP_SEC */
+
+/**
+ * @brief How to pool chromagram frames between beats before decoding
+ *
+ * One of BEAT_SYNC_NONE, BEAT_SYNC_MEAN, BEAT_SYNC_MEDIAN or BEAT_SYNC_MAX.
+ * Pooled columns are decoded instead of the frames, so chord changes land
+ * on beats and the decoder has less to do.
+ */
+#ifndef CFG_BEAT_SYNC
+#define CFG_BEAT_SYNC BEAT_SYNC_NONE
+#endif /* CFG_BEAT_SYNC */
+
 #ifndef CFG_SILENCE_THRESHOLD_DB
 #define CFG_SILENCE_THRESHOLD_DB -34
 #endif /* CFG_SILENCE_THRESHOLD_DB */
@@ -104,6 +205,40 @@
 #define CFG_CHORD_SELF_TRANSITION_P 0.1f
 #endif /* CFG_CHORD_SELF_TRANSITION_P */
 
+/**
+ * @brief Default of AnalysisConfig::viterbi_threads, the number of threads
+ *        to decode independent regions of the chord sequence with
+ *
+ * 0 means one per hardware thread. Callers which run a detector per core,
+ * e.g. lmserver or lmeval, keep it at 1, otherwise every one of them would
+ * start as many threads again.
+ */
+#ifndef CFG_VITERBI_THREADS
+#define CFG_VITERBI_THREADS 1
+#endif /* CFG_VITERBI_THREADS */
+
+/**
+ * @brief Set to 1 to collect per-stage timing and allocation statistics
+ *
+ * See StatsCollector. When 0 the instrumentation compiles to nothing.
+ *
+ * Allocations are counted by replacing the global operator new and delete,
+ * which affects the whole process the library is loaded into, not just the
+ * library: every allocation of the application and of other libraries goes
+ * through the counting operators too. Meant for tests and benchmarks,
+ * release builds which are linked into other applications should keep it 0.
+ */
+#ifndef CFG_STATS
+#define CFG_STATS 0
+#endif /* CFG_STATS */
+
+/**
+ * @brief Seconds of audio RTChordWorker can queue before it starts dropping frames
+ */
+#ifndef CFG_RT_QUEUE_SEC
+#define CFG_RT_QUEUE_SEC    2
+#endif /* CFG_RT_QUEUE_SEC */
+
 #ifndef CFG_HARTE_SYNTAX
 #define CFG_HARTE_SYNTAX 1
 #endif /* CFG_HARTE_SYNTAX */
@@ -27,8 +27,10 @@
 #pragma once
 
 #include "CQBase.h"
+#include "CQParameters.h"
 #include "CQSpectrogram.h"
 
+#include "analysis_config.h"
 #include "lmtypes.h"
 #include "tft.h"
 
@@ -37,9 +39,14 @@ namespace anatomist {
 typedef class CQTWrapper : public TFT {
 
 private:
+    CQParameters    cq_params_;
     CQSpectrogram   *cq_spectrogram_;
+    uint32_t        win_cols_;      /**< transform columns summed into a frame */
 
-    log_spectrogram_t ConvertRealBlock_(CQBase::RealBlock &block);
+    /**
+     * Sum transform columns into frames, at most \p frames of them
+     */
+    log_spectrogram_t ConvertRealBlock_(CQBase::RealBlock &block, size_t frames);
 
 public:
 
@@ -49,9 +56,21 @@ public:
     CQTWrapper(freq_hz_t f_low, freq_hz_t f_high, uint32_t sample_rate,
                uint16_t win_size, uint16_t hop_size);
 
+    /**
+     * Constructor, window and hop sizes are taken from \p config
+     */
+    CQTWrapper(freq_hz_t f_low, freq_hz_t f_high, uint32_t sample_rate,
+               const AnalysisConfig &config);
+
     ~CQTWrapper();
 
-    void Process(const td_t & td, uint32_t offset) override;
+    uint32_t Alignment() override;
+
+    uint32_t Context() override;
+
+    void Reset() override;
+
+    void Process(const SignalView & td, uint32_t offset) override;
 
     uint8_t BinsPerSemitone() override;
 
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file        decimator.h
+ * @brief       Anti-aliased decimation front end for time-frequency transforms
+ *
+ * Chord recognition does not look above a few kHz while audio usually comes
+ * at 44.1 or 48 kHz. Bringing the input down to the lowest sample rate which
+ * is still safe for the analysed frequency range makes every transform
+ * downstream proportionally cheaper. Filtering is done by polyphase
+ * Resampler from ext/cqtt.
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include "lmtypes.h"
+#include "signal_view.h"
+
+class Resampler;
+
+namespace anatomist {
+
+class Decimator {
+
+private:
+    Resampler       *resampler_;
+    const uint32_t  samplerate_;
+    const uint32_t  factor_;
+
+public:
+    /**
+     * Constructor
+     *
+     * @param   samplerate  sample rate of the input
+     * @param   factor      decimation factor, has to divide \p samplerate
+     */
+    Decimator(uint32_t samplerate, uint32_t factor);
+
+    ~Decimator();
+
+    Decimator(const Decimator &) = delete;
+
+    Decimator & operator=(const Decimator &) = delete;
+
+    /**
+     * Find the largest decimation factor which keeps \p f_max safely below
+     * the Nyquist frequency of the decimated signal
+     *
+     * Only power of two factors up to CFG_DECIMATION_FACTOR_MAX which divide
+     * \p samplerate are considered so the output sample rate stays integer.
+     *
+     * @param   samplerate  sample rate of the input
+     * @param   f_max       highest frequency of interest
+     * @return  decimation factor, 1 if decimation is not possible
+     */
+    static uint32_t SafeFactor(uint32_t samplerate, freq_hz_t f_max);
+
+    /**
+     * Decimate the whole signal
+     *
+     * Output is latency compensated, i.e. sample i of the output corresponds
+     * to the sample i * Factor() of the input.
+     *
+     * @param   td      time domain data
+     * @return  decimated time domain
+     */
+    td_t Process(const SignalView &td);
+
+    /**
+     * Same as Process(SignalView(td, samples))
+     */
+    td_t Process(const amplitude_t *td, uint32_t samples);
+
+    uint32_t Factor();
+
+    /**
+     * Number of input samples past sample i * Factor() which affect output
+     * sample i
+     */
+    uint32_t Latency();
+
+    uint32_t OutputSampleRate();
+};
+
+}
+
+/** @} */
@@ -60,6 +60,8 @@ public:
 
     uint16_t getDownsampleFactor();
 
+    const std::vector<amplitude_t> & getValues() const;
+
     bool isSilence(uint32_t startIdx, uint32_t endIdx);
 
     friend std::ostream& operator<<(std::ostream& os, const Envelope& e);
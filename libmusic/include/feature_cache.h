@@ -0,0 +1,101 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file        feature_cache.h
+ * @brief       Persistent chromagram cache
+ *
+ * Everything up to and including chromagram calculation is the expensive
+ * part of chord recognition while decoding is cheap. The cache keeps
+ * chromagrams on disk so that re-running the analysis of the same audio
+ * with different decoding parameters (transition probabilities, template
+ * set) skips the spectral analysis altogether.
+ *
+ * Each entry is a file named after its key. The file consists of a fixed
+ * header followed by the chromagram stored column by column, i.e. values
+ * of every pitch class over all frames are contiguous. Files are memory
+ * mapped for loading.
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include <string>
+
+#include "lmtypes.h"
+#include "pitch_cls_profile.h"
+#include "signal_view.h"
+
+namespace anatomist {
+
+class FeatureCache {
+
+private:
+    const std::string dir_;
+
+    std::string Path_(uint64_t key);
+
+public:
+    /**
+     * Constructor
+     *
+     * @param   dir     existing directory to keep the cache in
+     */
+    FeatureCache(const std::string &dir);
+
+    /**
+     * Build a key for the audio and analysis parameters
+     *
+     * @param   td          time domain data
+     * @param   samplerate  sample rate of \p td
+     * @param   params      description of every parameter the features
+     *                      depend on
+     * @return  cache key
+     */
+    static uint64_t Key(const SignalView &td, uint32_t samplerate, const std::string &params);
+
+    /**
+     * Look up a cached chromagram
+     *
+     * @param   key         cache key
+     * @param   chromagram  output chromagram
+     * @param   interval    output distance between chromagram frames
+     *                      in samples
+     * @return  true if found, false otherwise
+     */
+    bool Load(uint64_t key, chromagram_t *chromagram, uint32_t *interval);
+
+    /**
+     * Save the chromagram to the cache
+     *
+     * An entry is written to a temporary file first and then renamed so
+     * concurrent readers never see partially written entries. Every call
+     * gets a temporary file of its own, so the same key can be stored by
+     * several threads at once.
+     *
+     * @throws  std::runtime_error if the entry could not be written
+     */
+    void Store(uint64_t key, const chromagram_t &chromagram, uint32_t interval);
+};
+
+}
+
+/** @} */
@@ -103,8 +103,9 @@ private:
      *
      * @param fd_magnitudes frequency domain
      * @param fd_len        length of the \p fd_magnitudes
+     * @param harmonics     number of harmonics to multiply
      */
-    void ToHPS_(amplitude_t *fd_magnitudes, uint32_t fd_len);
+    void ToHPS_(amplitude_t *fd_magnitudes, uint32_t fd_len, uint32_t harmonics);
 
     /**
      *  Attenuate frequencies lower than \p freq to 0
@@ -122,12 +123,19 @@ private:
     void Inverse(std::vector<complex_t> & input);
 
 public:
+    /**
+     * Constructor
+     *
+     * @param   hps_harmonics   harmonics of the harmonic product spectrum to
+     *                          compute, 1 for the plain spectrum. Polar only
+     */
     FFT(amplitude_t *td, uint32_t td_len, uint32_t samplerate, freq_hz_t f_low,
-        freq_hz_t f_high, bool polar, bool hps);
+        freq_hz_t f_high, bool polar, uint32_t hps_harmonics);
 
     FFT(amplitude_t *td, uint32_t td_len, uint32_t samplerate, bool polar);
 
-    FFT(td_t td, uint32_t samplerate, freq_hz_t f_low, freq_hz_t f_high);
+    FFT(td_t td, uint32_t samplerate, freq_hz_t f_low, freq_hz_t f_high,
+        uint32_t hps_harmonics = 1);
 
     ~FFT();
 
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include "analysis_config.h"
 #include "pitch_calculator.h"
 #include "tft.h"
 
@@ -35,6 +36,8 @@ class FFTWrapper : public TFT {
 
 private:
     PitchCalculator     &pc_ = PitchCalculator::getInstance();
+    uint32_t            window_func_;
+    uint32_t            hps_harmonics_;
 
     /**
      * Performs logarithmic pruning of FFT frequencies
@@ -48,9 +51,16 @@ public:
     FFTWrapper(freq_hz_t f_low, freq_hz_t f_high, uint32_t sample_rate,
                uint16_t win_size, uint16_t hop_size);
 
+    /**
+     * Constructor, window and hop sizes, window function and HPS harmonics
+     * are taken from \p config
+     */
+    FFTWrapper(freq_hz_t f_low, freq_hz_t f_high, uint32_t sample_rate,
+               const AnalysisConfig &config);
+
     ~FFTWrapper() {}
 
-    void Process(const td_t & td, uint32_t offset) override;
+    void Process(const SignalView & td, uint32_t offset) override;
 
     uint8_t BinsPerSemitone() override;
 
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file        goertzel_bank.h
+ * @brief       Filterbank evaluating only the pitch frequencies
+ *
+ * FFT based transform computes thousands of bins and keeps a few hundred,
+ * the bank evaluates DFT right at BinToFreq() frequencies instead. Every
+ * window is either processed with a bank of Goertzel filters or, when
+ * windows overlap a lot, the DFT at each frequency is slid sample by sample
+ * so that cost does not depend on the hop size. Both modes apply Hann
+ * window and produce the same result.
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "analysis_config.h"
+#include "pitch_calculator.h"
+#include "tft.h"
+
+namespace anatomist {
+
+class GoertzelBank : public TFT {
+
+public:
+    typedef enum {
+        MODE_AUTO = 0,
+        MODE_GOERTZEL,
+        MODE_SLIDING,
+    } mode_t;
+
+private:
+    PitchCalculator         &pc_ = PitchCalculator::getInstance();
+
+    mode_t                  mode_;
+
+    /**
+     * Angular frequency of every bin in radians per sample
+     */
+    std::vector<amplitude_t> omega_;
+
+    std::vector<amplitude_t> window_;
+
+    void ProcessGoertzel_(const SignalView &td, uint32_t offset);
+
+    void ProcessSliding_(const SignalView &td, uint32_t offset);
+
+public:
+    /**
+     * Constructor
+     *
+     * @param   mode    MODE_AUTO picks sliding DFT when hop size is small
+     *                  compared to window size
+     */
+    GoertzelBank(freq_hz_t f_low, freq_hz_t f_high, uint16_t bpo, uint32_t sample_rate,
+                 uint16_t win_size, uint16_t hop_size, mode_t mode = MODE_AUTO);
+
+    GoertzelBank(freq_hz_t f_low, freq_hz_t f_high, uint32_t sample_rate,
+                 uint16_t win_size, uint16_t hop_size);
+
+    /**
+     * Constructor, window and hop sizes are taken from \p config
+     */
+    GoertzelBank(freq_hz_t f_low, freq_hz_t f_high, uint32_t sample_rate,
+                 const AnalysisConfig &config);
+
+    ~GoertzelBank() {}
+
+    void Process(const SignalView & td, uint32_t offset) override;
+
+    uint8_t BinsPerSemitone() override;
+
+    uint32_t FreqToBin(freq_hz_t f) override;
+
+    freq_hz_t BinToFreq(uint32_t idx) override;
+
+    mode_t Mode();
+};
+
+}
+
+/** @} */
@@ -26,9 +26,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <stdint.h>
 #include <vector>
-#include <fstream>
 
 #include "lmtypes.h"
 
@@ -67,6 +67,11 @@ public:
      */
     static bool isPowerOf2(uint32_t n);
 
+    /**
+     * Least common multiple of two positive numbers
+     */
+    static uint32_t lcm(uint32_t a, uint32_t b);
+
     static std::vector<complex_t> timeDomain2ComplexVector(amplitude_t *, uint32_t, uint32_t);
 
     /**
@@ -124,34 +129,30 @@ public:
         return median;
     }
 
+    /**
+     * Return median of [first, last) without copying, the range is reordered
+     */
     template<typename T>
-    static void lm_helpers_peep(const char *name, const std::vector<std::vector<T>> & matrix)
+    static T median(T *first, T *last)
     {
-        const char *path = getenv(name);
-        if (!path)
-            return;
-        std::ofstream csv(path, std::ios::out | std::ios::trunc);
-        if (csv.is_open()) {
-            for (auto &row : matrix) {
-                for (auto &value: row)
-                    csv << value << ",";
-                csv.seekp(-1, std::ios_base::end);
-                csv << std::endl;
-            }
-            csv.close();
+        size_t size = last - first;
+
+        if (size == 0) {
+            throw std::invalid_argument("median(): empty range");
+        } else if (size == 1) {
+            return first[0];
         }
-    }
-    template<typename T>
-    static void lm_helpers_peep(const char *name, const std::vector<T> & vect)
-    {
-        lm_helpers_peep(name, std::vector<std::vector<T>>(1, vect));
+
+        T *mid = first + size / 2;
+
+        std::nth_element(first, mid, last);
+
+        if (size % 2) {
+            return *mid;
+        }
+
+        return (*mid + *std::max_element(first, mid)) / 2;
     }
 };
 
-#ifndef NDEBUG
-    #define LM_PEEP(name, var) Helpers::lm_helpers_peep(#name, (var))
-#else
-    #define LM_PEEP(name, var) UNUSED(var) // make release build happpy
-#endif
-
 /** @} */
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file        lmstats.h
+ * @brief       Per-stage timing and allocation statistics
+ *
+ * Processing stages are wrapped with LM_STATS_SCOPE() which records wall
+ * time, number of frames processed and bytes allocated with operator new
+ * into the StatsCollector installed for the calling thread, if any.
+ * Frames are counted in samples for the time domain stages. Stages may be
+ * nested (e.g. "denoise" runs within "tft"), figures of a stage include
+ * everything called from it.
+ *
+ * Unless the library is built with CFG_STATS the macros expand to nothing
+ * and collectors stay empty. With CFG_STATS the library replaces the global
+ * operator new and delete for the whole process, see config.h.
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "config.h"
+
+namespace anatomist {
+
+/**
+ * Figures accumulated over all the runs of a single stage
+ */
+typedef struct {
+    std::string name;
+    uint32_t    calls;
+    uint64_t    wall_ns;
+    uint64_t    frames;     /**< or samples for time domain stages */
+    uint64_t    bytes;      /**< allocated with operator new */
+} stage_stats_t;
+
+typedef std::vector<stage_stats_t> stats_t;
+
+/**
+ * Sink for the stage statistics of the calling thread
+ *
+ * Collector installs itself on construction and uninstalls on destruction.
+ * Collectors can be nested, in which case the inner one passes everything
+ * it has collected to the outer one when destroyed.
+ */
+class StatsCollector {
+
+private:
+    stats_t         stats_;
+    StatsCollector  *outer_;
+
+public:
+    StatsCollector();
+
+    ~StatsCollector();
+
+    StatsCollector(const StatsCollector &) = delete;
+
+    StatsCollector & operator=(const StatsCollector &) = delete;
+
+    /**
+     * Add figures of a single stage run
+     */
+    void Add(const std::string &name, uint32_t calls, uint64_t wall_ns,
+             uint64_t frames, uint64_t bytes);
+
+    /**
+     * Statistics in order of the stages first appearance
+     */
+    const stats_t & Stats() const;
+
+    /**
+     * Collector installed for the calling thread, null if none
+     */
+    static StatsCollector * Current();
+
+    /**
+     * Total bytes allocated with operator new by the calling thread,
+     * always 0 unless built with CFG_STATS
+     */
+    static uint64_t AllocatedBytes();
+};
+
+/**
+ * RAII helper to measure a stage, see LM_STATS_SCOPE()
+ */
+class StatsScope {
+
+private:
+    const char *name_;
+    uint64_t    frames_;
+    uint64_t    bytes_start_;
+    std::chrono::steady_clock::time_point start_;
+
+public:
+    StatsScope(const char *name);
+
+    ~StatsScope();
+
+    void SetFrames(uint64_t frames);
+};
+
+}
+
+#if CFG_STATS
+#define LM_STATS_SCOPE(name)    anatomist::StatsScope lm_stats_scope_(name)
+#define LM_STATS_FRAMES(n)      lm_stats_scope_.SetFrames(n)
+#else
+#define LM_STATS_SCOPE(name)
+#define LM_STATS_FRAMES(n)
+#endif /* CFG_STATS */
+
+/** @} */
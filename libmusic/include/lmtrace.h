@@ -0,0 +1,152 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file        lmtrace.h
+ * @brief       Binary dumps of the intermediate processing results
+ *
+ * Tracing is enabled once at startup with Trace::Enable(). After that
+ * every LM_TRACE() writes its matrix or vector to <dir>/<name>.npy in
+ * NumPy format, so the dumps can be loaded with numpy.load() as is.
+ * Floating point data is stored as float32, integer data as int32.
+ * Repeated dumps with the same name get a counter suffix, e.g.
+ * chromagram.1.npy. In asynchronous mode files are written by a
+ * background thread and the caller only pays for a copy of the data.
+ *
+ * When tracing is disabled LM_TRACE() costs a single branch, which is why
+ * it is kept in release builds as well.
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace anatomist {
+
+class Trace {
+
+private:
+    static bool enabled_;
+
+    /**
+     * Queue serialized data for writing to <dir>/<name>.npy
+     */
+    static void Write_(const char *name, const char *descr, uint32_t rows,
+                       uint32_t cols, bool is_vector, std::vector<char> &data);
+
+    template<typename T>
+    using stored_t = typename std::conditional<std::is_integral<T>::value,
+                                               int32_t, float>::type;
+
+    template<typename T>
+    static const char * Descr_()
+    {
+        return std::is_integral<T>::value ? "<i4" : "<f4";
+    }
+
+public:
+    /**
+     * Start tracing
+     *
+     * Is supposed to be called once at startup, before any processing
+     * takes place.
+     *
+     * @param   dir     existing directory to put dumps to
+     * @param   async   write files from a background thread
+     */
+    static void Enable(const std::string &dir, bool async = true);
+
+    /**
+     * Stop tracing and wait until all pending dumps are written
+     */
+    static void Disable();
+
+    static bool Enabled()
+    {
+        return enabled_;
+    }
+
+    /**
+     * Dump a matrix row by row
+     *
+     * Empty rows, e.g. spectrogram columns of skipped silent frames, are
+     * written as zeros, all the others have to be of the same length.
+     */
+    template<typename T>
+    static void Dump(const char *name, const std::vector<std::vector<T>> &matrix)
+    {
+        uint32_t cols = 0;
+
+        for (auto &row : matrix) {
+            if (!row.empty()) {
+                cols = row.size();
+                break;
+            }
+        }
+
+        /* zero filled, which is what empty rows are left as */
+        std::vector<char> data(matrix.size() * cols * sizeof(stored_t<T>), 0);
+        stored_t<T> *out = reinterpret_cast<stored_t<T> *>(data.data());
+
+        for (auto &row : matrix) {
+            if (row.empty()) {
+                out += cols;
+                continue;
+            }
+            if (row.size() != cols) {
+                throw std::invalid_argument("Trace::Dump(): rows of different length");
+            }
+            for (auto &value : row) {
+                *out++ = static_cast<stored_t<T>>(value);
+            }
+        }
+
+        Write_(name, Descr_<T>(), matrix.size(), cols, false, data);
+    }
+
+    template<typename T>
+    static void Dump(const char *name, const std::vector<T> &vect)
+    {
+        std::vector<char> data(vect.size() * sizeof(stored_t<T>));
+        stored_t<T> *out = reinterpret_cast<stored_t<T> *>(data.data());
+
+        for (auto &value : vect) {
+            *out++ = static_cast<stored_t<T>>(value);
+        }
+
+        Write_(name, Descr_<T>(), 1, vect.size(), true, data);
+    }
+};
+
+}
+
+#define LM_TRACE(name, var)                                 \
+    do {                                                    \
+        if (anatomist::Trace::Enabled()) {                  \
+            anatomist::Trace::Dump(#name, (var));           \
+        }                                                   \
+    } while (0)
+
+/** @} */
@@ -30,6 +30,7 @@
 #include <complex>
 #include <map>
 #include <stdint.h>
+#include <type_traits>
 #include <vector>
 
 #include "config.h"
@@ -43,6 +44,12 @@
 
 #define TFT_TYPE_FFT        1
 #define TFT_TYPE_CONSTANTQ  2
+#define TFT_TYPE_GOERTZEL   3
+
+#define BEAT_SYNC_NONE      0
+#define BEAT_SYNC_MEAN      1
+#define BEAT_SYNC_MEDIAN    2
+#define BEAT_SYNC_MAX       3
 
 typedef double amplitude_t;
 typedef double freq_hz_t;
@@ -51,7 +58,7 @@ typedef std::complex<amplitude_t> complex_t;
 typedef std::vector<amplitude_t> td_t;  /* time domain      */
 typedef std::vector<amplitude_t> fd_t;  /* frequency domain */
 
-typedef enum {
+typedef enum : uint8_t {
     note_Unknown = 0,   // all note_t variables will be initialized as "unknown" by default
     note_C,
     note_C_sharp,
@@ -92,7 +99,7 @@ typedef enum : int32_t {
     OCTAVES_CNT = OCTAVE_MAX - OCTAVE_MIN + 1
 } octave_t;
 
-typedef enum {
+typedef enum : uint8_t {
     cq_unknown = 0,
     cq_maj,
     cq_min,
@@ -124,8 +131,10 @@ typedef enum {
     cq_Max = cq_min13
 } chord_quality_t;
 
-#include <unordered_set>
-typedef std::unordered_set<note_t, std::hash<int>> pcset_t;
+/**
+ * Set of pitch classes: bit (note - note_Min) is set for every note present
+ */
+typedef uint16_t pcset_t;
 pcset_t make_pcset(note_t, chord_quality_t);
 
 std::ostream& operator<<(std::ostream& os, const chord_quality_t& q);
@@ -137,7 +146,7 @@ private:
     note_t          __mBassNote;
     int8_t          __mBassInterval;
     chord_quality_t __mQuality;
-    pcset_t         __mPCset;
+    pcset_t         __mPCset;       /* what match() compares */
 
 public:
     Chord(note_t n, chord_quality_t q, note_t b = note_Unknown, int8_t bi = -1) :
@@ -174,6 +183,16 @@ public:
         return __mPCset == c.__mPCset;
     }
 
+    note_t rootNote() const
+    {
+        return __mRootNote;
+    }
+
+    chord_quality_t quality() const
+    {
+        return __mQuality;
+    }
+
     std::string toHarte() const
     {
         std::ostringstream ss;
@@ -218,4 +237,7 @@ public:
 
 } chord_t;
 
+static_assert(std::is_trivially_copyable<chord_t>::value,
+              "chord_t has to be copied around without allocations");
+
 /** @} */
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file        onset_detector.h
+ * @brief       Onset detection over an already computed spectrogram
+ *
+ * Onsets come almost for free with chord recognition, as the spectrogram
+ * chromagram is built from is all they need:
+ *   1. Onset strength of every column is half-wave rectified spectral flux
+ *      of the log compressed magnitudes
+ *   2. Peaks of the strength are onsets if they are the strongest within
+ *      CFG_ONSET_MIN_GAP_SEC and exceed the moving median around them by
+ *      CFG_ONSET_THRESHOLD (adaptive thresholding)
+ *
+ * Time resolution is the one of the spectrogram, see TFT::SpectrogramInterval().
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "lmtypes.h"
+#include "tft.h"
+
+namespace anatomist {
+
+class OnsetDetector {
+
+public:
+    /**
+     * Onset strength of every spectrogram column
+     *
+     * Magnitudes are normalised to the loudest bin first, so that strength
+     * does not depend on the input level. Empty columns, which are skipped
+     * by the transform, are treated as silence. The first column has nothing
+     * to be compared with, so its strength is 0.
+     *
+     * @param   sg  spectrogram
+     * @return  strength of every column in [0, 1]
+     */
+    static std::vector<amplitude_t> Strength(const log_spectrogram_t &sg);
+
+    /**
+     * Pick onsets out of the strength
+     *
+     * @param   strength    onset strength as returned by Strength()
+     * @param   interval    distance between strength frames in samples
+     * @param   sampleRate  sample rate of the input
+     * @return  indices of the onsets in samples, an onset is reported at
+     *          the start of the frame it was detected in
+     */
+    static std::vector<uint32_t> PickPeaks(const std::vector<amplitude_t> &strength,
+                                           uint32_t interval, uint32_t sampleRate);
+};
+
+}
+
+/** @} */
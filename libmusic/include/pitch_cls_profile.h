@@ -35,6 +35,19 @@
 
 namespace anatomist {
 
+/**
+ * Bass and treble windows over the semitones of a spectrum
+ *
+ * They only depend on the transform, so are computed once per chromagram
+ * with PitchClsProfile::Windows()
+ */
+struct pcp_windows_t {
+    const amplitude_t  *bass;
+    size_t              bass_len;
+    const amplitude_t  *treble;
+    size_t              treble_len;
+};
+
 typedef class PitchClsProfile {
 
 private:
@@ -48,6 +61,13 @@ private:
      * Because amplitudes in chord type templates are defined as 0 and 1
      */
     void __normalize();
+
+    /**
+     * Fold spectrum magnitudes into bass and treble pitch classes weighted
+     * by the windows over the semitones
+     */
+    void __fromMagnitudes(const fd_t &fd_mags, tft_t *tft, const amplitude_t *bass_win,
+                          size_t bass_len, const amplitude_t *treble_win);
 public:
     /**
      * Constructor for creating an empty profile
@@ -58,6 +78,30 @@ public:
 
     PitchClsProfile(fd_t &fd, tft_t *tft);
 
+    /**
+     * Same as PitchClsProfile(fd_t &, tft_t *) with the windows computed in
+     * advance
+     *
+     * @param   windows windows for spectra of the size of \p fd
+     * @throws  std::invalid_argument if they are for another size
+     */
+    PitchClsProfile(const fd_t &fd, tft_t *tft, const pcp_windows_t &windows);
+
+    /**
+     * Compute the windows for spectra of \p bins bins of \p tft
+     *
+     * @param   arena   memory for the windows, they are valid until it is
+     *                  released
+     */
+    static pcp_windows_t Windows(tft_t *tft, size_t bins, Arena &arena);
+
+    /**
+     * Constructor for restoring a profile from the raw values
+     *
+     * @param   values  values as returned by getValues()
+     */
+    PitchClsProfile(const std::vector<amplitude_t> &values);
+
     /**
      * Get pitch class value for the specified note
      * @param note  note to get PCP for
@@ -68,6 +112,11 @@ public:
 
     size_t size();
 
+    /**
+     * Raw profile values: bass pitch classes followed by treble ones
+     */
+    const std::vector<amplitude_t> & getValues() const;
+
     template<typename T> amplitude_t euclideanDistance(std::vector<T> &v)
     {
         if (v.size() != __mPCP.size()) {
@@ -90,6 +139,8 @@ public:
 
     amplitude_t sumProduct(std::vector<amplitude_t> &v);
 
+    amplitude_t sumProduct(const amplitude_t *v, size_t size);
+
     PitchClsProfile & operator+=(const PitchClsProfile& pcp);
 
     PitchClsProfile & operator/=(float denominator);
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file        rt_chord_analyzer.h
+ * @brief       Real-time safe chord recognition
+ *
+ * Unlike ChordDetector::getChord() the analyzer is meant to be called from
+ * an audio callback: all buffers, the FFT plan, the spectrum to chroma
+ * mapping and the chords to be returned are prepared at construction, so
+ * Process() neither allocates memory nor takes locks.
+ *
+ * Every block completes a window of the latest input, which is windowed,
+ * transformed with a real FFT and folded into bass and treble chroma,
+ * scored against every chord template and fed to an online max-product
+ * (Viterbi) filter with the same self-transition probability as the offline
+ * decoder, which keeps the output from flickering between chords. Windows
+ * overlap if the analyzer is constructed with more than one hop per window,
+ * e.g. with the "lowlatency" preset, which updates the estimate every 23 ms
+ * at 44.1 kHz.
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "kiss_fftr.h"
+
+#include "analysis_config.h"
+#include "lmtypes.h"
+
+namespace anatomist {
+
+class RTChordAnalyzer {
+
+private:
+    typedef struct {
+        uint32_t    bin;
+        uint8_t     pitch_cls;
+        amplitude_t bass_weight;
+        amplitude_t treble_weight;
+    } chroma_bin_t;
+
+    const uint32_t              samplerate_;
+    const uint32_t              win_size_;
+    const uint32_t              block_size_;
+    uint32_t                    fft_size_;
+    kiss_fftr_cfg               fft_cfg_;
+
+    /**
+     * Latest win_size_ samples, the oldest first
+     */
+    std::vector<amplitude_t>    history_;
+    std::vector<amplitude_t>    window_;
+    std::vector<amplitude_t>    frame_;
+    std::vector<kiss_fft_cpx>   fd_;
+    std::vector<chroma_bin_t>   chroma_bins_;
+    std::vector<amplitude_t>    pcp_;
+
+    /**
+     * Chord templates, PCP size values per template
+     */
+    std::vector<amplitude_t>    tpls_;
+    std::vector<chord_t>        chords_;
+    uint32_t                    n_idx_;
+
+    /**
+     * Log-probabilities of the best path ending in every chord
+     */
+    std::vector<amplitude_t>    delta_;
+    amplitude_t                 log_self_p_;
+    amplitude_t                 log_other_p_;
+    uint32_t                    current_;
+
+    amplitude_t                 silence_power_;
+
+    RTChordAnalyzer(uint32_t samplerate, uint32_t win_size, uint32_t block_size,
+                    uint32_t fft_size, uint32_t window_func, amplitude_t self_p);
+
+    void InitChromaBins_();
+
+    void InitTemplates_(amplitude_t self_p);
+
+    void ResetPath_();
+
+    template<typename T> const chord_t & Process_(const T *block);
+
+public:
+    /**
+     * Constructor, Hamming windows of a block each, FFT size and
+     * self-transition probability are the defaults of AnalysisConfig
+     *
+     * @param   samplerate  sample rate of the audio
+     * @param   block_size  number of samples passed to every Process() call
+     */
+    RTChordAnalyzer(uint32_t samplerate, uint32_t block_size);
+
+    /**
+     * Constructor
+     *
+     * Window size and function, FFT size and self-transition probability
+     * are taken from the config, blocks are a hop long. The analysis is
+     * always FFT based, tft_type and hps_harmonics are ignored.
+     *
+     * @param   samplerate  sample rate of the audio
+     * @param   config      analysis parameters, e.g. Preset("lowlatency")
+     * @throws  std::invalid_argument if the config is inconsistent
+     */
+    RTChordAnalyzer(uint32_t samplerate, const AnalysisConfig &config);
+
+    RTChordAnalyzer(uint32_t samplerate);
+
+    ~RTChordAnalyzer();
+
+    RTChordAnalyzer(const RTChordAnalyzer &) = delete;
+
+    RTChordAnalyzer & operator=(const RTChordAnalyzer &) = delete;
+
+    /**
+     * Analyse the next block, real-time safe
+     *
+     * @param   block   BlockSize() samples of single channel audio
+     * @return  chord estimate after this block, the reference stays valid
+     *          for the lifetime of the analyzer
+     */
+    const chord_t & Process(const amplitude_t *block);
+
+    const chord_t & Process(const float *block);
+
+    /**
+     * Current chord estimate, N if nothing has been processed yet
+     */
+    const chord_t & GetChord();
+
+    /**
+     * Forget the smoothing state and the input, real-time safe
+     */
+    void Reset();
+
+    uint32_t BlockSize();
+
+    /**
+     * Number of the latest samples every estimate is made from
+     */
+    uint32_t WindowSize();
+};
+
+}
+
+/** @} */
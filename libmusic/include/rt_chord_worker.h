@@ -0,0 +1,143 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file        rt_chord_worker.h
+ * @brief       Chord recognition of a live stream on a background thread
+ *
+ * Audio callback pushes interleaved float frames into a SpscRingBuffer,
+ * worker thread downmixes them into blocks for RTChordAnalyzer and
+ * publishes the result. Nothing on the audio callback side blocks or
+ * allocates, so a slow analysis can never cause priority inversion, it can
+ * only make the callback drop frames once the buffer is full.
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "chord_detector.h"
+#include "rt_chord_analyzer.h"
+#include "spsc_ring_buffer.h"
+
+namespace anatomist {
+
+class RTChordWorker {
+
+private:
+    const uint32_t                  channels_;
+    RTChordAnalyzer                 analyzer_;
+    SpscRingBuffer<float>           queue_;
+    ChordDetector::ResultsListener  *listener_;
+
+    std::vector<float>              chunk_;
+    std::vector<float>              block_;
+    uint32_t                        block_len_;
+    uint32_t                        idle_us_;
+
+    std::thread                     thread_;
+    std::atomic<bool>               running_;
+
+    std::atomic<const chord_t *>    chord_;
+    std::atomic<uint64_t>           position_;
+    std::atomic<uint64_t>           dropped_;
+
+    segment_t                       segment_;
+    const chord_t                   *segment_chord_;
+
+    void Run_();
+
+    /**
+     * Drain the queue
+     *
+     * @return  true if anything has been read
+     */
+    bool Consume_();
+
+    void OnBlock_();
+
+    void FinishSegment_();
+
+public:
+    /**
+     * Constructor
+     *
+     * @param   samplerate  sample rate of the stream
+     * @param   channels    number of interleaved channels
+     * @param   listener    optional listener, receives a segment every time
+     *                      the chord changes, is called from the worker thread
+     * @param   block_size  analysis block size in frames
+     */
+    RTChordWorker(uint32_t samplerate, uint32_t channels,
+                  ChordDetector::ResultsListener *listener = nullptr,
+                  uint32_t block_size = CFG_WINDOW_SIZE);
+
+    /**
+     * Destructor, stops the worker thread if it is running
+     */
+    ~RTChordWorker();
+
+    RTChordWorker(const RTChordWorker &) = delete;
+
+    RTChordWorker & operator=(const RTChordWorker &) = delete;
+
+    /**
+     * Start the worker thread
+     */
+    void Start();
+
+    /**
+     * Analyse everything which has been pushed so far and stop the worker
+     * thread. Listener gets the last segment and onChordAnalysisFinished().
+     */
+    void Stop();
+
+    /**
+     * Queue audio for analysis, real-time safe
+     *
+     * @param   frames      interleaved samples
+     * @param   n           number of frames
+     * @return  false if the queue is full, frames are dropped in this case
+     */
+    bool Push(const float *frames, uint32_t n);
+
+    /**
+     * Latest chord estimate, lock-free
+     */
+    const chord_t & GetChord();
+
+    /**
+     * Number of frames analysed so far
+     */
+    uint64_t GetPosition();
+
+    /**
+     * Number of frames dropped because of the queue overrun
+     */
+    uint64_t GetDropped();
+};
+
+}
+
+/** @} */
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file        signal_energy.h
+ * @brief       Constant time power queries over the time domain input
+ *
+ * Prefix sums of the squared frames are computed once per block of
+ * SIGNAL_ENERGY_BLOCK_SIZE frames, so the memory needed is a small
+ * fraction of the input while any range is answered by at most two
+ * partial blocks on its edges.
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "lmtypes.h"
+#include "signal_view.h"
+
+#define SIGNAL_ENERGY_BLOCK_SIZE   ((uint32_t)64)
+
+namespace anatomist {
+
+class SignalEnergy {
+
+private:
+    SignalView          x_;
+
+    /**
+     * Sum of the squared frames [0, i * SIGNAL_ENERGY_BLOCK_SIZE)
+     */
+    std::vector<double> prefix_;
+
+    double Sum_(size_t from, size_t to) const;
+
+public:
+    /**
+     * Constructor
+     *
+     * @param   x   input, must outlive the object
+     */
+    SignalEnergy(const SignalView &x);
+
+    /**
+     * Mean power of frames [from, to)
+     */
+    amplitude_t Power(size_t from, size_t to) const;
+
+    size_t size() const
+    {
+        return x_.size();
+    }
+};
+
+}
+
+/** @} */
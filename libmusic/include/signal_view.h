@@ -0,0 +1,120 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file        signal_view.h
+ * @brief       Non-owning view over the time domain input
+ *
+ * Lets the pipeline consume caller's buffers as they are: float or double
+ * samples, single channel or interleaved. Nothing is copied up front,
+ * frames are down-mixed only when a processing stage reads them.
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "lmtypes.h"
+
+namespace anatomist {
+
+class SignalView {
+
+private:
+    const double    *d_;
+    const float     *f_;
+    size_t          frames_;
+    uint32_t        channels_;
+    uint32_t        stride_;
+
+public:
+    /**
+     * Constructor
+     *
+     * Frame i is the average of \p channels samples starting at
+     * data[i * stride].
+     *
+     * @param   data        first sample of the first frame
+     * @param   frames      number of frames
+     * @param   channels    number of adjacent samples to be down-mixed into
+     *                      a frame
+     * @param   stride      distance between frames in samples, 0 means
+     *                      \p channels, i.e. interleaved data
+     */
+    SignalView(const double *data, size_t frames, uint32_t channels = 1, uint32_t stride = 0);
+
+    SignalView(const float *data, size_t frames, uint32_t channels = 1, uint32_t stride = 0);
+
+    /**
+     * View over the whole \p td, implicit so that td_t can be passed
+     * wherever a view is expected
+     */
+    SignalView(const td_t &td);
+
+    size_t size() const
+    {
+        return frames_;
+    }
+
+    bool empty() const
+    {
+        return frames_ == 0;
+    }
+
+    amplitude_t operator[](size_t i) const
+    {
+        const size_t pos = i * stride_;
+
+        if (channels_ == 1) {
+            return (d_ != nullptr) ? d_[pos] : f_[pos];
+        }
+
+        amplitude_t sum = 0;
+        for (uint32_t ch = 0; ch < channels_; ch++) {
+            sum += (d_ != nullptr) ? d_[pos + ch] : f_[pos + ch];
+        }
+
+        return sum / channels_;
+    }
+
+    /**
+     * Down-mix frames [from, from + n) into \p out
+     */
+    void Read(size_t from, size_t n, amplitude_t *out) const;
+
+    /**
+     * Frames as a plain array if no conversion is needed
+     *
+     * @return  nullptr unless the view is over single channel contiguous
+     *          double data
+     */
+    const amplitude_t * Contiguous() const;
+
+    /**
+     * View over frames [from, from + n)
+     */
+    SignalView Sub(size_t from, size_t n) const;
+};
+
+}
+
+/** @} */
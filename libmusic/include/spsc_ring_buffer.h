@@ -0,0 +1,159 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file        spsc_ring_buffer.h
+ * @brief       Wait-free single producer single consumer ring buffer
+ *
+ * One thread writes and another one reads, neither of them ever blocks,
+ * allocates or takes a lock, which makes the buffer suitable for passing
+ * data out of audio callbacks.
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <stddef.h>
+#include <stdexcept>
+#include <vector>
+
+#include "lmhelpers.h"
+
+namespace anatomist {
+
+template<typename T>
+class SpscRingBuffer {
+
+private:
+    std::vector<T>  buf_;
+    size_t          mask_;
+
+    /* written by the producer only, kept on separate cache lines */
+    alignas(64) std::atomic<size_t> head_;
+    /* written by the consumer only */
+    alignas(64) std::atomic<size_t> tail_;
+
+public:
+    /**
+     * Constructor
+     *
+     * @param   capacity    minimal number of items the buffer can hold,
+     *                      is rounded up to a power of 2
+     */
+    SpscRingBuffer(uint32_t capacity) : head_(0), tail_(0)
+    {
+        if (capacity == 0) {
+            throw std::invalid_argument("SpscRingBuffer(): invalid argument");
+        }
+
+        capacity = Helpers::nextPowerOf2(std::max(capacity, 2U));
+
+        buf_.resize(capacity);
+        mask_ = capacity - 1;
+    }
+
+    SpscRingBuffer(const SpscRingBuffer &) = delete;
+
+    SpscRingBuffer & operator=(const SpscRingBuffer &) = delete;
+
+    size_t Capacity() const
+    {
+        return buf_.size();
+    }
+
+    /**
+     * Append items, producer side
+     *
+     * Items are written either all or none so that e.g. frames of
+     * interleaved audio are never split by an overrun.
+     *
+     * @param   data    items to be appended
+     * @param   n       number of items
+     * @return  false if there is not enough space
+     */
+    bool Write(const T *data, size_t n)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+
+        if (buf_.size() - (head - tail) < n) {
+            return false;
+        }
+
+        size_t pos = head & mask_;
+        size_t first = std::min(n, buf_.size() - pos);
+
+        std::copy(data, data + first, buf_.begin() + pos);
+        std::copy(data + first, data + n, buf_.begin());
+
+        head_.store(head + n, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * Take items out, consumer side
+     *
+     * @param   data    output buffer
+     * @param   n       maximal number of items to be read
+     * @return  number of items read
+     */
+    size_t Read(T *data, size_t n)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+
+        n = std::min(n, head - tail);
+
+        size_t pos = tail & mask_;
+        size_t first = std::min(n, buf_.size() - pos);
+
+        std::copy(buf_.begin() + pos, buf_.begin() + pos + first, data);
+        std::copy(buf_.begin(), buf_.begin() + (n - first), data + first);
+
+        tail_.store(tail + n, std::memory_order_release);
+
+        return n;
+    }
+
+    /**
+     * Number of items which can be read, is exact on the consumer side only
+     */
+    size_t ReadAvailable() const
+    {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Number of items which can be written, is exact on the producer side only
+     */
+    size_t WriteAvailable() const
+    {
+        return buf_.size() - (head_.load(std::memory_order_relaxed) -
+                              tail_.load(std::memory_order_acquire));
+    }
+};
+
+}
+
+/** @} */
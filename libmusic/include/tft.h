@@ -28,7 +28,9 @@
 
 #include <vector>
 
+#include "arena.h"
 #include "lmtypes.h"
+#include "signal_view.h"
 
 #define BINS_PER_OCTAVE_DEFAULT 36
 
@@ -82,6 +84,21 @@ protected:
      */
     uint32_t        interval_;
 
+    /**
+     * Frames the caller does not need, see \ref SetSkipMask()
+     */
+    std::vector<bool>   skip_;
+
+    /**
+     * Where to take scratch memory of the processing from, see \ref SetArena()
+     */
+    Arena               *arena_;
+
+    bool Skip_(size_t frame)
+    {
+        return (frame < skip_.size()) && skip_[frame];
+    }
+
     void Denoise_(log_spectrogram_t &block);
 
 public:
@@ -96,11 +113,54 @@ public:
      */
     virtual ~TFT() {}
 
-    virtual log_spectrogram_t GetSpectrogram();
+    virtual const log_spectrogram_t & GetSpectrogram();
 
     virtual uint32_t SpectrogramInterval();
 
-    virtual void Process(const td_t & td, uint32_t offset) = 0;
+    /**
+     * Mark spectrogram frames which are not needed, e.g. silent ones
+     *
+     * Columns of such frames are left empty. Implementations skip as much
+     * of the work for them as the transform allows.
+     *
+     * @param   skip    flag for every frame, frames past its end are computed
+     */
+    void SetSkipMask(const std::vector<bool> &skip);
+
+    /**
+     * Take scratch memory of Process() from \p arena
+     *
+     * The owner of the arena releases it once the results are consumed.
+     * Without an arena every Process() call uses a temporary one.
+     *
+     * @param   arena   has to outlive the transform, nullptr to stop using it
+     */
+    void SetArena(Arena *arena);
+
+    /**
+     * Input positions a transform can be restarted at
+     *
+     * Processing the input from a multiple of the alignment, given
+     * \ref Context() samples before it, gives the same frames as processing
+     * from the very beginning. Measured in samples corresponding to
+     * \ref sample_rate_.
+     */
+    virtual uint32_t Alignment();
+
+    /**
+     * Number of samples around a frame which contribute to it
+     */
+    virtual uint32_t Context();
+
+    /**
+     * Drop the results and any state left from the previous signal
+     *
+     * The transform can then be reused for a new signal without being
+     * constructed again, which is expensive for some implementations.
+     */
+    virtual void Reset();
+
+    virtual void Process(const SignalView & td, uint32_t offset) = 0;
 
     virtual uint8_t BinsPerSemitone() = 0;
 
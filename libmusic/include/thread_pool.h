@@ -0,0 +1,103 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file        thread_pool.h
+ * @brief       Fixed size pool of worker threads
+ *
+ * @addtogroup  libmusic
+ * @{
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace anatomist {
+
+class ThreadPool {
+
+private:
+    std::vector<std::thread>            workers_;
+    std::mutex                          mutex_;
+    std::condition_variable             work_cv_;
+    std::condition_variable             done_cv_;
+
+    /* current job, guarded by mutex_ */
+    std::function<void(uint32_t)>       fn_;
+    uint32_t                            tasks_;
+    uint32_t                            next_;
+    uint32_t                            running_;
+    uint64_t                            generation_;
+    std::exception_ptr                  error_;
+    bool                                stop_;
+
+    void Worker_();
+
+    /**
+     * Run tasks of the current job until there are none left
+     */
+    void Drain_(std::unique_lock<std::mutex> &lock);
+
+public:
+    /**
+     * Constructor
+     *
+     * @param   threads     number of threads, 0 means one per hardware thread
+     */
+    ThreadPool(uint32_t threads);
+
+    /**
+     * Destructor, waits for the workers to finish
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool & operator=(const ThreadPool &) = delete;
+
+    /**
+     * Call \p fn(i) for every i in [0, tasks) and wait for all the calls
+     *
+     * The calling thread takes part in the processing. If any of the calls
+     * throws, remaining tasks are skipped and the first exception is
+     * rethrown. Is not reentrant, i.e. must not be called from \p fn or
+     * from several threads at once.
+     */
+    void Run(uint32_t tasks, const std::function<void(uint32_t)> &fn);
+
+    /**
+     * Number of threads processing tasks, including the calling one
+     */
+    uint32_t Size();
+
+    /**
+     * Resolve 0 to the number of hardware threads
+     */
+    static uint32_t Threads(uint32_t threads);
+};
+
+}
+
+/** @} */
@@ -26,10 +26,16 @@
 
 #pragma once
 
+#include <utility>
 #include <vector>
 
 #include "lmtypes.h"
 
+namespace anatomist {
+class Arena;
+class ThreadPool;
+}
+
 #ifndef VITERBI_TEST_FRIENDS
 #define VITERBI_TEST_FRIENDS
 #endif
@@ -41,14 +47,144 @@ VITERBI_TEST_FRIENDS;
 public:
     typedef std::vector<std::vector<prob_t>> prob_matrix_t;
 
+    /**
+     * Find the most likely sequence of states
+     *
+     * Observations where only one state is possible split the sequence into
+     * regions which are independent of each other, with \p threads other
+     * than 1 such regions are decoded in parallel. Result does not depend
+     * on the number of threads.
+     *
+     * @param   init_p      initial probabilities of the states
+     * @param   obs         probabilities of the states for every observation
+     * @param   trans_p     transition probabilities, trans_p[from][to]
+     * @param   threads     number of threads, 0 means one per hardware thread
+     * @param   arena       where to keep the path metrics, a temporary one
+     *                      if not specified. They are left in it for the
+     *                      caller to release
+     * @return  index of the state for every observation
+     */
     static std::vector<uint32_t> GetPath(std::vector<prob_t> &init_p,
                                          prob_matrix_t &obs,
-                                         prob_matrix_t &trans_p);
+                                         prob_matrix_t &trans_p,
+                                         uint32_t threads = 1,
+                                         anatomist::Arena *arena = nullptr);
+
+    /**
+     * Same as above, regions are decoded by the threads of \p pool
+     *
+     * The pool is kept by the caller between calls, so that threads are
+     * not started for every sequence.
+     */
+    static std::vector<uint32_t> GetPath(std::vector<prob_t> &init_p,
+                                         prob_matrix_t &obs,
+                                         prob_matrix_t &trans_p,
+                                         anatomist::ThreadPool &pool,
+                                         anatomist::Arena *arena = nullptr);
 
 private:
+    /**
+     * Implementation of GetPath(), a pool of \p threads is started for the
+     * call if \p pool is nullptr and the sequence splits into regions
+     */
+    static std::vector<uint32_t> Path_(std::vector<prob_t> &init_p, prob_matrix_t &obs,
+                                       prob_matrix_t &trans_p, uint32_t threads,
+                                       anatomist::ThreadPool *pool, anatomist::Arena *arena);
+
+    /**
+     * Best predecessor of the state and the log probability of the path
+     */
+    typedef std::pair<uint32_t, prob_t> state_metric_t;
+
+    /**
+     * Decode observations [begin, end] into \p path
+     *
+     * @param   log_trans   log of the transition probabilities, row by row
+     * @param   metrics     room for the metrics of every state of every
+     *                      decoded observation
+     */
+    static void Decode_(const std::vector<prob_t> &init_p, const prob_matrix_t &obs,
+                        const prob_t *log_trans, uint32_t begin, uint32_t end,
+                        state_metric_t *metrics, std::vector<uint32_t> &path);
+
+    /**
+     * Metrics \p cur of the observation \p obs_col which follows the one
+     * with metrics \p prev
+     */
+    static void Step_(const state_metric_t *prev, const std::vector<prob_t> &obs_col,
+                      const prob_t *log_trans, uint32_t states_cnt, state_metric_t *cur);
+
+    /**
+     * @return  the only state possible for the observation, -1 if there are
+     *          several of them
+     */
+    static int32_t Anchor_(const std::vector<prob_t> &obs);
+
     static void ValidateMatrix_(const prob_matrix_t &obs);
     static bool ValidateProbVector_(const std::vector<prob_t> &v);
     static void ValidateInitProbs_(const std::vector<prob_t> &init_p);
+
+public:
+    /**
+     * Decoder of a sequence which grows or changes in place
+     *
+     * Path metrics of every observation are kept between updates, so only
+     * the changed observations and the ones after them are decoded again.
+     * Propagation stops at the first observation past the change with a
+     * single possible state, nothing before it affects the metrics from
+     * there on, and backtracking stops where the new path joins the
+     * previous one. The path is the same as GetPath() gives for the whole
+     * sequence.
+     */
+    class Incremental {
+
+    private:
+        std::vector<prob_t>         init_p_;
+        std::vector<prob_t>         log_trans_;
+        uint32_t                    states_cnt_;
+        std::vector<state_metric_t> metrics_;
+        std::vector<uint32_t>       path_;
+        uint32_t                    decoded_;
+
+    public:
+        /**
+         * Constructor
+         *
+         * @param   init_p      initial probabilities of the states
+         * @param   trans_p     transition probabilities, trans_p[from][to]
+         */
+        Incremental(const std::vector<prob_t> &init_p, const prob_matrix_t &trans_p);
+
+        /**
+         * Bring the path up to date with \p obs
+         *
+         * Observations [from, to) and the ones past the length of the
+         * previous sequence are the changed ones, the rest have to be the
+         * same as in the previous call.
+         *
+         * @param   obs     probabilities of the states for every observation
+         * @param   from    first changed observation
+         * @param   to      observation after the last changed one
+         * @return  first observation whose state has changed, size of the
+         *          path if none has
+         */
+        uint32_t Update(const prob_matrix_t &obs, uint32_t from, uint32_t to);
+
+        /**
+         * Index of the state for every observation
+         */
+        const std::vector<uint32_t> & Path() const;
+
+        /**
+         * Number of observations the last Update() propagated metrics over
+         */
+        uint32_t Decoded() const;
+
+        /**
+         * Forget the sequence, the next Update() decodes it from scratch
+         */
+        void Reset();
+    };
 };
 
 /** @} */
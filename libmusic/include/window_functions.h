@@ -44,8 +44,19 @@ public:
     static void applyBlackman(td_t &td);
     static void applyDefault(td_t &td);
 
+    /**
+     * Apply window function \p fcode, one of WINDOW_FUNC_*
+     */
+    static void apply(td_t &td, uint32_t fcode);
+
     static std::vector<amplitude_t> getHamming(uint32_t len, uint32_t offset);
 
+    /**
+     * Write the Hamming window of \p len samples to \p win, samples before
+     * \p offset are 0
+     */
+    static void getHamming(uint32_t len, uint32_t offset, amplitude_t *win);
+
     static const char * toString(uint32_t);
 };
 
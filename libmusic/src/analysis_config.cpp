@@ -0,0 +1,127 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file    analysis_config.cpp
+ * @brief   Runtime analysis parameters and their presets
+ */
+
+#include <stdexcept>
+
+#include "analysis_config.h"
+#include "config.h"
+#include "lmtypes.h"
+
+using namespace std;
+
+namespace anatomist {
+
+AnalysisConfig::AnalysisConfig() :
+        tft_type(CFG_TFT_TYPE),
+        win_size(CFG_WINDOW_SIZE),
+        hops_per_window(CFG_HOPS_PER_WINDOW),
+        fft_size(CFG_FFT_SIZE),
+        window_func(CFG_WINDOW_FUNC),
+        hps_harmonics(1),
+        self_transition_p(CFG_CHORD_SELF_TRANSITION_P),
+        viterbi_threads(CFG_VITERBI_THREADS)
+{
+}
+
+vector<string> AnalysisConfig::Presets()
+{
+    return { "fast", "balanced", "accurate", "lowlatency" };
+}
+
+AnalysisConfig AnalysisConfig::Preset(const string &name)
+{
+    AnalysisConfig config;
+
+    config.tft_type = TFT_TYPE_CONSTANTQ;
+    config.win_size = 4096;
+    config.hops_per_window = 1;
+    config.fft_size = 8192;
+    config.window_func = WINDOW_FUNC_RECTANGULAR;
+    config.hps_harmonics = 1;
+    config.self_transition_p = 0.1;
+
+    if (name == "fast") {
+        /* half the frames to denoise, profile and decode */
+        config.win_size = 8192;
+    } else if (name == "accurate") {
+        /* twice the frames, more of them have to agree on a chord change */
+        config.hops_per_window = 2;
+        config.self_transition_p = 0.3;
+    } else if (name == "lowlatency") {
+        /*
+         * 46 ms windows every 23 ms. RTChordAnalyzer zero-pads them to
+         * fft_size, ChordDetector keeps the constant-Q transform, which
+         * unlike an FFT of 2048 samples still resolves the bass
+         */
+        config.win_size = 2048;
+        config.hops_per_window = 2;
+        config.window_func = WINDOW_FUNC_HAMMING;
+    } else if (name != "balanced") {
+        throw invalid_argument("Unknown analysis preset: " + name);
+    }
+
+    return config;
+}
+
+uint32_t AnalysisConfig::HopSize() const
+{
+    return win_size / hops_per_window;
+}
+
+void AnalysisConfig::Validate() const
+{
+    if ((tft_type != TFT_TYPE_FFT) && (tft_type != TFT_TYPE_CONSTANTQ) &&
+        (tft_type != TFT_TYPE_GOERTZEL))
+    {
+        throw invalid_argument("AnalysisConfig: unknown transform type");
+    }
+
+    /* transforms keep window and hop sizes in 16 bits */
+    if ((win_size < 256) || (win_size > UINT16_MAX)) {
+        throw invalid_argument("AnalysisConfig: window size is out of range");
+    }
+
+    if ((hops_per_window == 0) || (win_size % hops_per_window != 0)) {
+        throw invalid_argument("AnalysisConfig: window has to split into whole hops");
+    }
+
+    if (fft_size == 0) {
+        throw invalid_argument("AnalysisConfig: FFT size can't be 0");
+    }
+
+    if ((window_func < WINDOW_FUNC_MIN) || (window_func > WINDOW_FUNC_MAX)) {
+        throw invalid_argument("AnalysisConfig: unknown window function");
+    }
+
+    if (hps_harmonics == 0) {
+        throw invalid_argument("AnalysisConfig: HPS needs at least 1 harmonic");
+    }
+
+    if ((self_transition_p < 0) || (self_transition_p >= 1)) {
+        throw invalid_argument("AnalysisConfig: self-transition probability is out of range");
+    }
+}
+
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file    arena.cpp
+ * @brief   Implementation of the monotonic buffer
+ */
+
+#include <algorithm>
+#include <stdint.h>
+
+#include "arena.h"
+
+using namespace std;
+
+namespace anatomist {
+
+Arena::Arena(size_t min_block, size_t max_retained) :
+        used_(0),
+        min_block_(max<size_t>(min_block, 1)),
+        max_retained_(max_retained)
+{
+}
+
+void * Arena::Allocate(size_t bytes, size_t align)
+{
+    if (!blocks_.empty()) {
+        block_t &block = blocks_.back();
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+        size_t offset = ((base + used_ + align - 1) & ~(align - 1)) - base;
+
+        if (offset + bytes <= block.size) {
+            used_ = offset + bytes;
+            return block.data.get() + offset;
+        }
+    }
+
+    /* grow geometrically, so that the number of blocks stays logarithmic */
+    size_t size = max(min_block_, bytes + align);
+
+    if (!blocks_.empty()) {
+        size = max(size, 2 * blocks_.back().size);
+    }
+
+    blocks_.push_back({ unique_ptr<char[]>(new char[size]), size });
+    used_ = 0;
+
+    return Allocate(bytes, align);
+}
+
+void Arena::Release()
+{
+    size_t capacity = Capacity();
+    size_t size = min(capacity, max_retained_);
+
+    if ((blocks_.size() > 1) || (size < capacity)) {
+        blocks_.clear();
+
+        /* an arena that has outgrown the limit starts over with a block of it */
+        if (size > 0) {
+            blocks_.push_back({ unique_ptr<char[]>(new char[size]), size });
+        }
+    }
+
+    used_ = 0;
+}
+
+size_t Arena::Capacity() const
+{
+    size_t size = 0;
+
+    for (auto &block : blocks_) {
+        size += block.size;
+    }
+
+    return size;
+}
+
+}
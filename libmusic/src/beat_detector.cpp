@@ -28,6 +28,7 @@
 #include "config.h"
 #include "fft.h"
 #include "lmhelpers.h"
+#include "lmstats.h"
 
 #define BEAT_FREQ_HZ_MIN    1
 #define BEAT_FREQ_HZ_MAX    5
@@ -53,14 +54,17 @@ BeatDetector::BeatDetector(Envelope *e, uint32_t sampleRate)
 
 void BeatDetector::detectBeat(Envelope *env, uint32_t sampleRate)
 {
+    LM_STATS_SCOPE("beat_detector");
     vector<amplitude_t> env_diff = env->diff();
     uint32_t env_samplerate = sampleRate / env->getDownsampleFactor();
     FFT *fft = new FFT(env_diff.data(), env_diff.size(), env_samplerate, 0,
-                       env_samplerate / 2, true, true);
+                       env_samplerate / 2, true, CFG_FFT_HPS_HARMONICS);
     amplitude_t *env_fd = fft->GetFreqDomain().p;
     uint32_t maxFFTAmpIdx, maxEnvAmpIdx, closestLeftLocalMinIdx;
     freq_hz_t beat_hz;
 
+    LM_STATS_FRAMES(env_diff.size());
+
     maxFFTAmpIdx = max_element(env_fd, env_fd + fft->GetSize() / 2) - env_fd;
 
     beat_hz = fft->IdxToFreq(maxFFTAmpIdx);
@@ -0,0 +1,357 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    beat_tracker.cpp
+ * @brief   Implementation of the online beat tracking
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string.h>
+
+#include "beat_tracker.h"
+#include "config.h"
+#include "lmstats.h"
+
+/**
+ * Weight of the past beats in the cumulative score
+ */
+#define CSCORE_ALPHA        0.9
+
+/**
+ * How strictly beats are expected to follow the tempo in the cumulative score
+ */
+#define CSCORE_TIGHTNESS    5.0
+
+/**
+ * Tempo prior: center and width (in octaves) of the log-Gaussian weighting
+ */
+#define TEMPO_PRIOR_BPM     120.0
+#define TEMPO_PRIOR_WIDTH   1.0
+
+/**
+ * Number of comb filter harmonics used for tempo estimation
+ */
+#define TEMPO_COMB_HARMONICS    4
+
+/**
+ * Log compression factor for onset strength calculation
+ */
+#define ODF_LOG_GAMMA       100.0
+
+using namespace std;
+
+namespace anatomist {
+
+BeatTracker::BeatTracker(uint32_t sample_rate, uint32_t hop_size) :
+        sample_rate_(sample_rate),
+        hop_size_(hop_size),
+        win_size_(hop_size * 2)
+{
+    if ((sample_rate == 0) || (hop_size == 0)) {
+        throw invalid_argument("BeatTracker(): invalid argument");
+    }
+
+    amplitude_t fps = 1.0 * sample_rate_ / hop_size_;
+
+    history_ = ceil(CFG_BEAT_TRACKER_HISTORY_SEC * fps);
+    if (history_ < 2 * fps * 60 / CFG_BEAT_TRACKER_BPM_MIN + 1) {
+        throw invalid_argument("BeatTracker(): history is too short for the tempo range");
+    }
+
+    odf_.resize(history_);
+    cscore_.resize(history_);
+    acf_.resize(history_);
+    in_buf_.resize(win_size_);
+    frame_.resize(win_size_);
+    win_.resize(win_size_);
+    prev_mags_.resize(win_size_ / 2 + 1);
+    fd_.resize(win_size_ / 2 + 1);
+
+    for (uint32_t i = 0; i < win_size_; i++) {
+        win_[i] = 0.5 * (1 - cos(2 * M_PI * i / (win_size_ - 1)));
+    }
+
+    fft_cfg_ = kiss_fftr_alloc(win_size_, 0, nullptr, nullptr);
+    if (fft_cfg_ == nullptr) {
+        throw runtime_error("BeatTracker(): failed to allocate FFT");
+    }
+
+    Reset();
+}
+
+BeatTracker::BeatTracker(uint32_t sample_rate) :
+        BeatTracker(sample_rate, CFG_BEAT_TRACKER_HOP_SIZE) {}
+
+BeatTracker::~BeatTracker()
+{
+    kiss_fftr_free(fft_cfg_);
+}
+
+void BeatTracker::Reset()
+{
+    fill(odf_.begin(), odf_.end(), 0);
+    fill(cscore_.begin(), cscore_.end(), 0);
+    fill(prev_mags_.begin(), prev_mags_.end(), 0);
+    in_len_ = 0;
+    frame_idx_ = 0;
+    period_ = 0;
+    tempo_known_ = false;
+    last_beat_ = -1;
+    beats_cnt_ = 0;
+}
+
+amplitude_t & BeatTracker::Odf_(uint64_t frame)
+{
+    return odf_[frame % history_];
+}
+
+amplitude_t & BeatTracker::CScore_(uint64_t frame)
+{
+    return cscore_[frame % history_];
+}
+
+uint32_t BeatTracker::FrameToIdx_(uint64_t frame)
+{
+    return frame * hop_size_ + win_size_ / 2;
+}
+
+amplitude_t BeatTracker::OnsetStrength_()
+{
+    amplitude_t flux = 0;
+
+    for (uint32_t i = 0; i < win_size_; i++) {
+        frame_[i] = in_buf_[i] * win_[i];
+    }
+
+    kiss_fftr(fft_cfg_, frame_.data(), fd_.data());
+
+    for (uint32_t k = 0; k < fd_.size(); k++) {
+        amplitude_t mag = log1p(ODF_LOG_GAMMA * sqrt(fd_[k].r * fd_[k].r + fd_[k].i * fd_[k].i));
+
+        flux += max(0.0, mag - prev_mags_[k]);
+        prev_mags_[k] = mag;
+    }
+
+    /* nothing to compare the very first frame with */
+    return (frame_idx_ == 0) ? 0 : flux;
+}
+
+void BeatTracker::UpdateTempo_()
+{
+    amplitude_t fps = 1.0 * sample_rate_ / hop_size_;
+    uint32_t lag_min = floor(fps * 60 / CFG_BEAT_TRACKER_BPM_MAX);
+    uint32_t lag_max = ceil(fps * 60 / CFG_BEAT_TRACKER_BPM_MIN);
+    uint32_t n = min(static_cast<uint64_t>(history_), frame_idx_);
+    uint64_t first = frame_idx_ - n;
+    amplitude_t mean = 0, best_score = 0;
+    uint32_t best_lag = 0;
+
+    if (n < 2 * lag_max) {
+        return;
+    }
+
+    for (uint64_t f = first; f < frame_idx_; f++) {
+        mean += Odf_(f);
+    }
+    mean /= n;
+
+    /* autocorrelation of the mean-removed onset strength */
+    for (uint32_t lag = 1; lag < n; lag++) {
+        amplitude_t sum = 0;
+
+        if (lag > TEMPO_COMB_HARMONICS * lag_max + 1) {
+            break;
+        }
+
+        for (uint64_t f = first + lag; f < frame_idx_; f++) {
+            sum += (Odf_(f) - mean) * (Odf_(f - lag) - mean);
+        }
+        acf_[lag] = sum / (n - lag);
+    }
+
+    /* comb filter over the autocorrelation with log-Gaussian tempo prior */
+    for (uint32_t lag = max(lag_min, 1U); lag <= lag_max; lag++) {
+        amplitude_t score = 0;
+        amplitude_t prior = log2(lag / (fps * 60 / TEMPO_PRIOR_BPM)) / TEMPO_PRIOR_WIDTH;
+
+        for (uint32_t h = 1; h <= TEMPO_COMB_HARMONICS && h * lag < n; h++) {
+            score += acf_[h * lag] / h;
+        }
+        score *= exp(-0.5 * prior * prior);
+
+        if (score > best_score) {
+            best_score = score;
+            best_lag = lag;
+        }
+    }
+
+    if (best_lag == 0) {
+        return;
+    }
+
+    /* parabolic interpolation of the autocorrelation peak */
+    amplitude_t period = best_lag;
+    if (best_lag > 1 && best_lag + 1 < n) {
+        amplitude_t l = acf_[best_lag - 1], c = acf_[best_lag], r = acf_[best_lag + 1];
+        amplitude_t d = l - 2 * c + r;
+        if (d < 0) {
+            period += 0.5 * (l - r) / d;
+        }
+    }
+
+    if (tempo_known_ && abs(period - period_) < period_ * 0.15) {
+        period_ = 0.7 * period_ + 0.3 * period;
+    } else {
+        period_ = period;
+    }
+
+    tempo_known_ = true;
+}
+
+void BeatTracker::UpdateScore_(amplitude_t odf)
+{
+    amplitude_t best = 0;
+
+    if (tempo_known_) {
+        uint32_t l_min = max<int64_t>(1, lround(period_ / 2));
+        uint32_t l_max = lround(period_ * 2);
+
+        for (uint32_t l = l_min; l <= l_max && l < history_ && l <= frame_idx_; l++) {
+            amplitude_t dev = CSCORE_TIGHTNESS * log(l / period_);
+            amplitude_t score = CScore_(frame_idx_ - l) * exp(-0.5 * dev * dev);
+
+            best = max(best, score);
+        }
+    }
+
+    CScore_(frame_idx_) = (1 - CSCORE_ALPHA) * odf + CSCORE_ALPHA * best;
+}
+
+void BeatTracker::DetectBeat_(std::vector<uint32_t> *beats)
+{
+    if (!tempo_known_) {
+        return;
+    }
+
+    int64_t tol = max<int64_t>(1, lround(period_ / 4));
+    int64_t now = frame_idx_;
+    int64_t from, to;
+
+    if (last_beat_ < 0) {
+        /* anchor the first beat to the strongest score within the last period */
+        from = max<int64_t>(0, now - lround(period_) + 1);
+        to = now;
+    } else {
+        int64_t predicted = last_beat_ + lround(period_);
+
+        if (now < predicted + tol) {
+            return;
+        }
+
+        from = max<int64_t>(predicted - tol, last_beat_ + lround(period_ / 2));
+        to = predicted + tol;
+    }
+
+    from = max<int64_t>(from, now - history_ + 1);
+
+    int64_t beat = from;
+    for (int64_t f = from; f <= to; f++) {
+        if (CScore_(f) > CScore_(beat)) {
+            beat = f;
+        }
+    }
+
+    last_beat_ = beat;
+    beats_cnt_++;
+
+    if (beats != nullptr) {
+        beats->push_back(FrameToIdx_(beat));
+    }
+}
+
+void BeatTracker::Process(const amplitude_t *td, uint32_t samples,
+                          std::vector<uint32_t> *beats)
+{
+    if ((td == nullptr) && (samples > 0)) {
+        throw invalid_argument("BeatTracker::Process(): invalid argument");
+    }
+
+    Process(SignalView(td, samples), beats);
+}
+
+void BeatTracker::Process(const SignalView &td, std::vector<uint32_t> *beats)
+{
+    LM_STATS_SCOPE("beat_tracker");
+    LM_STATS_FRAMES(td.size());
+
+    size_t pos = 0;
+    size_t samples = td.size();
+
+    amplitude_t fps = 1.0 * sample_rate_ / hop_size_;
+    uint32_t tempo_update_frames = max(1.0, round(fps * CFG_BEAT_TRACKER_TEMPO_UPDATE_SEC));
+
+    while (samples > 0) {
+        uint32_t len = min<size_t>(samples, win_size_ - in_len_);
+
+        td.Read(pos, len, in_buf_.data() + in_len_);
+        in_len_ += len;
+        pos += len;
+        samples -= len;
+
+        if (in_len_ < win_size_) {
+            break;
+        }
+
+        amplitude_t odf = OnsetStrength_();
+
+        Odf_(frame_idx_) = odf;
+        UpdateScore_(odf);
+        DetectBeat_(beats);
+
+        frame_idx_++;
+
+        if (frame_idx_ % tempo_update_frames == 0) {
+            UpdateTempo_();
+        }
+
+        memmove(in_buf_.data(), in_buf_.data() + hop_size_,
+                (win_size_ - hop_size_) * sizeof(in_buf_[0]));
+        in_len_ = win_size_ - hop_size_;
+    }
+}
+
+float BeatTracker::GetBPM()
+{
+    return tempo_known_ ? 60.0 * sample_rate_ / (period_ * hop_size_) : 0;
+}
+
+uint32_t BeatTracker::GetIdxInterval()
+{
+    return tempo_known_ ? lround(period_ * hop_size_) : 0;
+}
+
+uint32_t BeatTracker::GetBeatsCnt()
+{
+    return beats_cnt_;
+}
+
+}
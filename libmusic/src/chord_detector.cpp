@@ -26,15 +26,24 @@
 
 #include <algorithm>
 #include <limits>
+#include <numeric>
+#include <sstream>
+#include <string.h>
 
 #include "beat_detector.h"
+#include "beat_tracker.h"
 #include "chord_detector.h"
 #include "config.h"
 #include "cqt_wrapper.h"
+#include "decimator.h"
 #include "envelope.h"
 #include "fft_wrapper.h"
+#include "goertzel_bank.h"
 #include "lmhelpers.h"
 #include "lmlogger.h"
+#include "lmstats.h"
+#include "lmtrace.h"
+#include "onset_detector.h"
 #include "tft.h"
 #include "window_functions.h"
 
@@ -45,33 +54,63 @@
 
 #define LOG_TAG "AA.ChordDetector"
 
+/** Has to be bumped whenever chunk_t serialization changes */
+#define CHUNK_VERSION   1
+#define CHUNK_MAGIC     "LMCK"
+
 using namespace std;
 
 namespace anatomist {
 
-ChordDetector::ChordDetector()
+typedef struct {
+    char        magic[4];
+    uint32_t    version;
+    uint32_t    first_frame;
+    uint32_t    interval;
+    uint32_t    frames;
+    uint32_t    states;
+    uint32_t    power_frames;
+    uint32_t    reserved;
+} chunk_header_t;
+
+ChordDetector::ChordDetector() : ChordDetector(AnalysisConfig()) {}
+
+ChordDetector::ChordDetector(const AnalysisConfig &config) : config_(config)
 {
+    config_.Validate();
+
     LOGMSG_D(LOG_TAG, "Using window size %u, FFT size %u and %s window function",
-             CFG_WINDOW_SIZE, CFG_FFT_SIZE, WindowFunctions::toString(CFG_WINDOW_FUNC));
+             config_.win_size, config_.fft_size, WindowFunctions::toString(config_.window_func));
 
     tpl_collection_ = new ChordTplCollection();
+    model_ = nullptr;
+    feature_cache_ = nullptr;
+    chunk_sr_ = 0;
+    chunk_alignment_ = 0;
+    chunk_context_ = 0;
+
+#if CFG_USE_HMM_TPLS == 1
+    SetModel(CFG_HMM_MODEL_FILE);
+#endif /* CFG_USE_HMM_TPLS */
 }
 
 ChordDetector::~ChordDetector()
 {
     delete tpl_collection_;
+    delete model_;
+    delete feature_cache_;
 }
 
 FFT * ChordDetector::GetFft_(td_t &td, uint32_t samplerate)
 {
-    if ((td.size() == 0) || (td.size() > CFG_FFT_SIZE) || (samplerate == 0))
+    if ((td.size() == 0) || (td.size() > config_.fft_size) || (samplerate == 0))
     {
         throw invalid_argument("__getFftResults() invalid argument");
     }
 
-    WindowFunctions::applyDefault(td);
+    WindowFunctions::apply(td, config_.window_func);
 
-    return new FFT(td, samplerate, FREQ_E2, FREQ_C8);
+    return new FFT(td, samplerate, FREQ_E2, FREQ_C8, config_.hps_harmonics);
 }
 
 chord_t ChordDetector::GetChordFromFft_(FFT *fft)
@@ -158,11 +197,11 @@ void ChordDetector::Process_(std::vector<segment_t> *segments,
 
     delete bd;
 #else
-    winSize = CFG_WINDOW_SIZE;
+    winSize = config_.win_size;
     offset = 0;
 #endif
 
-    hopSize = winSize / CFG_HOPS_PER_WINDOW;
+    hopSize = winSize / config_.hops_per_window;
 
     if (listener != nullptr) {
         listener->onPreprocessingProgress(1);
@@ -189,10 +228,10 @@ void ChordDetector::Process_(std::vector<segment_t> *segments,
 
         delete fft;
 
-        if (CFG_HOPS_PER_WINDOW > 1)  {
+        if (config_.hops_per_window > 1)  {
             pcpHopsBuf->add(pcp);
 
-            if (winCnt % CFG_HOPS_PER_WINDOW == 0) {
+            if (winCnt % config_.hops_per_window == 0) {
                 pcp = pcpHopsBuf->getCombinedPCP();
                 pcpHopsBuf->flush();
             } else {
@@ -228,11 +267,29 @@ float ChordDetector::Tune_(tft_t *tft)
 
 chromagram_t ChordDetector::ChromagramFromSpectrogram_(tft_t *tft)
 {
-    log_spectrogram_t lsg = tft->GetSpectrogram();
+    LM_STATS_SCOPE("chromagram");
+    const log_spectrogram_t &lsg = tft->GetSpectrogram();
     chromagram_t chromagram;
+    pcp_windows_t windows = {};
+    size_t windows_bins = 0;
+
+    LM_STATS_FRAMES(lsg.size());
+
+    chromagram.reserve(lsg.size());
 
     for (uint32_t win_idx = 0; win_idx < lsg.size(); win_idx++) {
-        chromagram.push_back(PitchClsProfile(lsg[win_idx], tft));
+        if (lsg[win_idx].empty()) {
+            /* skipped by the transform */
+            chromagram.push_back(PitchClsProfile());
+            continue;
+        }
+
+        if (lsg[win_idx].size() != windows_bins) {
+            windows_bins = lsg[win_idx].size();
+            windows = PitchClsProfile::Windows(tft, windows_bins, arena_);
+        }
+
+        chromagram.push_back(PitchClsProfile(lsg[win_idx], tft, windows));
     }
 
     return chromagram;
@@ -261,14 +318,31 @@ Viterbi::obs_matrix_t ChordDetector::GetScoreMatrix_(chromagram_t &chromagram)
     return score_mtx;
 }
 #else
-Viterbi::prob_matrix_t ChordDetector::GetScoreMatrix_(chromagram_t &chromagram)
+Viterbi::prob_matrix_t ChordDetector::GetScoreMatrix_(chromagram_t &chromagram,
+                                                      const vector<bool> &silent)
 {
+    LM_STATS_SCOPE("scoring");
+    LM_STATS_FRAMES(chromagram.size());
+
     Viterbi::prob_matrix_t score_mtx(chromagram.size());
 
     for (uint32_t win_idx = 0; win_idx < chromagram.size(); win_idx++) {
         pcp_t *pcp = &chromagram[win_idx];
         tpl_score_t sum = 0;
 
+        /* a single allocation per row rather than growing it score by score */
+        score_mtx[win_idx].reserve(tpl_collection_->Size());
+
+        /*
+         * Besides being correct this splits decoding into independent
+         * regions, see Viterbi::GetPath()
+         */
+        if ((win_idx < silent.size()) && silent[win_idx]) {
+            score_mtx[win_idx].resize(tpl_collection_->Size(), 0);
+            score_mtx[win_idx].back() = 1;
+            continue;
+        }
+
         for (uint32_t tpl_idx = 0; tpl_idx < tpl_collection_->Size(); tpl_idx++) {
             tpl_score_t score = tpl_collection_->GetTpl(tpl_idx)->GetScore(pcp);
 
@@ -298,63 +372,188 @@ Viterbi::prob_matrix_t ChordDetector::GetScoreMatrix_(chromagram_t &chromagram)
 }
 #endif /* 0 */
 
-void ChordDetector::Process_(vector<segment_t> *segments,
-                             const td_t &td, uint32_t samplerate,
-                             ResultsListener *listener, chromagram_t *c)
+tft_t * ChordDetector::NewTft_(uint32_t samplerate, uint32_t win_size)
+{
+    /* window is adjusted for decimation and beats */
+    AnalysisConfig config = config_;
+
+    config.win_size = win_size;
+
+    switch (config.tft_type) {
+        case TFT_TYPE_FFT:
+            return new FFTWrapper(FREQ_E1, FREQ_C6, samplerate, config);
+        case TFT_TYPE_GOERTZEL:
+            return new GoertzelBank(FREQ_E1, FREQ_C6, samplerate, config);
+        default:
+            return new CQTWrapper(FREQ_E1, FREQ_C6, samplerate, config);
+    }
+}
+
+tft_t * ChordDetector::Tft_(uint32_t samplerate, uint32_t win_size)
+{
+    std::unique_ptr<tft_t> &tft = tfts_[make_pair(samplerate, win_size)];
+
+    if (tft) {
+        tft->Reset();
+    } else {
+        tft.reset(NewTft_(samplerate, win_size));
+        tft->SetArena(&arena_);
+    }
+
+    return tft.get();
+}
+
+chromagram_t ChordDetector::Chromagram_(const SignalView &td, const SignalEnergy *energy,
+                                        uint32_t samplerate, uint32_t *interval,
+                                        onsets_t *onsets)
 {
     uint32_t win_size, offset;
 
 #ifdef CFG_DYNAMIC_WINDOW
-    std::unique_ptr<Envelope> e(new Envelope(td.data(), td.size()));
-    std::unique_ptr<BeatDetector> bd(new BeatDetector(e.get(), samplerate));
+    std::unique_ptr<BeatTracker> bt(new BeatTracker(samplerate));
+    vector<uint32_t> beats;
 
-    win_size = bd->getIdxInterval();
-    offset = bd->getOffset();
+    bt->Process(td, &beats);
+
+    win_size = bt->GetIdxInterval();
+    if (win_size == 0) {
+        win_size = config_.win_size;
+    }
+    while ((win_size < CFG_BEAT_INTERVAL_MIN) || (win_size > CFG_BEAT_INTERVAL_MAX)) {
+        win_size = (win_size < CFG_BEAT_INTERVAL_MIN) ? win_size * 2 : win_size / 2;
+    }
+    offset = beats.empty() ? 0 : beats[0] % win_size;
 #else
-    win_size = CFG_WINDOW_SIZE;
+    win_size = config_.win_size;
     offset = 0;
 #endif
 
-    uint32_t hop_size = win_size / CFG_HOPS_PER_WINDOW;
-    Viterbi::prob_matrix_t score_mtx;
-    vector<uint32_t> mtx_path;
-    uint32_t seg_start_idx = 0;
-#if !defined(CFG_TFT_TYPE) || (CFG_TFT_TYPE == TFT_TYPE_FFT)
-    std::unique_ptr<tft_t> tft(new FFTWrapper(FREQ_E1, FREQ_C6, samplerate, win_size, hop_size));
-#else
-    std::unique_ptr<tft_t> tft(new CQTWrapper(FREQ_E1, FREQ_C6, samplerate, win_size, hop_size));
-#endif
-    vector<double> init_p;
-    Viterbi::prob_matrix_t trans_p;
-    uint32_t chords_total = tpl_collection_->Size();
-    chromagram_t chromagram;
+    uint32_t tft_samplerate = samplerate;
+    uint32_t factor = 1;
+    SignalView tft_td = td;
+#if CFG_DECIMATION
+    std::unique_ptr<Decimator> decimator(
+            new Decimator(samplerate, Decimator::SafeFactor(samplerate, FREQ_C6)));
+    td_t td_decimated;
+
+    if (decimator->Factor() > 1) {
+        td_decimated = decimator->Process(td);
+        factor = decimator->Factor();
+        tft_samplerate = decimator->OutputSampleRate();
+        tft_td = td_decimated;
+        win_size /= factor;
+        offset /= factor;
+    }
+#endif /* CFG_DECIMATION */
 
-    if (listener != nullptr) {
-        listener->onPreprocessingProgress(1);
+    tft_t *tft = Tft_(tft_samplerate, win_size);
+
+    *interval = tft->SpectrogramInterval() * factor;
+
+    if (energy != nullptr) {
+        tft->SetSkipMask(SilentFrames_(FramePower_(*energy, *interval)));
     }
+    tft->Process(tft_td, offset);
 
-    tft->Process(td, offset);
+    Tune_(tft);
 
-    Tune_(tft.get());
+    chromagram_t chromagram = ChromagramFromSpectrogram_(tft);
 
-    chromagram = ChromagramFromSpectrogram_(tft.get());
+    if (onsets != nullptr) {
+        onsets->interval = *interval;
+        onsets->strength = OnsetDetector::Strength(tft->GetSpectrogram());
+        onsets->onsets = OnsetDetector::PickPeaks(onsets->strength, *interval, samplerate);
 
-    if (c != nullptr) {
-        *c = chromagram;
-        return;
+        /* transforms may produce a few frames past the end */
+        while (!onsets->onsets.empty() && (onsets->onsets.back() >= td.size())) {
+            onsets->onsets.pop_back();
+        }
     }
 
-    score_mtx = GetScoreMatrix_(chromagram);
+    /* the spectrogram is not needed until the transform is used again */
+    tft->Reset();
+
+    return chromagram;
+}
 
-    init_p = vector<double>(chords_total, 0);
-    init_p[init_p.size() - 1] = 1;
+vector<amplitude_t> ChordDetector::FramePower_(const SignalEnergy &energy, uint32_t interval)
+{
+    LM_STATS_SCOPE("silence");
 
-    for (uint32_t i = 0; i < tpl_collection_->Size(); i++) {
-#ifdef CFG_CHORD_SELF_TRANSITION_P
-        double self_trans_p = CFG_CHORD_SELF_TRANSITION_P;
-#else
-        double self_trans_p = 1 / chords_total;
-#endif /* CFG_CHORD_SELF_TRANSITION_P */
+    /* transforms may produce a few frames past the end, nothing is known about them */
+    uint32_t frames = (energy.size() + interval - 1) / interval;
+    vector<amplitude_t> power(frames);
+
+    LM_STATS_FRAMES(frames);
+
+    for (uint32_t f = 0; f < frames; f++) {
+        size_t start = static_cast<size_t>(f) * interval;
+
+        power[f] = energy.Power(start, min(start + interval, energy.size()));
+    }
+
+    return power;
+}
+
+vector<bool> ChordDetector::SilentFrames_(const vector<amplitude_t> &power)
+{
+    amplitude_t power_max = 0;
+    vector<bool> silent(power.size());
+
+    for (auto p : power) {
+        power_max = max(power_max, p);
+    }
+
+    for (uint32_t f = 0; f < power.size(); f++) {
+        silent[f] = (power_max == 0) ||
+                    (10 * log10(power[f] / power_max) < CFG_SILENCE_THRESHOLD_DB);
+    }
+
+    return silent;
+}
+
+string ChordDetector::FeatureParams(const AnalysisConfig &config)
+{
+    ostringstream params;
+
+    params << "tft=" << config.tft_type
+           << ";freq=" << FREQ_E1 << "-" << FREQ_C6
+           << ";win=" << config.win_size
+           << ";hops=" << config.hops_per_window
+           << ";fft=" << config.fft_size
+           << ";win_func=" << config.window_func
+           << ";decimation=" << CFG_DECIMATION
+           << "," << CFG_DECIMATION_FACTOR_MAX << "," << CFG_DECIMATION_MARGIN
+           << ";silence=" << CFG_SILENCE_THRESHOLD_DB;
+    /* only appended when used, so that keys of the existing caches stay valid */
+    if (config.hps_harmonics > 1) {
+        params << ";hps=" << config.hps_harmonics;
+    }
+#ifdef CFG_DYNAMIC_WINDOW
+    params << ";dynamic_window=" << CFG_BEAT_INTERVAL_MIN << "-" << CFG_BEAT_INTERVAL_MAX
+           << "," << CFG_BEAT_TRACKER_HOP_SIZE << "," << CFG_BEAT_TRACKER_HISTORY_SEC
+           << "," << CFG_BEAT_TRACKER_BPM_MIN << "-" << CFG_BEAT_TRACKER_BPM_MAX;
+#endif
+
+    return params.str();
+}
+
+void ChordDetector::Transitions_(vector<prob_t> *init_p, Viterbi::prob_matrix_t *trans_p)
+{
+    uint32_t chords_total = tpl_collection_->Size();
+
+    trans_p->clear();
+
+    if (model_ != nullptr) {
+        *init_p = model_->InitProbs();
+        *trans_p = model_->TransProbs();
+    } else {
+        *init_p = vector<double>(chords_total, 0);
+        init_p->back() = 1;
+    }
+
+    for (uint32_t i = 0; (model_ == nullptr) && (i < tpl_collection_->Size()); i++) {
+        double self_trans_p = config_.self_transition_p;
         double trans_other_p = (1 - self_trans_p) / (chords_total - (self_trans_p == 0 ? 0 : 1));
         vector<double> t = vector<double>(chords_total, trans_other_p);
         if (self_trans_p != 0) {
@@ -364,36 +563,158 @@ void ChordDetector::Process_(vector<segment_t> *segments,
             }
             t[i] = self_trans_p;
         }
-        trans_p.push_back(t);
+        trans_p->push_back(t);
     }
+}
 
-    mtx_path = Viterbi::GetPath(init_p, score_mtx, trans_p);
-
-    if (mtx_path.size() != chromagram.size()) {
-        throw runtime_error("__getSegments(): mtx_path.size() != chromagram.size()");
-    }
+void ChordDetector::PathSegments_(const vector<uint32_t> &mtx_path, const vector<bool> &silent,
+                                  uint32_t interval, const vector<uint32_t> &columns,
+                                  size_t samples, uint32_t seg_start_idx,
+                                  vector<segment_t> *segments, ResultsListener *listener)
+{
+    auto first_frame = [&columns](uint32_t col) { return columns.empty() ? col : columns[col]; };
 
-    for (uint32_t res = 1; res < mtx_path.size(); res++) {
-        if (mtx_path[res] != mtx_path[seg_start_idx] || res == mtx_path.size() - 1) {
-            chord_tpl_t *tpl = tpl_collection_->GetTpl(mtx_path[seg_start_idx]);
+    for (uint32_t res = seg_start_idx + 1; res < mtx_path.size(); res++) {
+        if ((mtx_path[res] != mtx_path[seg_start_idx]) || (silent[res] != silent[seg_start_idx]) ||
+            (res == mtx_path.size() - 1))
+        {
+            const chord_tpl_t *tpl = tpl_collection_->GetTpl(mtx_path[seg_start_idx]);
             segment_t segment;
 
-            segment.startIdx = seg_start_idx * tft->SpectrogramInterval();
-            segment.endIdx = min(res * (tft->SpectrogramInterval()) - 1,
-                                 static_cast<uint32_t>(td.size() - 1));
+            segment.startIdx = first_frame(seg_start_idx) * interval;
+            segment.endIdx = min(first_frame(res) * interval - 1,
+                                 static_cast<uint32_t>(samples - 1));
             segment.chord = Chord(tpl->RootNote(), tpl->Quality());
-            segment.silence = false;
+            segment.silence = silent[seg_start_idx];
 
             seg_start_idx = res;
 
             if (listener == nullptr) {
                 segments->push_back(segment);
             } else {
-                listener->onChordSegmentProcessed(segment, (segment.endIdx / (float)td.size()));
+                listener->onChordSegmentProcessed(segment, (segment.endIdx / (float)samples));
+            }
+        }
+    }
+}
+
+void ChordDetector::Decode_(Viterbi::prob_matrix_t &score_mtx, const vector<bool> &silent,
+                            uint32_t interval, const vector<uint32_t> &columns, size_t samples,
+                            vector<segment_t> *segments, ResultsListener *listener)
+{
+    vector<uint32_t> mtx_path;
+    vector<double> init_p;
+    Viterbi::prob_matrix_t trans_p;
+
+    Transitions_(&init_p, &trans_p);
+
+    if (ThreadPool::Threads(config_.viterbi_threads) == 1) {
+        mtx_path = Viterbi::GetPath(init_p, score_mtx, trans_p, 1, &arena_);
+    } else {
+        if (!decode_pool_) {
+            decode_pool_.reset(new ThreadPool(config_.viterbi_threads));
+        }
+        mtx_path = Viterbi::GetPath(init_p, score_mtx, trans_p, *decode_pool_, &arena_);
+    }
+    LM_TRACE(viterbi_path, mtx_path);
+
+    if (mtx_path.size() != score_mtx.size()) {
+        throw runtime_error("__getSegments(): mtx_path.size() != chromagram.size()");
+    }
+
+    PathSegments_(mtx_path, silent, interval, columns, samples, 0, segments, listener);
+}
+
+void ChordDetector::Process_(vector<segment_t> *segments,
+                             const SignalView &td, uint32_t samplerate,
+                             ResultsListener *listener, chromagram_t *c,
+                             uint32_t *c_interval, onsets_t *onsets)
+{
+#if CFG_STATS
+    StatsCollector stats;
+    std::unique_ptr<StatsScope> total_stats(new StatsScope("chord_detector"));
+
+    total_stats->SetFrames(td.size());
+#endif /* CFG_STATS */
+
+    ArenaScope arena_scope(arena_);
+    Viterbi::prob_matrix_t score_mtx;
+    chromagram_t chromagram;
+    uint32_t interval = 0;
+    uint64_t cache_key = 0;
+    SignalEnergy energy(td);
+    vector<bool> silent;
+    vector<uint32_t> columns;
+
+    if (listener != nullptr) {
+        listener->onPreprocessingProgress(1);
+    }
+
+    if (feature_cache_ != nullptr) {
+        cache_key = FeatureCache::Key(td, samplerate, FeatureParams(config_));
+    }
+
+    /* onsets are detected in the spectrogram, which is not cached */
+    if ((feature_cache_ == nullptr) || (onsets != nullptr) ||
+        !feature_cache_->Load(cache_key, &chromagram, &interval))
+    {
+        chromagram = Chromagram_(td, &energy, samplerate, &interval, onsets);
+
+        /* the result is there, failing to cache it is not a reason to lose it */
+        if (feature_cache_ != nullptr) {
+            try {
+                feature_cache_->Store(cache_key, chromagram, interval);
+            } catch (exception &e) {
+                LOGMSG_W(LOG_TAG, "%s", e.what());
             }
         }
     }
 
+    if (Trace::Enabled()) {
+        vector<vector<amplitude_t>> pcp_mtx;
+
+        for (auto &pcp : chromagram) {
+            pcp_mtx.push_back(pcp.getValues());
+        }
+
+        Trace::Dump("chromagram", pcp_mtx);
+    }
+
+    if (c != nullptr) {
+        *c = chromagram;
+        if (c_interval != nullptr) {
+            *c_interval = interval;
+        }
+#if CFG_STATS
+        total_stats.reset();
+        stats_ = stats.Stats();
+#endif /* CFG_STATS */
+        return;
+    }
+
+    silent = SilentFrames_(FramePower_(energy, interval));
+    silent.resize(chromagram.size(), false);
+
+#if CFG_BEAT_SYNC != BEAT_SYNC_NONE
+    columns = BeatColumns(td, samplerate, interval, chromagram.size());
+    if (!columns.empty()) {
+        chromagram = PoolChromagram(chromagram, columns, CFG_BEAT_SYNC, &silent);
+    }
+#endif /* CFG_BEAT_SYNC */
+
+    score_mtx = GetScoreMatrix_(chromagram, silent);
+    LM_TRACE(score_matrix, score_mtx);
+
+    Decode_(score_mtx, silent, interval, columns, td.size(), segments, listener);
+
+#if CFG_STATS
+    total_stats.reset();
+    stats_ = stats.Stats();
+    if (listener != nullptr) {
+        listener->onStatsReported(stats_);
+    }
+#endif /* CFG_STATS */
+
     if (listener != nullptr) {
         listener->onChordAnalysisFinished();
     }
@@ -403,17 +724,33 @@ void ChordDetector::getSegments(std::vector<segment_t>& segments,
                                 amplitude_t *timeDomain, uint32_t samples,
                                 uint32_t sampleRate)
 {
-    td_t td(timeDomain, timeDomain + samples);
-    Process_(&segments, td, sampleRate, nullptr, nullptr);
+    Process_(&segments, SignalView(timeDomain, samples), sampleRate, nullptr, nullptr);
 }
 
 void ChordDetector::getSegments(amplitude_t *timeDomain, uint32_t samples,
                                 uint32_t sampleRate, ResultsListener *listener)
 {
-    td_t td(timeDomain, timeDomain + samples);
+    Process_(nullptr, SignalView(timeDomain, samples), sampleRate, listener, nullptr);
+}
+
+void ChordDetector::getSegments(std::vector<segment_t>& segments, const SignalView &td,
+                                uint32_t sampleRate)
+{
+    Process_(&segments, td, sampleRate, nullptr, nullptr);
+}
+
+void ChordDetector::getSegments(const SignalView &td, uint32_t sampleRate,
+                                ResultsListener *listener)
+{
     Process_(nullptr, td, sampleRate, listener, nullptr);
 }
 
+void ChordDetector::getSegments(std::vector<segment_t>& segments, const SignalView &td,
+                                uint32_t sampleRate, onsets_t *onsets)
+{
+    Process_(&segments, td, sampleRate, nullptr, nullptr, nullptr, onsets);
+}
+
 pcp_t * ChordDetector::GetPCP(amplitude_t *x, uint32_t samples, uint32_t samplerate)
 {
     td_t td(x, x + samples);
@@ -423,15 +760,408 @@ pcp_t * ChordDetector::GetPCP(amplitude_t *x, uint32_t samples, uint32_t sampler
 
 chromagram_t ChordDetector::GetChromagram(amplitude_t *x, uint32_t samples,
                                           uint32_t samplerate)
+{
+    return GetChromagram(SignalView(x, samples), samplerate);
+}
+
+chromagram_t ChordDetector::GetChromagram(const SignalView &td, uint32_t samplerate)
 {
     chromagram_t chromagram;
-    td_t td(x, x + samples);
 
     Process_(nullptr, td, samplerate, nullptr, &chromagram);
 
     return chromagram;
 }
 
+chromagram_t ChordDetector::GetChromagram(const SignalView &td, uint32_t samplerate,
+                                          uint32_t *interval)
+{
+    chromagram_t chromagram;
+
+    Process_(nullptr, td, samplerate, nullptr, &chromagram, interval);
+
+    return chromagram;
+}
+
+onsets_t ChordDetector::GetOnsets(const SignalView &td, uint32_t samplerate)
+{
+    chromagram_t chromagram;
+    onsets_t onsets;
+
+    Process_(nullptr, td, samplerate, nullptr, &chromagram, nullptr, &onsets);
+
+    return onsets;
+}
+
+const AnalysisConfig & ChordDetector::GetConfig() const
+{
+    return config_;
+}
+
+const stats_t & ChordDetector::GetStats()
+{
+    return stats_;
+}
+
+void ChordDetector::SetFeatureCache(const std::string &dir)
+{
+    delete feature_cache_;
+    feature_cache_ = dir.empty() ? nullptr : new FeatureCache(dir);
+}
+
+void ChordDetector::SetModel(const std::string &path)
+{
+    /* nothing changes if the model can't be loaded */
+    std::unique_ptr<ChordModel> model(path.empty() ? nullptr : new ChordModel(ChordModel::Load(path)));
+
+    if ((model != nullptr) && (model->Params() != FeatureParams(config_))) {
+        throw invalid_argument("SetModel(): " + path + " was trained with other analysis "
+                               "parameters (" + model->Params() + "), expected " +
+                               FeatureParams(config_));
+    }
+
+    delete tpl_collection_;
+    delete model_;
+
+    model_ = model.release();
+    tpl_collection_ = (model_ == nullptr) ? new ChordTplCollection() :
+                                            new ChordTplCollection(*model_);
+}
+
+void ChordDetector::ChunkParams_(uint32_t samplerate, size_t *alignment, size_t *context)
+{
+#ifdef CFG_DYNAMIC_WINDOW
+    UNUSED(samplerate);
+    UNUSED(alignment);
+    UNUSED(context);
+    throw runtime_error("ChunkParams_(): window size depends on the whole recording "
+                        "with CFG_DYNAMIC_WINDOW");
+#else
+    if (samplerate == 0) {
+        throw invalid_argument("ChunkParams_(): invalid sample rate");
+    }
+
+    if (chunk_sr_ != samplerate) {
+        uint32_t factor = 1, latency = 0;
+#if CFG_DECIMATION
+        Decimator decimator(samplerate, Decimator::SafeFactor(samplerate, FREQ_C6));
+
+        factor = decimator.Factor();
+        latency = decimator.Latency();
+#endif /* CFG_DECIMATION */
+        tft_t *tft = Tft_(samplerate / factor, config_.win_size / factor);
+
+        chunk_alignment_ = static_cast<size_t>(tft->Alignment()) * factor;
+        chunk_context_ = static_cast<size_t>(tft->Context()) * factor + latency;
+        chunk_sr_ = samplerate;
+    }
+
+    *alignment = chunk_alignment_;
+    *context = chunk_context_;
+#endif /* CFG_DYNAMIC_WINDOW */
+}
+
+void ChordDetector::Prepare(uint32_t samplerate)
+{
+#ifdef CFG_DYNAMIC_WINDOW
+    /* window size is only known once the recording is there */
+    UNUSED(samplerate);
+#else
+    size_t alignment, context;
+
+    /* builds the transform the recordings will be analysed with */
+    ChunkParams_(samplerate, &alignment, &context);
+#endif /* CFG_DYNAMIC_WINDOW */
+}
+
+size_t ChordDetector::ChunkAlignment(uint32_t samplerate)
+{
+    size_t alignment, context;
+
+    ChunkParams_(samplerate, &alignment, &context);
+
+    return alignment;
+}
+
+void ChordDetector::ChunkInput(uint32_t samplerate, size_t samples, size_t start, size_t end,
+                               size_t *from, size_t *to)
+{
+    size_t alignment, context;
+
+    ChunkParams_(samplerate, &alignment, &context);
+
+    if ((start >= end) || (end > samples) || (start % alignment != 0) ||
+        ((end != samples) && (end % alignment != 0)))
+    {
+        throw invalid_argument("ChunkInput(): chunk boundaries are not aligned");
+    }
+
+    /* transforms are restarted at the same phase they have in the whole run */
+    size_t before = (context + alignment - 1) / alignment * alignment;
+
+    *from = (start > before) ? start - before : 0;
+    *to = min(samples, end + context);
+}
+
+chunk_t ChordDetector::AnalyzeChunk(const SignalView &x, uint32_t samplerate, size_t samples,
+                                    size_t start, size_t end)
+{
+    LM_STATS_SCOPE("chunk");
+    LM_STATS_FRAMES(end - start);
+
+    ArenaScope arena_scope(arena_);
+    size_t from, to;
+    uint32_t interval = 0;
+    chunk_t chunk;
+
+    ChunkInput(samplerate, samples, start, end, &from, &to);
+
+    if (x.size() != to - from) {
+        throw invalid_argument("AnalyzeChunk(): input does not match ChunkInput()");
+    }
+
+    /* silence is relative to the whole recording, it is up to MergeChunks() */
+    chromagram_t chromagram = Chromagram_(x, nullptr, samplerate, &interval);
+    vector<amplitude_t> power = FramePower_(SignalEnergy(x), interval);
+    size_t first = (start - from) / interval;
+    size_t last = (end == samples) ? chromagram.size() : (end - from) / interval;
+
+    if ((last > chromagram.size()) || (first >= last)) {
+        throw runtime_error("AnalyzeChunk(): not enough frames");
+    }
+
+    chromagram_t part(chromagram.begin() + first, chromagram.begin() + last);
+
+    chunk.first_frame = start / interval;
+    chunk.interval = interval;
+    chunk.scores = GetScoreMatrix_(part, vector<bool>());
+    chunk.power.assign(power.begin() + first, power.begin() + min(last, power.size()));
+
+    return chunk;
+}
+
+void ChordDetector::MergeChunks(const vector<chunk_t> &chunks, size_t samples,
+                                vector<segment_t> &segments)
+{
+    ArenaScope arena_scope(arena_);
+    vector<const chunk_t *> sorted;
+    Viterbi::prob_matrix_t score_mtx;
+    vector<amplitude_t> power;
+    vector<bool> silent;
+
+    if (chunks.empty()) {
+        throw invalid_argument("MergeChunks(): no chunks");
+    }
+
+    for (auto &chunk : chunks) {
+        sorted.push_back(&chunk);
+    }
+    sort(sorted.begin(), sorted.end(), [](const chunk_t *a, const chunk_t *b) {
+        return a->first_frame < b->first_frame;
+    });
+
+    uint32_t interval = sorted[0]->interval;
+
+    for (auto chunk : sorted) {
+        if ((chunk->interval != interval) || (chunk->first_frame != score_mtx.size()) ||
+            (chunk->power.size() > chunk->scores.size()))
+        {
+            throw invalid_argument("MergeChunks(): chunks do not cover the recording");
+        }
+
+        score_mtx.insert(score_mtx.end(), chunk->scores.begin(), chunk->scores.end());
+        power.insert(power.end(), chunk->power.begin(), chunk->power.end());
+    }
+
+    if ((interval == 0) || (power.size() != (samples + interval - 1) / interval)) {
+        throw invalid_argument("MergeChunks(): chunks do not cover the recording");
+    }
+
+    silent = SilentFrames_(power);
+    silent.resize(score_mtx.size(), false);
+
+    for (uint32_t f = 0; f < score_mtx.size(); f++) {
+        if (silent[f]) {
+            fill(score_mtx[f].begin(), score_mtx[f].end(), 0);
+            score_mtx[f].back() = 1;
+        }
+    }
+    LM_TRACE(score_matrix, score_mtx);
+
+    Decode_(score_mtx, silent, interval, vector<uint32_t>(), samples, &segments, nullptr);
+}
+
+void ChordDetector::SaveChunk(const chunk_t &chunk, ostream &os)
+{
+    chunk_header_t hdr;
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CHUNK_MAGIC, sizeof(hdr.magic));
+    hdr.version = CHUNK_VERSION;
+    hdr.first_frame = chunk.first_frame;
+    hdr.interval = chunk.interval;
+    hdr.frames = chunk.scores.size();
+    hdr.states = chunk.scores.empty() ? 0 : chunk.scores[0].size();
+    hdr.power_frames = chunk.power.size();
+
+    os.write(reinterpret_cast<const char *>(&hdr), sizeof(hdr));
+    for (auto &col : chunk.scores) {
+        if (col.size() != hdr.states) {
+            throw invalid_argument("SaveChunk(): inconsistent size of columns");
+        }
+        os.write(reinterpret_cast<const char *>(col.data()), col.size() * sizeof(col[0]));
+    }
+    os.write(reinterpret_cast<const char *>(chunk.power.data()),
+             chunk.power.size() * sizeof(chunk.power[0]));
+
+    if (!os) {
+        throw runtime_error("SaveChunk(): write failed");
+    }
+}
+
+chunk_t ChordDetector::LoadChunk(istream &is)
+{
+    chunk_header_t hdr;
+    chunk_t chunk;
+
+    is.read(reinterpret_cast<char *>(&hdr), sizeof(hdr));
+
+    if (!is || (memcmp(hdr.magic, CHUNK_MAGIC, sizeof(hdr.magic)) != 0) ||
+        (hdr.version != CHUNK_VERSION))
+    {
+        throw runtime_error("LoadChunk(): not a chunk");
+    }
+
+    chunk.first_frame = hdr.first_frame;
+    chunk.interval = hdr.interval;
+    chunk.scores.resize(hdr.frames, vector<prob_t>(hdr.states));
+    chunk.power.resize(hdr.power_frames);
+
+    for (auto &col : chunk.scores) {
+        is.read(reinterpret_cast<char *>(col.data()), col.size() * sizeof(col[0]));
+    }
+    is.read(reinterpret_cast<char *>(chunk.power.data()),
+            chunk.power.size() * sizeof(chunk.power[0]));
+
+    if (!is) {
+        throw runtime_error("LoadChunk(): truncated chunk");
+    }
+
+    return chunk;
+}
+
+vector<uint32_t> ChordDetector::BeatColumns(const SignalView &td, uint32_t samplerate,
+                                            uint32_t interval, uint32_t frames)
+{
+    BeatTracker bt(samplerate);
+    vector<uint32_t> beats, grid, columns;
+    uint64_t period;
+
+    if (interval == 0) {
+        throw invalid_argument("BeatColumns(): invalid interval");
+    }
+
+    bt.Process(td, &beats);
+
+    period = bt.GetIdxInterval();
+    if (beats.empty() || (period == 0) || (frames == 0)) {
+        return columns;
+    }
+
+    for (uint64_t b = beats.front() % period; b < beats.front(); b += period) {
+        grid.push_back(b);
+    }
+    grid.insert(grid.end(), beats.begin(), beats.end());
+    for (uint64_t b = beats.back() + period; b < static_cast<uint64_t>(frames) * interval;
+         b += period)
+    {
+        grid.push_back(b);
+    }
+
+    columns.push_back(0);
+    for (auto b : grid) {
+        uint32_t f = (b + interval / 2) / interval;
+
+        if ((f > columns.back()) && (f < frames)) {
+            columns.push_back(f);
+        }
+    }
+    columns.push_back(frames);
+
+    return columns;
+}
+
+chromagram_t ChordDetector::PoolChromagram(const chromagram_t &chromagram,
+                                           const vector<uint32_t> &columns, int pooling,
+                                           vector<bool> *silent)
+{
+    LM_STATS_SCOPE("beat_sync");
+    LM_STATS_FRAMES(chromagram.size());
+
+    chromagram_t pooled;
+    vector<bool> pooled_silent;
+    vector<amplitude_t> values, cls;
+
+    if ((columns.size() < 2) || (columns.front() != 0) ||
+        (columns.back() != chromagram.size()) || (silent == nullptr) ||
+        (silent->size() != chromagram.size()))
+    {
+        throw invalid_argument("PoolChromagram(): columns do not match the chromagram");
+    }
+
+    for (uint32_t col = 0; col + 1 < columns.size(); col++) {
+        uint32_t from = columns[col], to = columns[col + 1];
+        vector<uint32_t> frames;
+
+        if (from >= to) {
+            throw invalid_argument("PoolChromagram(): empty column");
+        }
+
+        for (uint32_t f = from; f < to; f++) {
+            if (!(*silent)[f]) {
+                frames.push_back(f);
+            }
+        }
+
+        if (frames.empty()) {
+            pooled.push_back(chromagram[from]);
+            pooled_silent.push_back(true);
+            continue;
+        }
+
+        values.resize(chromagram[frames[0]].getValues().size());
+
+        for (uint32_t i = 0; i < values.size(); i++) {
+            cls.clear();
+            for (auto f : frames) {
+                cls.push_back(chromagram[f].getValues().at(i));
+            }
+
+            switch (pooling) {
+            case BEAT_SYNC_MEAN:
+                values[i] = accumulate(cls.begin(), cls.end(), 0.0) / cls.size();
+                break;
+            case BEAT_SYNC_MEDIAN:
+                sort(cls.begin(), cls.end());
+                values[i] = (cls[(cls.size() - 1) / 2] + cls[cls.size() / 2]) / 2;
+                break;
+            case BEAT_SYNC_MAX:
+                values[i] = *max_element(cls.begin(), cls.end());
+                break;
+            default:
+                throw invalid_argument("PoolChromagram(): unknown pooling");
+            }
+        }
+
+        pooled.push_back(pcp_t(values));
+        pooled_silent.push_back(false);
+    }
+
+    *silent = pooled_silent;
+
+    return pooled;
+}
+
 }
 
 /** @} */
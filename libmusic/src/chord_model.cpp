@@ -0,0 +1,523 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    chord_model.cpp
+ * @brief   Implementation of the chord HMM training and storage
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <stdexcept>
+#include <string.h>
+
+#include "chord_model.h"
+#include "chord_tpl.h"
+#include "lmhelpers.h"
+
+/** Has to be bumped whenever file layout changes */
+#define MODEL_VERSION       2
+#define MODEL_MAGIC         "LMHM"
+
+/** Sanity limit of the analysis parameters description */
+#define MODEL_PARAMS_MAX    4096
+
+/** Chord qualities the library supports */
+#define QUALITIES           (cq_Max - cq_Min + 1)
+
+/** Index of N among the qualities of the trainer */
+#define QUALITY_N           QUALITIES
+
+using namespace std;
+
+namespace anatomist {
+
+typedef struct {
+    char        magic[4];
+    uint32_t    version;
+    uint32_t    states;
+    uint32_t    dims;
+    uint32_t    params_len;     /**< analysis parameters follow the header */
+} model_header_t;
+
+typedef struct {
+    uint8_t     root;
+    uint8_t     quality;
+    uint8_t     reserved[2];
+} model_state_t;
+
+/**
+ * Take count items of the given size out of the bytes left, without
+ * overflowing on the counts of a corrupted header
+ */
+static bool consume(uint64_t *left, uint64_t count, uint64_t size)
+{
+    if (count > *left / size) {
+        return false;
+    }
+    *left -= count * size;
+
+    return true;
+}
+
+ChordModel::ChordModel(const vector<chord_t> &states, const vector<vector<amplitude_t>> &tpls,
+                       const vector<prob_t> &init_p, const Viterbi::prob_matrix_t &trans_p,
+                       const string &params) :
+        states_(states), tpls_(tpls), init_p_(init_p), trans_p_(trans_p), params_(params)
+{
+    if (params.size() > MODEL_PARAMS_MAX) {
+        throw invalid_argument("ChordModel(): analysis parameters are too long");
+    }
+
+    if (states.empty() || (states.back().rootNote() != note_Unknown)) {
+        throw invalid_argument("ChordModel(): the last state has to be N");
+    }
+
+    if ((tpls.size() != states.size()) || (init_p.size() != states.size()) ||
+        (trans_p.size() != states.size()))
+    {
+        throw invalid_argument("ChordModel(): wrong number of states");
+    }
+
+    for (auto &tpl : tpls) {
+        if (tpl.empty() || (tpl.size() != tpls[0].size())) {
+            throw invalid_argument("ChordModel(): templates of different size");
+        }
+    }
+
+    if (!Helpers::almostEqual(accumulate(init_p.begin(), init_p.end(), 0.0), 1, 1.0 / 10000)) {
+        throw invalid_argument("ChordModel(): total initial probability is not 1");
+    }
+
+    for (auto &row : trans_p) {
+        if ((row.size() != states.size()) ||
+            !Helpers::almostEqual(accumulate(row.begin(), row.end(), 0.0), 1, 1.0 / 10000))
+        {
+            throw invalid_argument("ChordModel(): bad transition matrix");
+        }
+    }
+}
+
+ChordModel ChordModel::Load(const string &path)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    model_header_t hdr;
+
+    if (file == nullptr) {
+        throw runtime_error("ChordModel::Load(): failed to open " + path);
+    }
+
+    if ((fread(&hdr, sizeof(hdr), 1, file) != 1) ||
+        (memcmp(hdr.magic, MODEL_MAGIC, sizeof(hdr.magic)) != 0) ||
+        (hdr.version != MODEL_VERSION) || (hdr.states == 0) || (hdr.dims == 0) ||
+        (hdr.params_len > MODEL_PARAMS_MAX))
+    {
+        fclose(file);
+        throw runtime_error("ChordModel::Load(): " + path + " is not a chord model");
+    }
+
+    /* the header has to match the file size before anything is allocated for it */
+    long end = (fseek(file, 0, SEEK_END) == 0) ? ftell(file) : -1;
+    uint64_t left = (end >= static_cast<long>(sizeof(hdr))) ? end - sizeof(hdr) : 0;
+
+    if ((end < static_cast<long>(sizeof(hdr))) ||
+        (fseek(file, sizeof(hdr), SEEK_SET) != 0) ||
+        !consume(&left, hdr.params_len, 1) ||
+        !consume(&left, hdr.states, sizeof(model_state_t) + sizeof(prob_t)) ||
+        !consume(&left, hdr.states, static_cast<uint64_t>(hdr.states) * sizeof(prob_t)) ||
+        !consume(&left, hdr.states, static_cast<uint64_t>(hdr.dims) * sizeof(amplitude_t)) ||
+        (left != 0))
+    {
+        fclose(file);
+        throw runtime_error("ChordModel::Load(): " + path + " is truncated or corrupted");
+    }
+
+    vector<model_state_t> raw_states(hdr.states);
+    vector<prob_t> init_p(hdr.states);
+    Viterbi::prob_matrix_t trans_p(hdr.states, vector<prob_t>(hdr.states));
+    vector<vector<amplitude_t>> tpls(hdr.states, vector<amplitude_t>(hdr.dims));
+    string params(hdr.params_len, '\0');
+    bool ok = (fread(&params[0], 1, hdr.params_len, file) == hdr.params_len) &&
+              (fread(raw_states.data(), sizeof(raw_states[0]), hdr.states, file) == hdr.states) &&
+              (fread(init_p.data(), sizeof(init_p[0]), hdr.states, file) == hdr.states);
+
+    for (uint32_t s = 0; ok && (s < hdr.states); s++) {
+        ok = (fread(trans_p[s].data(), sizeof(prob_t), hdr.states, file) == hdr.states);
+    }
+    for (uint32_t s = 0; ok && (s < hdr.states); s++) {
+        ok = (fread(tpls[s].data(), sizeof(amplitude_t), hdr.dims, file) == hdr.dims);
+    }
+    ok = ok && (fgetc(file) == EOF);
+
+    fclose(file);
+
+    if (!ok) {
+        throw runtime_error("ChordModel::Load(): " + path + " is truncated or corrupted");
+    }
+
+    vector<chord_t> states;
+
+    for (auto &s : raw_states) {
+        if ((s.root > note_Max) || (s.quality > cq_Max) ||
+            ((s.root == note_Unknown) != (s.quality == cq_unknown)))
+        {
+            throw runtime_error("ChordModel::Load(): unsupported chord in " + path);
+        }
+        states.push_back(Chord(static_cast<note_t>(s.root),
+                               static_cast<chord_quality_t>(s.quality)));
+    }
+
+    return ChordModel(states, tpls, init_p, trans_p, params);
+}
+
+void ChordModel::Save(const string &path) const
+{
+    model_header_t hdr;
+    vector<model_state_t> raw_states(states_.size());
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, MODEL_MAGIC, sizeof(hdr.magic));
+    hdr.version = MODEL_VERSION;
+    hdr.states = states_.size();
+    hdr.dims = tpls_[0].size();
+    hdr.params_len = params_.size();
+
+    memset(raw_states.data(), 0, raw_states.size() * sizeof(raw_states[0]));
+    for (size_t s = 0; s < states_.size(); s++) {
+        raw_states[s].root = states_[s].rootNote();
+        raw_states[s].quality = states_[s].quality();
+    }
+
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        throw runtime_error("ChordModel::Save(): failed to create " + path);
+    }
+
+    bool ok = (fwrite(&hdr, sizeof(hdr), 1, file) == 1) &&
+              (fwrite(params_.data(), 1, hdr.params_len, file) == hdr.params_len) &&
+              (fwrite(raw_states.data(), sizeof(raw_states[0]), hdr.states, file) == hdr.states) &&
+              (fwrite(init_p_.data(), sizeof(init_p_[0]), hdr.states, file) == hdr.states);
+
+    for (uint32_t s = 0; ok && (s < hdr.states); s++) {
+        ok = (fwrite(trans_p_[s].data(), sizeof(prob_t), hdr.states, file) == hdr.states);
+    }
+    for (uint32_t s = 0; ok && (s < hdr.states); s++) {
+        ok = (fwrite(tpls_[s].data(), sizeof(amplitude_t), hdr.dims, file) == hdr.dims);
+    }
+
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok) {
+        remove(path.c_str());
+        throw runtime_error("ChordModel::Save(): failed to write " + path);
+    }
+}
+
+size_t ChordModel::Size() const
+{
+    return states_.size();
+}
+
+const vector<chord_t> & ChordModel::States() const
+{
+    return states_;
+}
+
+const vector<vector<amplitude_t>> & ChordModel::Templates() const
+{
+    return tpls_;
+}
+
+const vector<prob_t> & ChordModel::InitProbs() const
+{
+    return init_p_;
+}
+
+const Viterbi::prob_matrix_t & ChordModel::TransProbs() const
+{
+    return trans_p_;
+}
+
+const string & ChordModel::Params() const
+{
+    return params_;
+}
+
+ChordModelTrainer::ChordModelTrainer(const string &params) :
+        params_(params),
+        dims_(0),
+        recordings_(0),
+        frames_(0),
+        sums_(QUALITIES + 1),
+        profiles_(QUALITIES + 1, 0),
+        init_cnt_(QUALITIES + 1, 0),
+        trans_cnt_((QUALITIES + 1) * (QUALITIES + 1) * notes_Total, 0)
+{
+}
+
+uint32_t ChordModelTrainer::Quality_(const chord_t &chord)
+{
+    if ((chord.rootNote() == note_Unknown) ||
+        (chord.quality() < cq_Min) || (chord.quality() > cq_Max))
+    {
+        return QUALITY_N;
+    }
+
+    return static_cast<int>(chord.quality()) - static_cast<int>(cq_Min);
+}
+
+uint32_t ChordModelTrainer::Root_(const chord_t &chord)
+{
+    return (Quality_(chord) == QUALITY_N) ? 0 :
+           static_cast<int>(chord.rootNote()) - static_cast<int>(note_Min);
+}
+
+size_t ChordModelTrainer::TransIdx_(uint32_t q_from, uint32_t q_to, uint32_t interval)
+{
+    return (static_cast<size_t>(q_from) * (QUALITIES + 1) + q_to) * notes_Total + interval;
+}
+
+void ChordModelTrainer::Add(const chromagram_t &chromagram, const vector<chord_t> &chords,
+                            const vector<bool> &known)
+{
+    if ((chords.size() != chromagram.size()) || (known.size() != chromagram.size())) {
+        throw invalid_argument("ChordModelTrainer::Add(): annotation does not match chromagram");
+    }
+
+    bool first = true;
+    bool prev_known = false;
+    uint32_t prev_q = 0, prev_root = 0;
+
+    for (size_t f = 0; f < chromagram.size(); f++) {
+        if (!known[f]) {
+            prev_known = false;
+            continue;
+        }
+
+        const vector<amplitude_t> &values = chromagram[f].getValues();
+        uint32_t q = Quality_(chords[f]);
+        uint32_t root = Root_(chords[f]);
+
+        if (dims_ == 0) {
+            if ((values.size() == 0) || (values.size() % notes_Total != 0)) {
+                throw invalid_argument("ChordModelTrainer::Add(): unsupported profile size");
+            }
+            dims_ = values.size();
+            for (auto &s : sums_) {
+                s.resize(dims_, 0);
+            }
+        } else if (values.size() != dims_) {
+            throw invalid_argument("ChordModelTrainer::Add(): profiles of different size");
+        }
+
+        /* silent frames are not analysed */
+        if (any_of(values.begin(), values.end(), [](amplitude_t v) { return v != 0; })) {
+            for (size_t i = 0; i < dims_; i++) {
+                size_t octave = i - i % notes_Total;
+
+                sums_[q][octave + (i % notes_Total + notes_Total - root) % notes_Total] += values[i];
+            }
+            profiles_[q]++;
+        }
+
+        if (first) {
+            init_cnt_[q]++;
+            first = false;
+        }
+
+        if (prev_known) {
+            uint32_t interval = ((q == QUALITY_N) || (prev_q == QUALITY_N)) ? 0 :
+                                (root + notes_Total - prev_root) % notes_Total;
+
+            trans_cnt_[TransIdx_(prev_q, q, interval)]++;
+        }
+
+        prev_known = true;
+        prev_q = q;
+        prev_root = root;
+        frames_++;
+    }
+
+    recordings_++;
+}
+
+ChordModelTrainer & ChordModelTrainer::operator+=(const ChordModelTrainer &t)
+{
+    if (t.params_ != params_) {
+        throw invalid_argument("ChordModelTrainer: other analysis parameters");
+    }
+
+    if (t.dims_ != 0) {
+        if ((dims_ != 0) && (dims_ != t.dims_)) {
+            throw invalid_argument("ChordModelTrainer: profiles of different size");
+        }
+        dims_ = t.dims_;
+        for (uint32_t q = 0; q < sums_.size(); q++) {
+            sums_[q].resize(dims_, 0);
+            for (size_t i = 0; i < dims_; i++) {
+                sums_[q][i] += t.sums_[q][i];
+            }
+        }
+    }
+
+    for (uint32_t q = 0; q < profiles_.size(); q++) {
+        profiles_[q] += t.profiles_[q];
+        init_cnt_[q] += t.init_cnt_[q];
+    }
+    for (size_t i = 0; i < trans_cnt_.size(); i++) {
+        trans_cnt_[i] += t.trans_cnt_[i];
+    }
+
+    recordings_ += t.recordings_;
+    frames_ += t.frames_;
+
+    return *this;
+}
+
+uint32_t ChordModelTrainer::Recordings() const
+{
+    return recordings_;
+}
+
+uint64_t ChordModelTrainer::Frames() const
+{
+    return frames_;
+}
+
+vector<amplitude_t> ChordModelTrainer::Template_(uint32_t q, uint32_t root) const
+{
+    vector<amplitude_t> tpl(dims_);
+
+    if (profiles_[q] == 0) {
+        /* N is often annotated over silence only */
+        amplitude_t values[CHORD_TPL_SIZE];
+        ChordTpl n_tpl(note_Unknown, cq_unknown, 0, values);
+
+        if (dims_ == CHORD_TPL_SIZE) {
+            copy(values, values + CHORD_TPL_SIZE, tpl.begin());
+        } else if (dims_ == notes_Total) {
+            /* no separation between bass and treble */
+            copy(values + notes_Total, values + CHORD_TPL_SIZE, tpl.begin());
+        } else {
+            throw runtime_error("ChordModelTrainer: no theoretical N template of this size");
+        }
+
+        return tpl;
+    }
+
+    amplitude_t power = 0;
+
+    for (size_t i = 0; i < dims_; i++) {
+        size_t octave = i - i % notes_Total;
+
+        tpl[octave + (i % notes_Total + root) % notes_Total] = sums_[q][i] / profiles_[q];
+        power += sums_[q][i] * sums_[q][i] / (1.0 * profiles_[q] * profiles_[q]);
+    }
+
+    /* same scale as the theoretical templates, see ChordTpl::PostInit_() */
+    amplitude_t rms = sqrt(power / dims_);
+
+    for (auto &v : tpl) {
+        v = (rms > 0) ? v / rms : 0;
+    }
+
+    return tpl;
+}
+
+ChordModel ChordModelTrainer::Model(double smoothing) const
+{
+    if (dims_ == 0) {
+        throw runtime_error("ChordModelTrainer::Model(): nothing to train on");
+    }
+    if (smoothing < 0) {
+        throw invalid_argument("ChordModelTrainer::Model(): negative smoothing");
+    }
+
+    vector<chord_t> states;
+    vector<uint32_t> qualities, roots;
+    vector<vector<amplitude_t>> tpls;
+
+    for (uint32_t root = 0; root < notes_Total; root++) {
+        for (uint32_t q = 0; q < QUALITIES; q++) {
+            if (profiles_[q] == 0) {
+                continue;
+            }
+            states.push_back(Chord(static_cast<note_t>(static_cast<int>(note_Min) + root),
+                                   static_cast<chord_quality_t>(static_cast<int>(cq_Min) + q)));
+            qualities.push_back(q);
+            roots.push_back(root);
+        }
+    }
+    states.push_back(Chord());
+    qualities.push_back(QUALITY_N);
+    roots.push_back(0);
+
+    size_t n = states.size();
+    vector<prob_t> init_p(n);
+    Viterbi::prob_matrix_t trans_p(n, vector<prob_t>(n));
+
+    for (size_t s = 0; s < n; s++) {
+        tpls.push_back(Template_(qualities[s], roots[s]));
+
+        /* chords of every root share the statistics */
+        init_p[s] = init_cnt_[qualities[s]] / (qualities[s] == QUALITY_N ? 1 : notes_Total);
+    }
+
+    for (size_t from = 0; from < n; from++) {
+        uint32_t q_from = qualities[from];
+
+        for (size_t to = 0; to < n; to++) {
+            uint32_t q_to = qualities[to];
+
+            if (q_from == QUALITY_N) {
+                trans_p[from][to] = trans_cnt_[TransIdx_(q_from, q_to, 0)] /
+                                    (q_to == QUALITY_N ? 1 : notes_Total);
+            } else if (q_to == QUALITY_N) {
+                trans_p[from][to] = trans_cnt_[TransIdx_(q_from, q_to, 0)];
+            } else {
+                uint32_t interval = (roots[to] + notes_Total - roots[from]) % notes_Total;
+
+                trans_p[from][to] = trans_cnt_[TransIdx_(q_from, q_to, interval)];
+            }
+        }
+    }
+
+    auto normalize = [smoothing](vector<prob_t> &p) {
+        prob_t sum = 0;
+
+        for (auto &v : p) {
+            v += smoothing;
+            sum += v;
+        }
+        for (auto &v : p) {
+            v = (sum > 0) ? v / sum : 1.0 / p.size();
+        }
+    };
+
+    normalize(init_p);
+    for (auto &row : trans_p) {
+        normalize(row);
+    }
+
+    return ChordModel(states, tpls, init_p, trans_p, params_);
+}
+
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    chord_session.cpp
+ * @brief   Incremental chord recognition implementation
+ * @ingroup libmusic
+ * @{
+ */
+
+#include <algorithm>
+#include <iterator>
+
+#include "chord_session.h"
+#include "lmstats.h"
+
+using namespace std;
+
+namespace anatomist {
+
+ChordSession::ChordSession(ChordDetector &detector, uint32_t samplerate) :
+    detector_(detector), samplerate_(samplerate)
+{
+    detector_.ChunkParams_(samplerate_, &alignment_, &context_);
+
+    Reset();
+}
+
+void ChordSession::Reset()
+{
+    samples_ = 0;
+    dirty_from_ = 0;
+    dirty_to_ = 0;
+    interval_ = 0;
+    frames_analysed_ = 0;
+    frames_decoded_ = 0;
+
+    scores_.clear();
+    power_.clear();
+    silent_.clear();
+    obs_.clear();
+    segments_.clear();
+    decoder_.reset();
+}
+
+void ChordSession::Invalidate(size_t start, size_t end)
+{
+    if (start >= end) {
+        throw invalid_argument("Invalidate(): empty range");
+    }
+
+    if (dirty_from_ >= dirty_to_) {
+        dirty_from_ = start;
+        dirty_to_ = end;
+    } else {
+        dirty_from_ = min(dirty_from_, start);
+        dirty_to_ = max(dirty_to_, end);
+    }
+}
+
+void ChordSession::Update(const SignalView &x)
+{
+    LM_STATS_SCOPE("chord_session");
+
+    size_t samples = x.size();
+    size_t change_from = samples, change_to = 0;
+    bool resized = (samples != samples_);
+
+    if (dirty_from_ < dirty_to_) {
+        change_from = dirty_from_;
+        change_to = min(dirty_to_, samples);
+    }
+    dirty_from_ = dirty_to_ = 0;
+    frames_analysed_ = 0;
+    frames_decoded_ = 0;
+
+    if (samples == 0) {
+        Reset();
+        return;
+    }
+
+    /* frames around the end see where the recording ends */
+    if (resized) {
+        change_from = min(change_from, min(samples_, samples));
+        change_to = samples;
+    } else if (change_from >= change_to) {
+        return;
+    }
+
+    LM_STATS_FRAMES(change_to - change_from);
+
+    /*
+     * Frames before start only see the input before the change, the ones
+     * from end on restart the transform past it, see ChunkInput()
+     */
+    size_t before = (context_ + alignment_ - 1) / alignment_ * alignment_;
+    size_t start = (change_from > context_) ? (change_from - context_) / alignment_ * alignment_ : 0;
+    size_t end = (change_to + alignment_ - 1) / alignment_ * alignment_ + before;
+    size_t from, to;
+
+    if (resized || (end >= samples)) {
+        end = samples;
+    }
+
+    detector_.ChunkInput(samplerate_, samples, start, end, &from, &to);
+
+    chunk_t chunk = detector_.AnalyzeChunk(x.Sub(from, to - from), samplerate_, samples,
+                                           start, end);
+    uint32_t frames = scores_.size();
+    uint32_t first = chunk.first_frame;
+    uint32_t last = first + chunk.scores.size();
+
+    interval_ = chunk.interval;
+    frames_analysed_ = chunk.scores.size();
+
+    if (end == samples) {
+        scores_.resize(first);
+        power_.resize(min<size_t>(first, power_.size()));
+    } else if ((last > scores_.size()) || (first + chunk.power.size() > power_.size())) {
+        throw runtime_error("Update(): chunk does not match the recording");
+    }
+
+    scores_.erase(scores_.begin() + first, scores_.begin() + min<size_t>(last, scores_.size()));
+    scores_.insert(scores_.begin() + first, make_move_iterator(chunk.scores.begin()),
+                   make_move_iterator(chunk.scores.end()));
+    power_.erase(power_.begin() + first,
+                 power_.begin() + min<size_t>(first + chunk.power.size(), power_.size()));
+    power_.insert(power_.begin() + first, chunk.power.begin(), chunk.power.end());
+
+    /* silence is relative to the loudest frame, it may change anywhere */
+    vector<bool> silent = ChordDetector::SilentFrames_(power_);
+    uint32_t from_frame = first, to_frame = last;
+
+    silent.resize(scores_.size(), false);
+
+    for (uint32_t f = 0; f < min(silent.size(), silent_.size()); f++) {
+        if (silent[f] != silent_[f]) {
+            from_frame = min(from_frame, f);
+            to_frame = max(to_frame, f + 1);
+        }
+    }
+
+    obs_.resize(scores_.size());
+    for (uint32_t f = from_frame; f < to_frame; f++) {
+        obs_[f] = scores_[f];
+        if (silent[f]) {
+            fill(obs_[f].begin(), obs_[f].end(), 0);
+            obs_[f].back() = 1;
+        }
+    }
+    silent_ = move(silent);
+
+    if (!decoder_) {
+        vector<prob_t> init_p;
+        Viterbi::prob_matrix_t trans_p;
+
+        detector_.Transitions_(&init_p, &trans_p);
+        decoder_.reset(new Viterbi::Incremental(init_p, trans_p));
+    }
+
+    uint32_t changed = decoder_->Update(obs_, from_frame, to_frame);
+    frames_decoded_ = decoder_->Decoded();
+    size_t prev_samples = samples_;
+
+    samples_ = samples;
+    UpdateSegments_(min(changed, from_frame), frames, prev_samples);
+}
+
+void ChordSession::UpdateSegments_(uint32_t frame, uint32_t frames, size_t samples)
+{
+    const vector<uint32_t> &path = decoder_->Path();
+
+    /* the last frame ends a segment whatever it is, so does the end of the recording */
+    uint32_t cut = min<uint32_t>(frame, min<size_t>(frames, path.size()) - 1);
+    size_t end_max = min(samples, samples_);
+    size_t keep = 0;
+
+    if (frames == 0) {
+        cut = 0;
+    }
+
+    while (keep + 1 < segments_.size()) {
+        uint32_t end = segments_[keep + 1].startIdx / interval_;
+
+        if ((end >= cut) || (static_cast<size_t>(end) * interval_ > end_max)) {
+            break;
+        }
+        keep++;
+    }
+
+    uint32_t seg_start = (keep == 0) ? 0 : segments_[keep].startIdx / interval_;
+
+    segments_.resize(keep);
+    detector_.PathSegments_(path, silent_, interval_, vector<uint32_t>(), samples_, seg_start,
+                            &segments_, nullptr);
+}
+
+const vector<segment_t> & ChordSession::GetSegments() const
+{
+    return segments_;
+}
+
+uint32_t ChordSession::FramesAnalysed() const
+{
+    return frames_analysed_;
+}
+
+uint32_t ChordSession::FramesDecoded() const
+{
+    return frames_decoded_;
+}
+
+}
+
+/** @} */
@@ -23,168 +23,184 @@
  * Implementation of the ChordTpl class
  */
 
+#include <algorithm>
+#include <cmath>
+
 #include "chord_tpl.h"
 #include "config.h"
 #include "lmhelpers.h"
 #include "lmtypes.h"
-#include "music_scale.h"
 
 
 using namespace std;
 
 namespace anatomist {
 
-std::map<chord_quality_t, std::vector<std::vector<note_presense_state_t>>> ChordTpl::chord_qlty_tpls_ = {
-    {cq_maj,                {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
-                                    {nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
-                                    {nps_NP, nps_NP, nps_P,  nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
-                                    {nps_NP, nps_NP, nps_NP, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_min,                {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
-                                    {nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
-                                    {nps_NP, nps_NP, nps_P,  nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
-                                    {nps_NP, nps_NP, nps_NP, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_5,                  {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_NP, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_7,                  {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_PF,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
-                                }},
-    {cq_maj7,               {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_P,   nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_min7,               {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_PF,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_sus2,               {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_P,  nps_NP, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_sus4,               {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_NP, nps_P,  nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_hdim7,              {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_PF, nps_NP, nps_PF, nps_NP, nps_PF,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_aug,                {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_P,  nps_NP, nps_PS, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_dim,                {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_PF, nps_NP, nps_PF, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_dim7,               {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_PF, nps_NP, nps_PF, nps_NP, nps_PFF, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    /* END OF MINIMIM SUPPORTED SET */
-    {cq_dim7,               {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_PF, nps_NP, nps_PF, nps_NP, nps_PFF, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_maj_add9,           {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_P,  nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_min_add9,           {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_P,  nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_maj6,               {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_P,  nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_min6,               {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_P,  nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_maj9,               {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_P,   nps_NP, nps_P,  nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_min9,               {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_PF,  nps_NP, nps_P,  nps_NP, nps_NP, nps_NP, nps_NP}
-                                }},
-    {cq_maj_add11,          {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_P,  nps_NP, nps_NP}
-                                }},
-    {cq_7_add9sharp,        {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_PF,  nps_NP, nps_PS, nps_NP, nps_NP,  nps_NP, nps_NP}
-                                }},
-    {cq_9,                  {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_PF,  nps_NP, nps_P,  nps_NP, nps_NP, nps_NP, nps_NP},
-                                }},
-    {cq_aug7,               {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_P,  nps_NP, nps_PS, nps_NP, nps_PF,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
-                                }},
-    {cq_maj11,              {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_P,   nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_NP}
-                                }},
-    {cq_min11,              {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_PF,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_NP}
-                                }},
-    {cq_maj13,              {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_P,   nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_P}
-                                }},
-    {cq_min13,              {
-                                    {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
-                                     nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_PF,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_P}
-                                }},
+/**
+ * Notes of every chord quality and its slash subtypes as scale degrees of the
+ * root major scale: bass degrees followed by treble ones
+ */
+static constexpr note_presense_state_t chord_qlty_tpls[cq_Max + 1][CHORD_TPL_SUBTYPES_MAX][CHORD_TPL_DEGREES * 2] = {
+    /* cq_unknown */        {},
+    /* cq_maj */            {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                                {nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                                {nps_NP, nps_NP, nps_P,  nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                                {nps_NP, nps_NP, nps_NP, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_min */            {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                                {nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                                {nps_NP, nps_NP, nps_P,  nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                                {nps_NP, nps_NP, nps_NP, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_5 */              {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_NP, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_7 */              {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_PF,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_maj7 */           {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_P,   nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_min7 */           {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_PF,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_sus2 */           {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_P,  nps_NP, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_sus4 */           {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_NP, nps_P,  nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_hdim7 */          {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_PF, nps_NP, nps_PF, nps_NP, nps_PF,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_aug */            {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_P,  nps_NP, nps_PS, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_dim */            {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_PF, nps_NP, nps_PF, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_dim7 */           {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_PF, nps_NP, nps_PF, nps_NP, nps_PFF, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_maj_add9 */       {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_P,  nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_min_add9 */       {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_P,  nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_maj6 */           {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_P,  nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_min6 */           {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_P,  nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_maj9 */           {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_P,   nps_NP, nps_P,  nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_min9 */           {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_PF,  nps_NP, nps_P,  nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_maj_add11 */      {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_P,  nps_NP, nps_NP},
+                            },
+    /* cq_7_add9sharp */    {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_PF,  nps_NP, nps_PS, nps_NP, nps_NP,  nps_NP, nps_NP},
+                            },
+    /* cq_9 */              {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_PF,  nps_NP, nps_P,  nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_aug7 */           {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_P,  nps_NP, nps_PS, nps_NP, nps_PF,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP},
+                            },
+    /* cq_maj11 */          {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_P,   nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_NP},
+                            },
+    /* cq_min11 */          {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_PF,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_NP},
+                            },
+    /* cq_maj13 */          {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_P,   nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_P},
+                            },
+    /* cq_min13 */          {
+                                {nps_P,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,  nps_NP, nps_NP, nps_NP, nps_NP, nps_NP, nps_NP,
+                                 nps_P,  nps_NP, nps_PF, nps_NP, nps_P,  nps_NP, nps_PF,  nps_NP, nps_P,  nps_NP, nps_P,  nps_NP, nps_P},
+                            },
+};
+
+
+/**
+ * Semitones from the root to every degree of its major scale
+ */
+static constexpr uint8_t major_scale_semitones[CHORD_TPL_DEGREES] = {
+    0, 2, 4, 5, 7, 9, 11, 12, 14, 16, 17, 19, 21
 };
 
 
-ChordTpl::ChordTpl(note_t root_note, chord_quality_t cq, uint8_t slash_subtype) :
-        root_note_(root_note), chord_quality_(cq)
+ChordTpl::ChordTpl(note_t root_note, chord_quality_t cq, uint8_t slash_subtype,
+                   amplitude_t *values) :
+        root_note_(root_note), chord_quality_(cq), tpl_(values), size_(CHORD_TPL_SIZE)
 {
+    if (values == nullptr) {
+        throw std::invalid_argument("ChordTpl(): no storage for the template");
+    }
     if ((root_note < note_Min) || (root_note > note_Max)) {
         if ((root_note == note_Unknown) && (cq == cq_unknown)) {
-            InitN_();
+            InitN_(values);
             return;
         } else {
             throw std::invalid_argument("ChordTpl(): Invalid note");
         }
     }
-    if ((cq < cq_Min) || (cq > cq_Max) ||
-        (chord_qlty_tpls_.find(cq) == chord_qlty_tpls_.end()))
-    {
+    if ((cq < cq_Min) || (cq > cq_Max)) {
         throw std::invalid_argument("ChordTpl(): Invalid chord quality");
     }
-    if (slash_subtype >= chord_qlty_tpls_[cq].size()) {
+    if (slash_subtype >= SlashSubtypesCnt(cq)) {
         throw std::invalid_argument("ChordTpl(): Invalid slash subtype");
     }
 
-    InitTpl_(root_note, cq, slash_subtype);
+    InitTpl_(root_note, cq, slash_subtype, values);
 }
 
-ChordTpl::ChordTpl(note_t root_note, chord_quality_t cq, std::vector<prob_t> &tpl) :
-        root_note_(root_note), chord_quality_(cq), tpl_(tpl)
+ChordTpl::ChordTpl(note_t root_note, chord_quality_t cq, const std::vector<prob_t> &tpl) :
+        root_note_(root_note), chord_quality_(cq), tpl_(tpl.data()), size_(tpl.size())
 {
+    if ((root_note == note_Unknown) && (cq == cq_unknown)) {
+        return;
+    }
+
     if ((root_note < note_Min) || (root_note > note_Max)) {
         throw std::invalid_argument("ChordTpl(): Invalid note");
     }
@@ -194,22 +210,23 @@ ChordTpl::ChordTpl(note_t root_note, chord_quality_t cq, std::vector<prob_t> &tp
     }
 }
 
-void ChordTpl::InitTpl_(note_t root_note, chord_quality_t cq, uint8_t ss)
+void ChordTpl::InitTpl_(note_t root_note, chord_quality_t cq, uint8_t ss, amplitude_t *values)
 {
-    vector<note_t> scale = MusicScale::getMajorScale(root_note);
-    vector<note_presense_state_t> *qt = &chord_qlty_tpls_[cq][ss];
+    const note_presense_state_t *qt = chord_qlty_tpls[cq][ss];
+    const uint8_t qt_size = CHORD_TPL_DEGREES * 2;
 
-    tpl_.resize(notes_Total * 2, 0);
+    fill(values, values + CHORD_TPL_SIZE, 0);
 
-    for (uint8_t i = 0; i < qt->size(); i++) {
+    for (uint8_t i = 0; i < qt_size; i++) {
         note_t note = note_Unknown;
-        note_presense_state_t presenseState = (*qt)[i];
+        note_presense_state_t presenseState = qt[i];
         uint8_t treble_offset = notes_Total;
-        uint8_t scale_idx = i % (qt->size() / 2);
+        uint8_t scale_idx = i % CHORD_TPL_DEGREES;
+        note_t scale_note = root_note + major_scale_semitones[scale_idx];
 
         switch(presenseState) {
             case nps_present:
-                note = scale[scale_idx];
+                note = scale_note;
                 break;
             case nps_present_flat:
             case nps_present_flat_flat:
@@ -225,7 +242,7 @@ void ChordTpl::InitTpl_(note_t root_note, chord_quality_t cq, uint8_t ss)
                     interval = 1;
                 }
 
-                note = scale[scale_idx] + interval;
+                note = scale_note + interval;
 
                 break;
             }
@@ -236,84 +253,82 @@ void ChordTpl::InitTpl_(note_t root_note, chord_quality_t cq, uint8_t ss)
 
         if (note != note_Unknown) {
             // the first half of a template is bass and the second is treble
-            if (i < qt->size() / 2) {
+            if (i < qt_size / 2) {
                 bass_note_ = note;
                 bass_interval_ = scale_idx + 1;
                 treble_offset = 0;
             }
-            tpl_[note - note_Min + treble_offset] = 1;
+            values[note - note_Min + treble_offset] = 1;
         }
     }
 
-    for (uint8_t i = 0; i < tpl_.size() / 2; i++) {
-        if (tpl_[i] != 1 && tpl_[i + notes_Total] == 1) {
-            tpl_[i] = 0.5;
+    for (uint8_t i = 0; i < notes_Total; i++) {
+        if (values[i] != 1 && values[i + notes_Total] == 1) {
+            values[i] = 0.5;
         }
     }
 
-    PostInit_(1.0f);
+    PostInit_(values, CHORD_TPL_SIZE, 1.0f);
 }
 
-void ChordTpl::InitN_()
+void ChordTpl::InitN_(amplitude_t *values)
 {
-    typeof(tpl_) treble(notes_Total, 1);
-    tpl_.resize(notes_Total, 0.5);
-    tpl_.insert(tpl_.end(), treble.begin(), treble.end());
+    fill(values, values + notes_Total, 0.5);
+    fill(values + notes_Total, values + CHORD_TPL_SIZE, 1);
 
-    PostInit_(1.1f);
+    PostInit_(values, CHORD_TPL_SIZE, 1.1f);
 }
 
-void ChordTpl::PostInit_(float boost)
+void ChordTpl::PostInit_(amplitude_t *values, size_t size, float boost)
 {
     float stand = 0;
 
-    for (const auto & val : tpl_) {
-        stand += pow(abs(val), 2.0) / tpl_.size();
+    for (size_t i = 0; i < size; i++) {
+        stand += pow(abs(values[i]), 2.0) / size;
     }
 
     stand = powf(stand, 1.0f / 2.0) / boost;
 
-    for (auto & val : tpl_) {
-        val /= stand;
+    for (size_t i = 0; i < size; i++) {
+        values[i] /= stand;
     }
 }
 
-tpl_score_t ChordTpl::GetScore(pcp_t *pcp)
+tpl_score_t ChordTpl::GetScore(pcp_t *pcp) const
 {
-    if (pcp->size() == tpl_.size()) {
-        return pcp->sumProduct(tpl_);
-    } else if (pcp->size() == tpl_.size() / 2) { /* no separation between bass and treble */
-        vector<typeof(tpl_[0])> treble(tpl_.begin() + notes_Total, tpl_.end());
-        return pcp->euclideanDistance<typeof(tpl_[0])>(treble);
+    if (pcp->size() == size_) {
+        return pcp->sumProduct(tpl_, size_);
+    } else if (pcp->size() == size_ / 2) { /* no separation between bass and treble */
+        vector<amplitude_t> treble(tpl_ + notes_Total, tpl_ + size_);
+        return pcp->euclideanDistance<amplitude_t>(treble);
     } else {
         throw invalid_argument("Incompatible PCP size");
     }
 }
 
-note_t ChordTpl::RootNote()
+note_t ChordTpl::RootNote() const
 {
     return root_note_;
 }
 
-note_t ChordTpl::BassNote()
+note_t ChordTpl::BassNote() const
 {
     return bass_note_;
 }
 
-chord_quality_t ChordTpl::Quality()
+chord_quality_t ChordTpl::Quality() const
 {
     return chord_quality_;
 }
 
-size_t ChordTpl::SlashSubtypesCnt(chord_quality_t q)
+const amplitude_t * ChordTpl::Values() const
 {
-    if ((q < cq_Min) || (q > cq_Max) ||
-        (chord_qlty_tpls_.find(q) == chord_qlty_tpls_.end()))
-    {
-        throw std::invalid_argument("ChordTpl::SlashSubtypesCnt(): Invalid chord quality");
-    }
+    return tpl_;
+}
 
-    return chord_qlty_tpls_[q].size();
+size_t ChordTpl::Size() const
+{
+    return size_;
 }
 
 ostream& operator<<(std::ostream& os, const ChordTpl& tpl)
@@ -326,8 +341,8 @@ ostream& operator<<(std::ostream& os, const ChordTpl& tpl)
         os << "/" << tpl.bass_note_;
 #endif /* CFG_HARTE_SYNTAX */
     }
-    for (auto &v : tpl.tpl_) {
-        os << "," << v;
+    for (size_t i = 0; i < tpl.size_; i++) {
+        os << "," << tpl.tpl_[i];
     }
 
     return os;
@@ -27,8 +27,6 @@
 #include <vector>
 
 #include "chord_tpl_collection.h"
-#include "chord_tpls_hmm.h"
-#include "config.h"
 #include "lmtypes.h"
 
 
@@ -36,78 +34,96 @@ using namespace std;
 
 namespace anatomist {
 
-ChordTplCollection::ChordTplCollection()
+/**
+ * Number of theoretical templates for qualities from \p q up, N included
+ */
+static constexpr size_t TheoreticalCnt(int q = cq_Min)
 {
-    InitChordTpls_();
+    return (q > cq_Max) ? 1 :
+           notes_Total * ChordTpl::SlashSubtypesCnt(static_cast<chord_quality_t>(q)) +
+           TheoreticalCnt(q + 1);
 }
 
-ChordTplCollection::~ChordTplCollection()
-{
-    ClearChordTpls_();
-}
+/**
+ * Theoretical templates are the same for every collection, so all of them
+ * share a single instance. Values of all templates follow each other in one
+ * table, which is never written after construction.
+ */
+struct TheoreticalBank {
+    alignas(64) amplitude_t     values[TheoreticalCnt() * CHORD_TPL_SIZE];
+    std::vector<chord_tpl_t>    tpls;
+
+    TheoreticalBank();
+};
 
-void ChordTplCollection::ClearChordTpls_()
+TheoreticalBank::TheoreticalBank()
 {
-    for (auto tpl : tpls_) {
-        delete tpl;
+    amplitude_t *v = values;
+
+    tpls.reserve(TheoreticalCnt());
+
+    for (int n = note_Min; n <= note_Max; n++) {
+        note_t note = (note_t)n;
+
+        for (int q = cq_Min; q <= cq_Max; q++) {
+            chord_quality_t cq = (chord_quality_t)q;
+            size_t subtypes = ChordTpl::SlashSubtypesCnt(cq);
+            for (uint8_t s = 0; s < subtypes; s++) {
+                tpls.push_back(ChordTpl(note, cq, s, v));
+                v += CHORD_TPL_SIZE;
+            }
+        }
     }
+
+    tpls.push_back(ChordTpl(note_Unknown, cq_unknown, 0, v));
 }
 
-void ChordTplCollection::InitChordTpls_()
+ChordTplCollection::ChordTplCollection() :
+        tpls_(nullptr)
 {
-#if (!defined(CHORD_TPLS_HMM_TRAINED) || CHORD_TPLS_HMM_TRAINED == 0) && CFG_USE_HMM_TPLS == 1
-#error "Can't use HMM templates because of missing training results"
-#elif defined(CHORD_TPLS_HMM_TRAINED) && CHORD_TPLS_HMM_TRAINED == 1 && CFG_USE_HMM_TPLS == 1
-    InitFromHmm_();
-#else
     InitTheoretical_();
-#endif
 }
 
-void ChordTplCollection::InitFromHmm_()
+ChordTplCollection::ChordTplCollection(const ChordModel &model) :
+        tpls_(nullptr)
 {
-    for (int n = note_Min; n <= note_Max; n++) {
-        note_t note = (note_t)n;
+    InitFromHmm_(model);
+}
 
-        for (int q = cq_Min; q <= cq_Max; q++) {
-            chord_quality_t cq = (chord_quality_t)q;
+void ChordTplCollection::InitFromHmm_(const ChordModel &model)
+{
+    /* templates keep pointers to the values, so those are never resized */
+    hmm_values_ = model.Templates();
 
-            chord_tpl_t *tpl = new ChordTpl(note, cq, hmm_training_res[note][cq]);
-            tpls_.push_back(tpl);
-        }
+    for (size_t s = 0; s < model.Size(); s++) {
+        const chord_t &chord = model.States()[s];
+
+        own_tpls_.push_back(ChordTpl(chord.rootNote(), chord.quality(), hmm_values_[s]));
     }
+
+    tpls_ = &own_tpls_;
 }
 
 void ChordTplCollection::InitTheoretical_()
 {
-    for (int n = note_Min; n <= note_Max; n++) {
-        note_t note = (note_t)n;
-
-        for (int q = cq_Min; q <= cq_Max; q++) {
-            chord_quality_t cq = (chord_quality_t)q;
-            size_t subtypes = ChordTpl::SlashSubtypesCnt(cq);
-            for (uint8_t s = 0; s < subtypes; s++) {
-                chord_tpl_t *tpl = new ChordTpl(note, cq, s);
-                tpls_.push_back(tpl);
-            }
-        }
-    }
+    /* generated once, the first time a collection is created */
+    static const TheoreticalBank bank;
 
-    tpls_.push_back(new ChordTpl(note_Unknown, cq_unknown, 0));
+    tpls_ = &bank.tpls;
 }
 
 size_t ChordTplCollection::Size()
 {
-    return tpls_.size();
+    return tpls_->size();
 }
 
-chord_tpl_t * ChordTplCollection::GetTpl(uint32_t idx)
+const chord_tpl_t * ChordTplCollection::GetTpl(uint32_t idx)
 {
-    if (idx >= tpls_.size()) {
+    if (idx >= tpls_->size()) {
         throw invalid_argument("ChordTplCollection::GetTpl(): bad index");
     }
 
-    return tpls_[idx];
+    return &(*tpls_)[idx];
 }
 
 chord_t ChordTplCollection::getBestMatch(pcp_t *pcp)
@@ -117,14 +133,14 @@ chord_t ChordTplCollection::getBestMatch(pcp_t *pcp)
     chord_quality_t winningQuality = cq_maj;
     tpl_score_t score;
 
-    for (const auto tpl : tpls_) {
-        score = tpl->GetScore(pcp);
+    for (const auto &tpl : *tpls_) {
+        score = tpl.GetScore(pcp);
 
        if (score > scoreMin) { continue; }
 
        scoreMin = score;
-       winningNote = tpl->RootNote();
-       winningQuality = tpl->Quality();
+       winningNote = tpl.RootNote();
+       winningQuality = tpl.Quality();
     }
 
     return Chord(winningNote, winningQuality);
@@ -20,10 +20,13 @@
 #include <algorithm>
 #include <cmath>
 
+#include "CQKernel.h"
 #include "CQParameters.h"
 
 #include "cqt_wrapper.h"
 #include "lmhelpers.h"
+#include "lmstats.h"
+#include "lmtrace.h"
 
 namespace anatomist {
 
@@ -31,9 +34,10 @@ using namespace std;
 
 CQTWrapper::CQTWrapper(freq_hz_t f_low, freq_hz_t f_high, uint16_t bpo,
                        uint32_t sample_rate, uint16_t win_size, uint16_t hop_size) :
-            TFT(f_low, f_high, bpo, sample_rate, win_size, hop_size)
+            TFT(f_low, f_high, bpo, sample_rate, win_size, hop_size),
+            cq_params_(sample_rate, f_low, f_high, bpo)
 {
-    CQParameters p(sample_rate, f_low, f_high, bpo);
+    LM_STATS_SCOPE("tft_init");
 
     /*
      * From the paper:
@@ -41,9 +45,9 @@ CQTWrapper::CQTWrapper(freq_hz_t f_low, freq_hz_t f_high, uint16_t bpo,
      * analogously to the use of zero padding when calculating the DFT.
      * For example q = 0.5 corresponds to oversampling factor of 2.
      */
-    p.q = 0.5;
+    cq_params_.q = 0.5;
 
-    cq_spectrogram_ = new CQSpectrogram(p, CQSpectrogram::InterpolateLinear);
+    cq_spectrogram_ = new CQSpectrogram(cq_params_, CQSpectrogram::InterpolateLinear);
 
     if (!cq_spectrogram_->isValid()) {
         throw new runtime_error("Failed to construct a Q-Transform");
@@ -51,8 +55,13 @@ CQTWrapper::CQTWrapper(freq_hz_t f_low, freq_hz_t f_high, uint16_t bpo,
 
     f_min_ = cq_spectrogram_->getMinFrequency();
     f_max_ = cq_spectrogram_->getMaxFrequency();
-    interval_ = round(1.0 * win_size / cq_spectrogram_->getColumnHop())
-                * cq_spectrogram_->getColumnHop();
+
+    /* frames overlap when there is more than one hop per window */
+    uint32_t col_hop = cq_spectrogram_->getColumnHop();
+    uint32_t hop = (hop_size_ > 1) ? hop_size_ : win_size_;
+
+    win_cols_ = max(1.0, round(1.0 * win_size / col_hop));
+    interval_ = max(1.0, round(1.0 * hop / col_hop)) * col_hop;
 
 }
 
@@ -61,34 +70,74 @@ CQTWrapper::CQTWrapper(freq_hz_t f_low, freq_hz_t f_high, uint32_t sample_rate,
             CQTWrapper(f_low, f_high, BINS_PER_OCTAVE_DEFAULT, sample_rate,
                        win_size, hop_size) {}
 
+CQTWrapper::CQTWrapper(freq_hz_t f_low, freq_hz_t f_high, uint32_t sample_rate,
+                       const AnalysisConfig &config) :
+            CQTWrapper(f_low, f_high, BINS_PER_OCTAVE_DEFAULT, sample_rate,
+                       config.win_size, config.HopSize()) {}
+
 CQTWrapper::~CQTWrapper()
 {
     delete cq_spectrogram_;
 }
 
-void CQTWrapper::Process(const td_t & td, uint32_t offset)
+uint32_t CQTWrapper::Alignment()
+{
+    /*
+     * All the octaves are processed in one go per this many samples, the
+     * input has to be split at the same phase of it to get the same output
+     */
+    CQKernel kernel(cq_params_);
+    uint32_t block = kernel.getProperties().fftHop * pow(2, cq_spectrogram_->getOctaves() - 1);
+
+    return Helpers::lcm(block, interval_);
+}
+
+uint32_t CQTWrapper::Context()
+{
+    return cq_spectrogram_->getLatency() +
+           max(interval_, win_cols_ * cq_spectrogram_->getColumnHop());
+}
+
+void CQTWrapper::Reset()
 {
+    TFT::Reset();
+    /* keeps the kernel, which is what makes the transform expensive to construct */
+    cq_spectrogram_->reset();
+}
+
+void CQTWrapper::Process(const SignalView & td, uint32_t offset)
+{
+    LM_STATS_SCOPE("tft");
+    LM_STATS_FRAMES(td.size());
+
     CQBase::RealBlock output_block, output;
+    CQBase::RealSequence input;
+
+    /*
+     * Constant Q transform is streaming, feeding it window by window is the
+     * same as all at once. Every sample is fed once, frames overlap in
+     * ConvertRealBlock_().
+     */
+    size_t from = (hop_size_ > 1) ? offset : 0;
 
-    if (hop_size_ > 1) {
-        for (size_t sample = offset; sample < td.size(); sample += hop_size_) {
-            size_t len = min(static_cast<size_t>(win_size_), td.size() - sample);
-            CQBase::RealSequence input(td.begin() + sample, td.begin() + sample + len);
-            output_block = cq_spectrogram_->process(input);
+    for (size_t sample = from; sample < td.size(); sample += win_size_) {
+        size_t len = min(static_cast<size_t>(win_size_), td.size() - sample);
 
-            if (!output_block.empty()) {
-                output.insert(output.end(), output_block.begin(), output_block.end());
-                output_block.clear();
-            }
+        input.resize(len);
+        td.Read(sample, len, input.data());
+        output_block = cq_spectrogram_->process(input);
+
+        if (!output_block.empty()) {
+            output.insert(output.end(), make_move_iterator(output_block.begin()),
+                          make_move_iterator(output_block.end()));
+            output_block.clear();
         }
-    } else {
-        output_block = cq_spectrogram_->process(td);
-        output.insert(output.end(), output_block.begin(), output_block.end());
     }
 
     output_block = cq_spectrogram_->getRemainingOutput();
-    output.insert(output.end(), output_block.begin(), output_block.end());
-    LM_PEEP(CQTProcess_OUTPUT, output);
+    output.insert(output.end(), make_move_iterator(output_block.begin()),
+                  make_move_iterator(output_block.end()));
+    LM_TRACE(cqt_output, output);
     output.erase(output.begin(), output.begin() + cq_spectrogram_->getLatency() /
                                                   cq_spectrogram_->getColumnHop());
 
@@ -96,39 +145,59 @@ void CQTWrapper::Process(const td_t & td, uint32_t offset)
         reverse(col.begin(), col.end());
     }
 
-    spectrogram_ = ConvertRealBlock_(output);
+    /* overlapping frames would otherwise go on far into the latency tail */
+    size_t frames = SIZE_MAX;
+
+    if (win_cols_ * cq_spectrogram_->getColumnHop() > interval_) {
+        frames = (td.size() - min(from, td.size()) + interval_ - 1) / interval_;
+    }
+
+    spectrogram_ = ConvertRealBlock_(output, frames);
 }
 
-log_spectrogram_t CQTWrapper::ConvertRealBlock_(CQBase::RealBlock &block)
+log_spectrogram_t CQTWrapper::ConvertRealBlock_(CQBase::RealBlock &block, size_t frames)
 {
     if (block.empty()) {
         throw invalid_argument("Empty input block");
     }
 
     log_spectrogram_t lsg;
-    uint32_t cols_per_window = interval_ / cq_spectrogram_->getColumnHop();
+    uint32_t cols_per_hop = interval_ / cq_spectrogram_->getColumnHop();
 
-    if (cols_per_window <= 1) {
+    if (win_cols_ <= 1) {
         return block;
     }
 
-    for (uint32_t i = 0; i < block.size(); i += cols_per_window) {
-        uint32_t columns = min(cols_per_window, static_cast<uint32_t>(block.size()) - i);
-        vector<amplitude_t> col;
+    lsg.reserve(min(frames, (block.size() + cols_per_hop - 1) / cols_per_hop));
+
+    /*
+     * Kernels span many input windows, so the transform itself has to see
+     * every sample. Only summing and denoising of skipped frames is saved.
+     *
+     * Frames are summed into their first column, which is then moved to
+     * the spectrogram. Frames only overlap the ones after them, so no
+     * column is needed once it was summed into.
+     */
+    for (uint32_t i = 0; (i < block.size()) && (lsg.size() < frames); i += cols_per_hop) {
+        uint32_t columns = min(win_cols_, static_cast<uint32_t>(block.size()) - i);
+        vector<amplitude_t> &col = block[i];
+
+        if (Skip_(lsg.size())) {
+            lsg.push_back(vector<amplitude_t>());
+            continue;
+        }
 
-        for (uint32_t j = 0; j < block[i].size(); j++) {
-            amplitude_t row_value = 0;
-            for (uint32_t c = 0; c < columns; c++) {
-                row_value += block[i + c][j];
+        for (uint32_t c = 1; c < columns; c++) {
+            for (uint32_t j = 0; j < col.size(); j++) {
+                col[j] += block[i + c][j];
             }
-            col.push_back(row_value);
         }
 
-        lsg.push_back(col);
+        lsg.push_back(move(col));
     }
-    LM_PEEP(CQT_lsg, lsg);
+    LM_TRACE(cqt_spectrogram, lsg);
     Denoise_(lsg);
-    LM_PEEP(CQT_lsg_denoised, lsg);
+    LM_TRACE(cqt_spectrogram_denoised, lsg);
     return lsg;
 }
 
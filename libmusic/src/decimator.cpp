@@ -0,0 +1,147 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    decimator.cpp
+ * @brief   Implementation of the decimating front end
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "dsp/Resampler.h"
+
+#include "config.h"
+#include "decimator.h"
+#include "lmstats.h"
+
+/**
+ * Anti-aliasing filter parameters, same as used by the "better"
+ * decimator of the constant Q transform
+ */
+#define DECIMATOR_SNR_DB        50
+#define DECIMATOR_BANDWIDTH     0.05
+
+/**
+ * Non-contiguous input is converted and fed to the resampler by this many samples
+ */
+#define DECIMATOR_CHUNK_SIZE    ((size_t)4096)
+
+using namespace std;
+
+namespace anatomist {
+
+Decimator::Decimator(uint32_t samplerate, uint32_t factor) :
+        samplerate_(samplerate),
+        factor_(factor)
+{
+    if ((samplerate == 0) || (factor == 0) || (samplerate % factor)) {
+        throw invalid_argument("Decimator(): invalid argument");
+    }
+
+    /* Resampler only cares about the ratio between the rates */
+    resampler_ = new Resampler(factor_, 1, DECIMATOR_SNR_DB, DECIMATOR_BANDWIDTH);
+}
+
+Decimator::~Decimator()
+{
+    delete resampler_;
+}
+
+uint32_t Decimator::SafeFactor(uint32_t samplerate, freq_hz_t f_max)
+{
+    uint32_t factor = 1;
+
+    while ((factor * 2 <= CFG_DECIMATION_FACTOR_MAX) &&
+           (samplerate % (factor * 2) == 0) &&
+           (samplerate / (factor * 2) * (1 - DECIMATOR_BANDWIDTH) / 2 >=
+            f_max * CFG_DECIMATION_MARGIN))
+    {
+        factor *= 2;
+    }
+
+    return factor;
+}
+
+td_t Decimator::Process(const amplitude_t *td, uint32_t samples)
+{
+    return Process(SignalView(td, samples));
+}
+
+td_t Decimator::Process(const SignalView &td)
+{
+    LM_STATS_SCOPE("decimation");
+    LM_STATS_FRAMES(td.size());
+
+    size_t samples = td.size();
+
+    if (factor_ == 1) {
+        td_t out(samples);
+        td.Read(0, samples, out.data());
+        return out;
+    }
+
+    int latency = resampler_->getLatency();
+    int out_len = ceil(1.0 * samples / factor_);
+    td_t pad(latency * factor_ + factor_, 0);
+    td_t out(out_len + latency + 2, 0);
+    int got = 0;
+
+    /* resampler keeps its state between calls, feed it chunk by chunk */
+    if (td.Contiguous() != nullptr) {
+        got = resampler_->process(td.Contiguous(), out.data(), samples);
+    } else {
+        td_t chunk(DECIMATOR_CHUNK_SIZE);
+
+        for (size_t pos = 0; pos < samples; pos += chunk.size()) {
+            size_t len = min(chunk.size(), samples - pos);
+
+            td.Read(pos, len, chunk.data());
+            got += resampler_->process(chunk.data(), out.data() + got, len);
+        }
+    }
+    got += resampler_->process(pad.data(), out.data() + got, pad.size());
+
+    if (got < latency + out_len) {
+        throw runtime_error("Decimator::Process(): not enough output");
+    }
+
+    out.erase(out.begin(), out.begin() + latency);
+    out.resize(out_len);
+
+    return out;
+}
+
+uint32_t Decimator::Factor()
+{
+    return factor_;
+}
+
+uint32_t Decimator::Latency()
+{
+    return (factor_ == 1) ? 0 : resampler_->getLatency() * factor_;
+}
+
+uint32_t Decimator::OutputSampleRate()
+{
+    return samplerate_ / factor_;
+}
+
+}
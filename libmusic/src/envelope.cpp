@@ -31,6 +31,7 @@
 #include "cheby1_filter.h"
 #include "config.h"
 #include "envelope.h"
+#include "lmstats.h"
 #include "ma_filter.h"
 
 
@@ -38,6 +39,9 @@ using namespace std;
 
 Envelope::Envelope(const amplitude_t *td, uint32_t samples)
 {
+    LM_STATS_SCOPE("envelope");
+    LM_STATS_FRAMES(samples);
+
     Filter *f_ma = new MAFilter();
     Filter *f_bw = new ButterworthFilter();
     amplitude_t *tdCopy = (amplitude_t *) malloc(samples * sizeof(amplitude_t));
@@ -130,13 +134,18 @@ bool Envelope::isSilence(uint32_t startIdx, uint32_t endIdx)
         }
     }
 
-    return silentSamples / (end - start + 1) > 1;
+    return silentSamples == (end - start + 1);
+}
+
+const vector<amplitude_t> & Envelope::getValues() const
+{
+    return __mEnvelope;
 }
 
 ostream& operator<<(ostream& os, const Envelope& e)
 {
     for(uint32_t i = 0; i < e.__mEnvelope.size(); i++) {
-        os << i << "," << e.__mEnvelope[i] << endl;
+        os << i << "," << e.__mEnvelope[i] << "\n";
     }
 
     return os;
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    feature_cache.cpp
+ * @brief   Implementation of the persistent chromagram cache
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "feature_cache.h"
+#include "lmstats.h"
+
+/** Has to be bumped whenever file layout changes */
+#define CACHE_VERSION       1
+#define CACHE_MAGIC         "LMFC"
+#define CACHE_FILE_EXT      ".lmfc"
+
+#define FNV_OFFSET_BASIS    0xcbf29ce484222325ULL
+#define FNV_PRIME           0x100000001b3ULL
+
+/** Samples are converted for hashing by this many if they are not doubles already */
+#define KEY_CHUNK_SIZE      4096
+
+using namespace std;
+
+namespace anatomist {
+
+typedef struct {
+    char        magic[4];
+    uint32_t    version;
+    uint64_t    key;
+    uint32_t    frames;
+    uint32_t    cols;
+    uint32_t    interval;
+    uint32_t    reserved;
+} cache_header_t;
+
+/**
+ * FNV-1a, applied to 64-bit words rather than bytes to keep hashing of
+ * hour long inputs cheap compared to the analysis
+ */
+static uint64_t Fnv1a(uint64_t hash, const void *data, size_t len)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    uint64_t word;
+
+    for (; len >= sizeof(word); len -= sizeof(word), p += sizeof(word)) {
+        memcpy(&word, p, sizeof(word));
+        hash = (hash ^ word) * FNV_PRIME;
+    }
+
+    for (; len > 0; len--, p++) {
+        hash = (hash ^ *p) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
+FeatureCache::FeatureCache(const string &dir) :
+        dir_(dir)
+{
+    if (dir.empty()) {
+        throw invalid_argument("FeatureCache(): empty directory");
+    }
+}
+
+string FeatureCache::Path_(uint64_t key)
+{
+    char name[2 * sizeof(key) + 1];
+
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+
+    return dir_ + "/" + name + CACHE_FILE_EXT;
+}
+
+uint64_t FeatureCache::Key(const SignalView &td, uint32_t samplerate, const string &params)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    uint64_t samples = td.size();
+    uint32_t version = CACHE_VERSION;
+
+    hash = Fnv1a(hash, &version, sizeof(version));
+    hash = Fnv1a(hash, &samplerate, sizeof(samplerate));
+    hash = Fnv1a(hash, &samples, sizeof(samples));
+    hash = Fnv1a(hash, params.data(), params.size());
+
+    /* samples are hashed as doubles whatever the input layout is */
+    if (td.Contiguous() != nullptr) {
+        hash = Fnv1a(hash, td.Contiguous(), samples * sizeof(amplitude_t));
+    } else {
+        td_t chunk(KEY_CHUNK_SIZE);
+
+        for (size_t pos = 0; pos < samples; pos += chunk.size()) {
+            size_t len = min<size_t>(chunk.size(), samples - pos);
+
+            td.Read(pos, len, chunk.data());
+            hash = Fnv1a(hash, chunk.data(), len * sizeof(amplitude_t));
+        }
+    }
+
+    return hash;
+}
+
+bool FeatureCache::Load(uint64_t key, chromagram_t *chromagram, uint32_t *interval)
+{
+    LM_STATS_SCOPE("cache_load");
+
+    int fd = open(Path_(key).c_str(), O_RDONLY);
+    struct stat st;
+    void *addr;
+    bool found = false;
+
+    if (fd < 0) {
+        return false;
+    }
+
+    if ((fstat(fd, &st) != 0) || (static_cast<size_t>(st.st_size) < sizeof(cache_header_t))) {
+        close(fd);
+        return false;
+    }
+
+    addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+
+    const cache_header_t *hdr = static_cast<const cache_header_t *>(addr);
+    const amplitude_t *data = reinterpret_cast<const amplitude_t *>(hdr + 1);
+
+    if ((memcmp(hdr->magic, CACHE_MAGIC, sizeof(hdr->magic)) == 0) &&
+        (hdr->version == CACHE_VERSION) && (hdr->key == key) &&
+        (static_cast<size_t>(st.st_size) ==
+         sizeof(*hdr) + sizeof(amplitude_t) * hdr->frames * hdr->cols))
+    {
+        vector<amplitude_t> values(hdr->cols);
+
+        chromagram->clear();
+        chromagram->reserve(hdr->frames);
+
+        for (uint32_t f = 0; f < hdr->frames; f++) {
+            for (uint32_t c = 0; c < hdr->cols; c++) {
+                values[c] = data[static_cast<size_t>(c) * hdr->frames + f];
+            }
+            chromagram->push_back(PitchClsProfile(values));
+        }
+
+        *interval = hdr->interval;
+        found = true;
+
+        LM_STATS_FRAMES(hdr->frames);
+    }
+
+    munmap(addr, st.st_size);
+
+    return found;
+}
+
+void FeatureCache::Store(uint64_t key, const chromagram_t &chromagram, uint32_t interval)
+{
+    LM_STATS_SCOPE("cache_store");
+    LM_STATS_FRAMES(chromagram.size());
+
+    cache_header_t hdr;
+    string path = Path_(key);
+    uint32_t cols = chromagram.empty() ? 0 : chromagram[0].getValues().size();
+    vector<amplitude_t> data(static_cast<size_t>(cols) * chromagram.size());
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CACHE_MAGIC, sizeof(hdr.magic));
+    hdr.version = CACHE_VERSION;
+    hdr.key = key;
+    hdr.frames = chromagram.size();
+    hdr.cols = cols;
+    hdr.interval = interval;
+
+    for (uint32_t f = 0; f < chromagram.size(); f++) {
+        const vector<amplitude_t> &values = chromagram[f].getValues();
+
+        if (values.size() != cols) {
+            throw invalid_argument("FeatureCache::Store(): profiles of different size");
+        }
+        for (uint32_t c = 0; c < cols; c++) {
+            data[static_cast<size_t>(c) * hdr.frames + f] = values[c];
+        }
+    }
+
+    /*
+     * Writers of the same key, be it other processes or other threads of
+     * this one, each get a file of their own. Whoever renames it last wins,
+     * the contents are the same anyway.
+     */
+    vector<char> tmp_path(path.begin(), path.end());
+    const char tmp_suffix[] = ".tmp.XXXXXX";
+
+    tmp_path.insert(tmp_path.end(), tmp_suffix, tmp_suffix + sizeof(tmp_suffix));
+
+    int fd = mkstemp(tmp_path.data());
+    FILE *file = (fd < 0) ? nullptr : fdopen(fd, "wb");
+
+    if (file == nullptr) {
+        if (fd >= 0) {
+            close(fd);
+            remove(tmp_path.data());
+        }
+        throw runtime_error("FeatureCache::Store(): failed to create a file for " + path);
+    }
+
+    /* mkstemp() makes it private to the user, the cache is shared */
+    fchmod(fd, 0644);
+
+    bool ok = (fwrite(&hdr, sizeof(hdr), 1, file) == 1) &&
+              (fwrite(data.data(), sizeof(data[0]), data.size(), file) == data.size());
+
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok || (rename(tmp_path.data(), path.c_str()) != 0)) {
+        remove(tmp_path.data());
+        throw runtime_error("FeatureCache::Store(): failed to write " + path);
+    }
+}
+
+}
@@ -36,7 +36,7 @@ using namespace std;
 namespace anatomist {
 
 FFT::FFT(amplitude_t *td, uint32_t td_len, uint32_t samplerate, freq_hz_t f_low,
-        freq_hz_t f_high, bool polar, bool hps)
+        freq_hz_t f_high, bool polar, uint32_t hps_harmonics)
 {
     constexpr size_t avg_win = CFG_FFT_AVG_WINDOW;
 
@@ -71,22 +71,19 @@ FFT::FFT(amplitude_t *td, uint32_t td_len, uint32_t samplerate, freq_hz_t f_low,
     if (avg_win > 1)
         Avg_(fd_.p, fd_len_, avg_win);
 
-#if (defined(CFG_FFT_HPS_HARMONICS) && (CFG_FFT_HPS_HARMONICS > 1))
-    if (hps) {
-        ToHPS_(fd_.p, fd_len_);
+    if (hps_harmonics > 1) {
+        ToHPS_(fd_.p, fd_len_, hps_harmonics);
     }
-#else
-    UNUSED(hps);
-#endif
 
 }
 
 FFT::FFT(amplitude_t *td, uint32_t td_len, uint32_t samplerate, bool polar) :
-        FFT(td, td_len, samplerate, 0, samplerate / 2, polar, false) {}
+        FFT(td, td_len, samplerate, 0, samplerate / 2, polar, 1) {}
 
-FFT::FFT(td_t td, uint32_t samplerate, freq_hz_t f_low, freq_hz_t f_high) :
+FFT::FFT(td_t td, uint32_t samplerate, freq_hz_t f_low, freq_hz_t f_high,
+         uint32_t hps_harmonics) :
      FFT(td.data(), static_cast<uint32_t>(td.size()), samplerate, f_low,
-         f_high, true, false) {}
+         f_high, true, hps_harmonics) {}
 
 FFT::FFT()
 {
@@ -271,13 +268,13 @@ void FFT::ToPolar_(vector<complex_t> &input)
     ToPolar_(input, nullptr, nullptr, input.size(), 0);
 }
 
-void FFT::ToHPS_(amplitude_t *fd_magnitudes, uint32_t fd_len)
+void FFT::ToHPS_(amplitude_t *fd_magnitudes, uint32_t fd_len, uint32_t harmonics)
 {
     if (!polar_) {
         throw runtime_error("ToHPS_(): only implemented for polar notation");
     }
 
-    for (uint8_t m = 1; m < CFG_FFT_HPS_HARMONICS; m++) {
+    for (uint8_t m = 1; m < harmonics; m++) {
         for (uint32_t i = 0; i < fd_len / pow(2, m); i++) {
             fd_magnitudes[i] *= fd_magnitudes[i * (uint32_t)pow(2, m)];
         }
@@ -23,9 +23,12 @@
  *  FFTWrapper class implementation
  */
 
+#include "config.h"
 #include "fft.h"
 #include "fft_wrapper.h"
 #include "lmhelpers.h"
+#include "lmstats.h"
+#include "lmtrace.h"
 #include "pitch_calculator.h"
 #include "window_functions.h"
 
@@ -36,9 +39,13 @@ namespace anatomist {
 
 FFTWrapper::FFTWrapper(freq_hz_t f_low, freq_hz_t f_high, uint16_t bpo,
                        uint32_t sample_rate, uint16_t win_size, uint16_t hop_size) :
-            TFT(f_low, f_high, bpo, sample_rate, win_size, hop_size)
+            TFT(f_low, f_high, bpo, sample_rate, win_size, hop_size),
+            window_func_(CFG_WINDOW_FUNC),
+            hps_harmonics_(1)
 {
     f_min_ = pc_.getPitch(f_low);
+    /* a frame per hop, same as GoertzelBank */
+    interval_ = hop_size_;
 }
 
 FFTWrapper::FFTWrapper(freq_hz_t f_low, freq_hz_t f_high, uint32_t sample_rate,
@@ -46,23 +53,45 @@ FFTWrapper::FFTWrapper(freq_hz_t f_low, freq_hz_t f_high, uint32_t sample_rate,
             FFTWrapper(f_low, f_high, BINS_PER_OCTAVE_DEFAULT, sample_rate,
                        win_size, hop_size) {}
 
-void FFTWrapper::Process(const td_t & td, uint32_t offset)
+FFTWrapper::FFTWrapper(freq_hz_t f_low, freq_hz_t f_high, uint32_t sample_rate,
+                       const AnalysisConfig &config) :
+            FFTWrapper(f_low, f_high, BINS_PER_OCTAVE_DEFAULT, sample_rate,
+                       config.win_size, config.HopSize())
+{
+    window_func_ = config.window_func;
+    hps_harmonics_ = config.hps_harmonics;
+}
+
+void FFTWrapper::Process(const SignalView & td, uint32_t offset)
 {
+    LM_STATS_SCOPE("tft");
+    LM_STATS_FRAMES(td.size());
+
+    td_t td_win;
+
     for (uint32_t sample_idx = offset; sample_idx < td.size(); sample_idx += hop_size_) {
         size_t len = min(static_cast<size_t>(win_size_), td.size() - sample_idx);
-        td_t td_win(td.begin() + sample_idx, td.begin() + sample_idx + len);
         FFT *fft;
 
-        WindowFunctions::applyDefault(td_win);
+        if (Skip_(spectrogram_.size())) {
+            spectrogram_.push_back(fd_t());
+            continue;
+        }
+
+        td_win.resize(len);
+        td.Read(sample_idx, len, td_win.data());
+        WindowFunctions::apply(td_win, window_func_);
 
-        fft = new FFT(td_win, sample_rate_, f_min_, f_max_);
+        fft = new FFT(td_win.data(), len, sample_rate_, f_min_, f_max_, true, hps_harmonics_);
 
         spectrogram_.push_back(FFTPruned(fft));
 
         delete fft;
     }
 
+    LM_TRACE(fft_spectrogram, spectrogram_);
     Denoise_(spectrogram_);
+    LM_TRACE(fft_spectrogram_denoised, spectrogram_);
 }
 
 fd_t FFTWrapper::FFTPruned(FFT *fft)
@@ -0,0 +1,245 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    goertzel_bank.cpp
+ * @brief   Implementation of the pitch frequencies filterbank
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "goertzel_bank.h"
+#include "lmstats.h"
+#include "lmtrace.h"
+
+/**
+ * Sliding DFT costs 3 complex multiplications per bin per sample while
+ * Goertzel costs a real one per bin per sample of every window, so sliding
+ * pays off once windows overlap more than this many times
+ */
+#define SLIDING_HOPS_PER_WINDOW_MIN     8
+
+using namespace std;
+
+namespace anatomist {
+
+GoertzelBank::GoertzelBank(freq_hz_t f_low, freq_hz_t f_high, uint16_t bpo,
+                           uint32_t sample_rate, uint16_t win_size, uint16_t hop_size,
+                           mode_t mode) :
+            TFT(f_low, f_high, bpo, sample_rate, win_size, hop_size),
+            mode_(mode)
+{
+    if ((win_size == 0) || (hop_size == 0) || (bpo < notes_Total) ||
+        (f_high >= sample_rate / 2.0))
+    {
+        throw invalid_argument("GoertzelBank(): invalid argument");
+    }
+
+    f_min_ = pc_.getPitch(f_low);
+    interval_ = hop_size_;
+
+    if (mode_ == MODE_AUTO) {
+        mode_ = (hop_size_ * SLIDING_HOPS_PER_WINDOW_MIN <= win_size_) ?
+                MODE_SLIDING : MODE_GOERTZEL;
+    }
+
+    for (uint32_t bin = 0; BinToFreq(bin) < f_max_; bin++) {
+        omega_.push_back(2 * M_PI * BinToFreq(bin) / sample_rate_);
+    }
+
+    /* periodic Hann, see ProcessSliding_() */
+    window_.resize(win_size_);
+    for (uint32_t i = 0; i < win_size_; i++) {
+        window_[i] = 0.5 - 0.5 * cos(2 * M_PI * i / win_size_);
+    }
+}
+
+GoertzelBank::GoertzelBank(freq_hz_t f_low, freq_hz_t f_high, uint32_t sample_rate,
+                           uint16_t win_size, uint16_t hop_size) :
+            GoertzelBank(f_low, f_high, BINS_PER_OCTAVE_DEFAULT, sample_rate,
+                         win_size, hop_size) {}
+
+GoertzelBank::GoertzelBank(freq_hz_t f_low, freq_hz_t f_high, uint32_t sample_rate,
+                           const AnalysisConfig &config) :
+            GoertzelBank(f_low, f_high, BINS_PER_OCTAVE_DEFAULT, sample_rate,
+                         config.win_size, config.HopSize()) {}
+
+void GoertzelBank::Process(const SignalView & td, uint32_t offset)
+{
+    LM_STATS_SCOPE("tft");
+    LM_STATS_FRAMES(td.size());
+
+    if (mode_ == MODE_SLIDING) {
+        ProcessSliding_(td, offset);
+    } else {
+        ProcessGoertzel_(td, offset);
+    }
+
+    LM_TRACE(goertzel_spectrogram, spectrogram_);
+    Denoise_(spectrogram_);
+    LM_TRACE(goertzel_spectrogram_denoised, spectrogram_);
+}
+
+void GoertzelBank::ProcessGoertzel_(const SignalView &td, uint32_t offset)
+{
+    vector<amplitude_t> frame(win_size_);
+    vector<amplitude_t> coeff(omega_.size());
+    vector<amplitude_t> s1(omega_.size()), s2(omega_.size());
+
+    for (uint32_t bin = 0; bin < omega_.size(); bin++) {
+        coeff[bin] = 2 * cos(omega_[bin]);
+    }
+
+    for (uint32_t start = offset; start < td.size(); start += hop_size_) {
+        uint32_t len = min<size_t>(win_size_, td.size() - start);
+
+        if (Skip_(spectrogram_.size())) {
+            spectrogram_.push_back(fd_t());
+            continue;
+        }
+
+        fd_t col(omega_.size());
+
+        td.Read(start, len, frame.data());
+        fill(s1.begin(), s1.end(), 0);
+        fill(s2.begin(), s2.end(), 0);
+
+        /*
+         * All the filters are advanced together sample by sample, bins are
+         * independent so the inner loop vectorizes. The rest of a partial
+         * window is zero and does not contribute.
+         */
+        for (uint32_t i = 0; i < len; i++) {
+            amplitude_t x = frame[i] * window_[i];
+
+            for (uint32_t bin = 0; bin < omega_.size(); bin++) {
+                amplitude_t s0 = x + coeff[bin] * s1[bin] - s2[bin];
+                s2[bin] = s1[bin];
+                s1[bin] = s0;
+            }
+        }
+
+        for (uint32_t bin = 0; bin < omega_.size(); bin++) {
+            col[bin] = sqrt(max(0.0, s1[bin] * s1[bin] + s2[bin] * s2[bin] -
+                                     coeff[bin] * s1[bin] * s2[bin]));
+        }
+
+        spectrogram_.push_back(col);
+    }
+}
+
+/**
+ * Sliding DFT over the last win_size_ samples at any angular frequency w:
+ *
+ *   S(n) = e^(jw) * (S(n-1) - x(n-N)) + x(n) * e^(-jw(N-1))
+ *
+ * Hann windowed value is a combination of three neighbours one DFT bin
+ * apart: 0.5 * S_w - 0.25 * (S_w-d + S_w+d), d = 2pi/N.
+ */
+void GoertzelBank::ProcessSliding_(const SignalView &td, uint32_t offset)
+{
+    const uint32_t n_win = win_size_;
+    const uint32_t taps = omega_.size() * 3;
+    vector<amplitude_t> rot_re(taps), rot_im(taps), last_re(taps), last_im(taps);
+    vector<amplitude_t> s_re(taps, 0), s_im(taps, 0);
+    amplitude_t d = 2 * M_PI / n_win;
+
+    if (offset >= td.size()) {
+        return;
+    }
+
+    for (uint32_t bin = 0; bin < omega_.size(); bin++) {
+        for (uint32_t k = 0; k < 3; k++) {
+            amplitude_t w = omega_[bin] + (static_cast<int32_t>(k) - 1) * d;
+            uint32_t t = bin * 3 + k;
+
+            rot_re[t] = cos(w);
+            rot_im[t] = sin(w);
+            last_re[t] = cos(w * (n_win - 1));
+            last_im[t] = -sin(w * (n_win - 1));
+        }
+    }
+
+    uint32_t frames = (td.size() - offset + hop_size_ - 1) / hop_size_;
+    uint64_t end = offset + static_cast<uint64_t>(frames - 1) * hop_size_ + n_win;
+
+    for (uint64_t n = offset; n < end; n++) {
+        amplitude_t x_in = (n < td.size()) ? td[n] : 0;
+        amplitude_t x_out = ((n >= offset + n_win) && (n - n_win < td.size())) ? td[n - n_win] : 0;
+
+        for (uint32_t t = 0; t < taps; t++) {
+            amplitude_t re = s_re[t] - x_out, im = s_im[t];
+
+            s_re[t] = re * rot_re[t] - im * rot_im[t] + x_in * last_re[t];
+            s_im[t] = re * rot_im[t] + im * rot_re[t] + x_in * last_im[t];
+        }
+
+        uint64_t filled = n - offset + 1;
+        if ((filled < n_win) || ((filled - n_win) % hop_size_ != 0)) {
+            continue;
+        }
+
+        /* the recursion needs every sample, only the output can be skipped */
+        if (Skip_(spectrogram_.size())) {
+            spectrogram_.push_back(fd_t());
+            continue;
+        }
+
+        fd_t col(omega_.size());
+
+        for (uint32_t bin = 0; bin < omega_.size(); bin++) {
+            uint32_t t = bin * 3;
+            amplitude_t re = 0.5 * s_re[t + 1] - 0.25 * (s_re[t] + s_re[t + 2]);
+            amplitude_t im = 0.5 * s_im[t + 1] - 0.25 * (s_im[t] + s_im[t + 2]);
+
+            col[bin] = sqrt(re * re + im * im);
+        }
+
+        spectrogram_.push_back(col);
+    }
+}
+
+uint8_t GoertzelBank::BinsPerSemitone()
+{
+    return bpo_ / notes_Total;
+}
+
+uint32_t GoertzelBank::FreqToBin(freq_hz_t f)
+{
+    if ((f < f_min_) || (f > f_max_))
+    {
+        throw invalid_argument("GoertzelBank::FreqToBin(): f is out of range");
+    }
+
+    return round(static_cast<double>(log2(f / f_min_) * bpo_));
+}
+
+freq_hz_t GoertzelBank::BinToFreq(uint32_t idx)
+{
+    return f_min_ * pow(2, (1.0 * idx / bpo_));
+}
+
+GoertzelBank::mode_t GoertzelBank::Mode()
+{
+    return mode_;
+}
+
+}
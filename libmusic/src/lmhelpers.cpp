@@ -34,6 +34,19 @@ uint32_t Helpers::nextPowerOf2(uint32_t n)
 	return 1 << ((sizeof(uint32_t) * 8) - __builtin_clz(n - 1));
 }
 
+uint32_t Helpers::lcm(uint32_t a, uint32_t b)
+{
+    uint32_t x = a, y = b;
+
+    while (y != 0) {
+        uint32_t t = x % y;
+        x = y;
+        y = t;
+    }
+
+    return a / x * b;
+}
+
 vector<complex_t> Helpers::timeDomain2ComplexVector(amplitude_t *timeDomain,
                                 uint32_t timeDomainSize, uint32_t resultSize)
 {
@@ -54,7 +67,7 @@ vector<complex_t> Helpers::timeDomain2ComplexVector(amplitude_t *timeDomain,
 
 bool Helpers::isPowerOf2(uint32_t n)
 {
-    return ((n & (n - 1)) != 0);
+    return (n != 0) && ((n & (n - 1)) == 0);
 }
 
 bool Helpers::almostEqual(double a, double b, double eps)
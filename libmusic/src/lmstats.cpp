@@ -0,0 +1,147 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    lmstats.cpp
+ * @brief   Implementation of per-stage statistics
+ */
+
+#include <cstdlib>
+#include <new>
+
+#include "lmstats.h"
+
+using namespace std;
+
+static thread_local anatomist::StatsCollector *current_collector = nullptr;
+static thread_local uint64_t allocated_bytes = 0;
+
+#if CFG_STATS
+
+/*
+ * Allocation accounting. Only operator new is tracked, memory obtained
+ * with malloc() directly (e.g. by kissfft) is not accounted. These are the
+ * replaceable global operators, so they serve every allocation of the
+ * process, which is why CFG_STATS is off by default.
+ */
+void * operator new(size_t size)
+{
+    void *p = malloc(size == 0 ? 1 : size);
+
+    if (p == nullptr) {
+        throw bad_alloc();
+    }
+
+    allocated_bytes += size;
+
+    return p;
+}
+
+void * operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+#endif /* CFG_STATS */
+
+namespace anatomist {
+
+StatsCollector::StatsCollector() :
+        outer_(current_collector)
+{
+    current_collector = this;
+}
+
+StatsCollector::~StatsCollector()
+{
+    current_collector = outer_;
+
+    if (outer_ != nullptr) {
+        for (auto &s : stats_) {
+            outer_->Add(s.name, s.calls, s.wall_ns, s.frames, s.bytes);
+        }
+    }
+}
+
+void StatsCollector::Add(const string &name, uint32_t calls, uint64_t wall_ns,
+                         uint64_t frames, uint64_t bytes)
+{
+    for (auto &s : stats_) {
+        if (s.name == name) {
+            s.calls += calls;
+            s.wall_ns += wall_ns;
+            s.frames += frames;
+            s.bytes += bytes;
+            return;
+        }
+    }
+
+    stats_.push_back({ name, calls, wall_ns, frames, bytes });
+}
+
+const stats_t & StatsCollector::Stats() const
+{
+    return stats_;
+}
+
+StatsCollector * StatsCollector::Current()
+{
+    return current_collector;
+}
+
+uint64_t StatsCollector::AllocatedBytes()
+{
+    return allocated_bytes;
+}
+
+StatsScope::StatsScope(const char *name) :
+        name_(name),
+        frames_(0),
+        bytes_start_(allocated_bytes),
+        start_(chrono::steady_clock::now()) {}
+
+StatsScope::~StatsScope()
+{
+    if (current_collector == nullptr) {
+        return;
+    }
+
+    uint64_t wall_ns = chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now() - start_).count();
+    uint64_t bytes = allocated_bytes - bytes_start_;
+
+    current_collector->Add(name_, 1, wall_ns, frames_, bytes);
+}
+
+void StatsScope::SetFrames(uint64_t frames)
+{
+    frames_ = frames;
+}
+
+}
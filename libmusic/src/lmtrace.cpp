@@ -0,0 +1,206 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    lmtrace.cpp
+ * @brief   Implementation of the binary dumps
+ */
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "lmtrace.h"
+
+#define NPY_MAGIC           "\x93NUMPY\x01\x00"
+#define NPY_MAGIC_LEN       8
+#define NPY_ALIGNMENT       64
+
+using namespace std;
+
+namespace anatomist {
+
+/**
+ * Owns the output directory and the background writer
+ */
+class TraceWriter {
+
+private:
+    typedef struct {
+        string          path;
+        string          header;
+        vector<char>    data;
+    } job_t;
+
+    string              dir_;
+    map<string, uint32_t> name_cnt_;
+    bool                async_ = false;
+    bool                stop_ = false;
+    deque<job_t>        jobs_;
+    mutex               mutex_;
+    condition_variable  cv_;
+    thread              thread_;
+
+    static void WriteFile_(const job_t &job)
+    {
+        ofstream os(job.path, ios::out | ios::binary | ios::trunc);
+
+        if (!os.is_open()) {
+            return;
+        }
+
+        os.write(job.header.data(), job.header.size());
+        os.write(job.data.data(), job.data.size());
+    }
+
+    void Loop_()
+    {
+        unique_lock<mutex> lock(mutex_);
+
+        for (;;) {
+            cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+
+            if (jobs_.empty()) {
+                return;
+            }
+
+            job_t job = std::move(jobs_.front());
+            jobs_.pop_front();
+
+            lock.unlock();
+            WriteFile_(job);
+            lock.lock();
+        }
+    }
+
+public:
+    ~TraceWriter()
+    {
+        Stop();
+    }
+
+    void Start(const string &dir, bool async)
+    {
+        Stop();
+
+        lock_guard<mutex> lock(mutex_);
+
+        dir_ = dir;
+        async_ = async;
+        stop_ = false;
+
+        if (async_) {
+            thread_ = thread(&TraceWriter::Loop_, this);
+        }
+    }
+
+    void Stop()
+    {
+        {
+            lock_guard<mutex> lock(mutex_);
+            stop_ = true;
+        }
+
+        cv_.notify_all();
+
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    void Add(const char *name, string &header, vector<char> &data)
+    {
+        job_t job;
+
+        job.header.swap(header);
+        job.data.swap(data);
+
+        {
+            lock_guard<mutex> lock(mutex_);
+            uint32_t cnt = name_cnt_[name]++;
+
+            job.path = dir_ + "/" + name + (cnt > 0 ? "." + to_string(cnt) : "") + ".npy";
+
+            if (async_) {
+                jobs_.push_back(std::move(job));
+                cv_.notify_one();
+                return;
+            }
+        }
+
+        WriteFile_(job);
+    }
+};
+
+static TraceWriter writer;
+
+bool Trace::enabled_ = false;
+
+void Trace::Enable(const string &dir, bool async)
+{
+    if (dir.empty()) {
+        throw invalid_argument("Trace::Enable(): empty directory");
+    }
+
+    writer.Start(dir, async);
+    enabled_ = true;
+}
+
+void Trace::Disable()
+{
+    enabled_ = false;
+    writer.Stop();
+}
+
+void Trace::Write_(const char *name, const char *descr, uint32_t rows,
+                   uint32_t cols, bool is_vector, vector<char> &data)
+{
+    ostringstream dict;
+    string header;
+
+    dict << "{'descr': '" << descr << "', 'fortran_order': False, 'shape': (";
+    if (is_vector) {
+        dict << cols << ",";
+    } else {
+        dict << rows << ", " << cols;
+    }
+    dict << "), }";
+
+    header = dict.str();
+
+    /* pad with spaces and terminate with newline to keep the data aligned */
+    size_t total = NPY_MAGIC_LEN + 2 + header.size() + 1;
+    header.append((NPY_ALIGNMENT - total % NPY_ALIGNMENT) % NPY_ALIGNMENT, ' ');
+    header.push_back('\n');
+
+    uint16_t len = header.size();
+    string prefix(NPY_MAGIC, NPY_MAGIC_LEN);
+
+    prefix.push_back(len & 0xff);
+    prefix.push_back(len >> 8);
+    header.insert(0, prefix);
+
+    writer.Add(name, header, data);
+}
+
+}
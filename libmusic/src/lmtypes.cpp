@@ -19,16 +19,23 @@
 
 #include "config.h"
 #include "lmtypes.h"
-#include "music_scale.h"
 
 using namespace std;
 
 Chord::Chord(const string &cs):
-    __mRootNote(note_Unknown), __mQuality(cq_unknown)
+    __mRootNote(note_Unknown), __mBassNote(note_Unknown), __mBassInterval(-1),
+    __mQuality(cq_unknown)
 {
     const bool is_sharp = cs.length() > 1 && cs[1] == '#';
+    const bool is_flat = cs.length() > 1 && cs[1] == 'b';
     string cn = cs.substr(0, cs.find("/"));
 
+    if (cs == "N") {
+        /* no chord in Harte syntax, what toHarte() gives for the default chord */
+        __mPCset = make_pcset(__mRootNote, __mQuality);
+        return;
+    }
+
     switch (cs[0]) {
         case 'C': __mRootNote = is_sharp ? note_C_sharp: note_C; break;
         case 'D': __mRootNote = is_sharp ? note_D_sharp: note_D; break;
@@ -40,7 +47,10 @@ Chord::Chord(const string &cs):
         default:
             throw runtime_error("can't parse " + cs);
     }
-    cn.erase(0, is_sharp ? 2 : 1);
+    if (is_flat) {
+        __mRootNote = __mRootNote - 1;
+    }
+    cn.erase(0, (is_sharp || is_flat) ? 2 : 1);
     if (cn[0] == ':')
         cn.erase(0,1);
     static const map<const string,const chord_quality_t> s2cq {
@@ -63,6 +73,7 @@ Chord::Chord(const string &cs):
         {"maj9", cq_maj9},
         {"min9", cq_min9}, {"m9", cq_min9},
         {"maj(11)", cq_maj_add11}, {"add11", cq_maj_add11},
+        {"7(#9)", cq_7_add9sharp}, {"7#9", cq_7_add9sharp},
         {"9", cq_9},
         {"aug7", cq_aug7},
         {"maj11", cq_maj11},
@@ -191,41 +202,58 @@ ostream& operator<<(ostream& os, const chord_quality_t& q)
     return os;
 }
 
-static map<chord_quality_t, const vector<pair<size_t, int>>> pctpls = {
-    {cq_maj,           {{2, 0}, {4, 0}                             }},
-    {cq_min,           {{2,-1}, {4, 0}                             }},
-    {cq_5,             {{4, 0}                                     }},
-    {cq_7,             {{2, 0}, {4, 0}, {6,-1}                     }},
-    {cq_maj7,          {{2, 0}, {4, 0}, {6, 0}                     }},
-    {cq_min7,          {{2,-1}, {4, 0}, {6,-1}                     }},
-    {cq_sus2,          {{1, 0}, {4, 0}                             }},
-    {cq_sus4,          {{3, 0}, {4, 0}                             }},
-    {cq_hdim7,         {{2,-1}, {4,-1}, {6,-1}                     }},
-    {cq_aug,           {{2, 0}, {4,+1}                             }},
-    {cq_dim,           {{2,-1}, {4,-1}                             }},
-    {cq_dim7,          {{2,-1}, {4,-1}, {6,-2}                     }},
-    {cq_maj_add9,      {{2, 0}, {4, 0}, {8, 0}                     }},
-    {cq_min_add9,      {{2,-1}, {4, 0}, {8, 0}                     }},
-    {cq_maj6,          {{2, 0}, {4, 0}, {5, 0}                     }},
-    {cq_min6,          {{2,-1}, {4, 0}, {5, 0}                     }},
-    {cq_maj9,          {{2, 0}, {4, 0}, {6, 0}, {8, 0}             }},
-    {cq_min9,          {{2,-1}, {4, 0}, {6,-1}, {8, 0}             }},
-    {cq_maj_add11,     {{2, 0}, {4, 0}, {10,0}                     }},
-    {cq_7_add9sharp,   {{2, 0}, {4, 0}, {6,-1}, {8,+1}             }},
-    {cq_9,             {{2, 0}, {4, 0}, {6,-1}, {8, 0}             }},
-    {cq_aug7,          {{2, 0}, {4,+1}, {6,-1}                     }},
-    {cq_maj11,         {{2, 0}, {4, 0}, {6, 0}, {8, 0},{10,0}      }},
-    {cq_min11,         {{2,-1}, {4, 0}, {6,-1}, {8, 0},{10,0}      }},
-    {cq_maj13,         {{2, 0}, {4, 0}, {6, 0}, {8, 0},{10,0},{12,0}}},
-    {cq_min13,         {{2,-1}, {4, 0}, {6,-1}, {8, 0},{10,0},{12,0}}},
+/**
+ * Pitch classes of a chord as semitones from the root
+ */
+static constexpr pcset_t intervals() { return 0; }
+
+template<typename... T>
+static constexpr pcset_t intervals(int semitones, T... rest)
+{
+    return (1 << (semitones % notes_Total)) | intervals(rest...);
+}
+
+static constexpr pcset_t pctpls[cq_Max + 1] = {
+    /* cq_unknown */        intervals(0),
+    /* cq_maj */            intervals(0, 4, 7),
+    /* cq_min */            intervals(0, 3, 7),
+    /* cq_5 */              intervals(0, 7),
+    /* cq_7 */              intervals(0, 4, 7, 10),
+    /* cq_maj7 */           intervals(0, 4, 7, 11),
+    /* cq_min7 */           intervals(0, 3, 7, 10),
+    /* cq_sus2 */           intervals(0, 2, 7),
+    /* cq_sus4 */           intervals(0, 5, 7),
+    /* cq_hdim7 */          intervals(0, 3, 6, 10),
+    /* cq_aug */            intervals(0, 4, 8),
+    /* cq_dim */            intervals(0, 3, 6),
+    /* cq_dim7 */           intervals(0, 3, 6, 9),
+    /* cq_maj_add9 */       intervals(0, 4, 7, 14),
+    /* cq_min_add9 */       intervals(0, 3, 7, 14),
+    /* cq_maj6 */           intervals(0, 4, 7, 9),
+    /* cq_min6 */           intervals(0, 3, 7, 9),
+    /* cq_maj9 */           intervals(0, 4, 7, 11, 14),
+    /* cq_min9 */           intervals(0, 3, 7, 10, 14),
+    /* cq_maj_add11 */      intervals(0, 4, 7, 17),
+    /* cq_7_add9sharp */    intervals(0, 4, 7, 10, 15),
+    /* cq_9 */              intervals(0, 4, 7, 10, 14),
+    /* cq_aug7 */           intervals(0, 4, 8, 10),
+    /* cq_maj11 */          intervals(0, 4, 7, 11, 14, 17),
+    /* cq_min11 */          intervals(0, 3, 7, 10, 14, 17),
+    /* cq_maj13 */          intervals(0, 4, 7, 11, 14, 17, 21),
+    /* cq_min13 */          intervals(0, 3, 7, 10, 14, 17, 21),
 };
 
 pcset_t make_pcset(note_t root, chord_quality_t cq)
 {
-    auto scale = MusicScale::getMajorScale(root);
-    pcset_t pcset = { scale[0] };
-    const vector<pair<size_t, int>> & pctpl = pctpls[cq];
-    for (auto & E: pctpl)
-        pcset.insert(scale[E.first] + E.second);
-    return pcset;
+    const pcset_t all = (1 << notes_Total) - 1;
+
+    if ((root < note_Min) || (root > note_Max) || (cq > cq_Max)) {
+        return 0;
+    }
+
+    /* rotate the intervals to start at the root */
+    int shift = root - note_Min;
+    int tpl = pctpls[cq];
+
+    return ((tpl << shift) | (tpl >> (static_cast<int>(notes_Total) - shift))) & all;
 }
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file    onset_detector.cpp
+ * @brief   Implementation of the spectral flux onset detection
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "config.h"
+#include "lmstats.h"
+#include "onset_detector.h"
+
+/**
+ * Log compression factor of the normalised magnitudes, the larger it is the
+ * more weight quiet partials get
+ */
+#define ODF_LOG_GAMMA       1000.0
+
+using namespace std;
+
+namespace anatomist {
+
+vector<amplitude_t> OnsetDetector::Strength(const log_spectrogram_t &sg)
+{
+    LM_STATS_SCOPE("onsets");
+    LM_STATS_FRAMES(sg.size());
+
+    vector<amplitude_t> strength(sg.size(), 0);
+    vector<amplitude_t> prev, cur;
+    amplitude_t peak = 0, max_flux = 0;
+
+    for (auto &col : sg) {
+        for (auto val : col) {
+            peak = max(peak, val);
+        }
+    }
+
+    if (peak <= 0) {
+        return strength;
+    }
+
+    for (size_t f = 0; f < sg.size(); f++) {
+        amplitude_t flux = 0;
+
+        cur.resize(sg[f].size());
+        for (size_t k = 0; k < cur.size(); k++) {
+            cur[k] = log1p(ODF_LOG_GAMMA * max(0.0, sg[f][k]) / peak);
+        }
+
+        for (size_t k = 0; k < max(cur.size(), prev.size()); k++) {
+            amplitude_t c = (k < cur.size()) ? cur[k] : 0;
+            amplitude_t p = (k < prev.size()) ? prev[k] : 0;
+
+            flux += max(0.0, c - p);
+        }
+
+        /* nothing to compare the very first column with */
+        strength[f] = (f == 0) ? 0 : flux;
+        max_flux = max(max_flux, flux);
+        swap(prev, cur);
+    }
+
+    if (max_flux > 0) {
+        for (auto &s : strength) {
+            s /= max_flux;
+        }
+    }
+
+    return strength;
+}
+
+vector<uint32_t> OnsetDetector::PickPeaks(const vector<amplitude_t> &strength,
+                                          uint32_t interval, uint32_t samplerate)
+{
+    LM_STATS_SCOPE("onsets");
+
+    /* median is taken over CFG_ONSET_WINDOW_SEC centered at the frame */
+    size_t half = max(1.0, round(CFG_ONSET_WINDOW_SEC * samplerate / interval / 2));
+    size_t gap = max(1.0, round(CFG_ONSET_MIN_GAP_SEC * samplerate / interval));
+    vector<amplitude_t> window;
+    vector<uint32_t> onsets;
+
+    for (size_t f = 0; f < strength.size(); f++) {
+        size_t from = (f > half) ? f - half : 0;
+        size_t to = min(f + half + 1, strength.size());
+        size_t gap_to = min(f + gap + 1, strength.size());
+        bool peak = true;
+
+        /*
+         * Transforms smear the attack over a few frames, so the peak has to
+         * be the strongest within the gap. Rising edge of a plateau wins.
+         */
+        for (size_t i = (f > gap) ? f - gap : 0; peak && (i < gap_to); i++) {
+            peak = (i < f) ? (strength[i] < strength[f]) : (strength[i] <= strength[f]);
+        }
+
+        if (!peak) {
+            continue;
+        }
+
+        window.assign(strength.begin() + from, strength.begin() + to);
+        nth_element(window.begin(), window.begin() + window.size() / 2, window.end());
+
+        if (strength[f] >= window[window.size() / 2] + CFG_ONSET_THRESHOLD) {
+            onsets.push_back(f * interval);
+        }
+    }
+
+    return onsets;
+}
+
+}
@@ -81,14 +81,55 @@ PitchClsProfile::PitchClsProfile(fd_t &fd_mags, tft_t *tft)
 {
     PitchCalculator& pc = PitchCalculator::getInstance();
     uint8_t bps = tft->BinsPerSemitone();
-    int32_t offset = tft->FreqToBin(pc.noteToPitch(note_E, OCTAVE_MIN));
     uint8_t semitones_cnt = fd_mags.size() / bps;
-    freq_hz_t f3 = pc.noteToPitch(note_F, OCTAVE_3);
-    uint32_t f3_idx = tft->FreqToBin(f3);
+    uint32_t f3_idx = tft->FreqToBin(pc.noteToPitch(note_F, OCTAVE_3));
     uint32_t win_offset = 0; // TODO: calculate
     vector<amplitude_t> bass_win = WindowFunctions::getHamming(f3_idx / bps, win_offset);
     vector<amplitude_t> treble_win = WindowFunctions::getHamming(semitones_cnt, win_offset);
 
+    __fromMagnitudes(fd_mags, tft, bass_win.data(), bass_win.size(), treble_win.data());
+}
+
+PitchClsProfile::PitchClsProfile(const fd_t &fd_mags, tft_t *tft, const pcp_windows_t &windows)
+{
+    if (static_cast<uint8_t>(fd_mags.size() / tft->BinsPerSemitone()) != windows.treble_len) {
+        throw invalid_argument("PitchClsProfile(): windows are for another spectrum size");
+    }
+
+    __fromMagnitudes(fd_mags, tft, windows.bass, windows.bass_len, windows.treble);
+}
+
+pcp_windows_t PitchClsProfile::Windows(tft_t *tft, size_t bins, Arena &arena)
+{
+    PitchCalculator& pc = PitchCalculator::getInstance();
+    uint8_t bps = tft->BinsPerSemitone();
+    pcp_windows_t windows;
+    amplitude_t *bass_win;
+    amplitude_t *treble_win;
+
+    windows.bass_len = tft->FreqToBin(pc.noteToPitch(note_F, OCTAVE_3)) / bps;
+    windows.treble_len = static_cast<uint8_t>(bins / bps);
+
+    bass_win = arena.Allocate<amplitude_t>(windows.bass_len);
+    treble_win = arena.Allocate<amplitude_t>(windows.treble_len);
+
+    WindowFunctions::getHamming(windows.bass_len, 0, bass_win);
+    WindowFunctions::getHamming(windows.treble_len, 0, treble_win);
+
+    windows.bass = bass_win;
+    windows.treble = treble_win;
+
+    return windows;
+}
+
+void PitchClsProfile::__fromMagnitudes(const fd_t &fd_mags, tft_t *tft,
+                                       const amplitude_t *bass_win,
+                                       size_t bass_len, const amplitude_t *treble_win)
+{
+    PitchCalculator& pc = PitchCalculator::getInstance();
+    uint8_t bps = tft->BinsPerSemitone();
+    int32_t offset = tft->FreqToBin(pc.noteToPitch(note_E, OCTAVE_MIN));
+
     __mPCP.resize(notes_Total * 2, 0);
 
     for (uint32_t bin = offset; bin < fd_mags.size() - (bps/2+1); bin += bps) {
@@ -103,7 +144,7 @@ PitchClsProfile::PitchClsProfile(fd_t &fd_mags, tft_t *tft)
 
         note = pc.pitchToNote(pc.getPitch(tft->BinToFreq(bin)));
 
-        if (bin / bps < bass_win.size()) {
+        if (bin / bps < bass_len) {
             __mPCP[note - note_Min] += tmp * bass_win[bin / bps];
         }
         __mPCP[note - note_Min + notes_Total] += tmp * treble_win[bin / bps];
@@ -125,6 +166,16 @@ void PitchClsProfile::__normalize()
     }
 }
 
+PitchClsProfile::PitchClsProfile(const std::vector<amplitude_t> &values)
+{
+    if (values.empty()) {
+        throw invalid_argument("PitchClsProfile(): empty values");
+    }
+
+    __mPCP = values;
+    __mPitchClsMax = *max_element(__mPCP.begin(), __mPCP.end());
+}
+
 amplitude_t PitchClsProfile::getPitchCls(note_t note, bool is_treble) const
 {
     if ((note < note_Min) || (note > note_Max)) {
@@ -139,6 +190,11 @@ size_t PitchClsProfile::size()
     return __mPCP.size();
 }
 
+const std::vector<amplitude_t> & PitchClsProfile::getValues() const
+{
+    return __mPCP;
+}
+
 amplitude_t PitchClsProfile::euclideanDistance(PitchClsProfile &pcp)
 {
     amplitude_t d = euclideanDistance<typeof(__mPCP[0])>(pcp.__mPCP);
@@ -162,7 +218,12 @@ amplitude_t PitchClsProfile::divergenceKullbackLeibler(vector<amplitude_t> &v)
 
 amplitude_t PitchClsProfile::sumProduct(std::vector<amplitude_t> &v)
 {
-    if (v.size() != __mPCP.size()) {
+    return sumProduct(v.data(), v.size());
+}
+
+amplitude_t PitchClsProfile::sumProduct(const amplitude_t *v, size_t size)
+{
+    if (size != __mPCP.size()) {
         throw invalid_argument("sumProduct(): wrong vector size");
     }
 
@@ -0,0 +1,288 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    rt_chord_analyzer.cpp
+ * @brief   Implementation of the real-time safe chord recognition
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "chord_tpl_collection.h"
+#include "config.h"
+#include "lmhelpers.h"
+#include "rt_chord_analyzer.h"
+#include "window_functions.h"
+
+#define FREQ_E1     ((freq_hz_t)41.203)
+#define FREQ_F3     ((freq_hz_t)174.61)
+#define FREQ_C6     ((freq_hz_t)1046.5)
+
+/**
+ * Score of the N template is attenuated the same way as in the offline
+ * decoder, see ChordDetector::GetScoreMatrix_()
+ */
+#define N_SCORE_FACTOR  0.7
+#define SCORE_BASE      1.3
+
+using namespace std;
+
+namespace anatomist {
+
+static const AnalysisConfig & validated(const AnalysisConfig &config)
+{
+    config.Validate();
+
+    return config;
+}
+
+RTChordAnalyzer::RTChordAnalyzer(uint32_t samplerate, uint32_t win_size, uint32_t block_size,
+                                 uint32_t fft_size, uint32_t window_func, amplitude_t self_p) :
+        samplerate_(samplerate),
+        win_size_(win_size),
+        block_size_(block_size)
+{
+    if ((samplerate == 0) || (block_size == 0) || (block_size > win_size) ||
+        (FREQ_C6 >= samplerate / 2))
+    {
+        throw invalid_argument("RTChordAnalyzer(): invalid argument");
+    }
+
+    fft_size_ = Helpers::nextPowerOf2(max(fft_size, max(win_size, 2U)));
+
+    fft_cfg_ = kiss_fftr_alloc(fft_size_, 0, nullptr, nullptr);
+    if (fft_cfg_ == nullptr) {
+        throw runtime_error("RTChordAnalyzer(): failed to allocate FFT");
+    }
+
+    window_.resize(win_size_, 1);
+    WindowFunctions::apply(window_, window_func);
+    history_.resize(win_size_, 0);
+    frame_.resize(fft_size_, 0);
+    fd_.resize(fft_size_ / 2 + 1);
+    pcp_.resize(notes_Total * 2, 0);
+
+    /* average power of a full scale sine attenuated to the silence threshold */
+    silence_power_ = 0.5 * pow(10, CFG_SILENCE_THRESHOLD_DB / 10.0);
+
+    InitChromaBins_();
+    InitTemplates_(self_p);
+    Reset();
+}
+
+RTChordAnalyzer::RTChordAnalyzer(uint32_t samplerate, uint32_t block_size) :
+        RTChordAnalyzer(samplerate, block_size, block_size, AnalysisConfig().fft_size,
+                        WINDOW_FUNC_HAMMING, AnalysisConfig().self_transition_p) {}
+
+RTChordAnalyzer::RTChordAnalyzer(uint32_t samplerate) :
+        RTChordAnalyzer(samplerate, CFG_WINDOW_SIZE) {}
+
+RTChordAnalyzer::RTChordAnalyzer(uint32_t samplerate, const AnalysisConfig &config) :
+        RTChordAnalyzer(samplerate, validated(config).win_size, config.HopSize(),
+                        config.fft_size, config.window_func, config.self_transition_p) {}
+
+RTChordAnalyzer::~RTChordAnalyzer()
+{
+    kiss_fftr_free(fft_cfg_);
+}
+
+void RTChordAnalyzer::InitChromaBins_()
+{
+    amplitude_t bin_hz = 1.0 * samplerate_ / fft_size_;
+    uint32_t bin_min = ceil(FREQ_E1 / bin_hz);
+    uint32_t bin_max = floor(FREQ_C6 / bin_hz);
+    uint32_t semitones = lround(12 * log2(FREQ_C6 / FREQ_E1)) + 1;
+    uint32_t bass_semitones = lround(12 * log2(FREQ_F3 / FREQ_E1)) + 1;
+    vector<amplitude_t> bass_win = WindowFunctions::getHamming(bass_semitones, 0);
+    vector<amplitude_t> treble_win = WindowFunctions::getHamming(semitones, 0);
+
+    for (uint32_t bin = bin_min; bin <= bin_max; bin++) {
+        amplitude_t midi = 69 + 12 * log2(bin * bin_hz / 440);
+        int32_t semitone = lround(12 * log2(bin * bin_hz / FREQ_E1));
+        chroma_bin_t cb;
+
+        if ((semitone < 0) || (static_cast<uint32_t>(semitone) >= semitones)) {
+            continue;
+        }
+
+        cb.bin = bin;
+        cb.pitch_cls = (lround(midi) % notes_Total + notes_Total) % notes_Total;
+        cb.bass_weight = (static_cast<uint32_t>(semitone) < bass_semitones) ? bass_win[semitone] : 0;
+        cb.treble_weight = treble_win[semitone];
+
+        chroma_bins_.push_back(cb);
+    }
+}
+
+void RTChordAnalyzer::InitTemplates_(amplitude_t self_p)
+{
+    ChordTplCollection collection;
+
+    n_idx_ = collection.Size();
+
+    for (uint32_t i = 0; i < collection.Size(); i++) {
+        const chord_tpl_t *tpl = collection.GetTpl(i);
+
+        if (tpl->Size() != pcp_.size()) {
+            throw runtime_error("RTChordAnalyzer(): incompatible template size");
+        }
+
+        tpls_.insert(tpls_.end(), tpl->Values(), tpl->Values() + tpl->Size());
+        chords_.push_back(Chord(tpl->RootNote(), tpl->Quality()));
+
+        if (tpl->RootNote() == note_Unknown) {
+            n_idx_ = i;
+        }
+    }
+
+    if (n_idx_ == collection.Size()) {
+        throw runtime_error("RTChordAnalyzer(): no N template");
+    }
+
+    if (self_p == 0) {
+        self_p = 1.0 / chords_.size();
+    }
+
+    log_self_p_ = log(self_p);
+    log_other_p_ = log((1 - self_p) / (chords_.size() - 1));
+    delta_.resize(chords_.size());
+}
+
+void RTChordAnalyzer::ResetPath_()
+{
+    fill(delta_.begin(), delta_.end(), -numeric_limits<amplitude_t>::infinity());
+    delta_[n_idx_] = 0;
+    current_ = n_idx_;
+}
+
+void RTChordAnalyzer::Reset()
+{
+    fill(history_.begin(), history_.end(), 0);
+    ResetPath_();
+}
+
+template<typename T>
+const chord_t & RTChordAnalyzer::Process_(const T *block)
+{
+    amplitude_t power = 0, pcp_max = 0, best = -numeric_limits<amplitude_t>::infinity();
+    uint32_t best_idx = n_idx_;
+
+    if (block == nullptr) {
+        throw invalid_argument("RTChordAnalyzer::Process(): invalid argument");
+    }
+
+    /* the block completes the window, older samples move a block back */
+    copy(history_.begin() + block_size_, history_.end(), history_.begin());
+    copy(block, block + block_size_, history_.end() - block_size_);
+
+    for (uint32_t i = 0; i < win_size_; i++) {
+        power += history_[i] * history_[i];
+        frame_[i] = history_[i] * window_[i];
+    }
+    power /= win_size_;
+
+    if (power < silence_power_) {
+        ResetPath_();
+        return chords_[current_];
+    }
+
+    kiss_fftr(fft_cfg_, frame_.data(), fd_.data());
+
+    fill(pcp_.begin(), pcp_.end(), 0);
+    for (auto &cb : chroma_bins_) {
+        amplitude_t mag = sqrt(fd_[cb.bin].r * fd_[cb.bin].r + fd_[cb.bin].i * fd_[cb.bin].i);
+
+        pcp_[cb.pitch_cls] += mag * cb.bass_weight;
+        pcp_[cb.pitch_cls + notes_Total] += mag * cb.treble_weight;
+    }
+
+    pcp_max = *max_element(pcp_.begin(), pcp_.end());
+    if (pcp_max > 0) {
+        for (auto &v : pcp_) {
+            v /= pcp_max;
+        }
+    }
+
+    amplitude_t prev_best = delta_[current_];
+
+    for (uint32_t t = 0; t < chords_.size(); t++) {
+        const amplitude_t *tpl = &tpls_[t * pcp_.size()];
+        amplitude_t score = 0;
+
+        for (uint32_t i = 0; i < pcp_.size(); i++) {
+            score += pcp_[i] * tpl[i];
+        }
+
+        score = max<amplitude_t>(score, 0);
+        if (t == n_idx_) {
+            score *= N_SCORE_FACTOR;
+        }
+
+        /*
+         * Transition probability to any other chord is the same, so the best
+         * predecessor is either the chord itself or the overall best one
+         */
+        delta_[t] = score * log(SCORE_BASE) +
+                    max(delta_[t] + log_self_p_, prev_best + log_other_p_);
+
+        if (delta_[t] > best) {
+            best = delta_[t];
+            best_idx = t;
+        }
+    }
+
+    /* keep the values bounded */
+    for (auto &d : delta_) {
+        d -= best;
+    }
+
+    current_ = best_idx;
+
+    return chords_[current_];
+}
+
+const chord_t & RTChordAnalyzer::Process(const amplitude_t *block)
+{
+    return Process_(block);
+}
+
+const chord_t & RTChordAnalyzer::Process(const float *block)
+{
+    return Process_(block);
+}
+
+const chord_t & RTChordAnalyzer::GetChord()
+{
+    return chords_[current_];
+}
+
+uint32_t RTChordAnalyzer::BlockSize()
+{
+    return block_size_;
+}
+
+uint32_t RTChordAnalyzer::WindowSize()
+{
+    return win_size_;
+}
+
+}
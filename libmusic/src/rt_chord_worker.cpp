@@ -0,0 +1,188 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    rt_chord_worker.cpp
+ * @brief   Implementation of the background chord recognition of a live stream
+ */
+
+#include <chrono>
+#include <stdexcept>
+
+#include "config.h"
+#include "rt_chord_worker.h"
+
+using namespace std;
+
+namespace anatomist {
+
+RTChordWorker::RTChordWorker(uint32_t samplerate, uint32_t channels,
+                             ChordDetector::ResultsListener *listener,
+                             uint32_t block_size) :
+        channels_(channels),
+        analyzer_(samplerate, block_size),
+        queue_(channels * max<uint32_t>(CFG_RT_QUEUE_SEC * samplerate, 2 * block_size)),
+        listener_(listener),
+        block_len_(0),
+        running_(false),
+        position_(0),
+        dropped_(0),
+        segment_chord_(nullptr)
+{
+    if (channels == 0) {
+        throw invalid_argument("RTChordWorker(): invalid argument");
+    }
+
+    chunk_.resize(block_size * channels_);
+    block_.resize(block_size);
+
+    /* poll a few times per block so that the queue never fills up */
+    idle_us_ = max<uint32_t>(1, 1e6 * block_size / samplerate / 4);
+
+    chord_.store(&analyzer_.GetChord());
+}
+
+RTChordWorker::~RTChordWorker()
+{
+    Stop();
+}
+
+void RTChordWorker::Start()
+{
+    if (running_.exchange(true)) {
+        return;
+    }
+
+    segment_.startIdx = position_.load();
+    segment_chord_ = nullptr;
+    thread_ = thread(&RTChordWorker::Run_, this);
+}
+
+void RTChordWorker::Stop()
+{
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    thread_.join();
+
+    if (listener_ != nullptr) {
+        FinishSegment_();
+        listener_->onChordAnalysisFinished();
+    }
+}
+
+bool RTChordWorker::Push(const float *frames, uint32_t n)
+{
+    if (!queue_.Write(frames, n * channels_)) {
+        dropped_.fetch_add(n, memory_order_relaxed);
+        return false;
+    }
+
+    return true;
+}
+
+void RTChordWorker::Run_()
+{
+    /* check the flag before draining so that nothing pushed before Stop() is lost */
+    while (running_.load()) {
+        if (!Consume_()) {
+            this_thread::sleep_for(chrono::microseconds(idle_us_));
+        }
+    }
+
+    while (Consume_());
+}
+
+bool RTChordWorker::Consume_()
+{
+    uint32_t block_size = block_.size();
+    uint32_t frames = min<size_t>(queue_.ReadAvailable() / channels_, block_size - block_len_);
+
+    if (frames == 0) {
+        return false;
+    }
+
+    queue_.Read(chunk_.data(), frames * channels_);
+
+    for (uint32_t i = 0; i < frames; i++) {
+        float sum = 0;
+
+        for (uint32_t ch = 0; ch < channels_; ch++) {
+            sum += chunk_[i * channels_ + ch];
+        }
+
+        block_[block_len_++] = sum / channels_;
+    }
+
+    if (block_len_ == block_size) {
+        OnBlock_();
+        block_len_ = 0;
+    }
+
+    return true;
+}
+
+void RTChordWorker::OnBlock_()
+{
+    const chord_t *chord = &analyzer_.Process(block_.data());
+    uint64_t pos = position_.load(memory_order_relaxed);
+
+    if (listener_ != nullptr && chord != segment_chord_) {
+        FinishSegment_();
+
+        segment_.startIdx = pos;
+        segment_chord_ = chord;
+    }
+
+    chord_.store(chord, memory_order_release);
+    position_.store(pos + block_.size(), memory_order_release);
+}
+
+void RTChordWorker::FinishSegment_()
+{
+    if (segment_chord_ == nullptr) {
+        return;
+    }
+
+    segment_.endIdx = position_.load() - 1;
+    segment_.chord = *segment_chord_;
+    segment_.silence = false;
+
+    listener_->onChordSegmentProcessed(segment_, 0);
+
+    segment_chord_ = nullptr;
+}
+
+const chord_t & RTChordWorker::GetChord()
+{
+    return *chord_.load(memory_order_acquire);
+}
+
+uint64_t RTChordWorker::GetPosition()
+{
+    return position_.load(memory_order_acquire);
+}
+
+uint64_t RTChordWorker::GetDropped()
+{
+    return dropped_.load(memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    signal_energy.cpp
+ * @brief   Implementation of the power queries over the time domain input
+ */
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "lmstats.h"
+#include "signal_energy.h"
+
+using namespace std;
+
+namespace anatomist {
+
+SignalEnergy::SignalEnergy(const SignalView &x) :
+        x_(x)
+{
+    LM_STATS_SCOPE("signal_energy");
+    LM_STATS_FRAMES(x.size());
+
+    amplitude_t buf[SIGNAL_ENERGY_BLOCK_SIZE];
+    size_t blocks = x.size() / SIGNAL_ENERGY_BLOCK_SIZE;
+
+    prefix_.resize(blocks + 1, 0);
+
+    for (size_t b = 0; b < blocks; b++) {
+        double sum = 0;
+
+        x.Read(b * SIGNAL_ENERGY_BLOCK_SIZE, SIGNAL_ENERGY_BLOCK_SIZE, buf);
+        for (uint32_t i = 0; i < SIGNAL_ENERGY_BLOCK_SIZE; i++) {
+            sum += buf[i] * buf[i];
+        }
+
+        prefix_[b + 1] = prefix_[b] + sum;
+    }
+}
+
+double SignalEnergy::Sum_(size_t from, size_t to) const
+{
+    amplitude_t buf[SIGNAL_ENERGY_BLOCK_SIZE];
+    double sum = 0;
+
+    x_.Read(from, to - from, buf);
+    for (size_t i = 0; i < to - from; i++) {
+        sum += buf[i] * buf[i];
+    }
+
+    return sum;
+}
+
+amplitude_t SignalEnergy::Power(size_t from, size_t to) const
+{
+    if ((from >= to) || (to > x_.size())) {
+        throw invalid_argument("SignalEnergy::Power(): invalid range");
+    }
+
+    size_t first = (from + SIGNAL_ENERGY_BLOCK_SIZE - 1) / SIGNAL_ENERGY_BLOCK_SIZE;
+    size_t last = to / SIGNAL_ENERGY_BLOCK_SIZE;
+    double sum;
+
+    if (first > last) {
+        /* the range is within a single block */
+        sum = Sum_(from, to);
+    } else {
+        sum = prefix_[last] - prefix_[first] +
+              Sum_(from, first * SIGNAL_ENERGY_BLOCK_SIZE) +
+              Sum_(last * SIGNAL_ENERGY_BLOCK_SIZE, to);
+    }
+
+    return max(0.0, sum) / (to - from);
+}
+
+}
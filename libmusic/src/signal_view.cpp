@@ -0,0 +1,100 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    signal_view.cpp
+ * @brief   Implementation of the non-owning view over the time domain input
+ */
+
+#include <stdexcept>
+#include <string.h>
+
+#include "signal_view.h"
+
+using namespace std;
+
+namespace anatomist {
+
+SignalView::SignalView(const double *data, size_t frames, uint32_t channels, uint32_t stride) :
+        d_(data),
+        f_(nullptr),
+        frames_(frames),
+        channels_(channels),
+        stride_(stride == 0 ? channels : stride)
+{
+    if (((data == nullptr) && (frames > 0)) || (channels == 0) || (stride_ < channels_)) {
+        throw invalid_argument("SignalView(): invalid argument");
+    }
+}
+
+SignalView::SignalView(const float *data, size_t frames, uint32_t channels, uint32_t stride) :
+        d_(nullptr),
+        f_(data),
+        frames_(frames),
+        channels_(channels),
+        stride_(stride == 0 ? channels : stride)
+{
+    if (((data == nullptr) && (frames > 0)) || (channels == 0) || (stride_ < channels_)) {
+        throw invalid_argument("SignalView(): invalid argument");
+    }
+}
+
+SignalView::SignalView(const td_t &td) :
+        SignalView(td.data(), td.size()) {}
+
+void SignalView::Read(size_t from, size_t n, amplitude_t *out) const
+{
+    if (from + n > frames_) {
+        throw out_of_range("SignalView::Read(): out of range");
+    }
+
+    if (Contiguous() != nullptr) {
+        memcpy(out, d_ + from, n * sizeof(out[0]));
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        out[i] = (*this)[from + i];
+    }
+}
+
+const amplitude_t * SignalView::Contiguous() const
+{
+    return ((d_ != nullptr) && (channels_ == 1) && (stride_ == 1)) ? d_ : nullptr;
+}
+
+SignalView SignalView::Sub(size_t from, size_t n) const
+{
+    if (from + n > frames_) {
+        throw out_of_range("SignalView::Sub(): out of range");
+    }
+
+    SignalView sv(*this);
+
+    if (d_ != nullptr) {
+        sv.d_ += from * stride_;
+    } else {
+        sv.f_ += from * stride_;
+    }
+    sv.frames_ = n;
+
+    return sv;
+}
+
+}
@@ -26,6 +26,7 @@
 #include <algorithm>
 
 #include "lmhelpers.h"
+#include "lmstats.h"
 #include "tft.h"
 
 namespace anatomist {
@@ -37,13 +38,14 @@ TFT::TFT(freq_hz_t f_min, freq_hz_t f_max, uint16_t bpo, uint32_t sample_rate,
                                             bpo_(bpo),
                                             sample_rate_(sample_rate),
                                             win_size_(win_size),
-                                            hop_size_(hop_size)
+                                            hop_size_(hop_size),
+                                            arena_(nullptr)
 {
     spectrogram_ = log_spectrogram_t(0, fd_t(0));
     interval_ = win_size;
 }
 
-log_spectrogram_t TFT::GetSpectrogram()
+const log_spectrogram_t & TFT::GetSpectrogram()
 {
     return spectrogram_;
 }
@@ -53,18 +55,64 @@ uint32_t TFT::SpectrogramInterval()
     return interval_;
 }
 
+uint32_t TFT::Alignment()
+{
+    /* frames are independent of each other */
+    return interval_;
+}
+
+uint32_t TFT::Context()
+{
+    return win_size_;
+}
+
+void TFT::SetSkipMask(const std::vector<bool> &skip)
+{
+    skip_ = skip;
+}
+
+void TFT::SetArena(Arena *arena)
+{
+    arena_ = arena;
+}
+
+void TFT::Reset()
+{
+    spectrogram_.clear();
+    skip_.clear();
+}
+
 void TFT::Denoise_(log_spectrogram_t &block)
 {
+    LM_STATS_SCOPE("denoise");
+    LM_STATS_FRAMES(block.size());
+
+    Arena local_arena;
+    Arena &arena = (arena_ != nullptr) ? *arena_ : local_arena;
+    size_t height = 0;
+
+    for (auto & col : block) {
+        height = std::max(height, col.size());
+    }
+
+    /* medians reorder what they are given, so they work on a copy */
+    amplitude_t *scratch = arena.Allocate<amplitude_t>(height);
+
     for (auto & col : block) {
-        std::vector<amplitude_t> devs;
+        if (col.empty()) {
+            continue;
+        }
+
         amplitude_t thr_uni, sigma, mad;
-        amplitude_t median = Helpers::median(col);
 
-        for (auto val : col) {
-            devs.push_back(std::abs(val - median));
+        std::copy(col.begin(), col.end(), scratch);
+        amplitude_t median = Helpers::median(scratch, scratch + col.size());
+
+        for (size_t i = 0; i < col.size(); i++) {
+            scratch[i] = std::abs(col[i] - median);
         }
 
-        mad = Helpers::median(devs);
+        mad = Helpers::median(scratch, scratch + col.size());
 
         sigma = mad / 0.6745;
 
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file    thread_pool.cpp
+ * @brief   Implementation of the fixed size pool of worker threads
+ */
+
+#include <algorithm>
+
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace anatomist {
+
+ThreadPool::ThreadPool(uint32_t threads) :
+        tasks_(0),
+        next_(0),
+        running_(0),
+        generation_(0),
+        stop_(false)
+{
+    /* calling thread is one of the workers */
+    for (uint32_t i = 1; i < Threads(threads); i++) {
+        workers_.push_back(thread(&ThreadPool::Worker_, this));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+
+    for (auto &w : workers_) {
+        w.join();
+    }
+}
+
+uint32_t ThreadPool::Threads(uint32_t threads)
+{
+    if (threads == 0) {
+        threads = thread::hardware_concurrency();
+    }
+
+    return max(threads, 1U);
+}
+
+uint32_t ThreadPool::Size()
+{
+    return workers_.size() + 1;
+}
+
+void ThreadPool::Drain_(unique_lock<mutex> &lock)
+{
+    while (next_ < tasks_) {
+        uint32_t task = next_++;
+
+        running_++;
+        lock.unlock();
+
+        try {
+            fn_(task);
+        } catch (...) {
+            lock.lock();
+            if (!error_) {
+                error_ = current_exception();
+            }
+            next_ = tasks_;
+            running_--;
+            continue;
+        }
+
+        lock.lock();
+        running_--;
+    }
+
+    if (running_ == 0) {
+        done_cv_.notify_all();
+    }
+}
+
+void ThreadPool::Worker_()
+{
+    unique_lock<mutex> lock(mutex_);
+    uint64_t seen = generation_;
+
+    while (true) {
+        work_cv_.wait(lock, [this, seen]() { return stop_ || (generation_ != seen); });
+
+        if (stop_) {
+            return;
+        }
+
+        seen = generation_;
+        Drain_(lock);
+    }
+}
+
+void ThreadPool::Run(uint32_t tasks, const function<void(uint32_t)> &fn)
+{
+    unique_lock<mutex> lock(mutex_);
+
+    fn_ = fn;
+    tasks_ = tasks;
+    next_ = 0;
+    error_ = nullptr;
+    generation_++;
+    work_cv_.notify_all();
+
+    Drain_(lock);
+    done_cv_.wait(lock, [this]() { return (next_ >= tasks_) && (running_ == 0); });
+
+    fn_ = nullptr;
+
+    if (error_) {
+        rethrow_exception(error_);
+    }
+}
+
+}
@@ -18,13 +18,22 @@
  */
 
 #include <algorithm>
+#include <memory>
 
+#include "arena.h"
 #include "lmhelpers.h"
+#include "lmstats.h"
+#include "thread_pool.h"
 #include "viterbi.h"
 
-using namespace std;
+/**
+ * Regions shorter than this are not worth a task of their own
+ */
+#define VITERBI_REGION_MIN          ((uint32_t)64)
+#define VITERBI_REGIONS_PER_THREAD  4
 
-typedef pair<uint32_t, prob_t> state_metric_t;
+using namespace anatomist;
+using namespace std;
 
 
 bool Viterbi::ValidateProbVector_(const vector<prob_t> &v)
@@ -65,9 +74,99 @@ void Viterbi::ValidateMatrix_(const vector<vector<double>> &obs) {
     }
 }
 
+int32_t Viterbi::Anchor_(const vector<prob_t> &obs)
+{
+    int32_t anchor = -1;
+
+    for (uint32_t state = 0; state < obs.size(); state++) {
+        if (obs[state] > 0) {
+            if (anchor >= 0) {
+                return -1;
+            }
+            anchor = state;
+        }
+    }
+
+    return anchor;
+}
+
+void Viterbi::Step_(const state_metric_t *prev, const vector<prob_t> &obs_col,
+                    const prob_t *log_trans, uint32_t states_cnt, state_metric_t *cur)
+{
+    fill_n(cur, states_cnt, state_metric_t(0, -INFINITY));
+
+    for (uint32_t i_state = 0; i_state < states_cnt; i_state++) {
+        if (obs_col[i_state] > 0) {
+            state_metric_t max_metric(states_cnt - 1, -INFINITY), cur_metric;
+            for (uint32_t j_state = 0; j_state < states_cnt; j_state++) {
+                cur_metric = make_pair(j_state, prev[j_state].second +
+                                                log_trans[j_state * states_cnt + i_state]);
+                if (cur_metric.second > max_metric.second) {
+                    max_metric = cur_metric;
+                }
+            }
+            cur[i_state] = make_pair(max_metric.first, max_metric.second + log(obs_col[i_state]));
+        }
+    }
+
+    /*
+     * Whatever happened before, the path goes through the only possible
+     * state, so its metric is restarted the same way as at the beginning
+     * of a region. This keeps serial and parallel decoding bit-exact.
+     */
+    int32_t anchor = Anchor_(obs_col);
+    if (anchor >= 0) {
+        cur[anchor].second = log(1.0 * obs_col[anchor]);
+    }
+}
+
+void Viterbi::Decode_(const vector<prob_t> &init_p, const prob_matrix_t &obs,
+                      const prob_t *log_trans, uint32_t begin, uint32_t end,
+                      state_metric_t *metrics, vector<uint32_t> &path)
+{
+    uint32_t obs_cnt = end - begin + 1;
+    uint32_t states_cnt = init_p.size();
+
+    path.resize(obs_cnt);
+
+    for (uint32_t state = 0; state < states_cnt; state++) {
+        metrics[state] = make_pair(0, log(init_p[state] * obs[begin][state]));
+    }
+
+    for (uint32_t o = 1; o < obs_cnt; o++) {
+        Step_(metrics + static_cast<size_t>(o - 1) * states_cnt, obs[begin + o], log_trans,
+              states_cnt, metrics + static_cast<size_t>(o) * states_cnt);
+    }
+
+    const state_metric_t *last = metrics + static_cast<size_t>(obs_cnt - 1) * states_cnt;
+
+    path[obs_cnt - 1] = max_element(last, last + states_cnt,
+                                    Helpers::cmpPairBySecond<uint32_t, double>) - last;
+
+    for (int32_t o = obs_cnt - 2; o >= 0; o--) {
+        path[o] = metrics[static_cast<size_t>(o + 1) * states_cnt + path[o + 1]].first;
+    }
+}
+
+vector<uint32_t> Viterbi::GetPath(vector<prob_t> &init_p, prob_matrix_t &obs,
+                                  prob_matrix_t &trans_p, uint32_t threads, Arena *arena)
+{
+    return Path_(init_p, obs, trans_p, ThreadPool::Threads(threads), nullptr, arena);
+}
+
 vector<uint32_t> Viterbi::GetPath(vector<prob_t> &init_p, prob_matrix_t &obs,
-                                  prob_matrix_t &trans_p)
+                                  prob_matrix_t &trans_p, ThreadPool &pool, Arena *arena)
 {
+    return Path_(init_p, obs, trans_p, pool.Size(), &pool, arena);
+}
+
+vector<uint32_t> Viterbi::Path_(vector<prob_t> &init_p, prob_matrix_t &obs,
+                                prob_matrix_t &trans_p, uint32_t threads, ThreadPool *pool,
+                                Arena *arena)
+{
+    LM_STATS_SCOPE("viterbi");
+    LM_STATS_FRAMES(obs.size());
+
     ValidateInitProbs_(init_p);
     ValidateMatrix_(obs);
     ValidateMatrix_(trans_p);
@@ -83,37 +182,213 @@ vector<uint32_t> Viterbi::GetPath(vector<prob_t> &init_p, prob_matrix_t &obs,
         throw invalid_argument("GetPath(): wrong transition matrix dimensions");
     }
 
-    vector<vector<state_metric_t>> metrics(obs_cnt,
-                                           vector<state_metric_t>(states_cnt, {0, -INFINITY}));
-    vector<uint32_t> path(obs.size());
+    Arena local_arena;
 
-    for (uint32_t state = 0; state < states_cnt; state++) {
-        metrics[0][state] = make_pair(0, log(init_p[state] * obs[0][state]));
+    if (arena == nullptr) {
+        arena = &local_arena;
     }
 
-    for (uint32_t o = 1; o < obs_cnt; o++) {
-        for (uint32_t i_state = 0; i_state < states_cnt; i_state++) {
-            if (obs[o][i_state] > 0) {
-                state_metric_t max_metric(states_cnt - 1, -INFINITY), cur_metric;
-                for (uint32_t j_state = 0; j_state < states_cnt; j_state++) {
-                    cur_metric = make_pair(j_state, metrics[o-1][j_state].second + log(trans_p[j_state][i_state]));
-                    if (cur_metric.second > max_metric.second) {
-                        max_metric = cur_metric;
-                    }
-                }
-                metrics[o][i_state] = make_pair(max_metric.first, max_metric.second + log(obs[o][i_state]));
-            }
+    prob_t *log_trans = arena->Allocate<prob_t>(static_cast<size_t>(states_cnt) * states_cnt);
+
+    for (uint32_t from = 0; from < states_cnt; from++) {
+        for (uint32_t to = 0; to < states_cnt; to++) {
+            log_trans[from * states_cnt + to] = log(trans_p[from][to]);
         }
     }
 
-    path[obs_cnt - 1] = max_element(metrics[obs_cnt - 1].begin(),
-                                    metrics[obs_cnt - 1].end(),
-                                    Helpers::cmpPairBySecond<uint32_t, double>)
-                        - (metrics[obs_cnt - 1].begin());
+    vector<uint32_t> path(obs_cnt);
 
-    for (int32_t o = obs_cnt - 2; o >= 0; o--) {
-        path[o] = metrics[o + 1][path[o + 1]].first;
+    /* regions start at observations with a single possible state */
+    vector<uint32_t> starts = { 0 };
+    uint32_t region_min = max(VITERBI_REGION_MIN, obs_cnt / (threads * VITERBI_REGIONS_PER_THREAD));
+
+    for (uint32_t o = 1; (threads > 1) && (o < obs_cnt - 1); o++) {
+        if ((o - starts.back() >= region_min) && (Anchor_(obs[o]) >= 0)) {
+            starts.push_back(o);
+        }
     }
 
+    /*
+     * Metrics of all the regions are allocated up front, threads only write
+     * to their own part. Neighbouring regions share an observation, so every
+     * region gets a row more.
+     */
+    state_metric_t *metrics = arena->Allocate<state_metric_t>(
+            (static_cast<size_t>(obs_cnt) + starts.size()) * states_cnt);
+
+    if (starts.size() == 1) {
+        Decode_(init_p, obs, log_trans, 0, obs_cnt - 1, metrics, path);
+        return path;
+    }
+
+    unique_ptr<ThreadPool> call_pool;
+
+    if (pool == nullptr) {
+        call_pool.reset(new ThreadPool(min<uint32_t>(threads, starts.size())));
+        pool = call_pool.get();
+    }
+
+    pool->Run(starts.size(), [&](uint32_t r) {
+        uint32_t begin = starts[r];
+        uint32_t end = (r + 1 < starts.size()) ? starts[r + 1] : obs_cnt - 1;
+        vector<prob_t> region_init_p(states_cnt, 0);
+        vector<uint32_t> region_path;
+
+        if (r == 0) {
+            region_init_p = init_p;
+        } else {
+            region_init_p[Anchor_(obs[begin])] = 1;
+        }
+
+        Decode_(region_init_p, obs, log_trans, begin, end,
+                metrics + (static_cast<size_t>(begin) + r) * states_cnt, region_path);
+
+        /* shared anchor observation is written by the region it starts */
+        uint32_t len = (r + 1 < starts.size()) ? end - begin : end - begin + 1;
+        copy(region_path.begin(), region_path.begin() + len, path.begin() + begin);
+    });
+
     return path;
 }
+
+Viterbi::Incremental::Incremental(const vector<prob_t> &init_p, const prob_matrix_t &trans_p)
+{
+    ValidateInitProbs_(init_p);
+    ValidateMatrix_(trans_p);
+
+    states_cnt_ = init_p.size();
+
+    if ((trans_p.size() != states_cnt_) || (trans_p[0].size() != states_cnt_)) {
+        throw invalid_argument("Incremental(): wrong transition matrix dimensions");
+    }
+
+    init_p_ = init_p;
+    log_trans_.resize(static_cast<size_t>(states_cnt_) * states_cnt_);
+
+    for (uint32_t from = 0; from < states_cnt_; from++) {
+        for (uint32_t to = 0; to < states_cnt_; to++) {
+            log_trans_[from * states_cnt_ + to] = log(trans_p[from][to]);
+        }
+    }
+
+    decoded_ = 0;
+}
+
+uint32_t Viterbi::Incremental::Update(const prob_matrix_t &obs, uint32_t from, uint32_t to)
+{
+    LM_STATS_SCOPE("viterbi");
+
+    uint32_t obs_cnt = obs.size();
+    uint32_t old_cnt = path_.size();
+
+    if (from >= to) {
+        from = to = old_cnt;
+    }
+
+    /* anything past the previous sequence is new */
+    uint32_t begin = min(from, old_cnt);
+    uint32_t changed = min(old_cnt, obs_cnt);
+
+    decoded_ = 0;
+
+    if (obs_cnt == 0) {
+        Reset();
+        return 0;
+    }
+
+    if ((begin >= obs_cnt) && (obs_cnt == old_cnt)) {
+        return obs_cnt;
+    }
+
+    for (uint32_t o = begin; o < obs_cnt; o++) {
+        if ((o >= to) && (o < old_cnt)) {
+            continue;
+        }
+        if ((obs[o].size() != states_cnt_) || !ValidateProbVector_(obs[o])) {
+            throw invalid_argument("Update(): invalid observation");
+        }
+    }
+
+    LM_STATS_FRAMES(obs_cnt - min(begin, obs_cnt));
+
+    metrics_.resize(static_cast<size_t>(obs_cnt) * states_cnt_);
+    path_.resize(obs_cnt);
+
+    /* path after it is known to be the same */
+    uint32_t known = obs_cnt;
+
+    for (uint32_t o = begin; o < obs_cnt; o++) {
+        state_metric_t *cur = metrics_.data() + static_cast<size_t>(o) * states_cnt_;
+
+        if (o == 0) {
+            for (uint32_t state = 0; state < states_cnt_; state++) {
+                cur[state] = make_pair(0, log(init_p_[state] * obs[0][state]));
+            }
+        } else {
+            Step_(cur - states_cnt_, obs[o], log_trans_.data(), states_cnt_, cur);
+        }
+        decoded_++;
+
+        /* metrics after an unchanged anchor are the same as before */
+        if ((o >= to) && (o + 1 < old_cnt) && (Anchor_(obs[o]) >= 0)) {
+            if (obs_cnt > old_cnt) {
+                o = old_cnt - 1;
+            } else {
+                known = (obs_cnt == old_cnt) ? o + 1 : obs_cnt;
+                break;
+            }
+        }
+    }
+
+    int64_t o = known - 1;
+    bool same;
+
+    if (known == obs_cnt) {
+        const state_metric_t *last = metrics_.data() + static_cast<size_t>(o) * states_cnt_;
+        uint32_t state = max_element(last, last + states_cnt_,
+                                     Helpers::cmpPairBySecond<uint32_t, double>) - last;
+
+        same = (o < old_cnt) && (path_[o] == state);
+        path_[o] = state;
+    } else {
+        o = known;
+        same = true;
+    }
+
+    if (!same) {
+        changed = o;
+    }
+
+    for (o--; o >= 0; o--) {
+        /* rest of the path follows unchanged metrics from an unchanged state */
+        if (same && (o + 1 < begin)) {
+            break;
+        }
+
+        uint32_t state = metrics_[static_cast<size_t>(o + 1) * states_cnt_ + path_[o + 1]].first;
+
+        same = (o < old_cnt) && (path_[o] == state);
+        if (!same) {
+            changed = o;
+        }
+        path_[o] = state;
+    }
+
+    return changed;
+}
+
+const vector<uint32_t> & Viterbi::Incremental::Path() const
+{
+    return path_;
+}
+
+uint32_t Viterbi::Incremental::Decoded() const
+{
+    return decoded_;
+}
+
+void Viterbi::Incremental::Reset()
+{
+    metrics_.clear();
+    path_.clear();
+}
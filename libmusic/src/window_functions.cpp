@@ -31,18 +31,27 @@
 using namespace std;
 
 vector<amplitude_t> WindowFunctions::getHamming(uint32_t len, uint32_t offset)
+{
+    vector<amplitude_t> win(len);
+
+    getHamming(len, offset, win.data());
+
+    return win;
+}
+
+void WindowFunctions::getHamming(uint32_t len, uint32_t offset, amplitude_t *win)
 {
     if (offset >= len) {
         throw invalid_argument("getHamming(): offset >= len");
     }
 
-    vector<amplitude_t> win(len);
+    for (uint32_t i = 0; i < offset; i++) {
+        win[i] = 0;
+    }
 
     for (uint32_t i = offset; i < len; i++) {
         win[i] = (0.54 - 0.46 * cos(2 * M_PI * i / (len - 1)));
     }
-
-    return win;
 }
 
 void WindowFunctions::applyHamming(td_t &td)
@@ -71,16 +80,27 @@ void WindowFunctions::applyHann(td_t &td)
 
 void WindowFunctions::applyDefault(td_t &td)
 {
-#if !defined(CFG_WINDOW_FUNC) || (CFG_WINDOW_FUNC == WINDOW_FUNC_RECTANGULAR)
-    /* rectangular is a default. Do nothing for it */
-    UNUSED(td);
-#elif CFG_WINDOW_FUNC == WINDOW_FUNC_BLACKMAN
-    applyBlackman(td);
-#elif CFG_WINDOW_FUNC == WINDOW_FUNC_HAMMING
-    applyHamming(td);
-#elif CFG_WINDOW_FUNC == WINDOW_FUNC_HANN
-    applyHann(td);
-#endif
+    apply(td, CFG_WINDOW_FUNC);
+}
+
+void WindowFunctions::apply(td_t &td, uint32_t fcode)
+{
+    switch (fcode) {
+        case WINDOW_FUNC_RECTANGULAR:
+            /* rectangular is a default. Do nothing for it */
+            break;
+        case WINDOW_FUNC_BLACKMAN:
+            applyBlackman(td);
+            break;
+        case WINDOW_FUNC_HAMMING:
+            applyHamming(td);
+            break;
+        case WINDOW_FUNC_HANN:
+            applyHann(td);
+            break;
+        default:
+            throw std::invalid_argument("Invalid window function");
+    }
 }
 
 const char * WindowFunctions::toString(uint32_t fcode)
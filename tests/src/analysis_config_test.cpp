@@ -0,0 +1,151 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cmath>
+
+#include "cute.h"
+
+#include "chord_detector.h"
+#include "analysis_config_test.h"
+
+#define TEST_SAMPLERATE     44100
+
+
+using namespace anatomist;
+using namespace std;
+
+/**
+ * Presets are valid, unknown ones and inconsistent parameters are rejected
+ */
+void TestAnalysisPresets::__test()
+{
+    ASSERTM("No presets", !AnalysisConfig::Presets().empty());
+
+    for (auto &name : AnalysisConfig::Presets()) {
+        AnalysisConfig::Preset(name).Validate();
+    }
+
+    ASSERT_THROWSM("Unknown preset", AnalysisConfig::Preset("fastest"), invalid_argument);
+
+    AnalysisConfig config;
+
+    config.Validate();
+    ASSERT_EQUALM("Hop size", config.win_size / config.hops_per_window, config.HopSize());
+
+    config.hops_per_window = 3;
+    ASSERT_THROWSM("Window does not split into hops", config.Validate(), invalid_argument);
+
+    config = AnalysisConfig();
+    config.win_size = 100;
+    ASSERT_THROWSM("Window is too short", config.Validate(), invalid_argument);
+
+    config = AnalysisConfig();
+    config.self_transition_p = 1;
+    ASSERT_THROWSM("Self-transition probability", config.Validate(), invalid_argument);
+
+    config = AnalysisConfig();
+    config.tft_type = 100;
+    ASSERT_THROWSM("Detector with invalid config", ChordDetector cd(config), invalid_argument);
+}
+
+/**
+ * Every preset recognises a sustained triad, the more accurate and the
+ * low-latency ones with shorter frames
+ */
+void TestAnalysisConfigDetector::__test()
+{
+    const freq_hz_t notes[] = { 130.81, 164.81, 196.0 };   /* C3 E3 G3 */
+    td_t td(TEST_SAMPLERATE * 6, 0);
+    uint32_t prev_interval = UINT32_MAX;
+
+    for (uint32_t i = 0; i < td.size(); i++) {
+        for (freq_hz_t f : notes) {
+            for (uint32_t h = 1; h <= 3; h++) {
+                td[i] += 0.1 / h * sin(2 * M_PI * f * h * i / TEST_SAMPLERATE);
+            }
+        }
+    }
+
+    for (auto &name : AnalysisConfig::Presets()) {
+        ChordDetector cd(AnalysisConfig::Preset(name));
+        vector<segment_t> segments;
+        uint32_t interval = 0;
+        const segment_t *longest = nullptr;
+
+        ASSERT_EQUALM("Detector keeps the config", AnalysisConfig::Preset(name).win_size,
+                      cd.GetConfig().win_size);
+
+        cd.GetChromagram(td, TEST_SAMPLERATE, &interval);
+        ASSERTM("Frames of " + name + " are not shorter", interval <= prev_interval);
+        prev_interval = interval;
+
+        cd.getSegments(segments, td, TEST_SAMPLERATE);
+        ASSERTM("No segments with " + name, !segments.empty());
+
+        for (auto &s : segments) {
+            if (!s.silence && ((longest == nullptr) ||
+                               (s.endIdx - s.startIdx > longest->endIdx - longest->startIdx)))
+            {
+                longest = &s;
+            }
+        }
+
+        ASSERTM("Only silence with " + name, longest != nullptr);
+        ASSERTM("Wrong chord with " + name, longest->chord.match(Chord(note_C, cq_maj)));
+    }
+}
+
+/**
+ * FFT frames overlapping by a hop are one hop apart and cover the signal once
+ */
+void TestAnalysisConfigFftHops::__test()
+{
+    AnalysisConfig config;
+    td_t td(TEST_SAMPLERATE * 10, 0);
+    uint32_t interval = 0;
+
+    config.tft_type = TFT_TYPE_FFT;
+    config.win_size = 4096;
+    config.hops_per_window = 2;
+    config.Validate();
+
+    for (uint32_t i = 0; i < td.size(); i++) {
+        td[i] = 0.3 * sin(2 * M_PI * 220.0 * i / TEST_SAMPLERATE);
+    }
+
+    ChordDetector cd(config);
+    chromagram_t chromagram = cd.GetChromagram(td, TEST_SAMPLERATE, &interval);
+
+    ASSERT_EQUALM("Interval is a hop", config.HopSize(), interval);
+    ASSERTM("No frames", !chromagram.empty());
+    /* the last frame starts within the signal */
+    ASSERTM("Frames run past the signal",
+            (uint64_t)(chromagram.size() - 1) * interval < td.size());
+    ASSERTM("Frames do not cover the signal",
+            (uint64_t)chromagram.size() * interval >= td.size());
+
+    vector<segment_t> segments;
+
+    cd.getSegments(segments, td, TEST_SAMPLERATE);
+    ASSERTM("No segments", !segments.empty());
+    ASSERTM("Segments run past the signal", segments.back().endIdx < td.size());
+    ASSERTM("Segments do not cover the signal",
+            segments.back().endIdx + 2 * config.win_size >= td.size());
+}
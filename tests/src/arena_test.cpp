@@ -0,0 +1,146 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cmath>
+#include <stdint.h>
+
+#include "cute.h"
+
+#include "arena_test.h"
+#include "chord_detector.h"
+
+#define TEST_SAMPLERATE     44100
+
+
+using namespace anatomist;
+using namespace std;
+
+/**
+ * Allocations are aligned, do not overlap and may exceed the block size
+ */
+void TestArenaAllocate::__test()
+{
+    Arena arena(256);
+
+    ASSERT_EQUALM("Memory allocated up front", (size_t)0, arena.Capacity());
+
+    char *c = arena.Allocate<char>(3);
+    double *d = arena.Allocate<double>(10);
+    uint64_t *big = arena.Allocate<uint64_t>(1000);
+
+    ASSERTM("Misaligned", reinterpret_cast<uintptr_t>(d) % alignof(double) == 0);
+    ASSERTM("Misaligned", reinterpret_cast<uintptr_t>(big) % alignof(uint64_t) == 0);
+    ASSERTM("Overlap", (c + 3 <= reinterpret_cast<char *>(d)) ||
+                       (reinterpret_cast<char *>(d + 10) <= c));
+
+    for (uint32_t i = 0; i < 1000; i++) {
+        big[i] = i;
+    }
+    for (uint32_t i = 0; i < 10; i++) {
+        d[i] = -1;
+    }
+
+    ASSERT_EQUALM("Overwritten", (uint64_t)999, big[999]);
+    ASSERTM("Allocation is larger than the capacity", arena.Capacity() >= 8000);
+}
+
+/**
+ * Released arena serves the same allocations again from a single block, and
+ * detector reusing its arena gives the same results
+ */
+void TestArenaRelease::__test()
+{
+    Arena arena(256);
+
+    for (uint32_t i = 0; i < 100; i++) {
+        arena.Allocate<double>(100);
+    }
+
+    size_t capacity = arena.Capacity();
+
+    arena.Release();
+    ASSERT_EQUALM("Released memory is not kept", capacity, arena.Capacity());
+
+    for (uint32_t i = 0; i < 100; i++) {
+        arena.Allocate<double>(100);
+    }
+    ASSERT_EQUALM("Arena grew for the same allocations", capacity, arena.Capacity());
+
+    {
+        ArenaScope scope(arena);
+        arena.Allocate<double>(100);
+    }
+
+    void *p = arena.Allocate(1, 1);
+    arena.Release();
+    ASSERT_EQUALM("Scope did not release", p, arena.Allocate(1, 1));
+
+    const freq_hz_t roots[] = { 261.63, 220.0, 174.61, 196.0 };
+    td_t td(TEST_SAMPLERATE * 8, 0);
+    ChordDetector cd;
+    vector<segment_t> first, second;
+
+    for (uint32_t i = 0; i < td.size(); i++) {
+        freq_hz_t root = roots[(i / (2 * TEST_SAMPLERATE)) % 4];
+
+        for (double ratio : { 1.0, 1.26, 1.5 }) {
+            td[i] += 0.2 * sin(2 * M_PI * root * ratio * i / TEST_SAMPLERATE);
+        }
+    }
+
+    cd.getSegments(first, td.data(), td.size(), TEST_SAMPLERATE);
+    cd.getSegments(second, td.data(), td.size(), TEST_SAMPLERATE);
+
+    ASSERT_EQUALM("Same number of segments", first.size(), second.size());
+    for (uint32_t i = 0; i < first.size(); i++) {
+        ASSERT_EQUALM("Same start", first[i].startIdx, second[i].startIdx);
+        ASSERTM("Same chord", first[i].chord == second[i].chord);
+    }
+}
+
+/**
+ * Release() keeps no more than the limit, the arena grows past it again
+ */
+void TestArenaLimit::__test()
+{
+    Arena arena(256, 4096);
+
+    for (uint32_t i = 0; i < 100; i++) {
+        arena.Allocate<double>(100);
+    }
+    ASSERTM("Arena did not grow past the limit", arena.Capacity() > 4096);
+
+    arena.Release();
+    ASSERT_EQUALM("Limit is not kept", (size_t)4096, arena.Capacity());
+
+    double *d = arena.Allocate<double>(100);
+    d[99] = 1;
+    ASSERT_EQUALM("Retained block is not reused", (size_t)4096, arena.Capacity());
+
+    arena.Allocate<double>(1000);
+    ASSERTM("Arena did not grow again", arena.Capacity() > 4096);
+
+    Arena small(256, 0);
+
+    small.Allocate<double>(100);
+    small.Release();
+    ASSERT_EQUALM("Memory is kept with no limit", (size_t)0, small.Capacity());
+    ASSERTM("Released arena does not allocate", small.Allocate<double>(100) != nullptr);
+}
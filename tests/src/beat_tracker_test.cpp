@@ -0,0 +1,146 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "cute.h"
+
+#include "beat_tracker_test.h"
+
+#define TEST_SAMPLERATE     44100
+#define TEST_BLOCK_SIZE     1000
+
+
+using namespace anatomist;
+using namespace std;
+
+td_t BeatTrackerTestHelper::clickTrack(uint32_t samplerate, float bpm, float seconds)
+{
+    td_t td(samplerate * seconds, 0);
+    uint32_t interval = samplerate * 60 / bpm;
+    uint32_t click_len = samplerate / 100;
+
+    for (uint32_t beat = 0; beat < td.size(); beat += interval) {
+        for (uint32_t i = 0; i < click_len && beat + i < td.size(); i++) {
+            /* decaying 1 kHz burst */
+            td[beat + i] = sin(2 * M_PI * 1000 * i / samplerate) * (1 - 1.0 * i / click_len);
+        }
+    }
+
+    return td;
+}
+
+void TestClickTrackTempo::__test()
+{
+    td_t td = BeatTrackerTestHelper::clickTrack(TEST_SAMPLERATE, 120, 20);
+    BeatTracker bt(TEST_SAMPLERATE);
+
+    for (uint32_t i = 0; i < td.size(); i += TEST_BLOCK_SIZE) {
+        bt.Process(td.data() + i, min(TEST_BLOCK_SIZE, static_cast<int>(td.size() - i)), nullptr);
+    }
+
+    ASSERT_EQUAL_DELTAM("Tempo of a 120 BPM click track", 120, bt.GetBPM(), 2);
+}
+
+void TestClickTrackBeats::__test()
+{
+    uint32_t interval = TEST_SAMPLERATE / 2;
+    td_t td = BeatTrackerTestHelper::clickTrack(TEST_SAMPLERATE, 120, 20);
+    BeatTracker bt(TEST_SAMPLERATE);
+    vector<uint32_t> beats;
+
+    for (uint32_t i = 0; i < td.size(); i += TEST_BLOCK_SIZE) {
+        bt.Process(td.data() + i, min(TEST_BLOCK_SIZE, static_cast<int>(td.size() - i)), &beats);
+    }
+
+    ASSERTM("Too few beats detected", beats.size() > 30);
+
+    for (uint32_t i = 1; i < beats.size(); i++) {
+        uint32_t d = min(beats[i] % interval, interval - beats[i] % interval);
+
+        ASSERTM("Beat is too far from the click", d < CFG_BEAT_TRACKER_HOP_SIZE * 2);
+        ASSERTM("Beats are not increasing", beats[i] > beats[i - 1]);
+    }
+}
+
+void TestBeatSyncColumns::__test()
+{
+    uint32_t interval = 1024;
+    td_t td = BeatTrackerTestHelper::clickTrack(TEST_SAMPLERATE, 120, 20);
+    uint32_t frames = (td.size() + interval - 1) / interval;
+    vector<uint32_t> columns = ChordDetector::BeatColumns(SignalView(td.data(), td.size()),
+                                                          TEST_SAMPLERATE, interval, frames);
+
+    ASSERTM("No columns found", columns.size() > 2);
+    ASSERT_EQUALM("Columns do not start at the first frame", 0, columns.front());
+    ASSERT_EQUALM("Columns do not end at the last frame", frames, columns.back());
+
+    /* inner boundaries lie on the clicks, beats detected before lock included */
+    for (uint32_t i = 1; i + 1 < columns.size(); i++) {
+        uint32_t idx = columns[i] * interval;
+        uint32_t beat = TEST_SAMPLERATE / 2;
+        uint32_t d = min(idx % beat, beat - idx % beat);
+
+        ASSERTM("Column boundary is too far from the click", d < interval * 2);
+        ASSERTM("Columns are not increasing", columns[i] > columns[i - 1]);
+    }
+
+    ASSERTM("Beat grid does not cover the recording",
+            columns.size() > 20 * 2 - 2);
+}
+
+void TestBeatSyncPooling::__test()
+{
+    chromagram_t chromagram;
+    vector<uint32_t> columns = { 0, 3, 5 };
+    vector<bool> silent;
+
+    chromagram.push_back(pcp_t(vector<amplitude_t>{ 1, 0 }));
+    chromagram.push_back(pcp_t(vector<amplitude_t>{ 0, 4 }));
+    chromagram.push_back(pcp_t(vector<amplitude_t>{ 5, 2 }));
+    chromagram.push_back(pcp_t(vector<amplitude_t>{ 9, 9 }));
+    chromagram.push_back(pcp_t(vector<amplitude_t>{ 9, 9 }));
+
+    silent = { false, false, false, true, true };
+    chromagram_t mean = ChordDetector::PoolChromagram(chromagram, columns, BEAT_SYNC_MEAN, &silent);
+
+    ASSERT_EQUALM("Wrong number of columns", 2, mean.size());
+    ASSERT_EQUALM("Wrong number of silence flags", 2, silent.size());
+    ASSERTM("Column with sound is silent", !silent[0]);
+    ASSERTM("Column of silent frames is not silent", silent[1]);
+    ASSERT_EQUAL_DELTAM("Wrong mean", 2, mean[0].getValues()[0], 1e-9);
+    ASSERT_EQUAL_DELTAM("Wrong mean", 2, mean[0].getValues()[1], 1e-9);
+
+    silent = { false, false, false, true, true };
+    chromagram_t median = ChordDetector::PoolChromagram(chromagram, columns, BEAT_SYNC_MEDIAN,
+                                                        &silent);
+
+    ASSERT_EQUAL_DELTAM("Wrong median", 1, median[0].getValues()[0], 1e-9);
+    ASSERT_EQUAL_DELTAM("Wrong median", 2, median[0].getValues()[1], 1e-9);
+
+    /* silent frames do not take part in pooling */
+    silent = { false, true, false, false, true };
+    chromagram_t max = ChordDetector::PoolChromagram(chromagram, columns, BEAT_SYNC_MAX, &silent);
+
+    ASSERT_EQUAL_DELTAM("Wrong max", 5, max[0].getValues()[0], 1e-9);
+    ASSERT_EQUAL_DELTAM("Wrong max", 2, max[0].getValues()[1], 1e-9);
+    ASSERT_EQUAL_DELTAM("Wrong max", 9, max[1].getValues()[1], 1e-9);
+    ASSERTM("Column with sound is silent", !silent[1]);
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "beat_tracker.h"
+#include "chord_detector.h"
+
+
+class BeatTrackerTestHelper {
+public:
+    static td_t clickTrack(uint32_t samplerate, float bpm, float seconds);
+};
+
+class TestClickTrackTempo {
+private:
+    void __test();
+
+public:
+    void operator()() { __test(); };
+};
+
+class TestClickTrackBeats {
+private:
+    void __test();
+
+public:
+    void operator()() { __test(); };
+};
+
+class TestBeatSyncColumns {
+private:
+    void __test();
+
+public:
+    void operator()() { __test(); };
+};
+
+class TestBeatSyncPooling {
+private:
+    void __test();
+
+public:
+    void operator()() { __test(); };
+};
@@ -0,0 +1,243 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "cute.h"
+
+#include "chord_eval_test.h"
+
+#define TEST_EPS    1e-9
+
+
+using namespace anatomist;
+using namespace std;
+
+static lab_segment_t seg(double start, double end, const chord_t &chord, bool known = true)
+{
+    lab_segment_t s;
+
+    s.start = start;
+    s.end = end;
+    s.chord = chord;
+    s.known = known;
+
+    return s;
+}
+
+static bool near(double a, double b)
+{
+    return fabs(a - b) < TEST_EPS;
+}
+
+/**
+ * Lines are parsed into segments, empty ones are skipped, unparsable labels
+ * are kept as unknown chords
+ */
+void TestChordEvalReadLab::__test()
+{
+    char path[] = "/tmp/lmeval_test_XXXXXX";
+    int fd = mkstemp(path);
+
+    ASSERTM("Failed to create a temporary file", fd >= 0);
+
+    const char text[] = "0.0 1.5 C\n"
+                        "1.5\t3.25\tA:min7\r\n"
+                        "\n"
+                        "3.25 3.25 G\n"
+                        "3.25 4.0 ?\n"
+                        "4.0 5.0 N";
+    ASSERT_EQUALM("Short write", (ssize_t)(sizeof(text) - 1), write(fd, text, sizeof(text) - 1));
+    close(fd);
+
+    lab_t lab = ChordEval::ReadLab(path);
+
+    ASSERT_EQUALM("Empty segments are kept", (size_t)4, lab.size());
+    ASSERTM("Start", near(1.5, lab[1].start));
+    ASSERTM("End", near(3.25, lab[1].end));
+    ASSERTM("Chord", lab[0].known && (lab[0].chord == Chord(note_C, cq_maj)));
+    ASSERTM("Chord after tabs", lab[1].known && (lab[1].chord == Chord(note_A, cq_min7)));
+    ASSERTM("Unparsable label", !lab[2].known);
+    ASSERTM("No chord", lab[3].known && (lab[3].chord.rootNote() == note_Unknown));
+
+    FILE *f = fopen(path, "w");
+    fputs("0.0 1.0 C\n1.0 D\n", f);
+    fclose(f);
+    ASSERT_THROWSM("Malformed line", ChordEval::ReadLab(path), runtime_error);
+
+    unlink(path);
+    ASSERT_THROWSM("Missing file", ChordEval::ReadLab(path), runtime_error);
+}
+
+/**
+ * Annotation is sorted, clipped to the span and gaps are filled with no
+ * chord
+ */
+void TestChordEvalAdjust::__test()
+{
+    const chord_t c(note_C, cq_maj), g(note_G, cq_maj), n;
+
+    lab_t lab = ChordEval::Adjust_({ seg(2, 5, g), seg(-1, 1, c) }, 0, 4);
+
+    ASSERT_EQUALM("Clipped and padded", (size_t)3, lab.size());
+    ASSERTM("Start is clipped", near(0, lab[0].start) && near(1, lab[0].end) && lab[0].chord == c);
+    ASSERTM("Gap", near(1, lab[1].start) && near(2, lab[1].end) && lab[1].chord == n &&
+                   lab[1].known);
+    ASSERTM("End is clipped", near(2, lab[2].start) && near(4, lab[2].end) && lab[2].chord == g);
+
+    lab = ChordEval::Adjust_({ seg(0, 3, c), seg(2, 5, g) }, 0, 5);
+
+    ASSERT_EQUALM("Overlap", (size_t)2, lab.size());
+    ASSERTM("Later segment starts where the earlier ends", near(3, lab[1].start));
+
+    lab = ChordEval::Adjust_({ seg(1, 2, c) }, 0, 4);
+
+    ASSERT_EQUALM("Padded on both sides", (size_t)3, lab.size());
+    ASSERTM("Head gap", near(0, lab[0].start) && near(1, lab[0].end) && lab[0].chord == n);
+    ASSERTM("Tail gap", near(2, lab[2].start) && near(4, lab[2].end) && lab[2].chord == n);
+
+    lab = ChordEval::Adjust_({ seg(5, 6, c) }, 0, 4);
+
+    ASSERT_EQUALM("Segment past the end", (size_t)1, lab.size());
+    ASSERTM("All no chord", near(0, lab[0].start) && near(4, lab[0].end) && lab[0].chord == n);
+}
+
+/**
+ * Segments overlapping partially are scored for the overlapping parts
+ *
+ * ref: C [0, 2)  G [2, 4)
+ * est: C [0, 1)  A:min [1, 3)  G [3, 4)
+ */
+void TestChordEvalOverlap::__test()
+{
+    const chord_t c(note_C, cq_maj), g(note_G, cq_maj), am(note_A, cq_min), cm(note_C, cq_min);
+
+    eval_result_t r = ChordEval::Evaluate({ seg(0, 2, c), seg(2, 4, g) },
+                                          { seg(0, 1, c), seg(1, 3, am), seg(3, 4, g) });
+
+    ASSERTM("Duration", near(4, r.duration));
+    ASSERTM("Known", near(4, r.known));
+    ASSERTM("Root", near(2, r.root));
+    ASSERTM("MajMin", near(2, r.majmin) && near(4, r.majmin_known));
+    ASSERTM("PC set", near(2, r.pcset));
+    ASSERTM("Score", near(0.5, r.MajMin()));
+
+    /* same root, other quality: [0, 1) of C against C:min */
+    r = ChordEval::Evaluate({ seg(0, 2, c) }, { seg(0, 1, cm), seg(1, 2, c) });
+
+    ASSERTM("Root ignores quality", near(2, r.root));
+    ASSERTM("MajMin compares quality", near(1, r.majmin));
+
+    /* unknown reference chords do not count */
+    r = ChordEval::Evaluate({ seg(0, 1, c), seg(1, 3, chord_t(), false) }, { seg(0, 3, c) });
+
+    ASSERTM("Duration with unknown", near(3, r.duration));
+    ASSERTM("Known duration", near(1, r.known) && near(1, r.majmin_known));
+    ASSERTM("Unknown is not scored", near(1, r.Root()));
+}
+
+/**
+ * Parts the estimate does not cover are no chord, reference defines the span
+ */
+void TestChordEvalPadding::__test()
+{
+    const chord_t c(note_C, cq_maj), g(note_G, cq_maj), n;
+
+    /* est: N [0, 1.5) C [1.5, 3) N [3, 4) after padding, wrong in [1, 1.5) */
+    eval_result_t r = ChordEval::Evaluate({ seg(0, 1, n), seg(1, 3, c), seg(3, 4, n) },
+                                          { seg(1.5, 3, c) });
+
+    ASSERTM("Gaps match no chord", near(3.5, r.root));
+    ASSERTM("Gaps in MajMin", near(3.5, r.majmin) && near(4, r.majmin_known));
+
+    /* reference longer than the estimate */
+    r = ChordEval::Evaluate({ seg(0, 10, c) }, { seg(0, 5, c) });
+
+    ASSERTM("Duration of the reference", near(10, r.duration));
+    ASSERTM("Missing estimate is wrong", near(5, r.root) && near(0.5, r.Root()));
+
+    /* reference shorter than the estimate, which is clipped */
+    r = ChordEval::Evaluate({ seg(1, 4, c) }, { seg(-1, 2, c), seg(2, 6, g) });
+
+    ASSERTM("Duration is not extended", near(3, r.duration) && near(3, r.known));
+    ASSERTM("Estimate is clipped", near(1, r.root));
+
+    /* reference starting late is not padded */
+    r = ChordEval::Evaluate({ seg(2, 3, c) }, { seg(0, 3, c) });
+
+    ASSERTM("Span starts with the reference", near(1, r.duration) && near(1, r.Root()));
+}
+
+/**
+ * Sevenths vocabulary maps extensions to sevenths and skips other chords,
+ * MajMin compares triads
+ *
+ * ref: C:7 [0, 1)  C:maj7 [1, 2)  C:min9 [2, 3)  C:sus4 [3, 4)
+ * est: C:7         C:maj          C:min7         C:sus4
+ */
+void TestChordEvalSevenths::__test()
+{
+    eval_result_t r = ChordEval::Evaluate(
+        { seg(0, 1, chord_t(note_C, cq_7)), seg(1, 2, chord_t(note_C, cq_maj7)),
+          seg(2, 3, chord_t(note_C, cq_min9)), seg(3, 4, chord_t(note_C, cq_sus4)) },
+        { seg(0, 1, chord_t(note_C, cq_7)), seg(1, 2, chord_t(note_C, cq_maj)),
+          seg(2, 3, chord_t(note_C, cq_min7)), seg(3, 4, chord_t(note_C, cq_sus4)) });
+
+    ASSERTM("Sevenths", near(2, r.sevenths));
+    ASSERTM("Sus4 is not in sevenths", near(3, r.sevenths_known));
+    ASSERTM("Triads", near(3, r.majmin));
+    ASSERTM("Sus4 is not in MajMin", near(3, r.majmin_known));
+    ASSERTM("Root", near(4, r.root));
+    ASSERTM("Sevenths score", near(2.0 / 3, r.Sevenths()));
+}
+
+/**
+ * Segmentation is 1 - the larger of the two directional Hamming distances
+ */
+void TestChordEvalSegmentation::__test()
+{
+    const chord_t c(note_C, cq_maj), g(note_G, cq_maj), am(note_A, cq_min);
+
+    /*
+     * ref -> est: [0, 2) and [2, 4) have 1 out of their longest overlaps
+     * est -> ref: [1, 3) has 1 out of its longest overlap
+     */
+    eval_result_t r = ChordEval::Evaluate({ seg(0, 2, c), seg(2, 4, g) },
+                                          { seg(0, 1, c), seg(1, 3, am), seg(3, 4, g) });
+
+    ASSERTM("Over-segmented", near(2, r.seg) && near(0.5, r.Seg()));
+
+    /* ref -> est: 1, est -> ref: 0 */
+    r = ChordEval::Evaluate({ seg(0, 4, c) }, { seg(0, 1, g), seg(1, 4, c) });
+
+    ASSERTM("Directional", near(3, r.seg) && near(0.75, r.Seg()));
+
+    /* ref -> est: 0, est -> ref: 1 */
+    r = ChordEval::Evaluate({ seg(0, 1, g), seg(1, 4, c) }, { seg(0, 4, c) });
+
+    ASSERTM("Other direction", near(3, r.seg));
+
+    /* neighbours with the same chord are one segment */
+    r = ChordEval::Evaluate({ seg(0, 2, c), seg(2, 4, c) }, { seg(0, 4, c) });
+
+    ASSERTM("Merged", near(4, r.seg) && near(1, r.Seg()));
+}
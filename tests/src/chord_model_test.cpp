@@ -0,0 +1,223 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "cute.h"
+
+#include "chord_detector.h"
+#include "chord_model_test.h"
+
+using namespace anatomist;
+using namespace std;
+
+/**
+ * Profile of a triad on \p root with the root in the bass
+ */
+static PitchClsProfile triadProfile(note_t root, bool minor)
+{
+    vector<amplitude_t> values(notes_Total * 2, 0);
+    int r = root - note_Min;
+    int treble = notes_Total;
+
+    values[r] = 1;
+    values[treble + r] = 1;
+    values[treble + (r + (minor ? 3 : 4)) % notes_Total] = 1;
+    values[treble + (r + 7) % notes_Total] = 1;
+
+    return PitchClsProfile(values);
+}
+
+static size_t stateOf(const ChordModel &model, const chord_t &chord)
+{
+    for (size_t s = 0; s < model.Size(); s++) {
+        if (model.States()[s] == chord) {
+            return s;
+        }
+    }
+
+    throw runtime_error("no state for " + chord.toString());
+}
+
+/**
+ * C C C X D D N, X is not annotated
+ */
+static void addRecording(ChordModelTrainer &trainer)
+{
+    chromagram_t chromagram;
+    vector<chord_t> chords;
+    vector<bool> known;
+
+    for (auto root : { note_C, note_C, note_C, note_E, note_D, note_D }) {
+        chromagram.push_back(triadProfile(root, false));
+        chords.push_back(Chord(root, cq_maj));
+        known.push_back(root != note_E);
+    }
+    chromagram.push_back(PitchClsProfile(vector<amplitude_t>(notes_Total * 2, 0)));
+    chords.push_back(Chord());
+    known.push_back(true);
+
+    trainer.Add(chromagram, chords, known);
+}
+
+void TestChordModelTrainer::__test()
+{
+    ChordModelTrainer trainer;
+
+    addRecording(trainer);
+
+    ASSERT_EQUALM("Recordings", 1U, trainer.Recordings());
+    ASSERT_EQUALM("Annotated frames", 6U, trainer.Frames());
+
+    ChordModel model = trainer.Model(0);
+
+    ASSERT_EQUALM("Major chord of every root and N", static_cast<size_t>(notes_Total) + 1, model.Size());
+    ASSERT_EQUALM("N is the last state", Chord(), model.States().back());
+
+    /* every root shares the statistics of C and D */
+    size_t f = stateOf(model, Chord(note_F, cq_maj));
+    size_t g = stateOf(model, Chord(note_G, cq_maj));
+    size_t n = model.Size() - 1;
+    const vector<amplitude_t> &tpl = model.Templates()[f];
+    vector<amplitude_t> expected = triadProfile(note_F, false).getValues();
+    amplitude_t scale = tpl[static_cast<int>(notes_Total) + (note_F - note_Min)];
+
+    for (size_t i = 0; i < tpl.size(); i++) {
+        ASSERT_EQUAL_DELTAM("Template is the profile rotated to the root",
+                            expected[i] * scale, tpl[i], 1e-9);
+    }
+
+    ASSERT_EQUAL_DELTAM("Initial probability", 1.0 / notes_Total, model.InitProbs()[f], 1e-9);
+    ASSERT_EQUAL_DELTAM("No initial N", 0, model.InitProbs()[n], 1e-9);
+
+    /* C -> C twice, D -> D and D -> N, nothing across the frame without annotation */
+    ASSERT_EQUAL_DELTAM("Self-transition", 3.0 / 4, model.TransProbs()[f][f], 1e-9);
+    ASSERT_EQUAL_DELTAM("Transition to N", 1.0 / 4, model.TransProbs()[f][n], 1e-9);
+    ASSERT_EQUAL_DELTAM("No transition up a tone", 0, model.TransProbs()[f][g], 1e-9);
+    ASSERT_EQUAL_DELTAM("Nothing is known about N", 1.0 / model.Size(),
+                        model.TransProbs()[n][f], 1e-9);
+}
+
+void TestChordModelReduction::__test()
+{
+    ChordModelTrainer single, first, second;
+    chromagram_t chromagram;
+    vector<chord_t> chords;
+
+    for (auto root : { note_A, note_A, note_F, note_G }) {
+        chromagram.push_back(triadProfile(root, root == note_A));
+        chords.push_back(Chord(root, (root == note_A) ? cq_min : cq_maj));
+    }
+    vector<bool> known(chords.size(), true);
+
+    addRecording(single);
+    single.Add(chromagram, chords, known);
+
+    addRecording(first);
+    second.Add(chromagram, chords, known);
+    first += second;
+
+    ChordModel a = single.Model(), b = first.Model();
+
+    ASSERT_EQUALM("Recordings", single.Recordings(), first.Recordings());
+    ASSERT_EQUALM("States", a.States(), b.States());
+    ASSERT_EQUALM("Templates", a.Templates(), b.Templates());
+    ASSERT_EQUALM("Initial probabilities", a.InitProbs(), b.InitProbs());
+    ASSERT_EQUALM("Transitions", a.TransProbs(), b.TransProbs());
+}
+
+void TestChordModelRoundTrip::__test()
+{
+    char path[] = "/tmp/lmhm_test_XXXXXX";
+    ChordModelTrainer trainer;
+    int fd = mkstemp(path);
+
+    if (fd < 0) {
+        throw runtime_error("Failed to create a temporary file");
+    }
+    close(fd);
+
+    addRecording(trainer);
+
+    ChordModel stored = trainer.Model();
+
+    stored.Save(path);
+
+    ChordModel loaded = ChordModel::Load(path);
+
+    ASSERT_EQUALM("States", stored.States(), loaded.States());
+    ASSERT_EQUALM("Templates", stored.Templates(), loaded.Templates());
+    ASSERT_EQUALM("Initial probabilities", stored.InitProbs(), loaded.InitProbs());
+    ASSERT_EQUALM("Transitions", stored.TransProbs(), loaded.TransProbs());
+
+    /* states of the header, after the magic and the version */
+    uint32_t huge = 0x40000000;
+    FILE *file = fopen(path, "r+b");
+
+    ASSERTM("Model is reopened", file != nullptr);
+    ASSERT_EQUALM("Header is overwritten", 0, fseek(file, 8, SEEK_SET));
+    ASSERT_EQUALM("Header is overwritten", 1U, fwrite(&huge, sizeof(huge), 1, file));
+    fclose(file);
+    ASSERT_THROWSM("Header beyond the file size is rejected before allocation",
+                   ChordModel::Load(path), runtime_error);
+
+    ASSERT_EQUALM("Truncated file", 0, truncate(path, 100));
+    ASSERT_THROWSM("Truncated file is rejected", ChordModel::Load(path), runtime_error);
+
+    unlink(path);
+}
+
+/**
+ * Model keeps the analysis parameters it was trained with, detectors of
+ * other parameters do not load it
+ */
+void TestChordModelParams::__test()
+{
+    char path[] = "/tmp/lmhm_test_XXXXXX";
+    AnalysisConfig balanced = AnalysisConfig::Preset("balanced");
+    AnalysisConfig fast = AnalysisConfig::Preset("fast");
+    string params = ChordDetector::FeatureParams(balanced);
+    ChordModelTrainer trainer(params), other(ChordDetector::FeatureParams(fast));
+    int fd = mkstemp(path);
+
+    if (fd < 0) {
+        throw runtime_error("Failed to create a temporary file");
+    }
+    close(fd);
+
+    ASSERTM("Presets of the same parameters", params != ChordDetector::FeatureParams(fast));
+
+    addRecording(trainer);
+    addRecording(other);
+    ASSERT_THROWSM("Trainers of other parameters are combined", trainer += other,
+                   invalid_argument);
+
+    trainer.Model().Save(path);
+    ASSERT_EQUALM("Parameters are not stored", params, ChordModel::Load(path).Params());
+
+    ChordDetector matching(balanced), mismatching(fast);
+
+    matching.SetModel(path);
+    ASSERT_THROWSM("Model of other parameters is loaded", mismatching.SetModel(path),
+                   invalid_argument);
+
+    unlink(path);
+}
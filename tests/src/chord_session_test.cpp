@@ -0,0 +1,165 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+
+#include "cute.h"
+
+#include "chord_session_test.h"
+
+#define TEST_SAMPLERATE     44100
+
+
+using namespace anatomist;
+using namespace std;
+
+/**
+ * Chords changing every couple of seconds starting from \p first, with a
+ * silent gap at \p gap
+ */
+static void SessionTestChords(td_t &td, size_t start, size_t end, uint32_t first, uint32_t gap)
+{
+    const freq_hz_t roots[] = { 261.63, 220.0, 174.61, 196.0 };
+
+    for (size_t i = start; i < end; i++) {
+        uint32_t sec = i / TEST_SAMPLERATE;
+        freq_hz_t root = roots[(first + sec / 2) % 4];
+
+        td[i] = 0;
+        if ((sec >= gap) && (sec < gap + 3)) {
+            continue;
+        }
+
+        for (double ratio : { 1.0, 1.26, 1.5 }) {
+            td[i] += 0.2 * sin(2 * M_PI * root * ratio * i / TEST_SAMPLERATE);
+        }
+    }
+}
+
+static void AssertSameSegments(const vector<segment_t> &expected, const vector<segment_t> &actual)
+{
+    ASSERT_EQUALM("Same number of segments", expected.size(), actual.size());
+    for (uint32_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQUALM("Same start", expected[i].startIdx, actual[i].startIdx);
+        ASSERT_EQUALM("Same end", expected[i].endIdx, actual[i].endIdx);
+        ASSERT_EQUALM("Same silence flag", expected[i].silence, actual[i].silence);
+        ASSERT_EQUALM("Same chord", true, expected[i].chord == actual[i].chord);
+    }
+}
+
+/**
+ * Most of the input around a change the transform is restarted with, in
+ * samples: context and alignment before it and frames past the end after it
+ */
+static size_t SessionTestSlack(ChordDetector &cd, size_t samples)
+{
+    size_t alignment = cd.ChunkAlignment(TEST_SAMPLERATE);
+    size_t from, to;
+
+    cd.ChunkInput(TEST_SAMPLERATE, samples, 2 * alignment, 3 * alignment, &from, &to);
+
+    return (2 * alignment - from) + (to - 3 * alignment) + alignment;
+}
+
+/**
+ * Recording appended piece by piece gives the same segments as analysed
+ * at once, and only the new part is analysed every time
+ */
+void TestSessionAppend::__test()
+{
+    td_t td(TEST_SAMPLERATE * 40);
+    ChordDetector cd, whole;
+    ChordSession session(cd, TEST_SAMPLERATE);
+    size_t slack = SessionTestSlack(cd, td.size());
+    uint32_t interval = 0;
+    size_t samples = 0;
+
+    SessionTestChords(td, 0, td.size(), 0, 20);
+    whole.GetChromagram(SignalView(td.data(), TEST_SAMPLERATE), TEST_SAMPLERATE, &interval);
+
+    ASSERT_EQUALM("Recording is longer than the restart context", true, td.size() > slack);
+
+    for (double sec : { 0.3, 2.5, 7.1, 13.0, 21.7, 30.0, 40.0 }) {
+        size_t len = min<size_t>(sec * TEST_SAMPLERATE, td.size());
+        vector<segment_t> expected;
+
+        session.Update(SignalView(td.data(), len));
+        whole.getSegments(expected, SignalView(td.data(), len), TEST_SAMPLERATE);
+
+        AssertSameSegments(expected, session.GetSegments());
+        ASSERT_EQUALM("Appended part is analysed", true,
+                      static_cast<size_t>(session.FramesAnalysed()) * interval <
+                      len - samples + slack);
+        samples = len;
+    }
+
+    session.Update(td);
+    ASSERT_EQUALM("Nothing analysed without changes", 0U, session.FramesAnalysed());
+    ASSERT_EQUALM("Nothing decoded without changes", 0U, session.FramesDecoded());
+}
+
+/**
+ * Edited, truncated and appended again recording gives the same segments
+ * as analysed at once
+ */
+void TestSessionEdit::__test()
+{
+    td_t td(TEST_SAMPLERATE * 60);
+    ChordDetector cd, whole;
+    ChordSession session(cd, TEST_SAMPLERATE);
+    size_t slack = SessionTestSlack(cd, td.size());
+    uint32_t interval = 0;
+    vector<segment_t> expected;
+
+    SessionTestChords(td, 0, td.size(), 0, 45);
+    whole.GetChromagram(SignalView(td.data(), TEST_SAMPLERATE), TEST_SAMPLERATE, &interval);
+    session.Update(td);
+
+    /* other chords over a few seconds */
+    SessionTestChords(td, TEST_SAMPLERATE * 6, TEST_SAMPLERATE * 10, 1, 45);
+    session.Invalidate(TEST_SAMPLERATE * 6, TEST_SAMPLERATE * 10);
+    session.Update(td);
+    whole.getSegments(expected, td, TEST_SAMPLERATE);
+
+    AssertSameSegments(expected, session.GetSegments());
+    ASSERT_EQUALM("Edited part is analysed", true,
+                  static_cast<size_t>(session.FramesAnalysed()) * interval <
+                  TEST_SAMPLERATE * 4 + slack + cd.ChunkAlignment(TEST_SAMPLERATE));
+    ASSERT_EQUALM("Decoding stops at the silence", true,
+                  static_cast<size_t>(session.FramesDecoded()) * interval < TEST_SAMPLERATE * 46);
+
+    /* truncated */
+    expected.clear();
+    session.Update(SignalView(td.data(), TEST_SAMPLERATE * 25));
+    whole.getSegments(expected, SignalView(td.data(), TEST_SAMPLERATE * 25), TEST_SAMPLERATE);
+
+    AssertSameSegments(expected, session.GetSegments());
+
+    /* appended again with a quiet take, which changes what is silent */
+    for (size_t i = TEST_SAMPLERATE * 25; i < td.size(); i++) {
+        td[i] *= 0.001;
+    }
+    expected.clear();
+    session.Update(td);
+    whole.getSegments(expected, td, TEST_SAMPLERATE);
+
+    AssertSameSegments(expected, session.GetSegments());
+
+    ASSERT_THROWSM("Empty range", session.Invalidate(10, 10), invalid_argument);
+}
@@ -19,8 +19,21 @@
 
 #pragma once
 
-#include "lmtypes.h"
+#include "chord_session.h"
 
-#define CHORD_TPLS_HMM_TRAINED 0
 
-std::map<note_t, std::map<chord_quality_t, std::vector<prob_t>>> hmm_training_res;
+class TestSessionAppend {
+private:
+    void __test();
+
+public:
+    void operator()() { __test(); };
+};
+
+class TestSessionEdit {
+private:
+    void __test();
+
+public:
+    void operator()() { __test(); };
+};
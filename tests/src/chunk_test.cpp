@@ -0,0 +1,146 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <sstream>
+
+#include "cute.h"
+
+#include "chunk_test.h"
+
+#define TEST_SAMPLERATE     44100
+
+
+using namespace anatomist;
+using namespace std;
+
+/**
+ * Chords changing every couple of seconds with a silent gap in the middle
+ */
+static td_t ChunkTestSignal(uint32_t seconds)
+{
+    const freq_hz_t roots[] = { 261.63, 220.0, 174.61, 196.0 };
+    td_t td(TEST_SAMPLERATE * seconds, 0);
+
+    for (uint32_t i = 0; i < td.size(); i++) {
+        uint32_t sec = i / TEST_SAMPLERATE;
+        freq_hz_t root = roots[(sec / 2) % 4];
+
+        if ((sec >= seconds / 2) && (sec < seconds / 2 + 3)) {
+            continue;
+        }
+
+        for (double ratio : { 1.0, 1.26, 1.5 }) {
+            td[i] += 0.2 * sin(2 * M_PI * root * ratio * i / TEST_SAMPLERATE);
+        }
+    }
+
+    return td;
+}
+
+/**
+ * Merged chunks give the same segments as the whole recording
+ */
+void TestChunkMerge::__test()
+{
+    td_t td = ChunkTestSignal(40);
+    ChordDetector cd;
+    vector<segment_t> expected, actual;
+    vector<chunk_t> chunks;
+    size_t alignment = cd.ChunkAlignment(TEST_SAMPLERATE);
+
+    cd.getSegments(expected, td.data(), td.size(), TEST_SAMPLERATE);
+
+    ASSERT_EQUALM("Recording is longer than a chunk", true, td.size() > alignment);
+    ASSERT_THROWSM("Unaligned chunk", cd.AnalyzeChunk(td, TEST_SAMPLERATE, td.size(), 1, td.size()),
+                   invalid_argument);
+
+    /* in reverse order, merging does not depend on it */
+    for (size_t end = td.size(); end > 0; ) {
+        size_t start = (end - 1) / alignment * alignment;
+        size_t from, to;
+
+        cd.ChunkInput(TEST_SAMPLERATE, td.size(), start, end, &from, &to);
+        chunks.push_back(cd.AnalyzeChunk(SignalView(td).Sub(from, to - from), TEST_SAMPLERATE,
+                                         td.size(), start, end));
+        end = start;
+    }
+
+    cd.MergeChunks(chunks, td.size(), actual);
+
+    ASSERT_EQUALM("Same number of segments", expected.size(), actual.size());
+    for (uint32_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQUALM("Same start", expected[i].startIdx, actual[i].startIdx);
+        ASSERT_EQUALM("Same end", expected[i].endIdx, actual[i].endIdx);
+        ASSERT_EQUALM("Same silence flag", expected[i].silence, actual[i].silence);
+        ASSERT_EQUALM("Same chord", true, expected[i].chord == actual[i].chord);
+    }
+
+    chunks.pop_back();
+    ASSERT_THROWSM("Missing chunk", cd.MergeChunks(chunks, td.size(), actual), invalid_argument);
+}
+
+void TestChunkSerialization::__test()
+{
+    chunk_t chunk;
+    stringstream ss;
+
+    chunk.first_frame = 42;
+    chunk.interval = 4096;
+    chunk.scores = { { 0.25, 0.75 }, { 1, 0 }, { 0.5, 0.5 } };
+    chunk.power = { 0.1, 0.2 };
+
+    ChordDetector::SaveChunk(chunk, ss);
+    chunk_t loaded = ChordDetector::LoadChunk(ss);
+
+    ASSERT_EQUALM("First frame", chunk.first_frame, loaded.first_frame);
+    ASSERT_EQUALM("Interval", chunk.interval, loaded.interval);
+    ASSERT_EQUALM("Scores", true, chunk.scores == loaded.scores);
+    ASSERT_EQUALM("Power", true, chunk.power == loaded.power);
+
+    stringstream truncated(ss.str().substr(0, 40));
+    ASSERT_THROWSM("Truncated chunk", ChordDetector::LoadChunk(truncated), runtime_error);
+}
+
+/**
+ * Detector which has analysed another recording gives the same results as
+ * a new one, i.e. nothing is left over in the transforms it keeps
+ */
+void TestDetectorReuse::__test()
+{
+    td_t first = ChunkTestSignal(10), second = ChunkTestSignal(16);
+    ChordDetector fresh, reused;
+    vector<segment_t> expected, actual;
+
+    reused.Prepare(TEST_SAMPLERATE);
+    reused.getSegments(actual, first.data(), first.size(), TEST_SAMPLERATE);
+    actual.clear();
+
+    reused.getSegments(actual, second.data(), second.size(), TEST_SAMPLERATE);
+    fresh.getSegments(expected, second.data(), second.size(), TEST_SAMPLERATE);
+
+    ASSERT_EQUALM("Same number of segments", expected.size(), actual.size());
+    for (uint32_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQUALM("Same start", expected[i].startIdx, actual[i].startIdx);
+        ASSERT_EQUALM("Same end", expected[i].endIdx, actual[i].endIdx);
+        ASSERT_EQUALM("Same chord", true, expected[i].chord == actual[i].chord);
+        ASSERT_EQUALM("Chord survives Harte syntax", true,
+                      Chord(actual[i].chord.toHarte()) == actual[i].chord);
+    }
+}
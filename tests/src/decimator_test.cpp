@@ -0,0 +1,59 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+
+#include "cute.h"
+
+#include "decimator_test.h"
+
+#define TEST_SAMPLERATE     44100
+#define TEST_FREQ           440
+#define TEST_F_MAX          1046.5
+
+
+using namespace anatomist;
+using namespace std;
+
+void TestDecimatorSafeFactor::__test()
+{
+    ASSERT_EQUALM("44.1 kHz down to 11025 Hz", 4, Decimator::SafeFactor(44100, TEST_F_MAX));
+    ASSERT_EQUALM("48 kHz down to 6000 Hz", 8, Decimator::SafeFactor(48000, TEST_F_MAX));
+    ASSERT_EQUALM("Nothing to gain at 8 kHz", 1, Decimator::SafeFactor(8000, 4000));
+}
+
+void TestDecimatorSine::__test()
+{
+    uint32_t factor = Decimator::SafeFactor(TEST_SAMPLERATE, TEST_F_MAX);
+    Decimator decimator(TEST_SAMPLERATE, factor);
+    td_t td(TEST_SAMPLERATE);
+
+    for (uint32_t i = 0; i < td.size(); i++) {
+        td[i] = sin(2 * M_PI * TEST_FREQ * i / TEST_SAMPLERATE);
+    }
+
+    td_t out = decimator.Process(td.data(), td.size());
+
+    ASSERT_EQUALM("Output length", td.size() / factor, out.size());
+
+    /* skip filter ramp-up at both ends */
+    for (uint32_t i = out.size() / 10; i < out.size() * 9 / 10; i++) {
+        ASSERT_EQUAL_DELTAM("Decimated sample matches the input", td[i * factor], out[i], 0.01);
+    }
+}
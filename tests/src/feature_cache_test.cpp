@@ -0,0 +1,181 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <dirent.h>
+#include <stdlib.h>
+#include <thread>
+#include <unistd.h>
+
+#include "cute.h"
+
+#include "chord_detector.h"
+#include "feature_cache_test.h"
+
+#define TEST_SAMPLERATE     44100
+#define TEST_FRAMES         10
+#define TEST_INTERVAL       4096
+
+
+using namespace anatomist;
+using namespace std;
+
+static string makeCacheDir()
+{
+    char dir[] = "/tmp/lmfc_test_XXXXXX";
+
+    if (mkdtemp(dir) == nullptr) {
+        throw runtime_error("Failed to create a temporary directory");
+    }
+
+    return dir;
+}
+
+static void removeCacheDir(const string &dir, uint64_t key)
+{
+    char name[32];
+
+    snprintf(name, sizeof(name), "/%016llx.lmfc", static_cast<unsigned long long>(key));
+    unlink((dir + name).c_str());
+    rmdir(dir.c_str());
+}
+
+void TestFeatureCacheRoundTrip::__test()
+{
+    string dir = makeCacheDir();
+    FeatureCache cache(dir);
+    td_t td(TEST_SAMPLERATE, 0.5);
+    uint64_t key = FeatureCache::Key(td, TEST_SAMPLERATE, "params");
+    chromagram_t stored, loaded;
+    uint32_t interval = 0;
+
+    for (uint32_t f = 0; f < TEST_FRAMES; f++) {
+        vector<amplitude_t> values(notes_Total * 2);
+
+        for (uint32_t i = 0; i < values.size(); i++) {
+            values[i] = 1.0 / (f + i + 1);
+        }
+        stored.push_back(PitchClsProfile(values));
+    }
+
+    cache.Store(key, stored, TEST_INTERVAL);
+
+    ASSERT_EQUALM("Stored entry is found", true, cache.Load(key, &loaded, &interval));
+    ASSERT_EQUALM("Interval", TEST_INTERVAL, interval);
+    ASSERT_EQUALM("Frames", stored.size(), loaded.size());
+    for (uint32_t f = 0; f < TEST_FRAMES; f++) {
+        ASSERT_EQUALM("Values", stored[f].getValues(), loaded[f].getValues());
+    }
+
+    removeCacheDir(dir, key);
+}
+
+void TestFeatureCacheMiss::__test()
+{
+    string dir = makeCacheDir();
+    FeatureCache cache(dir);
+    td_t td(TEST_SAMPLERATE, 0.5);
+    chromagram_t c(1, PitchClsProfile());
+    uint64_t key = FeatureCache::Key(td, TEST_SAMPLERATE, "params");
+    uint32_t interval = 0;
+
+    cache.Store(key, c, TEST_INTERVAL);
+
+    td[0] = 0.25;
+    ASSERT_EQUALM("Different audio is a miss", false,
+                  cache.Load(FeatureCache::Key(td, TEST_SAMPLERATE, "params"), &c, &interval));
+
+    td[0] = 0.5;
+    ASSERT_EQUALM("Different parameters are a miss", false,
+                  cache.Load(FeatureCache::Key(td, TEST_SAMPLERATE, "other"), &c, &interval));
+
+    removeCacheDir(dir, key);
+}
+
+/**
+ * Threads storing the same key do not get in each other's way
+ */
+void TestFeatureCacheConcurrentStore::__test()
+{
+    string dir = makeCacheDir();
+    FeatureCache cache(dir);
+    td_t td(TEST_SAMPLERATE, 0.5);
+    uint64_t key = FeatureCache::Key(td, TEST_SAMPLERATE, "params");
+    chromagram_t stored(TEST_FRAMES, PitchClsProfile(vector<amplitude_t>(notes_Total * 2, 0.5)));
+    chromagram_t loaded;
+    atomic<uint32_t> failed(0);
+    vector<thread> threads;
+    uint32_t interval = 0;
+
+    for (uint32_t t = 0; t < 8; t++) {
+        threads.emplace_back([&]() {
+            for (uint32_t i = 0; i < 50; i++) {
+                try {
+                    cache.Store(key, stored, TEST_INTERVAL);
+                } catch (exception &) {
+                    failed++;
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    ASSERT_EQUALM("No store failed", 0U, failed.load());
+    ASSERT_EQUALM("Stored entry is found", true, cache.Load(key, &loaded, &interval));
+    ASSERT_EQUALM("Frames", stored.size(), loaded.size());
+
+    /* no temporary files are left behind */
+    DIR *d = opendir(dir.c_str());
+    uint32_t files = 0;
+
+    for (struct dirent *e = readdir(d); e != nullptr; e = readdir(d)) {
+        files += (e->d_name[0] != '.');
+    }
+    closedir(d);
+
+    ASSERT_EQUALM("Only the entry is there", 1U, files);
+
+    removeCacheDir(dir, key);
+}
+
+/**
+ * Analysis result is returned even if it could not be cached
+ */
+void TestFeatureCacheStoreFailure::__test()
+{
+    string dir = makeCacheDir();
+    ChordDetector cd;
+    td_t td(TEST_SAMPLERATE * 2);
+    vector<segment_t> segments;
+
+    for (uint32_t i = 0; i < td.size(); i++) {
+        td[i] = 0.3 * sin(2 * M_PI * 220.0 * i / TEST_SAMPLERATE);
+    }
+
+    cd.SetFeatureCache(dir);
+    rmdir(dir.c_str());
+
+    cd.getSegments(segments, td.data(), td.size(), TEST_SAMPLERATE);
+
+    ASSERT_EQUALM("Segments are there", false, segments.empty());
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "feature_cache.h"
+
+
+class TestFeatureCacheRoundTrip {
+private:
+    void __test();
+
+public:
+    void operator()() { __test(); };
+};
+
+class TestFeatureCacheMiss {
+private:
+    void __test();
+
+public:
+    void operator()() { __test(); };
+};
+
+class TestFeatureCacheConcurrentStore {
+private:
+    void __test();
+
+public:
+    void operator()() { __test(); };
+};
+
+class TestFeatureCacheStoreFailure {
+private:
+    void __test();
+
+public:
+    void operator()() { __test(); };
+};
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "cute.h"
+
+#include "goertzel_bank_test.h"
+
+#define TEST_SAMPLERATE     11025
+#define TEST_WIN_SIZE       2048
+#define TEST_F_MIN          41.2
+#define TEST_F_MAX          1046.5
+
+
+using namespace anatomist;
+using namespace std;
+
+static td_t sine(freq_hz_t f, uint32_t samples)
+{
+    td_t td(samples);
+
+    for (uint32_t i = 0; i < samples; i++) {
+        td[i] = sin(2 * M_PI * f * i / TEST_SAMPLERATE);
+    }
+
+    return td;
+}
+
+void TestGoertzelBankPeak::__test()
+{
+    GoertzelBank gb(TEST_F_MIN, TEST_F_MAX, TEST_SAMPLERATE, TEST_WIN_SIZE, TEST_WIN_SIZE);
+
+    ASSERT_EQUALM("Goertzel mode without overlap", GoertzelBank::MODE_GOERTZEL, gb.Mode());
+
+    gb.Process(sine(440, TEST_SAMPLERATE), 0);
+
+    log_spectrogram_t s = gb.GetSpectrogram();
+
+    ASSERT_EQUALM("One column per hop", (TEST_SAMPLERATE + TEST_WIN_SIZE - 1) / TEST_WIN_SIZE, s.size());
+    ASSERT_EQUALM("Interval is the hop size", TEST_WIN_SIZE, gb.SpectrogramInterval());
+
+    for (uint32_t col = 0; col < s.size() - 1; col++) {
+        uint32_t peak = max_element(s[col].begin(), s[col].end()) - s[col].begin();
+        ASSERT_EQUALM("Peak at A4", gb.FreqToBin(440), peak);
+    }
+}
+
+void TestGoertzelBankSliding::__test()
+{
+    uint16_t hop = TEST_WIN_SIZE / 8;
+    td_t td = sine(261.63, TEST_SAMPLERATE);
+    td_t e = sine(329.63, TEST_SAMPLERATE);
+    GoertzelBank goertzel(TEST_F_MIN, TEST_F_MAX, BINS_PER_OCTAVE_DEFAULT, TEST_SAMPLERATE,
+                          TEST_WIN_SIZE, hop, GoertzelBank::MODE_GOERTZEL);
+    GoertzelBank sliding(TEST_F_MIN, TEST_F_MAX, TEST_SAMPLERATE, TEST_WIN_SIZE, hop);
+
+    ASSERT_EQUALM("Sliding mode with small hops", GoertzelBank::MODE_SLIDING, sliding.Mode());
+
+    for (uint32_t i = 0; i < td.size(); i++) {
+        td[i] += 0.5 * e[i];
+    }
+
+    goertzel.Process(td, 100);
+    sliding.Process(td, 100);
+
+    log_spectrogram_t g = goertzel.GetSpectrogram();
+    log_spectrogram_t s = sliding.GetSpectrogram();
+
+    ASSERT_EQUALM("Same number of columns", g.size(), s.size());
+
+    for (uint32_t col = 0; col < g.size(); col++) {
+        ASSERT_EQUALM("Same number of bins", g[col].size(), s[col].size());
+        for (uint32_t bin = 0; bin < g[col].size(); bin++) {
+            ASSERT_EQUAL_DELTAM("Sliding DFT matches Goertzel", g[col][bin], s[col][bin], 1e-6);
+        }
+    }
+}
@@ -34,7 +34,47 @@ void TestNextPowerOf2::__test()
 	ASSERT_EQUAL(2147483648, Helpers::nextPowerOf2(1770165767));
 }
 
+void TestIsPowerOf2::__test()
+{
+    ASSERT(Helpers::isPowerOf2(1));
+    ASSERT(Helpers::isPowerOf2(2));
+    ASSERT(Helpers::isPowerOf2(4096));
+    ASSERT(Helpers::isPowerOf2(2147483648U));
+    ASSERT(!Helpers::isPowerOf2(0));
+    ASSERT(!Helpers::isPowerOf2(3));
+    ASSERT(!Helpers::isPowerOf2(4095));
+    ASSERT(!Helpers::isPowerOf2(6144));
+}
+
 void TestStdRound::__test()
 {
     ASSERT_EQUAL(7.1234, Helpers::stdRound(7.1234123, 4));
 }
+
+/**
+ * Median of a range is the same as of a vector
+ */
+void TestMedian::__test()
+{
+    for (auto v : std::vector<std::vector<double>>{ { 3 }, { 5, 1, 4 }, { 2, 8, 1, 9 },
+                                                     { 7, 7, 1, 3, 3, 9 } }) {
+        std::vector<double> r(v);
+
+        ASSERT_EQUAL(Helpers::median(v), Helpers::median(r.data(), r.data() + r.size()));
+    }
+
+    ASSERT_THROWS(Helpers::median((double *)nullptr, (double *)nullptr), std::invalid_argument);
+}
+
+void TestChordMatch::__test()
+{
+    ASSERTM("Same pitch classes do not match",
+            Chord(note_C, cq_maj6).match(Chord(note_A, cq_min7)));
+    ASSERTM("Inversion does not match",
+            Chord(note_C, cq_maj, note_E, 3).match(Chord(note_C, cq_maj)));
+    ASSERTM("Different chords match", !Chord(note_C, cq_maj).match(Chord(note_C, cq_min)));
+    ASSERTM("Different roots match", !Chord(note_B, cq_maj).match(Chord(note_C, cq_maj)));
+    ASSERTM("N does not match N", Chord().match(Chord("N")));
+    ASSERTM("N matches a chord", !Chord().match(Chord(note_C, cq_5)));
+    ASSERTM("Parsed chord does not match", Chord("A#:min7").match(Chord(note_A_sharp, cq_min7)));
+}
@@ -18,6 +18,7 @@
  */
 
 #include "lmhelpers.h"
+#include "lmtypes.h"
 
 class TestNextPowerOf2 {
 private:
@@ -27,6 +28,14 @@ public:
     void operator()() { __test(); };
 };
 
+class TestIsPowerOf2 {
+private:
+    void __test();
+
+public:
+    void operator()() { __test(); };
+};
+
 class TestStdRound {
 private:
     void __test();
@@ -34,3 +43,19 @@ private:
 public:
     void operator()() { __test(); };
 };
+
+class TestMedian {
+private:
+    void __test();
+
+public:
+    void operator()() { __test(); };
+};
+
+class TestChordMatch {
+private:
+    void __test();
+
+public:
+    void operator()() { __test(); };
+};
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cmath>
+
+#include "cute.h"
+
+#include "chord_detector.h"
+#include "onset_detector_test.h"
+
+#define TEST_SAMPLERATE     44100
+
+
+using namespace anatomist;
+using namespace std;
+
+/**
+ * Strength rises with the magnitudes only, skipped columns are silence
+ */
+void TestOnsetStrength::__test()
+{
+    log_spectrogram_t sg = {
+        { 1, 1, 1 },
+        { 1, 1, 1 },
+        { 1, 40, 1 },   /* onset */
+        { 1, 2, 1 },
+        { },            /* skipped */
+        { 1, 2, 1 },    /* onset after silence */
+        { 1, 2, 1 },
+        { 1, 2, 1 },
+    };
+
+    vector<amplitude_t> strength = OnsetDetector::Strength(sg);
+
+    ASSERT_EQUALM("Strength of every column", sg.size(), strength.size());
+    ASSERT_EQUAL_DELTAM("First column", 0, strength[0], 1e-12);
+    ASSERT_EQUAL_DELTAM("Steady magnitudes", 0, strength[1], 1e-12);
+    ASSERT_EQUAL_DELTAM("Falling magnitudes", 0, strength[3], 1e-12);
+    ASSERT_EQUAL_DELTAM("Skipped column", 0, strength[4], 1e-12);
+    ASSERT_EQUAL_DELTAM("Strongest onset", 1, strength[5], 1e-12);
+    ASSERTM("Rising magnitudes", strength[2] > 0.1);
+
+    vector<uint32_t> onsets = OnsetDetector::PickPeaks(strength, 100, 1000);
+
+    ASSERT_EQUALM("Onsets count", (size_t)2, onsets.size());
+    ASSERT_EQUALM("First onset", (uint32_t)200, onsets[0]);
+    ASSERT_EQUALM("Onset after silence", (uint32_t)500, onsets[1]);
+
+    ASSERTM("Silence has no onsets",
+            OnsetDetector::PickPeaks(OnsetDetector::Strength({ { 0, 0 }, { 0, 0 } }),
+                                     100, 1000).empty());
+}
+
+/**
+ * Struck notes are found within a frame of where they start, the same with
+ * and without chord recognition
+ */
+void TestOnsetNotes::__test()
+{
+    const vector<double> starts = { 0.5, 1.3, 2.1, 2.9 };
+    const vector<double> freqs = { 220, 261.63, 329.63, 196 };
+    td_t td(TEST_SAMPLERATE * 3.7, 0);
+
+    for (uint32_t n = 0; n < starts.size(); n++) {
+        for (size_t i = starts[n] * TEST_SAMPLERATE; i < td.size(); i++) {
+            double t = 1.0 * i / TEST_SAMPLERATE - starts[n];
+
+            for (uint32_t h = 1; h <= 3; h++) {
+                td[i] += 0.3 / h * exp(-4 * t) * sin(2 * M_PI * freqs[n] * h * t);
+            }
+        }
+    }
+
+    ChordDetector cd;
+    SignalView x(td.data(), td.size());
+    onsets_t onsets = cd.GetOnsets(x, TEST_SAMPLERATE);
+
+    ASSERTM("No interval", onsets.interval > 0);
+    ASSERT_EQUALM("Onsets count", starts.size(), onsets.onsets.size());
+
+    for (uint32_t n = 0; n < starts.size(); n++) {
+        double d = abs(1.0 * onsets.onsets[n] - starts[n] * TEST_SAMPLERATE);
+
+        ASSERTM("Onset is too far from the note", d <= onsets.interval);
+    }
+
+    vector<segment_t> segments;
+    onsets_t with_chords;
+
+    cd.getSegments(segments, x, TEST_SAMPLERATE, &with_chords);
+
+    ASSERTM("No segments", !segments.empty());
+    ASSERTM("Onsets differ with chord recognition", onsets.onsets == with_chords.onsets);
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <stdexcept>
+
+#include "cute.h"
+
+#include "config.h"
+#include "lmstats.h"
+#include "rt_chord_analyzer_test.h"
+
+#define TEST_SAMPLERATE     44100
+#define TEST_BLOCK_SIZE     4096
+#define TEST_BLOCKS         20
+
+
+using namespace anatomist;
+using namespace std;
+
+/**
+ * C major triad in the middle register with a few harmonics per note
+ */
+static td_t cMajorSignal(uint32_t samples)
+{
+    const freq_hz_t notes[] = { 130.81, 261.63, 329.63, 392.00 };
+    td_t td(samples, 0);
+
+    for (uint32_t i = 0; i < samples; i++) {
+        for (auto f : notes) {
+            for (uint32_t h = 1; h <= 3; h++) {
+                td[i] += 0.1 / h * sin(2 * M_PI * f * h * i / TEST_SAMPLERATE);
+            }
+        }
+    }
+
+    return td;
+}
+
+void TestRTChordAnalyzerTriad::__test()
+{
+    RTChordAnalyzer rt(TEST_SAMPLERATE, TEST_BLOCK_SIZE);
+    td_t td = cMajorSignal(TEST_BLOCK_SIZE * TEST_BLOCKS);
+
+    ASSERT_EQUALM("Nothing has been processed", Chord(note_Unknown, cq_unknown), rt.GetChord());
+
+    for (uint32_t b = 0; b < TEST_BLOCKS; b++) {
+        rt.Process(td.data() + b * TEST_BLOCK_SIZE);
+    }
+
+    ASSERT_EQUALM("C major is detected", Chord(note_C, cq_maj).toHarte(), rt.GetChord().toHarte());
+}
+
+void TestRTChordAnalyzerSilence::__test()
+{
+    RTChordAnalyzer rt(TEST_SAMPLERATE, TEST_BLOCK_SIZE);
+    td_t td = cMajorSignal(TEST_BLOCK_SIZE * TEST_BLOCKS);
+    td_t silence(TEST_BLOCK_SIZE, 0);
+
+    for (uint32_t b = 0; b < TEST_BLOCKS; b++) {
+        rt.Process(td.data() + b * TEST_BLOCK_SIZE);
+    }
+
+    ASSERT_EQUALM("Silence resets to N", Chord().toHarte(), rt.Process(silence.data()).toHarte());
+}
+
+/**
+ * Low-latency preset analyses overlapping windows a hop at a time
+ */
+void TestRTChordAnalyzerConfig::__test()
+{
+    AnalysisConfig config = AnalysisConfig::Preset("lowlatency");
+    RTChordAnalyzer rt(TEST_SAMPLERATE, config);
+    uint32_t block = rt.BlockSize();
+    td_t td = cMajorSignal(block * TEST_BLOCKS);
+    td_t silence(block, 0);
+
+    ASSERT_EQUALM("Block is a hop", config.HopSize(), block);
+    ASSERT_EQUALM("Window of the config", config.win_size, rt.WindowSize());
+
+    for (uint32_t b = 0; b < TEST_BLOCKS; b++) {
+        rt.Process(td.data() + b * block);
+    }
+
+    /* short windows blur the extensions, root and third still have to be right */
+    ASSERT_EQUALM("C is detected", note_C, rt.GetChord().rootNote());
+    ASSERTM("Major chord is detected", rt.GetChord().toHarte().compare(0, 5, "C:maj") == 0);
+
+    /* silence is only detected once it fills the window */
+    for (uint32_t b = 0; b < config.hops_per_window; b++) {
+        rt.Process(silence.data());
+    }
+
+    ASSERT_EQUALM("Silence resets to N", Chord().toHarte(), rt.GetChord().toHarte());
+
+    config.win_size = 100;
+    ASSERT_THROWSM("Invalid config", RTChordAnalyzer(TEST_SAMPLERATE, config), invalid_argument);
+}
+
+void TestRTChordAnalyzerNoAlloc::__test()
+{
+#if CFG_STATS
+    RTChordAnalyzer rt(TEST_SAMPLERATE, TEST_BLOCK_SIZE);
+    RTChordAnalyzer rt_overlap(TEST_SAMPLERATE, AnalysisConfig::Preset("lowlatency"));
+    td_t td = cMajorSignal(TEST_BLOCK_SIZE * TEST_BLOCKS);
+    vector<float> td_f(td.begin(), td.end());
+    uint64_t before = StatsCollector::AllocatedBytes();
+
+    for (uint32_t b = 0; b < TEST_BLOCKS; b++) {
+        rt.Process(td.data() + b * TEST_BLOCK_SIZE);
+        rt.Process(td_f.data() + b * TEST_BLOCK_SIZE);
+        rt_overlap.Process(td_f.data() + b * TEST_BLOCK_SIZE);
+    }
+    rt.Reset();
+    rt_overlap.Reset();
+
+    uint64_t after = StatsCollector::AllocatedBytes();
+
+    ASSERT_EQUALM("Process() does not allocate", before, after);
+#endif /* CFG_STATS */
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "cute.h"
+
+#include "rt_chord_worker_test.h"
+
+#define TEST_SAMPLERATE     44100
+#define TEST_CHANNELS       2
+#define TEST_CALLBACK_SIZE  256
+#define TEST_SEC            3
+
+
+using namespace anatomist;
+using namespace std;
+
+class SegmentsCollector : public ChordDetector::ResultsListener {
+public:
+    vector<segment_t> segments;
+    bool finished = false;
+
+    void onPreprocessingProgress(float) {}
+
+    void onChordSegmentProcessed(segment_t &s, float)
+    {
+        segments.push_back(s);
+    }
+
+    void onChordAnalysisFinished()
+    {
+        finished = true;
+    }
+};
+
+void TestSpscRingBufferOrder::__test()
+{
+    const uint32_t total = 1 << 20;
+    SpscRingBuffer<uint32_t> rb(1000);
+    bool in_order = true;
+
+    ASSERT_EQUALM("Capacity is a power of 2", 1024U, rb.Capacity());
+
+    thread producer([&rb, total]() {
+        uint32_t chunk[37];
+
+        for (uint32_t i = 0; i < total; ) {
+            uint32_t n = min<uint32_t>(37, total - i);
+
+            for (uint32_t j = 0; j < n; j++) {
+                chunk[j] = i + j;
+            }
+
+            if (rb.Write(chunk, n)) {
+                i += n;
+            } else {
+                this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t chunk[53];
+    for (uint32_t expected = 0; expected < total; ) {
+        size_t n = rb.Read(chunk, 53);
+
+        for (uint32_t j = 0; j < n; j++) {
+            in_order &= (chunk[j] == expected++);
+        }
+
+        if (n == 0) {
+            this_thread::yield();
+        }
+    }
+
+    producer.join();
+
+    ASSERT_EQUALM("Items are read in the order they were written", true, in_order);
+    ASSERT_EQUALM("Buffer is drained", 0U, rb.ReadAvailable());
+}
+
+/**
+ * Feed a C major triad through the worker the way an audio callback would
+ */
+void TestRTChordWorkerFeeder::__test()
+{
+    const freq_hz_t notes[] = { 130.81, 261.63, 329.63, 392.00 };
+    SegmentsCollector collector;
+    RTChordWorker worker(TEST_SAMPLERATE, TEST_CHANNELS, &collector);
+    vector<float> frames(TEST_CALLBACK_SIZE * TEST_CHANNELS);
+    uint32_t total = TEST_SAMPLERATE * TEST_SEC;
+    uint64_t overruns = 0;
+
+    worker.Start();
+
+    for (uint32_t pos = 0; pos < total; pos += TEST_CALLBACK_SIZE) {
+        for (uint32_t i = 0; i < TEST_CALLBACK_SIZE; i++) {
+            float v = 0;
+
+            for (auto f : notes) {
+                v += 0.2 * sin(2 * M_PI * f * (pos + i) / TEST_SAMPLERATE);
+            }
+            frames[i * TEST_CHANNELS] = v;
+            frames[i * TEST_CHANNELS + 1] = v;
+        }
+
+        /* feeding is faster than real time, wait for the worker to catch up */
+        while (!worker.Push(frames.data(), TEST_CALLBACK_SIZE)) {
+            overruns += TEST_CALLBACK_SIZE;
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+    }
+
+    worker.Stop();
+
+    uint32_t blocks = (total / TEST_CALLBACK_SIZE * TEST_CALLBACK_SIZE) / CFG_WINDOW_SIZE;
+
+    ASSERT_EQUALM("Listener is notified", true, collector.finished);
+    ASSERT_EQUALM("Every full block is analysed", blocks * CFG_WINDOW_SIZE, worker.GetPosition());
+    ASSERT_EQUALM("Overruns are accounted", overruns, worker.GetDropped());
+    ASSERT_EQUALM("Segments are reported", false, collector.segments.empty());
+    ASSERT_EQUALM("Last segment ends at the last analysed sample",
+                  worker.GetPosition() - 1, collector.segments.back().endIdx);
+    ASSERT_EQUALM("C major is detected", Chord(note_C, cq_maj).toHarte(),
+                  collector.segments.back().chord.toHarte());
+    ASSERT_EQUALM("Latest chord is published", Chord(note_C, cq_maj).toHarte(),
+                  worker.GetChord().toHarte());
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cute.h"
+
+#include "chord_detector.h"
+#include "lmtrace.h"
+#include "signal_energy_test.h"
+
+#define TEST_SAMPLERATE     44100
+
+
+using namespace anatomist;
+using namespace std;
+
+/**
+ * Block prefix sums give the same power as summing the range directly
+ */
+void TestSignalEnergyPower::__test()
+{
+    const uint32_t frames = 1000;
+    vector<float> stereo(frames * 2);
+
+    for (uint32_t i = 0; i < frames; i++) {
+        stereo[2 * i] = sin(0.01 * i * i);
+        stereo[2 * i + 1] = 0.5 * cos(0.3 * i);
+    }
+
+    SignalView x(stereo.data(), frames, 2);
+    SignalEnergy energy(x);
+
+    ASSERT_EQUALM("Frames count", (size_t)frames, energy.size());
+
+    for (size_t from : { 0, 1, 63, 64, 65, 500 }) {
+        for (size_t to : { 66, 127, 128, 129, 999, 1000 }) {
+            double expected = 0;
+
+            if (to <= from) {
+                continue;
+            }
+
+            for (size_t i = from; i < to; i++) {
+                expected += x[i] * x[i];
+            }
+            expected /= (to - from);
+
+            ASSERT_EQUAL_DELTAM("Power of the range", expected, energy.Power(from, to), 1e-9);
+        }
+    }
+
+    ASSERT_THROWSM("Empty range", energy.Power(10, 10), invalid_argument);
+    ASSERT_THROWSM("Range past the end", energy.Power(10, frames + 1), invalid_argument);
+}
+
+/**
+ * Silence between two chords is reported as a silence segment
+ */
+/**
+ * C major triad with silence between 2 and 4 s
+ */
+static td_t triadWithGap(uint32_t frames)
+{
+    td_t td(frames, 0);
+
+    for (uint32_t i = 0; i < frames; i++) {
+        if ((i >= TEST_SAMPLERATE * 2) && (i < TEST_SAMPLERATE * 4)) {
+            continue;
+        }
+
+        for (freq_hz_t f : { 261.63, 329.63, 392.0 }) {
+            td[i] += 0.2 * sin(2 * M_PI * f * i / TEST_SAMPLERATE);
+        }
+    }
+
+    return td;
+}
+
+/**
+ * Read a 2-dimensional float32 .npy file written by Trace
+ */
+static vector<vector<float>> readNpy(const string &path)
+{
+    ifstream ifs(path, ios::binary);
+    string file((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
+    unsigned rows = 0, cols = 0;
+
+    if (file.size() < 10) {
+        throw runtime_error("no trace at " + path);
+    }
+
+    size_t header_len = static_cast<uint8_t>(file[8]) | (static_cast<uint8_t>(file[9]) << 8);
+    string header = file.substr(10, header_len);
+    size_t shape = header.find("'shape': (");
+
+    if ((shape == string::npos) ||
+        (sscanf(header.c_str() + shape, "'shape': (%u, %u)", &rows, &cols) != 2) ||
+        (file.size() != 10 + header_len + rows * cols * sizeof(float)))
+    {
+        throw runtime_error("unexpected trace at " + path);
+    }
+
+    vector<vector<float>> matrix(rows, vector<float>(cols));
+    const char *data = file.data() + 10 + header_len;
+
+    for (unsigned r = 0; r < rows; r++) {
+        memcpy(matrix[r].data(), data + r * cols * sizeof(float), cols * sizeof(float));
+    }
+
+    return matrix;
+}
+
+static void removeDir(const string &dir)
+{
+    DIR *d = opendir(dir.c_str());
+    struct dirent *e;
+
+    while ((d != nullptr) && ((e = readdir(d)) != nullptr)) {
+        if (e->d_name[0] != '.') {
+            unlink((dir + "/" + e->d_name).c_str());
+        }
+    }
+    if (d != nullptr) {
+        closedir(d);
+    }
+    rmdir(dir.c_str());
+}
+
+void TestSilenceSegments::__test()
+{
+    uint32_t frames = TEST_SAMPLERATE * 6;
+    td_t td = triadWithGap(frames);
+    vector<segment_t> segments;
+
+    ChordDetector cd;
+    cd.getSegments(segments, td.data(), td.size(), TEST_SAMPLERATE);
+
+    bool silence_found = false;
+    for (auto &s : segments) {
+        if (!s.silence) {
+            continue;
+        }
+
+        silence_found = true;
+        ASSERT_EQUALM("Silence starts after the first chord", true,
+                      s.startIdx >= TEST_SAMPLERATE * 2 - CFG_WINDOW_SIZE);
+        ASSERT_EQUALM("Silence ends before the second chord", true,
+                      s.endIdx <= TEST_SAMPLERATE * 4 + CFG_WINDOW_SIZE);
+    }
+
+    ASSERT_EQUALM("Silence segment reported", true, silence_found);
+    ASSERT_EQUALM("Sound at the beginning", false, segments.front().silence);
+    ASSERT_EQUALM("Sound at the end", false, segments.back().silence);
+}
+
+/**
+ * Spectrograms with skipped silent frames are traced, the skipped frames
+ * as zeros
+ */
+void TestSilenceTrace::__test()
+{
+    const struct {
+        uint32_t    tft_type;
+        const char  *name;
+    } transforms[] = {
+        { TFT_TYPE_CONSTANTQ,   "cqt_spectrogram" },
+        { TFT_TYPE_FFT,         "fft_spectrogram" },
+        { TFT_TYPE_GOERTZEL,    "goertzel_spectrogram" },
+    };
+    td_t td = triadWithGap(TEST_SAMPLERATE * 6);
+
+    for (auto &t : transforms) {
+        char dir[] = "/tmp/lmtrace_test_XXXXXX";
+        AnalysisConfig config;
+        vector<segment_t> segments;
+        uint32_t interval = 0;
+
+        if (mkdtemp(dir) == nullptr) {
+            throw runtime_error("Failed to create a temporary directory");
+        }
+
+        config.tft_type = t.tft_type;
+        ChordDetector cd(config);
+
+        Trace::Enable(dir, false);
+        try {
+            cd.getSegments(segments, td, TEST_SAMPLERATE);
+            cd.GetChromagram(td, TEST_SAMPLERATE, &interval);
+        } catch (...) {
+            Trace::Disable();
+            removeDir(dir);
+            throw;
+        }
+        Trace::Disable();
+
+        vector<vector<float>> sg = readNpy(string(dir) + "/" + t.name + ".npy");
+        /* a frame well inside the silence */
+        size_t silent = 3 * TEST_SAMPLERATE / interval;
+
+        removeDir(dir);
+
+        ASSERTM(string("Frames are missing from ") + t.name, sg.size() > silent);
+        ASSERTM(string("No bins in ") + t.name, !sg[0].empty());
+        for (float v : sg[silent]) {
+            ASSERT_EQUALM(string("Skipped frame is not zero in ") + t.name, 0.0f, v);
+        }
+        ASSERTM(string("Sound is zero in ") + t.name,
+                any_of(sg[0].begin(), sg[0].end(), [](float v) { return v != 0; }));
+    }
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2019 Volodymyr Kononenko
+ *
+ * This file is part of Music-DSP.
+ *
+ * Music-DSP is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Music-DSP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+
+#include "cute.h"
+
+#include "chord_detector.h"
+#include "signal_view_test.h"
+
+#define TEST_SAMPLERATE     44100
+
+
+using namespace anatomist;
+using namespace std;
+
+void TestSignalViewLayout::__test()
+{
+    /* 3 interleaved channels, frame i is { i, 10 * i, 100 * i } */
+    vector<float> data;
+    for (uint32_t i = 0; i < 8; i++) {
+        data.insert(data.end(), { 1.0f * i, 10.0f * i, 100.0f * i });
+    }
+
+    SignalView first(data.data(), 8, 1, 3);
+    SignalView stereo(data.data(), 8, 2, 3);
+    SignalView sub = stereo.Sub(2, 4);
+    td_t out(4);
+
+    ASSERT_EQUALM("Frames count", 8U, first.size());
+    ASSERT_EQUAL_DELTAM("First channel", 5.0, first[5], 1e-9);
+    ASSERT_EQUAL_DELTAM("Down-mix of two channels", 5.5 * 7, stereo[7], 1e-9);
+    ASSERT_EQUALM("No direct access to float data", true, first.Contiguous() == nullptr);
+
+    sub.Read(1, 3, out.data());
+    ASSERT_EQUAL_DELTAM("Sub-view starts at its offset", 5.5 * 3, out[0], 1e-9);
+    ASSERT_EQUAL_DELTAM("Sub-view ends at its length", 5.5 * 5, out[2], 1e-9);
+    ASSERT_THROWSM("Read out of range", sub.Read(2, 3, out.data()), out_of_range);
+
+    td_t td(4, 1);
+    ASSERT_EQUALM("Direct access to mono double data", td.data(), SignalView(td).Contiguous());
+}
+
+/**
+ * Interleaved stereo floats are analysed the same way as a mono copy
+ */
+void TestSignalViewChromagram::__test()
+{
+    uint32_t frames = TEST_SAMPLERATE * 2;
+    td_t mono(frames);
+    vector<float> stereo(frames * 2);
+
+    for (uint32_t i = 0; i < frames; i++) {
+        float v = 0.3 * sin(2 * M_PI * 261.63 * i / TEST_SAMPLERATE) +
+                  0.3 * sin(2 * M_PI * 329.63 * i / TEST_SAMPLERATE);
+
+        stereo[2 * i] = v;
+        stereo[2 * i + 1] = v;
+        mono[i] = v;
+    }
+
+    ChordDetector cd;
+    chromagram_t expected = cd.GetChromagram(mono.data(), mono.size(), TEST_SAMPLERATE);
+    chromagram_t actual = cd.GetChromagram(SignalView(stereo.data(), frames, 2), TEST_SAMPLERATE);
+
+    ASSERT_EQUALM("Same number of frames", expected.size(), actual.size());
+    for (uint32_t i = 0; i < expected.size(); i++) {
+        vector<amplitude_t> e = expected[i].getValues();
+        vector<amplitude_t> a = actual[i].getValues();
+
+        for (uint32_t j = 0; j < e.size(); j++) {
+            ASSERT_EQUAL_DELTAM("Same chroma", e[j], a[j], 1e-9);
+        }
+    }
+}
@@ -24,10 +24,25 @@
 #include "xml_listener.h"
 #include "cute_runner.h"
 
+#include "analysis_config_test.h"
+#include "arena_test.h"
+#include "beat_tracker_test.h"
+#include "decimator_test.h"
+#include "feature_cache_test.h"
 #include "chord_detector_test.h"
+#include "chord_eval_test.h"
+#include "chord_model_test.h"
+#include "chord_session_test.h"
+#include "chunk_test.h"
 #include "fft_test.h"
+#include "goertzel_bank_test.h"
 #include "helpers_test.h"
+#include "onset_detector_test.h"
 #include "pitch_calculator_test.h"
+#include "rt_chord_analyzer_test.h"
+#include "rt_chord_worker_test.h"
+#include "signal_energy_test.h"
+#include "signal_view_test.h"
 #include "viterbi_test.h"
 
 
@@ -60,7 +75,10 @@ cute::suite helpersTestSuite()
     cute::suite s;
 
     s.push_back(TestNextPowerOf2());
+    s.push_back(TestIsPowerOf2());
     s.push_back(TestStdRound());
+    s.push_back(TestMedian());
+    s.push_back(TestChordMatch());
 
     return s;
 }
@@ -93,6 +111,164 @@ cute::suite chordDetectorTestSuite()
     return s;
 }
 
+cute::suite beatTrackerTestSuite()
+{
+    cute::suite s;
+
+    s.push_back(TestClickTrackTempo());
+    s.push_back(TestClickTrackBeats());
+    s.push_back(TestBeatSyncColumns());
+    s.push_back(TestBeatSyncPooling());
+
+    return s;
+}
+
+cute::suite decimatorTestSuite()
+{
+    cute::suite s;
+
+    s.push_back(TestDecimatorSafeFactor());
+    s.push_back(TestDecimatorSine());
+
+    return s;
+}
+
+cute::suite goertzelBankTestSuite()
+{
+    cute::suite s;
+
+    s.push_back(TestGoertzelBankPeak());
+    s.push_back(TestGoertzelBankSliding());
+
+    return s;
+}
+
+cute::suite featureCacheTestSuite()
+{
+    cute::suite s;
+
+    s.push_back(TestFeatureCacheRoundTrip());
+    s.push_back(TestFeatureCacheMiss());
+    s.push_back(TestFeatureCacheConcurrentStore());
+    s.push_back(TestFeatureCacheStoreFailure());
+
+    return s;
+}
+
+cute::suite chordModelTestSuite()
+{
+    cute::suite s;
+
+    s.push_back(TestChordModelTrainer());
+    s.push_back(TestChordModelReduction());
+    s.push_back(TestChordModelRoundTrip());
+    s.push_back(TestChordModelParams());
+
+    return s;
+}
+
+cute::suite onsetTestSuite()
+{
+    cute::suite s;
+
+    s.push_back(TestOnsetStrength());
+    s.push_back(TestOnsetNotes());
+
+    return s;
+}
+
+cute::suite analysisConfigTestSuite()
+{
+    cute::suite s;
+
+    s.push_back(TestAnalysisPresets());
+    s.push_back(TestAnalysisConfigDetector());
+    s.push_back(TestAnalysisConfigFftHops());
+
+    return s;
+}
+
+cute::suite arenaTestSuite()
+{
+    cute::suite s;
+
+    s.push_back(TestArenaAllocate());
+    s.push_back(TestArenaRelease());
+    s.push_back(TestArenaLimit());
+
+    return s;
+}
+
+cute::suite rtChordAnalyzerTestSuite()
+{
+    cute::suite s;
+
+    s.push_back(TestRTChordAnalyzerTriad());
+    s.push_back(TestRTChordAnalyzerSilence());
+    s.push_back(TestRTChordAnalyzerConfig());
+    s.push_back(TestRTChordAnalyzerNoAlloc());
+    s.push_back(TestSpscRingBufferOrder());
+    s.push_back(TestRTChordWorkerFeeder());
+
+    return s;
+}
+
+cute::suite chunkTestSuite()
+{
+    cute::suite s;
+
+    s.push_back(TestChunkMerge());
+    s.push_back(TestChunkSerialization());
+    s.push_back(TestDetectorReuse());
+
+    return s;
+}
+
+cute::suite chordEvalTestSuite()
+{
+    cute::suite s;
+
+    s.push_back(TestChordEvalReadLab());
+    s.push_back(TestChordEvalAdjust());
+    s.push_back(TestChordEvalOverlap());
+    s.push_back(TestChordEvalPadding());
+    s.push_back(TestChordEvalSevenths());
+    s.push_back(TestChordEvalSegmentation());
+
+    return s;
+}
+
+cute::suite sessionTestSuite()
+{
+    cute::suite s;
+
+    s.push_back(TestSessionAppend());
+    s.push_back(TestSessionEdit());
+
+    return s;
+}
+
+cute::suite silenceTestSuite()
+{
+    cute::suite s;
+
+    s.push_back(TestSignalEnergyPower());
+    s.push_back(TestSilenceSegments());
+    s.push_back(TestSilenceTrace());
+
+    return s;
+}
+
+cute::suite signalViewTestSuite()
+{
+    cute::suite s;
+
+    s.push_back(TestSignalViewLayout());
+    s.push_back(TestSignalViewChromagram());
+
+    return s;
+}
+
 cute::suite viterbiTestSuite()
 {
     cute::suite s;
@@ -100,13 +276,15 @@ cute::suite viterbiTestSuite()
     s.push_back(TestInitProbsEmpty());
     s.push_back(TestInitProbsBadSum());
     s.push_back(TestObsEmpty());
+    s.push_back(TestParallelPath());
+    s.push_back(TestIncrementalPath());
 
     return s;
 }
 
 void usage()
 {
-	cout << "Usage:\r\tlmtests --<all|fft|helpers|chords|viterbi>" << endl;
+	cout << "Usage:\r\tlmtests --<all|fft|helpers|chords|viterbi|beats|decimator|cache|rt|goertzel|view|silence|chunks|model|onsets|config|arena|session|eval>" << endl;
 }
 
 int main(int argc, char const *argv[])
@@ -136,6 +314,48 @@ int main(int argc, char const *argv[])
 	} else if (strcmp(argv[1], "--viterbi") == 0) {
 	    suite = viterbiTestSuite();
 	    name = "Viterbi Test Suite";
+	} else if (strcmp(argv[1], "--beats") == 0) {
+	    suite = beatTrackerTestSuite();
+	    name = "Beat Tracker Test Suite";
+	} else if (strcmp(argv[1], "--decimator") == 0) {
+	    suite = decimatorTestSuite();
+	    name = "Decimator Test Suite";
+	} else if (strcmp(argv[1], "--cache") == 0) {
+	    suite = featureCacheTestSuite();
+	    name = "Feature Cache Test Suite";
+	} else if (strcmp(argv[1], "--goertzel") == 0) {
+	    suite = goertzelBankTestSuite();
+	    name = "Goertzel Bank Test Suite";
+	} else if (strcmp(argv[1], "--view") == 0) {
+	    suite = signalViewTestSuite();
+	    name = "Signal View Test Suite";
+	} else if (strcmp(argv[1], "--chunks") == 0) {
+	    suite = chunkTestSuite();
+	    name = "Chunked Analysis Test Suite";
+	} else if (strcmp(argv[1], "--session") == 0) {
+	    suite = sessionTestSuite();
+	    name = "Chord Session Test Suite";
+	} else if (strcmp(argv[1], "--silence") == 0) {
+	    suite = silenceTestSuite();
+	    name = "Silence Test Suite";
+	} else if (strcmp(argv[1], "--model") == 0) {
+	    suite = chordModelTestSuite();
+	    name = "Chord Model Test Suite";
+	} else if (strcmp(argv[1], "--onsets") == 0) {
+	    suite = onsetTestSuite();
+	    name = "Onset Detector Test Suite";
+	} else if (strcmp(argv[1], "--config") == 0) {
+	    suite = analysisConfigTestSuite();
+	    name = "Analysis Config Test Suite";
+	} else if (strcmp(argv[1], "--arena") == 0) {
+	    suite = arenaTestSuite();
+	    name = "Arena Test Suite";
+	} else if (strcmp(argv[1], "--eval") == 0) {
+	    suite = chordEvalTestSuite();
+	    name = "Chord Evaluation Test Suite";
+	} else if (strcmp(argv[1], "--rt") == 0) {
+	    suite = rtChordAnalyzerTestSuite();
+	    name = "Real-Time Chord Analyzer Test Suite";
 	} else {
 		usage();
 		return -1;
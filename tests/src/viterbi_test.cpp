@@ -17,11 +17,15 @@
  * along with Music-DSP. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <random>
+
 #include "cute.h"
 
+#include "thread_pool.h"
 #include "viterbi_test.h"
 
 
+using namespace anatomist;
 using namespace std;
 
 bool ViterbiTestHelper::ValidateInitProbs_(vector<double> &init_p) {
@@ -57,3 +61,140 @@ void TestObsEmpty::__test()
 {
 
 }
+
+/**
+ * Random observations, the only state possible every \p anchors of them
+ */
+static Viterbi::prob_matrix_t RandomObs(uint32_t obs_cnt, uint32_t states_cnt, uint32_t anchors,
+                                        mt19937 &gen)
+{
+    uniform_real_distribution<double> dist(0.01, 1.0);
+    Viterbi::prob_matrix_t obs(obs_cnt, vector<double>(states_cnt));
+
+    for (uint32_t o = 0; o < obs_cnt; o++) {
+        double sum = 0;
+
+        for (uint32_t s = 0; s < states_cnt; s++) {
+            obs[o][s] = dist(gen);
+            sum += obs[o][s];
+        }
+        for (uint32_t s = 0; s < states_cnt; s++) {
+            obs[o][s] /= sum;
+        }
+
+        if (o % anchors == anchors - 1) {
+            fill(obs[o].begin(), obs[o].end(), 0);
+            obs[o][o % states_cnt] = 1;
+        }
+    }
+
+    return obs;
+}
+
+static Viterbi::prob_matrix_t StickyTransitions(uint32_t states_cnt)
+{
+    Viterbi::prob_matrix_t trans_p(states_cnt, vector<double>(states_cnt, 0.1 / (states_cnt - 1)));
+
+    for (uint32_t s = 0; s < states_cnt; s++) {
+        trans_p[s][s] = 0.9;
+    }
+
+    return trans_p;
+}
+
+void TestParallelPath::__test()
+{
+    const uint32_t states_cnt = 5;
+    const uint32_t obs_cnt = 2000;
+    mt19937 gen(7);
+
+    vector<double> init_p(states_cnt, 1.0 / states_cnt);
+    Viterbi::prob_matrix_t trans_p = StickyTransitions(states_cnt);
+    /* the only state possible every now and then splits the sequence */
+    Viterbi::prob_matrix_t obs = RandomObs(obs_cnt, states_cnt, 150, gen);
+
+    vector<uint32_t> serial = Viterbi::GetPath(init_p, obs, trans_p, 1);
+
+    ASSERT_EQUALM("Path length", obs_cnt, (uint32_t)serial.size());
+
+    for (uint32_t threads : { 2U, 4U, 0U }) {
+        vector<uint32_t> parallel = Viterbi::GetPath(init_p, obs, trans_p, threads);
+
+        ASSERT_EQUALM("Parallel path matches serial one", true, serial == parallel);
+    }
+
+    /* pool kept by the caller serves call after call */
+    ThreadPool pool(3);
+
+    for (uint32_t call = 0; call < 2; call++) {
+        vector<uint32_t> pooled = Viterbi::GetPath(init_p, obs, trans_p, pool);
+
+        ASSERT_EQUALM("Path decoded by the pool matches serial one", true, serial == pooled);
+    }
+
+    for (uint32_t o = 149; o < obs_cnt; o += 150) {
+        ASSERT_EQUALM("Path goes through the only possible state", o % states_cnt, serial[o]);
+    }
+}
+
+/**
+ * Path of a growing and edited sequence is the same as of the whole one
+ */
+void TestIncrementalPath::__test()
+{
+    const uint32_t states_cnt = 5;
+    mt19937 gen(11);
+
+    vector<double> init_p(states_cnt, 1.0 / states_cnt);
+    Viterbi::prob_matrix_t trans_p = StickyTransitions(states_cnt);
+    Viterbi::prob_matrix_t all = RandomObs(3000, states_cnt, 170, gen);
+    Viterbi::prob_matrix_t obs;
+    Viterbi::Incremental decoder(init_p, trans_p);
+    vector<uint32_t> prev;
+
+    auto check = [&](uint32_t changed) {
+        vector<uint32_t> expected = Viterbi::GetPath(init_p, obs, trans_p, 1);
+        uint32_t first = 0;
+
+        while ((first < min(prev.size(), expected.size())) && (prev[first] == expected[first])) {
+            first++;
+        }
+        if ((first == prev.size()) && (expected.size() > prev.size())) {
+            first = prev.size();
+        }
+
+        ASSERT_EQUALM("Same path as of the whole sequence", true, decoder.Path() == expected);
+        ASSERT_EQUALM("First changed state", first, changed);
+        prev = expected;
+    };
+
+    /* appended in pieces of different length */
+    for (uint32_t len : { 1U, 40U, 200U, 1000U, 1600U, 2400U }) {
+        obs.assign(all.begin(), all.begin() + len);
+        check(decoder.Update(obs, 0, 0));
+    }
+
+    /* unchanged sequence */
+    ASSERT_EQUALM("Nothing changed", (uint32_t)obs.size(), decoder.Update(obs, 0, 0));
+    ASSERT_EQUALM("Nothing decoded", 0U, decoder.Decoded());
+
+    /* edited in the middle, propagation stops at the next anchor */
+    for (uint32_t o = 1000; o < 1010; o++) {
+        obs[o] = all[2500 + o - 1000];
+    }
+    check(decoder.Update(obs, 1000, 1010));
+    ASSERT_EQUALM("Decoded up to the next anchor", 1020U - 1000U, decoder.Decoded());
+
+    /* edited and appended at once */
+    obs[500] = all[2999];
+    obs.insert(obs.end(), all.begin() + 2400, all.end());
+    check(decoder.Update(obs, 500, 501));
+
+    /* truncated */
+    obs.resize(1234);
+    check(decoder.Update(obs, 0, 0));
+
+    ASSERT_THROWSM("Invalid observation",
+                   decoder.Update(Viterbi::prob_matrix_t(2000, vector<double>(states_cnt, 1)), 0, 0),
+                   invalid_argument);
+}
@@ -54,3 +54,18 @@ public:
     void operator()() { __test(); };
 };
 
+class TestParallelPath {
+private:
+    void __test();
+
+public:
+    void operator()() { __test(); };
+};
+
+class TestIncrementalPath {
+private:
+    void __test();
+
+public:
+    void operator()() { __test(); };
+};
@@ -158,6 +158,32 @@ Parachord::getOutputDescriptors() const
     d.sampleRate = m_inputSampleRate / m_blockSize;
     list.push_back(d);
 
+    d = OutputDescriptor();
+    d.identifier = "onsets";
+    d.name = "Onsets";
+    d.description = "Onsets detected in the spectrogram chords are estimated from.";
+    d.unit = "";
+    d.hasFixedBinCount = true;
+    d.binCount = 0;
+    d.hasKnownExtents = false;
+    d.isQuantized = false;
+    d.sampleType = OutputDescriptor::VariableSampleRate;
+    d.hasDuration = false;
+    d.sampleRate = 0;
+    list.push_back(d);
+
+    d.identifier = "onsetstrength";
+    d.name = "Onset Strength";
+    d.description = "Spectral flux onsets are picked from.";
+    d.binCount = 1;
+    d.hasKnownExtents = true;
+    d.minValue = 0;
+    d.maxValue = 1;
+    /* frames are onsets_t::interval apart, which is only known after processing */
+    d.sampleType = OutputDescriptor::VariableSampleRate;
+    d.sampleRate = 0;
+    list.push_back(d);
+
     return list;
 }
 
@@ -228,9 +254,11 @@ Parachord::getChordFeatures()
 {
     anatomist::ChordDetector *cd = new anatomist::ChordDetector();
     vector<segment_t> segments;
+    onsets_t onsets;
     Parachord::FeatureSet retFeatures;
 
-    cd->getSegments(segments, m_channelInput.data(), m_channelInput.size(), m_inputSampleRate);
+    cd->getSegments(segments, anatomist::SignalView(m_channelInput.data(), m_channelInput.size()),
+                    m_inputSampleRate, &onsets);
 
     for (uint32_t i = 0; i < segments.size(); i++) {
         segment_t *s = &segments[i];
@@ -250,6 +278,22 @@ Parachord::getChordFeatures()
             f.values.push_back(chromagram[i].getPitchCls(static_cast<note_t>(N), true));
         retFeatures[1].push_back(f);
     }
+
+    for (auto o : onsets.onsets) {
+        Parachord::Feature f;
+        f.hasTimestamp = true;
+        f.timestamp = RealTime::frame2RealTime(o, m_inputSampleRate);
+        retFeatures[2].push_back(f);
+    }
+
+    for (uint32_t i = 0; i < onsets.strength.size(); i++) {
+        Parachord::Feature f;
+        f.hasTimestamp = true;
+        f.timestamp = RealTime::frame2RealTime(static_cast<long>(i) * onsets.interval,
+                                               m_inputSampleRate);
+        f.values.push_back(onsets.strength[i]);
+        retFeatures[3].push_back(f);
+    }
     delete cd;
 
     return retFeatures;